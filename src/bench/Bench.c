@@ -0,0 +1,205 @@
+/**
+ * @file Bench.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lvgl/lvgl.h"
+
+#include "Bench.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define BENCH_MAX_SERIES 256
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static int compare_double(const void *a, const void *b);
+static double percentile(const double *sorted, uint32_t count, double p);
+static void write_string(FILE *out, const char *text);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static Bench_series_t series[BENCH_MAX_SERIES];
+static uint32_t seriesCount;
+static uint32_t iterations = 200;
+static const char *nameFilter;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+uint32_t Bench_iterations(void)
+{
+  return iterations;
+}
+
+void Bench_set_iterations(uint32_t count)
+{
+  iterations = (count != 0) ? count : 1U;
+}
+
+void Bench_set_filter(const char *filter)
+{
+  nameFilter = filter;
+}
+
+bool Bench_enabled(const char *name)
+{
+  return nameFilter == NULL || strstr(name, nameFilter) != NULL;
+}
+
+Bench_series_t *Bench_series(const char *name, const char *params)
+{
+  for (uint32_t i = 0; i < seriesCount; i++)
+  {
+    if (strcmp(series[i].name, name) == 0 && strcmp(series[i].params, params) == 0)
+    {
+      return &series[i];
+    }
+  }
+
+  if (seriesCount == BENCH_MAX_SERIES)
+  {
+    fprintf(stderr, "bench: too many series, dropping %s\n", name);
+    exit(EXIT_FAILURE);
+  }
+
+  Bench_series_t *created = &series[seriesCount++];
+  snprintf(created->name, sizeof(created->name), "%s", name);
+  snprintf(created->params, sizeof(created->params), "%s", params);
+
+  return created;
+}
+
+void Bench_sample(Bench_series_t *s, double us)
+{
+  if (s->count == s->capacity)
+  {
+    s->capacity = (s->capacity != 0) ? s->capacity * 2U : 256U;
+    s->samplesUs = realloc(s->samplesUs, s->capacity * sizeof(double));
+    if (s->samplesUs == NULL)
+    {
+      fprintf(stderr, "bench: out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  s->samplesUs[s->count++] = us;
+}
+
+uint64_t Bench_now_us(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000U + (uint64_t) now.tv_nsec / 1000U;
+}
+
+int64_t Bench_heap_used(void)
+{
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+  return (int64_t) mon.total_size - (int64_t) mon.free_size;
+}
+
+void Bench_write_json(FILE *out)
+{
+  fprintf(out, "{\n  \"lvgl\": \"%d.%d.%d\",\n  \"iterations\": %u,\n  \"results\": [",
+          LVGL_VERSION_MAJOR, LVGL_VERSION_MINOR, LVGL_VERSION_PATCH, (unsigned) iterations);
+
+  /* Series without samples are skipped, so the separator depends on what was written */
+  bool first = true;
+  for (uint32_t i = 0; i < seriesCount; i++)
+  {
+    Bench_series_t *s = &series[i];
+    if (s->count == 0)
+    {
+      continue;
+    }
+
+    qsort(s->samplesUs, s->count, sizeof(double), compare_double);
+    double sum = 0.0;
+    for (uint32_t k = 0; k < s->count; k++)
+    {
+      sum += s->samplesUs[k];
+    }
+    double median = percentile(s->samplesUs, s->count, 0.5);
+
+    /* Names and params may come from a key file, written escaped */
+    fprintf(out, "%s\n    { \"name\": ", first ? "" : ",");
+    write_string(out, s->name);
+    fprintf(out, ", \"params\": ");
+    write_string(out, s->params);
+    fprintf(out, ", \"samples\": %u, ", (unsigned) s->count);
+    first = false;
+    fprintf(out, "\"medianUs\": %.2f, \"p99Us\": %.2f, \"minUs\": %.2f, \"maxUs\": %.2f, \"meanUs\": %.2f, ", median,
+            percentile(s->samplesUs, s->count, 0.99), s->samplesUs[0], s->samplesUs[s->count - 1U],
+            sum / (double) s->count);
+    fprintf(out, "\"heapDeltaBytes\": %lld", (long long) s->heapDelta);
+    if (s->itemsPerSample > 0.0 && median > 0.0)
+    {
+      fprintf(out, ", \"itemsPerSecond\": %.0f", s->itemsPerSample * 1e6 / median);
+    }
+    fprintf(out, " }");
+  }
+
+  fprintf(out, "\n  ]\n}\n");
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static int compare_double(const void *a, const void *b)
+{
+  double da = *(const double *) a;
+  double db = *(const double *) b;
+
+  return (da > db) - (da < db);
+}
+
+/** Nearest-rank percentile of an ascending array */
+static double percentile(const double *sorted, uint32_t count, double p)
+{
+  uint32_t rank = (uint32_t) (p * (double) count + 0.999999);
+
+  if (rank == 0)
+  {
+    rank = 1;
+  }
+  if (rank > count)
+  {
+    rank = count;
+  }
+
+  return sorted[rank - 1U];
+}
+
+/** `text` as a JSON string literal, as simrunner writes its job names */
+static void write_string(FILE *out, const char *text)
+{
+  fputc('"', out);
+  for (const char *p = text; *p != '\0'; p++)
+  {
+    if (*p == '"' || *p == '\\')
+    {
+      fprintf(out, "\\%c", *p);
+    }
+    else if ((unsigned char) *p < 0x20U)
+    {
+      fprintf(out, "\\u%04x", (unsigned) (unsigned char) *p);
+    }
+    else
+    {
+      fputc(*p, out);
+    }
+  }
+  fputc('"', out);
+}
@@ -0,0 +1,71 @@
+/**
+ * @file Bench.h
+ * Minimal benchmark harness: named series of timing samples, reported as
+ * median/p99 in JSON so results can be compared across commits.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define BENCH_NAME_LEN 64
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  char name[BENCH_NAME_LEN];
+  char params[BENCH_NAME_LEN];
+  double *samplesUs;
+  uint32_t count;
+  uint32_t capacity;
+  int64_t heapDelta;   /**< bytes of LVGL heap kept after the measured operation */
+  double itemsPerSample; /**< work items per sample, gives a throughput if not 0 */
+} Bench_series_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Iterations every case should run, set from the command line */
+uint32_t Bench_iterations(void);
+
+void Bench_set_iterations(uint32_t iterations);
+
+/** Only cases whose name contains `filter` run, NULL runs all */
+void Bench_set_filter(const char *filter);
+
+bool Bench_enabled(const char *name);
+
+/** Get or create the series with this name and parameter string */
+Bench_series_t *Bench_series(const char *name, const char *params);
+
+void Bench_sample(Bench_series_t *series, double us);
+
+uint64_t Bench_now_us(void);
+
+/** Bytes currently allocated from the LVGL heap */
+int64_t Bench_heap_used(void);
+
+void Bench_write_json(FILE *out);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*BENCH_H*/
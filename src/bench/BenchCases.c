@@ -0,0 +1,1131 @@
+/**
+ * @file BenchCases.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lvgl/lvgl.h"
+
+#include "Bench.h"
+#include "BenchCases.h"
+#include "CANLineX2Graphics/DisplayStateMachine.h"
+#include "CANLineX2Graphics/ClockWindow.h"
+#include "CANLineX2Graphics/ChartData.h"
+#include "CANLineX2Interface/ConfigurationHandler.h"
+#include "../ui/ScreenCache.h"
+#include "../ui/BarBank.h"
+#include "../ui/SensorList.h"
+#include "../ui/StaticLayer.h"
+#include "../ui/NumLabel.h"
+#include "../ui/VectorIcon.h"
+#include "../ui/SensorBinding.h"
+#include "../sim/SimDescriptor.h"
+#include "../sim/AlarmKernel.h"
+#include "../sim/SimSensors.h"
+#include "../sim/SensorIngest.h"
+#include "../history/TrendStore.h"
+#include "../history/CompressedHistory.h"
+#include "../history/EventJournal.h"
+#include "../hal/blit565.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define CHART_POINTS 120
+#define CHART_MAX_SERIES 128
+#define LABEL_COUNT 128
+#define LABEL_COLUMNS 8
+#define BAR_COUNT 128
+#define TREND_CHANNELS 128
+#define TREND_ROWS_PER_SAMPLE 1000U
+#define HISTORY_SAMPLES 86400U
+#define HISTORY_BLOCKS 4096U
+#define JOURNAL_EVENTS 100000U
+#define JOURNAL_HOUR_MS 3600000LL
+#define ALARM_FUZZ_STEPS 20000U
+#define ALARM_UPDATES_PER_SAMPLE 100U
+#define BLIT_WIDTH 800U
+#define BLIT_HEIGHT 480U
+#define DIAL_SIZE 400
+#define DIAL_TICKS 61
+#define ICON_COUNT 48U
+#define ICON_COLUMNS 8U
+#define ICON_SIZE 48
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static double render_us(void);
+static lv_obj_t *blank_screen_load(void);
+static lv_obj_t *overview_create(void *user);
+static void overview_update(lv_obj_t *screen, void *user);
+static lv_obj_t *dial_create(lv_obj_t *parent);
+static void warning_icon_draw(lv_vector_dsc_t *dsc, float size, lv_color_t color);
+static void live_icon_draw_cb(lv_event_t *e);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static uint32_t overviewTick;
+static const VectorIcon_src_t warningIcon = { "warning", warning_icon_draw };
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void BenchCases_display_state_machine(const char *const *keys, uint32_t keyCount)
+{
+  char params[BENCH_NAME_LEN];
+
+  if (!Bench_enabled("DisplayStateMachine"))
+  {
+    return;
+  }
+
+  int64_t heapBefore = Bench_heap_used();
+  uint64_t start = Bench_now_us();
+  ChartData_init();
+  DisplayStateMachine_init();
+  DisplayStateMachine_handler();
+  double initUs = (double) (Bench_now_us() - start) + render_us();
+  Bench_series_t *init = Bench_series("DisplayStateMachine init", "first screen");
+  Bench_sample(init, initUs);
+  init->heapDelta = Bench_heap_used() - heapBefore;
+
+  Bench_series_t *idle = Bench_series("DisplayStateMachine idle pass", "handler + render");
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    start = Bench_now_us();
+    DisplayStateMachine_handler();
+    Bench_sample(idle, (double) (Bench_now_us() - start) + render_us());
+  }
+
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    for (uint32_t k = 0; k < keyCount; k++)
+    {
+      lv_obj_t *before = lv_screen_active();
+      heapBefore = Bench_heap_used();
+
+      /* create/load/destroy all happen inside the handler pass */
+      start = Bench_now_us();
+      ConfigurationHandler_SetKeyValue(keys[k]);
+      DisplayStateMachine_handler();
+      double switchUs = (double) (Bench_now_us() - start);
+      double drawUs = render_us();
+
+      if (lv_screen_active() == before)
+      {
+        continue;
+      }
+      snprintf(params, sizeof(params), "step %u: %s", (unsigned) k, keys[k]);
+      Bench_series_t *sw = Bench_series("DisplayStateMachine switch", params);
+      Bench_sample(sw, switchUs);
+      sw->heapDelta = Bench_heap_used() - heapBefore;
+      Bench_sample(Bench_series("DisplayStateMachine first render", params), drawUs);
+    }
+  }
+}
+
+void BenchCases_clock_window(void)
+{
+  if (!Bench_enabled("ClockWindow"))
+  {
+    return;
+  }
+
+  lv_obj_t *blank = blank_screen_load();
+  int64_t heapBefore = Bench_heap_used();
+  uint64_t start = Bench_now_us();
+  ClockWindow_init();
+  Bench_series_t *init = Bench_series("ClockWindow init", "");
+  Bench_sample(init, (double) (Bench_now_us() - start));
+  init->heapDelta = Bench_heap_used() - heapBefore;
+
+  Bench_series_t *load = Bench_series("ClockWindow load", "load + render");
+  Bench_series_t *tick = Bench_series("ClockWindow second", "timers + render");
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    lv_screen_load(blank);
+    lv_refr_now(NULL);
+
+    heapBefore = Bench_heap_used();
+    start = Bench_now_us();
+    ClockWindow_load();
+    Bench_sample(load, (double) (Bench_now_us() - start) + render_us());
+    load->heapDelta = Bench_heap_used() - heapBefore;
+
+    /* One clock update: let the window's timers run, then draw */
+    start = Bench_now_us();
+    lv_timer_handler();
+    Bench_sample(tick, (double) (Bench_now_us() - start) + render_us());
+  }
+
+  lv_screen_load(blank);
+}
+
+void BenchCases_chart(void)
+{
+  char params[BENCH_NAME_LEN];
+  lv_chart_series_t *series[CHART_MAX_SERIES];
+
+  if (!Bench_enabled("chart"))
+  {
+    return;
+  }
+
+  for (uint32_t count = 1; count <= CHART_MAX_SERIES; count *= 2U)
+  {
+    snprintf(params, sizeof(params), "%u series x %u points", (unsigned) count, (unsigned) CHART_POINTS);
+    Bench_series_t *create = Bench_series("chart create", params);
+    Bench_series_t *update = Bench_series("chart update", params);
+    Bench_series_t *destroy = Bench_series("chart destroy", params);
+    update->itemsPerSample = (double) count;
+
+    for (uint32_t i = 0; i < Bench_iterations(); i++)
+    {
+      lv_obj_t *screen = blank_screen_load();
+      int64_t heapBefore = Bench_heap_used();
+
+      uint64_t start = Bench_now_us();
+      lv_obj_t *chart = lv_chart_create(screen);
+      lv_obj_set_size(chart, 760, 400);
+      lv_obj_center(chart);
+      lv_chart_set_point_count(chart, CHART_POINTS);
+      lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, 0, 300);
+      for (uint32_t s = 0; s < count; s++)
+      {
+        series[s] = lv_chart_add_series(chart, lv_palette_main((lv_palette_t) (s % LV_PALETTE_LAST)),
+                                        LV_CHART_AXIS_PRIMARY_Y);
+        for (uint32_t p = 0; p < CHART_POINTS; p++)
+        {
+          lv_chart_set_next_value(chart, series[s], (int32_t) ((p * 7U + s * 13U) % 300U));
+        }
+      }
+      Bench_sample(create, (double) (Bench_now_us() - start) + render_us());
+      create->heapDelta = Bench_heap_used() - heapBefore;
+
+      /* Shift every series by one point, like ChartData does once per second */
+      start = Bench_now_us();
+      for (uint32_t s = 0; s < count; s++)
+      {
+        lv_chart_set_next_value(chart, series[s], (int32_t) ((i * 11U + s * 5U) % 300U));
+      }
+      lv_chart_refresh(chart);
+      Bench_sample(update, (double) (Bench_now_us() - start) + render_us());
+
+      start = Bench_now_us();
+      lv_obj_delete(chart);
+      Bench_sample(destroy, (double) (Bench_now_us() - start) + render_us());
+      lv_obj_delete(screen);
+    }
+  }
+}
+
+void BenchCases_labels(void)
+{
+  lv_obj_t *labels[LABEL_COUNT];
+
+  if (!Bench_enabled("label"))
+  {
+    return;
+  }
+
+  lv_obj_t *screen = blank_screen_load();
+  int32_t cellW = 800 / LABEL_COLUMNS;
+  int32_t cellH = 480 / (LABEL_COUNT / LABEL_COLUMNS);
+  for (uint32_t i = 0; i < LABEL_COUNT; i++)
+  {
+    labels[i] = lv_label_create(screen);
+    lv_obj_set_pos(labels[i], (int32_t) (i % LABEL_COLUMNS) * cellW, (int32_t) (i / LABEL_COLUMNS) * cellH);
+    lv_label_set_text(labels[i], "0 PPM");
+  }
+  lv_refr_now(NULL);
+
+  Bench_series_t *setText = Bench_series("label set_text", "128 labels");
+  Bench_series_t *redraw = Bench_series("label update", "128 labels, set_text + render");
+  setText->itemsPerSample = LABEL_COUNT;
+  redraw->itemsPerSample = LABEL_COUNT;
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    uint64_t start = Bench_now_us();
+    for (uint32_t l = 0; l < LABEL_COUNT; l++)
+    {
+      int32_t value = (int32_t) ((i * 3U + l * 17U) % 300U);
+      lv_label_set_text_fmt(labels[l], "%" LV_PRId32 " PPM", value);
+    }
+    double setUs = (double) (Bench_now_us() - start);
+    Bench_sample(setText, setUs);
+    Bench_sample(redraw, setUs + render_us());
+  }
+  lv_obj_delete(screen);
+
+  /* The same values from cached glyph runs */
+  screen = blank_screen_load();
+  for (uint32_t i = 0; i < LABEL_COUNT; i++)
+  {
+    labels[i] = NumLabel_create(screen);
+    lv_obj_set_pos(labels[i], (int32_t) (i % LABEL_COLUMNS) * cellW, (int32_t) (i / LABEL_COLUMNS) * cellH);
+    NumLabel_set_format(labels[i], 3, 0, false);
+    NumLabel_set_unit(labels[i], "PPM");
+  }
+  lv_refr_now(NULL);
+
+  Bench_series_t *setValue = Bench_series("numlabel set_value", "128 labels");
+  Bench_series_t *numRedraw = Bench_series("numlabel update", "128 labels, set_value + render");
+  setValue->itemsPerSample = LABEL_COUNT;
+  numRedraw->itemsPerSample = LABEL_COUNT;
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    uint64_t start = Bench_now_us();
+    for (uint32_t l = 0; l < LABEL_COUNT; l++)
+    {
+      NumLabel_set_value(labels[l], (int32_t) ((i * 3U + l * 17U) % 300U));
+    }
+    double setUs = (double) (Bench_now_us() - start);
+    Bench_sample(setValue, setUs);
+    Bench_sample(numRedraw, setUs + render_us());
+  }
+  lv_obj_delete(screen);
+}
+
+void BenchCases_bars(void)
+{
+  static int32_t values[BAR_COUNT];
+  lv_obj_t *bars[BAR_COUNT];
+
+  if (!Bench_enabled("bars"))
+  {
+    return;
+  }
+
+  lv_obj_t *screen = blank_screen_load();
+  int64_t heapBefore = Bench_heap_used();
+  int32_t barW = 800 / BAR_COUNT;
+  for (uint32_t i = 0; i < BAR_COUNT; i++)
+  {
+    bars[i] = lv_bar_create(screen);
+    lv_obj_set_pos(bars[i], (int32_t) i * barW, 100);
+    lv_obj_set_size(bars[i], barW - 1, 300);
+  }
+  lv_refr_now(NULL);
+  Bench_series_t *objects = Bench_series("bars lv_bar", "128 objects, 16 values change + render");
+  objects->heapDelta = Bench_heap_used() - heapBefore;
+  objects->itemsPerSample = BAR_COUNT;
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    uint64_t start = Bench_now_us();
+    for (uint32_t b = i % 8U; b < BAR_COUNT; b += 8U)
+    {
+      lv_bar_set_value(bars[b], (int32_t) ((i * 7U + b * 13U) % 100U), LV_ANIM_OFF);
+    }
+    Bench_sample(objects, (double) (Bench_now_us() - start) + render_us());
+  }
+  lv_obj_clean(screen);
+
+  heapBefore = Bench_heap_used();
+  lv_obj_t *bank = BarBank_create(screen);
+  lv_obj_set_size(bank, 800, 300);
+  lv_obj_set_pos(bank, 0, 100);
+  BarBank_set_count(bank, BAR_COUNT);
+  BarBank_set_values(bank, values);
+  lv_refr_now(NULL);
+  Bench_series_t *single = Bench_series("bars BarBank", "1 object, 16 values change + render");
+  single->heapDelta = Bench_heap_used() - heapBefore;
+  single->itemsPerSample = BAR_COUNT;
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    uint64_t start = Bench_now_us();
+    for (uint32_t b = i % 8U; b < BAR_COUNT; b += 8U)
+    {
+      values[b] = (int32_t) ((i * 7U + b * 13U) % 100U);
+    }
+    BarBank_refresh(bank);
+    Bench_sample(single, (double) (Bench_now_us() - start) + render_us());
+  }
+
+  lv_obj_delete(screen);
+}
+
+void BenchCases_sensor_list(void)
+{
+  char params[BENCH_NAME_LEN];
+  const SimDescriptor_t *descriptor = SimDescriptor_get();
+
+  if (!Bench_enabled("sensor list") || descriptor == NULL || descriptor->sensorCount == 0)
+  {
+    return;
+  }
+
+  lv_obj_t *screen = blank_screen_load();
+  lv_snprintf(params, sizeof(params), "%" LV_PRIu32 " sensors", descriptor->sensorCount);
+  int64_t heapBefore = Bench_heap_used();
+  uint64_t start = Bench_now_us();
+  lv_obj_t *list = SensorList_create(screen);
+  SensorList_set_sensors(list, 0, descriptor->sensorCount);
+  Bench_series_t *create = Bench_series("sensor list create", params);
+  Bench_sample(create, (double) (Bench_now_us() - start) + render_us());
+  create->heapDelta = Bench_heap_used() - heapBefore;
+
+  lv_snprintf(params, sizeof(params), "%" LV_PRIu32 " sensors, %" LV_PRIu32 " rows", descriptor->sensorCount,
+              SensorList_get_row_count(list));
+  Bench_series_t *scroll = Bench_series("sensor list select next", params);
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    start = Bench_now_us();
+    SensorList_set_selected(list, i % descriptor->sensorCount);
+    Bench_sample(scroll, (double) (Bench_now_us() - start) + render_us());
+  }
+
+  lv_obj_delete(screen);
+}
+
+void BenchCases_trend_store(const char *path)
+{
+  int32_t values[TREND_CHANNELS];
+  int32_t points[CHART_POINTS];
+  int64_t timeMs = 0;
+
+  if (!Bench_enabled("trend store"))
+  {
+    return;
+  }
+
+  remove(path);
+  uint64_t start = Bench_now_us();
+  TrendStore_t *store = TrendStore_open(path, TREND_CHANNELS);
+  if (store == NULL)
+  {
+    fprintf(stderr, "bench: cannot create %s\n", path);
+    return;
+  }
+  Bench_sample(Bench_series("trend store open", "empty"), (double) (Bench_now_us() - start));
+
+  Bench_series_t *append = Bench_series("trend store append", "1000 rows x 128 channels");
+  append->itemsPerSample = TREND_ROWS_PER_SAMPLE;
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    start = Bench_now_us();
+    for (uint32_t r = 0; r < TREND_ROWS_PER_SAMPLE; r++)
+    {
+      for (uint32_t c = 0; c < TREND_CHANNELS; c++)
+      {
+        values[c] = (int32_t) ((r + c) % 300U);
+      }
+      TrendStore_append(store, timeMs, values);
+      timeMs += 1000;
+    }
+    Bench_sample(append, (double) (Bench_now_us() - start));
+  }
+  TrendStore_close(store);
+
+  char params[BENCH_NAME_LEN];
+  lv_snprintf(params, sizeof(params), "%" LV_PRIu32 " rows", Bench_iterations() * TREND_ROWS_PER_SAMPLE);
+  start = Bench_now_us();
+  store = TrendStore_open(path, TREND_CHANNELS);
+  Bench_sample(Bench_series("trend store open", params), (double) (Bench_now_us() - start));
+  if (store == NULL)
+  {
+    return;
+  }
+
+  /* Zoom levels from the whole history down to 1/64 of it, pages at random offsets */
+  Bench_series_t *page = Bench_series("trend store chart page", params);
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    int64_t span = timeMs >> (i % 7U);
+    int64_t from = (int64_t) ((i * 2654435761U) % 1000U) * (timeMs - span) / 1000;
+    start = Bench_now_us();
+    TrendStore_read_chart(store, i % TREND_CHANNELS, from, from + span, points, CHART_POINTS);
+    Bench_sample(page, (double) (Bench_now_us() - start));
+  }
+  TrendStore_close(store);
+  remove(path);
+}
+
+void BenchCases_compressed_history(void)
+{
+  static const char *const signals[] = { "steady", "drifting", "noisy" };
+  char params[BENCH_NAME_LEN];
+  int32_t points[CHART_POINTS];
+
+  if (!Bench_enabled("history"))
+  {
+    return;
+  }
+
+  int64_t *rawTimes = malloc(sizeof(int64_t) * HISTORY_SAMPLES);
+  int32_t *rawValues = malloc(sizeof(int32_t) * HISTORY_SAMPLES);
+  CompressedHistory_t *history = CompressedHistory_create(HISTORY_BLOCKS);
+  if (rawTimes == NULL || rawValues == NULL || history == NULL)
+  {
+    free(rawTimes);
+    free(rawValues);
+    CompressedHistory_delete(history);
+    return;
+  }
+
+  for (uint32_t kind = 0; kind < 3U; kind++)
+  {
+    CompressedHistory_delete(history);
+    history = CompressedHistory_create(HISTORY_BLOCKS);
+    uint32_t seed = 1;
+    int32_t value = 200;
+    for (uint32_t i = 0; i < HISTORY_SAMPLES; i++)
+    {
+      seed = seed * 1103515245U + 12345U;
+      uint32_t r = seed >> 16;
+      if (kind == 1U && (r % 30U) == 0U)
+      {
+        value += (int32_t) (r % 3U) - 1;
+      }
+      else if (kind == 2U)
+      {
+        value = 200 + (int32_t) (r % 21U) - 10;
+      }
+      rawTimes[i] = (int64_t) i * 1000;
+      rawValues[i] = value;
+      CompressedHistory_append(history, rawTimes[i], value);
+    }
+
+    size_t rawBytes = HISTORY_SAMPLES * (sizeof(int64_t) + sizeof(int32_t));
+    size_t packedBytes = CompressedHistory_get_used_memory(history);
+    lv_snprintf(params, sizeof(params), "%s, %u vs %u bytes, %.1fx", signals[kind], (unsigned) packedBytes,
+                (unsigned) rawBytes, (double) rawBytes / (double) (packedBytes ? packedBytes : 1U));
+    Bench_series_t *packed = Bench_series("history chart compressed", params);
+    Bench_series_t *raw = Bench_series("history chart raw", params);
+    packed->itemsPerSample = HISTORY_SAMPLES;
+    raw->itemsPerSample = HISTORY_SAMPLES;
+
+    for (uint32_t i = 0; i < Bench_iterations(); i++)
+    {
+      uint64_t start = Bench_now_us();
+      CompressedHistory_read_chart(history, 0, (int64_t) HISTORY_SAMPLES * 1000, points, CHART_POINTS);
+      Bench_sample(packed, (double) (Bench_now_us() - start));
+
+      /* Same bucketing over the plain arrays */
+      start = Bench_now_us();
+      for (uint32_t p = 0; p < CHART_POINTS; p++)
+      {
+        points[p] = COMPRESSED_HISTORY_NO_POINT;
+      }
+      for (uint32_t s = 0; s < HISTORY_SAMPLES; s++)
+      {
+        uint32_t bucket = (uint32_t) (rawTimes[s] * CHART_POINTS / ((int64_t) HISTORY_SAMPLES * 1000));
+        if (points[bucket] == COMPRESSED_HISTORY_NO_POINT || rawValues[s] > points[bucket])
+        {
+          points[bucket] = rawValues[s];
+        }
+      }
+      Bench_sample(raw, (double) (Bench_now_us() - start));
+    }
+  }
+
+  free(rawTimes);
+  free(rawValues);
+  CompressedHistory_delete(history);
+}
+
+void BenchCases_event_journal(void)
+{
+  static const char *const names[] = { "unacked level 2 of one sensor, 8 h", "one sensor, 24 h", "level 0, 1 h",
+                                       "all, 10 min" };
+
+  if (!Bench_enabled("journal"))
+  {
+    return;
+  }
+
+  const EventJournal_event_t **found = malloc(sizeof(EventJournal_event_t *) * JOURNAL_EVENTS);
+  const EventJournal_event_t **all = malloc(sizeof(EventJournal_event_t *) * JOURNAL_EVENTS);
+  EventJournal_t *journal = EventJournal_create(JOURNAL_EVENTS);
+  if (found == NULL || all == NULL || journal == NULL)
+  {
+    free(found);
+    free(all);
+    EventJournal_delete(journal);
+    return;
+  }
+
+  /* A month of events, about one every 26 s, most of them acknowledged */
+  uint32_t seed = 1;
+  int64_t timeMs = 0;
+  for (uint32_t i = 0; i < JOURNAL_EVENTS; i++)
+  {
+    seed = seed * 1103515245U + 12345U;
+    timeMs += 1 + (int64_t) ((seed >> 8) % 52000U);
+    uint32_t seq = EventJournal_append(journal, timeMs, (uint16_t) ((seed >> 4) % 59U), (uint8_t) ((seed >> 12) % 5U),
+                                       ((seed >> 20) & 1U) ? EVENT_JOURNAL_TRIGGER : EVENT_JOURNAL_RELEASE);
+    if ((seed >> 24) % 4U != 0U)
+    {
+      EventJournal_ack(journal, seq, timeMs);
+    }
+  }
+
+  EventJournal_filter_t filters[4];
+  for (uint32_t q = 0; q < 4U; q++)
+  {
+    EventJournal_filter_init(&filters[q]);
+  }
+  uint32_t count = EventJournal_query(journal, &filters[0], all, JOURNAL_EVENTS);
+  filters[0].source = 12;
+  filters[0].level = 2;
+  filters[0].unackedOnly = true;
+  filters[0].fromMs = timeMs - 8 * JOURNAL_HOUR_MS;
+  filters[1].source = 12;
+  filters[1].fromMs = timeMs - 24 * JOURNAL_HOUR_MS;
+  filters[2].level = 0;
+  filters[2].fromMs = timeMs - JOURNAL_HOUR_MS;
+  filters[3].fromMs = timeMs - JOURNAL_HOUR_MS / 6;
+
+  for (uint32_t q = 0; q < 4U; q++)
+  {
+    const EventJournal_filter_t *filter = &filters[q];
+    Bench_series_t *indexed = Bench_series("journal query indexed", names[q]);
+    Bench_series_t *scan = Bench_series("journal query scan", names[q]);
+
+    for (uint32_t i = 0; i < Bench_iterations(); i++)
+    {
+      uint64_t start = Bench_now_us();
+      EventJournal_query(journal, filter, found, JOURNAL_EVENTS);
+      Bench_sample(indexed, (double) (Bench_now_us() - start));
+
+      /* Every record against the filter, what a plain ring would do */
+      start = Bench_now_us();
+      uint32_t n = 0;
+      for (uint32_t e = 0; e < count; e++)
+      {
+        const EventJournal_event_t *event = all[e];
+        if (event->timeMs < filter->fromMs || event->timeMs > filter->toMs)
+        {
+          continue;
+        }
+        if ((filter->source == EVENT_JOURNAL_ANY || event->source == (uint32_t) filter->source) &&
+            (filter->level == EVENT_JOURNAL_ANY || event->level == (uint32_t) filter->level) &&
+            (!filter->unackedOnly || (event->kind == EVENT_JOURNAL_TRIGGER && !event->acked)))
+        {
+          found[n++] = event;
+        }
+      }
+      Bench_sample(scan, (double) (Bench_now_us() - start));
+    }
+  }
+
+  free(found);
+  free(all);
+  EventJournal_delete(journal);
+}
+
+void BenchCases_alarm_kernel(void)
+{
+  static const uint32_t sensorCounts[] = { 128, 512 };
+  char params[BENCH_NAME_LEN];
+  int32_t values[SIM_DESCRIPTOR_MAX_SENSORS];
+  bool faults[SIM_DESCRIPTOR_MAX_SENSORS];
+
+  if (!Bench_enabled("alarms"))
+  {
+    return;
+  }
+
+  AlarmKernel_levels_t *levels = malloc(sizeof(AlarmKernel_levels_t));
+  AlarmKernel_state_t *state = malloc(sizeof(AlarmKernel_state_t));
+  if (levels == NULL || state == NULL)
+  {
+    free(levels);
+    free(state);
+    return;
+  }
+
+  /* Both implementations must agree before their times mean anything */
+  uint32_t mismatches = AlarmKernel_fuzz_compare(1, ALARM_FUZZ_STEPS);
+  if (mismatches != 0)
+  {
+    fprintf(stderr, "bench: alarm kernel differs from the scalar reference in %u of %u steps\n",
+            (unsigned) mismatches, (unsigned) ALARM_FUZZ_STEPS);
+  }
+
+  /* The descriptor levels repeated over all lanes, values sweeping through them */
+  const SimDescriptor_t *desc = SimDescriptor_get();
+  AlarmKernel_load(levels, desc);
+  for (uint32_t s = desc->sensorCount; s < SIM_DESCRIPTOR_MAX_SENSORS && desc->sensorCount != 0; s++)
+  {
+    uint32_t from = s % desc->sensorCount;
+    levels->sensorActive[s] = levels->sensorActive[from];
+    for (uint32_t e = 0; e < ALARM_KERNEL_ENTRIES; e++)
+    {
+      levels->threshold[e][s] = levels->threshold[e][from];
+      levels->hysteresis[e][s] = levels->hysteresis[e][from];
+      levels->rising[e][s] = levels->rising[e][from];
+      levels->armed[e][s] = levels->armed[e][from];
+      levels->delayMs[e][s] = levels->delayMs[e][from];
+      levels->timeoutMs[e][s] = levels->timeoutMs[e][from];
+    }
+  }
+  memset(faults, 0, sizeof(faults));
+
+  for (uint32_t c = 0; c < sizeof(sensorCounts) / sizeof(sensorCounts[0]); c++)
+  {
+    levels->sensorCount = sensorCounts[c];
+    lv_snprintf(params, sizeof(params), "%u sensors, %s, fuzz %u mismatches", (unsigned) sensorCounts[c],
+                AlarmKernel_is_vectorized() ? "SSE2" : "scalar fallback", (unsigned) mismatches);
+    Bench_series_t *scalar = Bench_series("alarm update scalar", params);
+    Bench_series_t *kernel = Bench_series("alarm update kernel", params);
+    scalar->itemsPerSample = ALARM_UPDATES_PER_SAMPLE;
+    kernel->itemsPerSample = ALARM_UPDATES_PER_SAMPLE;
+
+    uint32_t nowMs = 0;
+    for (uint32_t i = 0; i < Bench_iterations(); i++)
+    {
+      for (uint32_t s = 0; s < SIM_DESCRIPTOR_MAX_SENSORS; s++)
+      {
+        values[s] = (int32_t) ((i * 7U + s * 13U) % 1000U);
+      }
+
+      AlarmKernel_reset(state);
+      uint64_t start = Bench_now_us();
+      for (uint32_t u = 0; u < ALARM_UPDATES_PER_SAMPLE; u++)
+      {
+        AlarmKernel_update_scalar(levels, state, values, faults, nowMs + u * 1000U, NULL);
+      }
+      Bench_sample(scalar, (double) (Bench_now_us() - start));
+
+      AlarmKernel_reset(state);
+      start = Bench_now_us();
+      for (uint32_t u = 0; u < ALARM_UPDATES_PER_SAMPLE; u++)
+      {
+        AlarmKernel_update(levels, state, values, faults, nowMs + u * 1000U, NULL);
+      }
+      Bench_sample(kernel, (double) (Bench_now_us() - start));
+      nowMs += ALARM_UPDATES_PER_SAMPLE * 1000U;
+    }
+  }
+
+  free(levels);
+  free(state);
+}
+
+void BenchCases_screen_cache(void)
+{
+  static const ScreenCache_desc_t overviews[2] = {
+    { "overview A", overview_create, overview_update, NULL },
+    { "overview B", overview_create, overview_update, NULL },
+  };
+
+  if (!Bench_enabled("screen switch"))
+  {
+    return;
+  }
+
+  lv_obj_t *home = blank_screen_load();
+  Bench_series_t *rebuilt = Bench_series("screen switch rebuilt", "128 labels + bars, create + delete + render");
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    uint64_t start = Bench_now_us();
+    lv_obj_t *screen = overview_create(NULL);
+    overview_update(screen, NULL);
+    lv_screen_load(screen);
+    lv_obj_delete(home);
+    home = screen;
+    Bench_sample(rebuilt, (double) (Bench_now_us() - start) + render_us());
+  }
+
+  int64_t heapBefore = Bench_heap_used();
+  Bench_series_t *cached = Bench_series("screen switch cached", "128 labels + bars, update + render");
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    uint64_t start = Bench_now_us();
+    ScreenCache_load(&overviews[i & 1U]);
+    if (i == 0)
+    {
+      lv_obj_delete(home);
+    }
+    Bench_sample(cached, (double) (Bench_now_us() - start) + render_us());
+  }
+  cached->heapDelta = Bench_heap_used() - heapBefore;
+
+  lv_screen_load(lv_obj_create(NULL));
+  ScreenCache_invalidate(&overviews[0]);
+  ScreenCache_invalidate(&overviews[1]);
+}
+
+void BenchCases_rgb565_blit(void)
+{
+  static const struct {
+    const char *params;
+    uint32_t w;
+    uint32_t h;
+  } areas[] = {
+    { "full frame 800x480", BLIT_WIDTH, BLIT_HEIGHT },
+    { "value label 96x24", 96U, 24U },
+  };
+  char params[BENCH_NAME_LEN];
+
+  if (!Bench_enabled("rgb565"))
+  {
+    return;
+  }
+
+  uint16_t *src = malloc(BLIT_WIDTH * BLIT_HEIGHT * sizeof(uint16_t));
+  uint32_t *dst = malloc(BLIT_WIDTH * BLIT_HEIGHT * sizeof(uint32_t));
+  uint32_t *ref = malloc(BLIT_WIDTH * BLIT_HEIGHT * sizeof(uint32_t));
+  if (src == NULL || dst == NULL || ref == NULL)
+  {
+    free(src);
+    free(dst);
+    free(ref);
+    return;
+  }
+
+  /* Every 565 color at every alignment must convert like the reference */
+  uint32_t mismatches = 0;
+  for (uint32_t i = 0; i < BLIT_WIDTH * BLIT_HEIGHT; i++)
+  {
+    src[i] = (uint16_t) (i * 40503U);
+  }
+  for (uint32_t offset = 0; offset < 8U; offset++)
+  {
+    uint32_t count = 65536U + 31U;
+    blit565_to_xrgb8888_scalar(ref, src + offset, count);
+    blit565_to_xrgb8888(dst, src + offset, count);
+    mismatches += (memcmp(ref, dst, count * sizeof(uint32_t)) != 0) ? 1U : 0U;
+  }
+  if (mismatches != 0)
+  {
+    fprintf(stderr, "bench: %s RGB565 conversion differs from the scalar reference\n", blit565_get_impl());
+  }
+
+  for (uint32_t a = 0; a < sizeof(areas) / sizeof(areas[0]); a++)
+  {
+    lv_snprintf(params, sizeof(params), "%s, %s", areas[a].params, blit565_get_impl());
+    Bench_series_t *scalar = Bench_series("rgb565 blit scalar", areas[a].params);
+    Bench_series_t *simd = Bench_series("rgb565 blit", params);
+    scalar->itemsPerSample = (double) areas[a].w * areas[a].h;
+    simd->itemsPerSample = scalar->itemsPerSample;
+
+    for (uint32_t i = 0; i < Bench_iterations(); i++)
+    {
+      uint64_t start = Bench_now_us();
+      for (uint32_t y = 0; y < areas[a].h; y++)
+      {
+        blit565_to_xrgb8888_scalar(dst + y * BLIT_WIDTH, src + y * BLIT_WIDTH, areas[a].w);
+      }
+      Bench_sample(scalar, (double) (Bench_now_us() - start));
+
+      start = Bench_now_us();
+      blit565_rect((uint8_t *) dst, BLIT_WIDTH * 4U, (const uint8_t *) src, BLIT_WIDTH * 2U, areas[a].w,
+                   areas[a].h);
+      Bench_sample(simd, (double) (Bench_now_us() - start));
+    }
+  }
+
+  free(src);
+  free(dst);
+  free(ref);
+}
+
+void BenchCases_static_layer(void)
+{
+  static lv_point_precise_t hand[2];
+  static const char *const params[2] = { "live", "cached layer" };
+
+  if (!Bench_enabled("static layer"))
+  {
+    return;
+  }
+
+  for (uint32_t mode = 0; mode < 2U; mode++)
+  {
+    lv_obj_t *screen = blank_screen_load();
+    lv_obj_t *dial = dial_create(screen);
+    /* The dynamic part, above the dial */
+    lv_obj_t *line = lv_line_create(screen);
+    lv_obj_set_style_line_width(line, 4, 0);
+    lv_obj_set_style_line_rounded(line, true, 0);
+    lv_obj_set_size(line, 800, 480);
+    lv_obj_t *time = lv_label_create(screen);
+    lv_obj_align(time, LV_ALIGN_BOTTOM_MID, 0, -8);
+    lv_refr_now(NULL);
+
+    Bench_series_t *second = Bench_series("static layer second", params[mode]);
+    StaticLayer_t *layer = NULL;
+    if (mode == 1U)
+    {
+      int64_t heapBefore = Bench_heap_used();
+      layer = StaticLayer_create(dial);
+      /* The layer caches once the dial has been still for the settle time */
+      for (uint32_t waitMs = 0; waitMs < 4U * STATIC_LAYER_SETTLE_MS && !StaticLayer_is_cached(layer); waitMs += 10U)
+      {
+        lv_timer_handler();
+        lv_delay_ms(10);
+      }
+      if (!StaticLayer_is_cached(layer))
+      {
+        fprintf(stderr, "bench: the static layer was not cached\n");
+      }
+      second->heapDelta = Bench_heap_used() - heapBefore;
+      lv_refr_now(NULL);
+    }
+
+    for (uint32_t i = 0; i < Bench_iterations(); i++)
+    {
+      uint32_t sec = i % 60U;
+      int16_t angle = (int16_t) ((int32_t) sec * 6 + 270); /* 0 s points up */
+
+      uint64_t start = Bench_now_us();
+      hand[0].x = 400;
+      hand[0].y = 240;
+      hand[1].x = 400 + ((DIAL_SIZE / 2 - 40) * lv_trigo_cos(angle)) / LV_TRIGO_SIN_MAX;
+      hand[1].y = 240 + ((DIAL_SIZE / 2 - 40) * lv_trigo_sin(angle)) / LV_TRIGO_SIN_MAX;
+      lv_line_set_points(line, hand, 2);
+      lv_label_set_text_fmt(time, "12:34:%02u", (unsigned) sec);
+      Bench_sample(second, (double) (Bench_now_us() - start) + render_us());
+    }
+
+    StaticLayer_delete(layer);
+    lv_screen_load(lv_obj_create(NULL));
+    lv_obj_delete(screen);
+  }
+}
+
+void BenchCases_vector_icons(void)
+{
+  static const char *const params[2] = { "live", "cached" };
+  lv_obj_t *icons[ICON_COUNT];
+
+  if (!Bench_enabled("vector icon"))
+  {
+    return;
+  }
+
+  for (uint32_t mode = 0; mode < 2U; mode++)
+  {
+    lv_obj_t *screen = blank_screen_load();
+    int64_t heapBefore = Bench_heap_used();
+    for (uint32_t i = 0; i < ICON_COUNT; i++)
+    {
+      lv_color_t color = lv_palette_main((i % 2U == 0U) ? LV_PALETTE_ORANGE : LV_PALETTE_RED);
+      if (mode == 0U)
+      {
+        /* Tessellated and rasterized on every draw */
+        icons[i] = lv_obj_create(screen);
+        lv_obj_remove_style_all(icons[i]);
+        lv_obj_set_size(icons[i], ICON_SIZE, ICON_SIZE);
+        lv_obj_set_style_text_color(icons[i], color, 0);
+        lv_obj_add_event_cb(icons[i], live_icon_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+      }
+      else
+      {
+        icons[i] = VectorIcon_create(screen, &warningIcon, ICON_SIZE, color);
+      }
+      lv_obj_set_pos(icons[i], (int32_t) (i % ICON_COLUMNS) * 100 + 26, (int32_t) (i / ICON_COLUMNS) * 80 + 16);
+    }
+    lv_refr_now(NULL);
+
+    /* Every icon redrawn, e.g. by a screen change or a blinking alarm banner */
+    Bench_series_t *redraw = Bench_series("vector icon redraw", params[mode]);
+    redraw->itemsPerSample = ICON_COUNT;
+    redraw->heapDelta = Bench_heap_used() - heapBefore;
+    for (uint32_t i = 0; i < Bench_iterations(); i++)
+    {
+      lv_obj_invalidate(screen);
+      Bench_sample(redraw, render_us());
+    }
+
+    lv_screen_load(lv_obj_create(NULL));
+    lv_obj_delete(screen);
+  }
+
+  VectorIcon_key_t keys[16];
+  for (uint32_t k = 0; k < 16U; k++)
+  {
+    keys[k].src = &warningIcon;
+    keys[k].size = ICON_SIZE;
+    keys[k].rotation = (int32_t) k * 225;
+    keys[k].color = lv_palette_main(LV_PALETTE_ORANGE);
+  }
+  Bench_series_t *prewarm = Bench_series("vector icon prewarm", "16 rotations");
+  prewarm->itemsPerSample = 16;
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    VectorIcon_clear_cache();
+    uint64_t start = Bench_now_us();
+    (void) VectorIcon_prewarm(keys, 16);
+    Bench_sample(prewarm, (double) (Bench_now_us() - start));
+  }
+  VectorIcon_clear_cache();
+}
+
+void BenchCases_sensor_ingest(void)
+{
+  char params[BENCH_NAME_LEN];
+  char text[32];
+
+  if (!Bench_enabled("sensor ingest"))
+  {
+    return;
+  }
+
+  const SimDescriptor_t *desc = SimDescriptor_get();
+  SensorIngest_reset();
+  lv_snprintf(params, sizeof(params), "%u sensors", (unsigned) desc->sensorCount);
+  Bench_series_t *format = Bench_series("sensor ingest per widget", params);
+  Bench_series_t *ingest = Bench_series("sensor ingest snapshot", params);
+  format->itemsPerSample = desc->sensorCount;
+  ingest->itemsPerSample = desc->sensorCount;
+
+  for (uint32_t i = 0; i < Bench_iterations(); i++)
+  {
+    for (uint32_t s = 0; s < desc->sensorCount; s++)
+    {
+      SimSensors_set_value(s, (int32_t) ((i * 7U + s * 13U) % 1000U), i);
+    }
+
+    /* What each value widget did on its own: descriptor lookup, scaling and formatting */
+    uint64_t start = Bench_now_us();
+    for (uint32_t s = 0; s < desc->sensorCount; s++)
+    {
+      SensorBinding_format_value(s, SimSensors_get_value(s), text, sizeof(text));
+    }
+    Bench_sample(format, (double) (Bench_now_us() - start));
+
+    start = Bench_now_us();
+    SensorIngest_update(i);
+    Bench_sample(ingest, (double) (Bench_now_us() - start));
+  }
+
+  SimSensors_reset();
+  SensorIngest_reset();
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static double render_us(void)
+{
+  uint64_t start = Bench_now_us();
+  lv_refr_now(NULL);
+  return (double) (Bench_now_us() - start);
+}
+
+static lv_obj_t *blank_screen_load(void)
+{
+  lv_obj_t *screen = lv_obj_create(NULL);
+  lv_screen_load(screen);
+  lv_refr_now(NULL);
+
+  return screen;
+}
+
+/** Stand-in for a sensor overview: value label and bar per sensor */
+static lv_obj_t *overview_create(void *user)
+{
+  LV_UNUSED(user);
+
+  lv_obj_t *screen = lv_obj_create(NULL);
+  int32_t cellW = 800 / LABEL_COLUMNS;
+  int32_t cellH = 480 / (LABEL_COUNT / LABEL_COLUMNS);
+  for (uint32_t i = 0; i < LABEL_COUNT; i++)
+  {
+    int32_t x = (int32_t) (i % LABEL_COLUMNS) * cellW;
+    int32_t y = (int32_t) (i / LABEL_COLUMNS) * cellH;
+    lv_obj_t *label = lv_label_create(screen);
+    lv_obj_set_pos(label, x, y);
+    lv_obj_t *bar = lv_bar_create(screen);
+    lv_obj_set_pos(bar, x, y + cellH / 2);
+    lv_obj_set_size(bar, cellW - 8, cellH / 3);
+  }
+
+  return screen;
+}
+
+/** Children alternate label, bar */
+static void overview_update(lv_obj_t *screen, void *user)
+{
+  LV_UNUSED(user);
+
+  overviewTick++;
+  for (uint32_t i = 0; i < LABEL_COUNT; i++)
+  {
+    int32_t value = (int32_t) ((overviewTick * 3U + i * 17U) % 100U);
+    lv_label_set_text_fmt(lv_obj_get_child(screen, (int32_t) (i * 2U)), "%" LV_PRId32 " %%LEL", value);
+    lv_bar_set_value(lv_obj_get_child(screen, (int32_t) (i * 2U + 1U)), value, LV_ANIM_OFF);
+  }
+}
+
+/** Stand-in for the ClockWindow dial: frame, scale with minute ticks and hour labels, title */
+static lv_obj_t *dial_create(lv_obj_t *parent)
+{
+  lv_obj_t *dial = lv_obj_create(parent);
+  lv_obj_set_size(dial, DIAL_SIZE, DIAL_SIZE);
+  lv_obj_center(dial);
+  lv_obj_set_style_radius(dial, LV_RADIUS_CIRCLE, 0);
+  lv_obj_set_style_border_width(dial, 6, 0);
+  lv_obj_set_style_shadow_width(dial, 20, 0);
+  lv_obj_remove_flag(dial, LV_OBJ_FLAG_SCROLLABLE);
+
+  lv_obj_t *scale = lv_scale_create(dial);
+  lv_obj_set_size(scale, DIAL_SIZE - 40, DIAL_SIZE - 40);
+  lv_obj_center(scale);
+  lv_scale_set_mode(scale, LV_SCALE_MODE_ROUND_INNER);
+  lv_scale_set_angle_range(scale, 360);
+  lv_scale_set_rotation(scale, 270);
+  lv_scale_set_range(scale, 0, 60);
+  lv_scale_set_total_tick_count(scale, DIAL_TICKS);
+  lv_scale_set_major_tick_every(scale, 5);
+  lv_scale_set_label_show(scale, true);
+
+  lv_obj_t *title = lv_label_create(dial);
+  lv_label_set_text(title, "CANLineX2");
+  lv_obj_align(title, LV_ALIGN_CENTER, 0, 60);
+
+  return dial;
+}
+
+/** A rounded warning triangle with an exclamation mark */
+static void warning_icon_draw(lv_vector_dsc_t *dsc, float size, lv_color_t color)
+{
+  lv_vector_path_t *path = lv_vector_path_create(LV_VECTOR_PATH_QUALITY_MEDIUM);
+  lv_fpoint_t top = { size / 2.0f, size * 0.08f };
+  lv_fpoint_t right = { size * 0.96f, size * 0.9f };
+  lv_fpoint_t left = { size * 0.04f, size * 0.9f };
+  lv_vector_path_move_to(path, &top);
+  lv_vector_path_line_to(path, &right);
+  lv_vector_path_line_to(path, &left);
+  lv_vector_path_close(path);
+  lv_vector_dsc_set_fill_color(dsc, color);
+  lv_vector_dsc_set_stroke_color(dsc, color);
+  lv_vector_dsc_set_stroke_width(dsc, size * 0.06f);
+  lv_vector_dsc_set_stroke_join(dsc, LV_VECTOR_STROKE_JOIN_ROUND);
+  lv_vector_dsc_add_path(dsc, path);
+
+  lv_vector_path_clear(path);
+  lv_area_t bar = { (int32_t) (size * 0.46f), (int32_t) (size * 0.34f), (int32_t) (size * 0.54f),
+                    (int32_t) (size * 0.64f) };
+  lv_fpoint_t dot = { size / 2.0f, size * 0.76f };
+  lv_vector_path_append_rect(path, &bar, size * 0.04f, size * 0.04f);
+  lv_vector_path_append_circle(path, &dot, size * 0.05f, size * 0.05f);
+  lv_vector_dsc_set_fill_color(dsc, lv_color_white());
+  lv_vector_dsc_set_stroke_opa(dsc, LV_OPA_TRANSP);
+  lv_vector_dsc_add_path(dsc, path);
+  lv_vector_path_delete(path);
+}
+
+static void live_icon_draw_cb(lv_event_t *e)
+{
+  lv_obj_t *obj = lv_event_get_target(e);
+  lv_area_t coords;
+  lv_obj_get_coords(obj, &coords);
+
+  lv_vector_dsc_t *dsc = lv_vector_dsc_create(lv_event_get_layer(e));
+  lv_vector_dsc_translate(dsc, (float) coords.x1, (float) coords.y1);
+  warning_icon_draw(dsc, (float) lv_area_get_width(&coords), lv_obj_get_style_text_color(obj, LV_PART_MAIN));
+  lv_draw_vector(dsc);
+  lv_vector_dsc_delete(dsc);
+}
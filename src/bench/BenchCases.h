@@ -0,0 +1,82 @@
+/**
+ * @file BenchCases.h
+ * Benchmark cases of the `bench` target. Every case expects LVGL and a
+ * headless display to be initialized and cleans up its own screens.
+ */
+
+#ifndef BENCH_CASES_H
+#define BENCH_CASES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Walk the DisplayStateMachine with a key sequence and measure every pass that
+ * switches the screen. The sequence should be a round trip back to the start
+ * screen, so step n reaches the same screen in every iteration.
+ */
+void BenchCases_display_state_machine(const char *const *keys, uint32_t keyCount);
+
+/** Load and redraw the ClockWindow */
+void BenchCases_clock_window(void);
+
+/** Create, update and delete charts with 1..128 series */
+void BenchCases_chart(void);
+
+/** Update and redraw a bank of 128 value labels, as lv_label and as NumLabel */
+void BenchCases_labels(void);
+
+/** 128 bars as lv_bar objects versus one BarBank, 1/8 of the values change per update */
+void BenchCases_bars(void);
+
+/** Create a SensorList of all descriptor sensors and scroll through it row by row */
+void BenchCases_sensor_list(void);
+
+/** Append rows to a trend store file and read chart pages back */
+void BenchCases_trend_store(const char *path);
+
+/**
+ * 24 h of 1 s samples: memory and chart decode of CompressedHistory against
+ * uncompressed (time, value) samples
+ */
+void BenchCases_compressed_history(void);
+
+/** Filtered queries on a journal of 100k alarm events against a linear scan */
+void BenchCases_event_journal(void);
+
+/**
+ * Alarm level evaluation, scalar reference against the vector kernel, after
+ * a fuzz comparison of both
+ */
+void BenchCases_alarm_kernel(void);
+
+/** Switch between two sensor overview screens, rebuilt versus cached */
+void BenchCases_screen_cache(void);
+
+/** RGB565 to XRGB8888 conversion of a frame and of a small dirty area, scalar against SIMD */
+void BenchCases_rgb565_blit(void);
+
+/** A clock face updated every second, the dial drawn live against a cached StaticLayer */
+void BenchCases_static_layer(void);
+
+/** 48 vector icons redrawn live against cached VectorIcon bitmaps, and prewarming */
+void BenchCases_vector_icons(void);
+
+/** Per-widget scaling and formatting of all sensor values against one SensorIngest update */
+void BenchCases_sensor_ingest(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*BENCH_CASES_H*/
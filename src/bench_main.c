@@ -0,0 +1,170 @@
+/**
+ * @file bench_main.c
+ * Benchmarks of the CANLineX2Graphics screens and the widgets they are built from.
+ *
+ * Usage: bench [-n iterations] [-o results.json] [-k keys.txt] [-f filter] [-c 565|8888]
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "lvgl/lvgl.h"
+
+#include "hal/hal.h"
+#include "bench/Bench.h"
+#include "bench/BenchCases.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define MAX_KEYS 64
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static uint32_t load_keys(const char *path);
+static void print_usage(const char *program);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/** Default menu round trip: into the menu, one entry down and back out */
+static const char *keys[MAX_KEYS] = { "Return", "Down", "Return", "Escape", "Up", "Escape" };
+static uint32_t keyCount = 6;
+static char keyNames[MAX_KEYS][16];
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+int main(int argc, char **argv)
+{
+  const char *output = NULL;
+  bool rgb565 = false;
+
+  for (int i = 1; i < argc; i += 2)
+  {
+    const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    if (value == NULL)
+    {
+      print_usage(argv[0]);
+      return 1;
+    }
+    if (strcmp(argv[i], "-n") == 0)
+    {
+      Bench_set_iterations((uint32_t) strtoul(value, NULL, 10));
+    }
+    else if (strcmp(argv[i], "-o") == 0)
+    {
+      output = value;
+    }
+    else if (strcmp(argv[i], "-k") == 0)
+    {
+      keyCount = load_keys(value);
+    }
+    else if (strcmp(argv[i], "-f") == 0)
+    {
+      Bench_set_filter(value);
+    }
+    else if (strcmp(argv[i], "-c") == 0 && (strcmp(value, "565") == 0 || strcmp(value, "8888") == 0))
+    {
+      rgb565 = strcmp(value, "565") == 0;
+    }
+    else
+    {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  lv_init();
+  lv_display_t *disp = headless_hal_init(800, 480);
+  if (disp == NULL)
+  {
+    fprintf(stderr, "bench: cannot create the display\n");
+    return 1;
+  }
+  /* The screens render like on the 16-bit panel */
+  if (rgb565 && !hal_rgb565_enable(disp))
+  {
+    fprintf(stderr, "bench: cannot render in RGB565\n");
+    return 1;
+  }
+
+  BenchCases_chart();
+  BenchCases_labels();
+  BenchCases_bars();
+  BenchCases_sensor_list();
+  BenchCases_trend_store("bench_trend.bin");
+  BenchCases_compressed_history();
+  BenchCases_event_journal();
+  BenchCases_alarm_kernel();
+  BenchCases_sensor_ingest();
+  BenchCases_screen_cache();
+  BenchCases_rgb565_blit();
+  BenchCases_static_layer();
+  BenchCases_vector_icons();
+  BenchCases_clock_window();
+  /* Last, the state machine keeps its screens alive */
+  BenchCases_display_state_machine(keys, keyCount);
+
+  FILE *out = (output != NULL) ? fopen(output, "w") : stdout;
+  if (out == NULL)
+  {
+    fprintf(stderr, "bench: cannot write %s\n", output);
+    return 1;
+  }
+  Bench_write_json(out);
+  if (out != stdout)
+  {
+    fclose(out);
+  }
+
+  return 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/** One SDL key name per line, as passed to ConfigurationHandler_SetKeyValue() */
+static uint32_t load_keys(const char *path)
+{
+  char line[64];
+  uint32_t count = 0;
+
+  FILE *in = fopen(path, "r");
+  if (in == NULL)
+  {
+    fprintf(stderr, "bench: cannot read %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+  while (count < MAX_KEYS && fgets(line, sizeof(line), in) != NULL)
+  {
+    if (line[0] == '#' || sscanf(line, "%15s", keyNames[count]) != 1)
+    {
+      continue;
+    }
+    keys[count] = keyNames[count];
+    count++;
+  }
+  fclose(in);
+
+  return count;
+}
+
+static void print_usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [-n iterations] [-o results.json] [-k keys.txt] [-f filter] [-c 565|8888]\n"
+          "  -n  iterations per case (default: 200)\n"
+          "  -o  write the JSON results to a file instead of stdout\n"
+          "  -k  key sequence that walks the DisplayStateMachine screens, one SDL key name per line\n"
+          "  -f  run only the cases whose name contains the filter\n"
+          "  -c  color format the screens render in, 565 like the panel (default: 8888)\n",
+          program);
+}
@@ -0,0 +1,101 @@
+/**
+ * @file fleet_main.c
+ * Entry point of the multi-instance fleet simulator.
+ *
+ * Usage: fleet [-n instances] [-t threads] [-c columns] [-s scale] [-d seconds] [--headless] [-m module]
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sim/SimFleet.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#ifndef SIM_PANEL_MODULE_PATH
+  #define SIM_PANEL_MODULE_PATH "clx2panel.so"
+#endif
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void print_usage(const char *program);
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+int main(int argc, char **argv)
+{
+  SimFleet_config_t config;
+
+  SimFleet_config_init(&config);
+  config.modulePath = SIM_PANEL_MODULE_PATH;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+    if (strcmp(arg, "--headless") == 0)
+    {
+      config.headless = true;
+      continue;
+    }
+    if (value == NULL || arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0')
+    {
+      print_usage(argv[0]);
+      return 1;
+    }
+
+    switch (arg[1])
+    {
+    case 'n':
+      config.instanceCount = (uint32_t) strtoul(value, NULL, 10);
+      break;
+    case 't':
+      config.threadCount = (uint32_t) strtoul(value, NULL, 10);
+      break;
+    case 'c':
+      config.columns = (uint32_t) strtoul(value, NULL, 10);
+      break;
+    case 's':
+      config.scale = strtof(value, NULL);
+      break;
+    case 'd':
+      config.runTimeMs = (uint32_t) (strtod(value, NULL) * 1000.0);
+      break;
+    case 'm':
+      config.modulePath = value;
+      break;
+    default:
+      print_usage(argv[0]);
+      return 1;
+    }
+    i++;
+  }
+
+  return SimFleet_run(&config) ? 0 : 1;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void print_usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [-n instances] [-t threads] [-c columns] [-s scale] [-d seconds] [--headless] [-m module]\n"
+          "  -n  number of panels (default: one per CPU)\n"
+          "  -t  worker threads (default: one per CPU)\n"
+          "  -c  tiles per row in the window (default: square)\n"
+          "  -s  window scale (default: fit to 1920 px)\n"
+          "  -d  stop after the given time and print the step statistics\n"
+          "  -m  panel module to load (default: %s)\n",
+          program, SIM_PANEL_MODULE_PATH);
+}
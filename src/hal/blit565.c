@@ -0,0 +1,181 @@
+/**
+ * @file blit565.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "blit565.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define BLIT565_SSE2 1
+#else
+  #define BLIT565_SSE2 0
+#endif
+
+/*AVX2 is chosen at run time where the compiler can target it per function*/
+#if BLIT565_SSE2 && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #include <immintrin.h>
+  #define BLIT565_AVX2 1
+  #define BLIT565_AVX2_TARGET __attribute__((target("avx2")))
+  #define BLIT565_AVX2_DETECT() __builtin_cpu_supports("avx2")
+#elif BLIT565_SSE2 && defined(__AVX2__)
+  #include <immintrin.h>
+  #define BLIT565_AVX2 1
+  #define BLIT565_AVX2_TARGET
+  #define BLIT565_AVX2_DETECT() 1
+#else
+  #define BLIT565_AVX2 0
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+#if BLIT565_SSE2
+static void blit_sse2(uint32_t * dst, const uint16_t * src, uint32_t count);
+#endif
+#if BLIT565_AVX2
+BLIT565_AVX2_TARGET static void blit_avx2(uint32_t * dst, const uint16_t * src, uint32_t count);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/*0: not detected yet, 1: scalar, 2: SSE2, 3: AVX2*/
+static int impl;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void blit565_to_xrgb8888(uint32_t * dst, const uint16_t * src, uint32_t count)
+{
+  if (impl == 0)
+  {
+    (void) blit565_get_impl();
+  }
+#if BLIT565_AVX2
+  if (impl == 3)
+  {
+    blit_avx2(dst, src, count);
+    return;
+  }
+#endif
+#if BLIT565_SSE2
+  blit_sse2(dst, src, count);
+#else
+  blit565_to_xrgb8888_scalar(dst, src, count);
+#endif
+}
+
+void blit565_to_xrgb8888_scalar(uint32_t * dst, const uint16_t * src, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++)
+  {
+    uint32_t c = src[i];
+    uint32_t r = (c >> 11) & 0x1FU;
+    uint32_t g = (c >> 5) & 0x3FU;
+    uint32_t b = c & 0x1FU;
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+    dst[i] = 0xFF000000U | (r << 16) | (g << 8) | b;
+  }
+}
+
+void blit565_rect(uint8_t * dst, uint32_t dst_stride, const uint8_t * src, uint32_t src_stride,
+                  uint32_t w, uint32_t h)
+{
+  for (uint32_t y = 0; y < h; y++)
+  {
+    blit565_to_xrgb8888((uint32_t *)(dst + (size_t) y * dst_stride), (const uint16_t *)(src + (size_t) y * src_stride),
+                        w);
+  }
+}
+
+const char * blit565_get_impl(void)
+{
+  if (impl == 0)
+  {
+#if BLIT565_AVX2
+    impl = BLIT565_AVX2_DETECT() ? 3 : 2;
+#elif BLIT565_SSE2
+    impl = 2;
+#else
+    impl = 1;
+#endif
+  }
+
+  return (impl == 3) ? "AVX2" : (impl == 2) ? "SSE2" : "scalar";
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#if BLIT565_SSE2
+/**
+ * Eight pixels per step in 16-bit lanes: blue and green form the low half of
+ * each output pixel, red and the opaque alpha the high half, interleaved
+ * into four pixels each.
+ */
+static void blit_sse2(uint32_t * dst, const uint16_t * src, uint32_t count)
+{
+  const __m128i mask5 = _mm_set1_epi16(0x1F);
+  const __m128i mask6 = _mm_set1_epi16(0x3F);
+  const __m128i alpha = _mm_set1_epi16((short) 0xFF00);
+  uint32_t i = 0;
+
+  for (; i + 8U <= count; i += 8U)
+  {
+    __m128i c = _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i r = _mm_srli_epi16(c, 11);
+    __m128i g = _mm_and_si128(_mm_srli_epi16(c, 5), mask6);
+    __m128i b = _mm_and_si128(c, mask5);
+    r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+    g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+    b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+    __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+    __m128i ra = _mm_or_si128(r, alpha);
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128((__m128i *)(dst + i + 4U), _mm_unpackhi_epi16(bg, ra));
+  }
+  blit565_to_xrgb8888_scalar(dst + i, src + i, count - i);
+}
+#endif
+
+#if BLIT565_AVX2
+/** As blit_sse2(), 16 pixels; the interleave works per 128-bit lane, so the halves are put back in order */
+BLIT565_AVX2_TARGET static void blit_avx2(uint32_t * dst, const uint16_t * src, uint32_t count)
+{
+  const __m256i mask5 = _mm256_set1_epi16(0x1F);
+  const __m256i mask6 = _mm256_set1_epi16(0x3F);
+  const __m256i alpha = _mm256_set1_epi16((short) 0xFF00);
+  uint32_t i = 0;
+
+  for (; i + 16U <= count; i += 16U)
+  {
+    __m256i c = _mm256_loadu_si256((const __m256i *)(src + i));
+    __m256i r = _mm256_srli_epi16(c, 11);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi16(c, 5), mask6);
+    __m256i b = _mm256_and_si256(c, mask5);
+    r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+    g = _mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4));
+    b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+    __m256i bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+    __m256i ra = _mm256_or_si256(r, alpha);
+    __m256i lo = _mm256_unpacklo_epi16(bg, ra); /*pixels 0..3, 8..11*/
+    __m256i hi = _mm256_unpackhi_epi16(bg, ra); /*pixels 4..7, 12..15*/
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i *)(dst + i + 8U), _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+  blit_sse2(dst + i, src + i, count - i);
+}
+#endif
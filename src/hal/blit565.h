@@ -0,0 +1,47 @@
+/**
+ * @file blit565.h
+ * RGB565 to XRGB8888 conversion for presenting a 16-bit frame.
+ *
+ * The channels are widened by bit replication (r8 = r5 << 3 | r5 >> 2), so
+ * black and white stay exact and every 565 color maps to one 8888 color,
+ * the way the panel shows it. blit565_to_xrgb8888() uses AVX2 when the CPU
+ * has it, else SSE2, else blit565_to_xrgb8888_scalar(), which is the
+ * reference; all give the same pixels.
+ */
+
+#ifndef BLIT565_H
+#define BLIT565_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Convert `count` pixels, `dst` and `src` need no alignment */
+void blit565_to_xrgb8888(uint32_t * dst, const uint16_t * src, uint32_t count);
+
+void blit565_to_xrgb8888_scalar(uint32_t * dst, const uint16_t * src, uint32_t count);
+
+/**
+ * Convert a rectangle of `w` x `h` pixels between buffers with their own
+ * stride in bytes
+ */
+void blit565_rect(uint8_t * dst, uint32_t dst_stride, const uint8_t * src, uint32_t src_stride,
+                  uint32_t w, uint32_t h);
+
+/** "AVX2", "SSE2" or "scalar", whichever blit565_to_xrgb8888() runs */
+const char * blit565_get_impl(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*BLIT565_H*/
@@ -0,0 +1,905 @@
+/**
+ * @file frame_stream.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#ifndef _DEFAULT_SOURCE
+  #define _DEFAULT_SOURCE /* needed for the socket API */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <arpa/inet.h>
+  #include <netinet/in.h>
+  #include <netinet/tcp.h>
+  #include <sys/socket.h>
+  #include <sys/un.h>
+#endif
+
+#include "frame_stream.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define KEY_MAGIC "CLXK"
+#define FRAME_MAGIC "CLXF"
+#define KEY_MSG_MAX (5U + 255U)
+#define HASH_PRIME 0x100000001B3ULL
+#define HASH_BASIS 0xCBF29CE484222325ULL
+
+#ifndef MSG_NOSIGNAL
+  #define MSG_NOSIGNAL 0
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  int fd;                 /**< -1 if the slot is free */
+  uint8_t * pending;      /**< queued bytes the socket did not take yet */
+  size_t pending_len;
+  size_t pending_off;
+  size_t pending_cap;
+  uint8_t in[KEY_MSG_MAX];
+  uint32_t in_len;
+  bool need_key;
+} client_t;
+
+struct _frame_stream_t {
+  int listen_fd;
+  char unix_path[128];
+  uint32_t width;
+  uint32_t height;
+  uint32_t cols;
+  uint32_t rows;
+  uint64_t * hashes;      /**< per tile, of the pixels sent last */
+  uint8_t * dirty;        /**< per tile */
+  bool any_dirty;
+  bool have_format;
+  frame_stream_format_t format;
+  uint32_t seq;
+  uint8_t * msg;
+  size_t msg_cap;
+  uint8_t * tile_px;      /**< one tile in the wire format */
+  client_t clients[FRAME_STREAM_MAX_CLIENTS];
+  frame_stream_key_cb_t key_cb;
+  void * key_user;
+  frame_stream_stats_t stats;
+};
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+#ifndef _WIN32
+static int address_resolve(const char * address, struct sockaddr_storage * sa, socklen_t * len);
+static void accept_clients(frame_stream_t * stream);
+static void read_client(frame_stream_t * stream, client_t * client);
+static void flush_client(frame_stream_t * stream, client_t * client);
+static void close_client(frame_stream_t * stream, client_t * client);
+static bool queue_client(frame_stream_t * stream, client_t * client, const uint8_t * data, size_t len);
+#endif
+static size_t encode_frame(frame_stream_t * stream, const uint8_t * frame, uint32_t stride, frame_stream_src_t src,
+                           bool key);
+static uint32_t extract_tile(const frame_stream_t * stream, const uint8_t * frame, uint32_t stride,
+                             frame_stream_src_t src, uint32_t col, uint32_t row);
+static uint64_t hash_bytes(const uint8_t * data, size_t len);
+static void put_le(uint8_t * dst, uint32_t value, uint32_t bytes);
+static uint32_t get_le(const uint8_t * src, uint32_t bytes);
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+#ifndef _WIN32
+
+frame_stream_t * frame_stream_open(const char * address, uint32_t width, uint32_t height)
+{
+  struct sockaddr_storage sa;
+  socklen_t sa_len;
+  int one = 1;
+
+  if (width == 0U || height == 0U || width > 0xFFFFU || height > 0xFFFFU ||
+      address_resolve(address, &sa, &sa_len) != 0)
+  {
+    return NULL;
+  }
+
+  frame_stream_t * stream = calloc(1, sizeof(frame_stream_t));
+  if (stream == NULL)
+  {
+    return NULL;
+  }
+  stream->width = width;
+  stream->height = height;
+  stream->cols = (width + FRAME_STREAM_TILE_SIZE - 1U) / FRAME_STREAM_TILE_SIZE;
+  stream->rows = (height + FRAME_STREAM_TILE_SIZE - 1U) / FRAME_STREAM_TILE_SIZE;
+  stream->hashes = calloc((size_t) stream->cols * stream->rows, sizeof(uint64_t));
+  stream->dirty = calloc((size_t) stream->cols * stream->rows, 1);
+  stream->tile_px = malloc(FRAME_STREAM_TILE_SIZE * FRAME_STREAM_TILE_SIZE * 3U);
+  for (uint32_t i = 0; i < FRAME_STREAM_MAX_CLIENTS; i++)
+  {
+    stream->clients[i].fd = -1;
+  }
+
+  stream->listen_fd = socket(sa.ss_family, SOCK_STREAM, 0);
+  if (stream->hashes == NULL || stream->dirty == NULL || stream->tile_px == NULL || stream->listen_fd < 0)
+  {
+    frame_stream_close(stream);
+    return NULL;
+  }
+  if (sa.ss_family == AF_UNIX)
+  {
+    /* A stale socket file of an earlier run would make bind() fail */
+    const struct sockaddr_un * sun = (const struct sockaddr_un *) &sa;
+    snprintf(stream->unix_path, sizeof(stream->unix_path), "%s", sun->sun_path);
+    unlink(stream->unix_path);
+  }
+  else
+  {
+    setsockopt(stream->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  }
+  if (bind(stream->listen_fd, (const struct sockaddr *) &sa, sa_len) != 0 ||
+      listen(stream->listen_fd, (int) FRAME_STREAM_MAX_CLIENTS) != 0 ||
+      fcntl(stream->listen_fd, F_SETFL, fcntl(stream->listen_fd, F_GETFL, 0) | O_NONBLOCK) != 0)
+  {
+    stream->unix_path[0] = '\0';
+    frame_stream_close(stream);
+    return NULL;
+  }
+
+  return stream;
+}
+
+void frame_stream_close(frame_stream_t * stream)
+{
+  if (stream == NULL)
+  {
+    return;
+  }
+  for (uint32_t i = 0; i < FRAME_STREAM_MAX_CLIENTS; i++)
+  {
+    close_client(stream, &stream->clients[i]);
+  }
+  if (stream->listen_fd >= 0)
+  {
+    close(stream->listen_fd);
+  }
+  if (stream->unix_path[0] != '\0')
+  {
+    unlink(stream->unix_path);
+  }
+  free(stream->hashes);
+  free(stream->dirty);
+  free(stream->tile_px);
+  free(stream->msg);
+  free(stream);
+}
+
+void frame_stream_send(frame_stream_t * stream, const uint8_t * frame, uint32_t stride, frame_stream_src_t src)
+{
+  frame_stream_format_t format = (src == FRAME_STREAM_SRC_RGB565) ? FRAME_STREAM_RGB565 : FRAME_STREAM_BGR888;
+  uint32_t active = 0;
+
+  accept_clients(stream);
+  for (uint32_t i = 0; i < FRAME_STREAM_MAX_CLIENTS; i++)
+  {
+    client_t * client = &stream->clients[i];
+    if (client->fd >= 0)
+    {
+      read_client(stream, client);
+    }
+    if (client->fd >= 0)
+    {
+      flush_client(stream, client);
+    }
+    active += (client->fd >= 0) ? 1U : 0U;
+  }
+  stream->stats.clients = active;
+
+  if (!stream->have_format || format != stream->format)
+  {
+    /* Different pixels on the wire, every viewer starts over */
+    stream->have_format = true;
+    stream->format = format;
+    for (uint32_t i = 0; i < FRAME_STREAM_MAX_CLIENTS; i++)
+    {
+      stream->clients[i].need_key = true;
+    }
+  }
+  if (active == 0U)
+  {
+    /* The next viewer starts with a key frame anyway */
+    memset(stream->dirty, 0, (size_t) stream->cols * stream->rows);
+    stream->any_dirty = false;
+    return;
+  }
+
+  size_t delta_len = stream->any_dirty ? encode_frame(stream, frame, stride, src, false) : 0U;
+  for (uint32_t i = 0; i < FRAME_STREAM_MAX_CLIENTS && delta_len != 0U; i++)
+  {
+    client_t * client = &stream->clients[i];
+    if (client->fd < 0 || client->need_key)
+    {
+      continue;
+    }
+    if (client->pending_off != client->pending_len)
+    {
+      /* Still busy with older frames, it catches up with a key frame */
+      client->need_key = true;
+      stream->stats.dropped++;
+      continue;
+    }
+    queue_client(stream, client, stream->msg, delta_len);
+  }
+
+  size_t key_len = 0;
+  for (uint32_t i = 0; i < FRAME_STREAM_MAX_CLIENTS; i++)
+  {
+    client_t * client = &stream->clients[i];
+    if (client->fd < 0 || !client->need_key || client->pending_off != client->pending_len)
+    {
+      continue;
+    }
+    if (key_len == 0U)
+    {
+      key_len = encode_frame(stream, frame, stride, src, true);
+    }
+    if (key_len != 0U && queue_client(stream, client, stream->msg, key_len))
+    {
+      client->need_key = false;
+    }
+  }
+
+  for (uint32_t i = 0; i < FRAME_STREAM_MAX_CLIENTS; i++)
+  {
+    if (stream->clients[i].fd >= 0)
+    {
+      flush_client(stream, &stream->clients[i]);
+    }
+  }
+}
+
+int frame_stream_connect(const char * address)
+{
+  struct sockaddr_storage sa;
+  socklen_t sa_len;
+
+  if (address_resolve(address, &sa, &sa_len) != 0)
+  {
+    return -1;
+  }
+  int fd = socket(sa.ss_family, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    return -1;
+  }
+  if (connect(fd, (const struct sockaddr *) &sa, sa_len) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+bool frame_stream_send_key(int fd, const char * key_name)
+{
+  uint8_t msg[KEY_MSG_MAX];
+  size_t name_len = strlen(key_name);
+
+  if (name_len == 0U || name_len > 255U)
+  {
+    return false;
+  }
+  memcpy(msg, KEY_MAGIC, 4);
+  msg[4] = (uint8_t) name_len;
+  memcpy(&msg[5], key_name, name_len);
+
+  size_t off = 0;
+  while (off < name_len + 5U)
+  {
+    ssize_t sent = send(fd, msg + off, name_len + 5U - off, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (sent <= 0)
+    {
+      return false;
+    }
+    off += (size_t) sent;
+  }
+
+  return true;
+}
+
+#else /*_WIN32*/
+
+frame_stream_t * frame_stream_open(const char * address, uint32_t width, uint32_t height)
+{
+  (void) address;
+  (void) width;
+  (void) height;
+  return NULL;
+}
+
+void frame_stream_close(frame_stream_t * stream)
+{
+  (void) stream;
+}
+
+void frame_stream_send(frame_stream_t * stream, const uint8_t * frame, uint32_t stride, frame_stream_src_t src)
+{
+  (void) stream;
+  (void) frame;
+  (void) stride;
+  (void) src;
+  (void) encode_frame;
+}
+
+int frame_stream_connect(const char * address)
+{
+  (void) address;
+  return -1;
+}
+
+bool frame_stream_send_key(int fd, const char * key_name)
+{
+  (void) fd;
+  (void) key_name;
+  return false;
+}
+
+#endif /*_WIN32*/
+
+void frame_stream_set_key_cb(frame_stream_t * stream, frame_stream_key_cb_t cb, void * user)
+{
+  stream->key_cb = cb;
+  stream->key_user = user;
+}
+
+void frame_stream_mark(frame_stream_t * stream, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+  if (x1 < 0)
+  {
+    x1 = 0;
+  }
+  if (y1 < 0)
+  {
+    y1 = 0;
+  }
+  if (x2 >= (int32_t) stream->width)
+  {
+    x2 = (int32_t) stream->width - 1;
+  }
+  if (y2 >= (int32_t) stream->height)
+  {
+    y2 = (int32_t) stream->height - 1;
+  }
+  if (x1 > x2 || y1 > y2)
+  {
+    return;
+  }
+
+  for (uint32_t row = (uint32_t) y1 / FRAME_STREAM_TILE_SIZE; row <= (uint32_t) y2 / FRAME_STREAM_TILE_SIZE; row++)
+  {
+    memset(&stream->dirty[row * stream->cols + (uint32_t) x1 / FRAME_STREAM_TILE_SIZE], 1,
+           (uint32_t) x2 / FRAME_STREAM_TILE_SIZE - (uint32_t) x1 / FRAME_STREAM_TILE_SIZE + 1U);
+  }
+  stream->any_dirty = true;
+}
+
+void frame_stream_get_stats(const frame_stream_t * stream, frame_stream_stats_t * stats)
+{
+  *stats = stream->stats;
+}
+
+bool frame_stream_parse_header(const uint8_t * data, frame_stream_header_t * header)
+{
+  if (memcmp(data, FRAME_MAGIC, 4) != 0)
+  {
+    return false;
+  }
+  header->seq = get_le(&data[4], 4);
+  header->width = get_le(&data[8], 2);
+  header->height = get_le(&data[10], 2);
+  header->format = (frame_stream_format_t) data[12];
+  header->flags = data[13];
+  header->tile_size = get_le(&data[14], 2);
+  header->tile_count = get_le(&data[16], 4);
+  header->payload_bytes = get_le(&data[20], 4);
+
+  return header->width != 0U && header->height != 0U && header->tile_size != 0U &&
+         (header->format == FRAME_STREAM_RGB565 || header->format == FRAME_STREAM_BGR888);
+}
+
+uint32_t frame_stream_pixel_size(frame_stream_format_t format)
+{
+  return (format == FRAME_STREAM_RGB565) ? 2U : 3U;
+}
+
+/**
+ * Control byte 0..127: that many plus one literal pixels follow. 128..255:
+ * the following pixel repeats (control - 126) times, 2..129.
+ */
+uint32_t frame_stream_rle_encode(uint8_t * dst, const uint8_t * src, uint32_t count, uint32_t pixel_size)
+{
+  uint32_t out = 0;
+  uint32_t i = 0;
+
+  while (i < count)
+  {
+    uint32_t run = 1;
+    while (i + run < count && run < 129U &&
+           memcmp(src + (size_t) (i + run) * pixel_size, src + (size_t) i * pixel_size, pixel_size) == 0)
+    {
+      run++;
+    }
+    if (run >= 2U)
+    {
+      dst[out++] = (uint8_t) (0x80U | (run - 2U));
+      memcpy(dst + out, src + (size_t) i * pixel_size, pixel_size);
+      out += pixel_size;
+      i += run;
+      continue;
+    }
+
+    /* Literals up to the next pair of equal pixels */
+    uint32_t start = i;
+    uint32_t literals = 1;
+    i++;
+    while (i < count && literals < 128U &&
+           !(i + 1U < count &&
+             memcmp(src + (size_t) i * pixel_size, src + (size_t) (i + 1U) * pixel_size, pixel_size) == 0))
+    {
+      literals++;
+      i++;
+    }
+    dst[out++] = (uint8_t) (literals - 1U);
+    memcpy(dst + out, src + (size_t) start * pixel_size, (size_t) literals * pixel_size);
+    out += literals * pixel_size;
+  }
+
+  return out;
+}
+
+bool frame_stream_rle_decode(uint8_t * dst, uint32_t count, uint32_t pixel_size, const uint8_t * src,
+                             uint32_t src_len)
+{
+  uint32_t i = 0;
+  uint32_t in = 0;
+
+  while (i < count)
+  {
+    if (in >= src_len)
+    {
+      return false;
+    }
+    uint32_t control = src[in++];
+    if (control & 0x80U)
+    {
+      uint32_t run = (control & 0x7FU) + 2U;
+      if (in + pixel_size > src_len || i + run > count)
+      {
+        return false;
+      }
+      for (uint32_t k = 0; k < run; k++)
+      {
+        memcpy(dst + (size_t) (i + k) * pixel_size, src + in, pixel_size);
+      }
+      in += pixel_size;
+      i += run;
+    }
+    else
+    {
+      uint32_t literals = control + 1U;
+      if (in + literals * pixel_size > src_len || i + literals > count)
+      {
+        return false;
+      }
+      memcpy(dst + (size_t) i * pixel_size, src + in, (size_t) literals * pixel_size);
+      in += literals * pixel_size;
+      i += literals;
+    }
+  }
+
+  return in == src_len;
+}
+
+uint32_t frame_stream_rle_bound(uint32_t count, uint32_t pixel_size)
+{
+  return count * pixel_size + (count + 127U) / 128U;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#ifndef _WIN32
+
+/** "unix:<path>", "<host>:<port>" or "<port>" */
+static int address_resolve(const char * address, struct sockaddr_storage * sa, socklen_t * len)
+{
+  memset(sa, 0, sizeof(*sa));
+  if (address == NULL)
+  {
+    return -1;
+  }
+
+  if (strncmp(address, "unix:", 5) == 0)
+  {
+    struct sockaddr_un * sun = (struct sockaddr_un *) sa;
+    if (strlen(address + 5) == 0U || strlen(address + 5) >= sizeof(sun->sun_path))
+    {
+      return -1;
+    }
+    sun->sun_family = AF_UNIX;
+    strcpy(sun->sun_path, address + 5);
+    *len = (socklen_t) sizeof(struct sockaddr_un);
+    return 0;
+  }
+
+  char host[64] = "127.0.0.1";
+  const char * colon = strrchr(address, ':');
+  const char * port = address;
+  if (colon != NULL)
+  {
+    size_t host_len = (size_t) (colon - address);
+    if (host_len == 0U || host_len >= sizeof(host))
+    {
+      return -1;
+    }
+    memcpy(host, address, host_len);
+    host[host_len] = '\0';
+    port = colon + 1;
+  }
+
+  struct sockaddr_in * sin = (struct sockaddr_in *) sa;
+  char * end;
+  unsigned long number = strtoul(port, &end, 10);
+  if (*port == '\0' || *end != '\0' || number == 0U || number > 65535U ||
+      inet_pton(AF_INET, host, &sin->sin_addr) != 1)
+  {
+    return -1;
+  }
+  sin->sin_family = AF_INET;
+  sin->sin_port = htons((uint16_t) number);
+  *len = (socklen_t) sizeof(struct sockaddr_in);
+
+  return 0;
+}
+
+static void accept_clients(frame_stream_t * stream)
+{
+  int one = 1;
+
+  while (1)
+  {
+    int fd = accept(stream->listen_fd, NULL, NULL);
+    if (fd < 0)
+    {
+      return;
+    }
+
+    client_t * client = NULL;
+    for (uint32_t i = 0; i < FRAME_STREAM_MAX_CLIENTS && client == NULL; i++)
+    {
+      client = (stream->clients[i].fd < 0) ? &stream->clients[i] : NULL;
+    }
+    if (client == NULL || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0)
+    {
+      close(fd);
+      continue;
+    }
+    if (stream->unix_path[0] == '\0')
+    {
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+#ifdef SO_NOSIGPIPE
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    client->fd = fd;
+    client->pending_len = 0;
+    client->pending_off = 0;
+    client->in_len = 0;
+    client->need_key = true;
+  }
+}
+
+/** Key messages of the viewer, a malformed one disconnects it */
+static void read_client(frame_stream_t * stream, client_t * client)
+{
+  while (client->fd >= 0)
+  {
+    ssize_t received = recv(client->fd, client->in + client->in_len, KEY_MSG_MAX - client->in_len, 0);
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+    {
+      close_client(stream, client);
+      return;
+    }
+    if (received < 0)
+    {
+      return;
+    }
+    client->in_len += (uint32_t) received;
+
+    while (client->in_len >= 5U)
+    {
+      if (memcmp(client->in, KEY_MAGIC, 4) != 0 || client->in[4] == 0U)
+      {
+        close_client(stream, client);
+        return;
+      }
+      uint32_t msg_len = 5U + client->in[4];
+      if (client->in_len < msg_len)
+      {
+        break;
+      }
+      char name[256];
+      memcpy(name, &client->in[5], client->in[4]);
+      name[client->in[4]] = '\0';
+      client->in_len -= msg_len;
+      memmove(client->in, client->in + msg_len, client->in_len);
+      if (stream->key_cb != NULL)
+      {
+        stream->key_cb(name, stream->key_user);
+      }
+    }
+  }
+}
+
+static void flush_client(frame_stream_t * stream, client_t * client)
+{
+  while (client->pending_off < client->pending_len)
+  {
+    ssize_t sent = send(client->fd, client->pending + client->pending_off,
+                        client->pending_len - client->pending_off, MSG_NOSIGNAL);
+    if (sent > 0)
+    {
+      client->pending_off += (size_t) sent;
+      stream->stats.bytes_sent += (uint64_t) sent;
+    }
+    else if (sent < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      return;
+    }
+    else
+    {
+      close_client(stream, client);
+      return;
+    }
+  }
+  client->pending_len = 0;
+  client->pending_off = 0;
+}
+
+static void close_client(frame_stream_t * stream, client_t * client)
+{
+  (void) stream;
+
+  if (client->fd >= 0)
+  {
+    close(client->fd);
+  }
+  client->fd = -1;
+  free(client->pending);
+  client->pending = NULL;
+  client->pending_cap = 0;
+  client->pending_len = 0;
+  client->pending_off = 0;
+}
+
+static bool queue_client(frame_stream_t * stream, client_t * client, const uint8_t * data, size_t len)
+{
+  if (client->pending_len + len > FRAME_STREAM_MAX_PENDING)
+  {
+    close_client(stream, client);
+    return false;
+  }
+  if (client->pending_len + len > client->pending_cap)
+  {
+    size_t cap = (client->pending_len + len) * 2U;
+    uint8_t * grown = realloc(client->pending, cap);
+    if (grown == NULL)
+    {
+      close_client(stream, client);
+      return false;
+    }
+    client->pending = grown;
+    client->pending_cap = cap;
+  }
+  memcpy(client->pending + client->pending_len, data, len);
+  client->pending_len += len;
+
+  return true;
+}
+
+#endif /*_WIN32*/
+
+/**
+ * Encode the dirty tiles whose hash changed, or all tiles for a key frame,
+ * into stream->msg. Returns the message size, 0 if no tile changed.
+ */
+static size_t encode_frame(frame_stream_t * stream, const uint8_t * frame, uint32_t stride, frame_stream_src_t src,
+                           bool key)
+{
+  uint32_t pixel_size = frame_stream_pixel_size(stream->format);
+  size_t len = FRAME_STREAM_HEADER_SIZE;
+  uint32_t tile_count = 0;
+  uint64_t raw_bytes = 0;
+
+  /* Room for every tile to encode at its worst first, so no tile is marked sent for a message that is dropped */
+  size_t tiles = 0;
+  for (uint32_t index = 0; index < stream->cols * stream->rows; index++)
+  {
+    tiles += (key || stream->dirty[index]) ? 1U : 0U;
+  }
+  size_t needed = FRAME_STREAM_HEADER_SIZE +
+                  tiles * (FRAME_STREAM_TILE_HEADER_SIZE +
+                           frame_stream_rle_bound(FRAME_STREAM_TILE_SIZE * FRAME_STREAM_TILE_SIZE, pixel_size));
+  if (needed > stream->msg_cap)
+  {
+    size_t cap = (needed > stream->msg_cap * 2U) ? needed : stream->msg_cap * 2U;
+    uint8_t * grown = realloc(stream->msg, cap);
+    if (grown == NULL)
+    {
+      return 0;
+    }
+    stream->msg = grown;
+    stream->msg_cap = cap;
+  }
+
+  for (uint32_t row = 0; row < stream->rows; row++)
+  {
+    for (uint32_t col = 0; col < stream->cols; col++)
+    {
+      uint32_t index = row * stream->cols + col;
+      if (!key)
+      {
+        if (!stream->dirty[index])
+        {
+          continue;
+        }
+        stream->dirty[index] = 0;
+      }
+
+      uint32_t pixels = extract_tile(stream, frame, stride, src, col, row);
+      uint64_t hash = hash_bytes(stream->tile_px, (size_t) pixels * pixel_size);
+      if (!key && hash == stream->hashes[index])
+      {
+        stream->stats.tiles_unchanged++;
+        continue;
+      }
+      stream->hashes[index] = hash;
+
+      uint32_t bytes = frame_stream_rle_encode(stream->msg + len + FRAME_STREAM_TILE_HEADER_SIZE, stream->tile_px,
+                                               pixels, pixel_size);
+      put_le(stream->msg + len, col, 2);
+      put_le(stream->msg + len + 2, row, 2);
+      put_le(stream->msg + len + 4, bytes, 4);
+      len += FRAME_STREAM_TILE_HEADER_SIZE + bytes;
+      tile_count++;
+      raw_bytes += (uint64_t) pixels * pixel_size;
+    }
+  }
+  if (!key)
+  {
+    stream->any_dirty = false;
+  }
+  if (tile_count == 0U || stream->msg == NULL)
+  {
+    return 0;
+  }
+
+  uint8_t * header = stream->msg;
+  memcpy(header, FRAME_MAGIC, 4);
+  put_le(&header[4], stream->seq++, 4);
+  put_le(&header[8], stream->width, 2);
+  put_le(&header[10], stream->height, 2);
+  header[12] = (uint8_t) stream->format;
+  header[13] = key ? FRAME_STREAM_FLAG_KEY : 0U;
+  put_le(&header[14], FRAME_STREAM_TILE_SIZE, 2);
+  put_le(&header[16], tile_count, 4);
+  put_le(&header[20], (uint32_t) (len - FRAME_STREAM_HEADER_SIZE), 4);
+
+  stream->stats.tiles_sent += tile_count;
+  stream->stats.raw_bytes += raw_bytes;
+  if (key)
+  {
+    stream->stats.key_frames++;
+  }
+  else
+  {
+    stream->stats.frames++;
+  }
+
+  return len;
+}
+
+/** Copy a tile into stream->tile_px in the wire format, returns its pixel count */
+static uint32_t extract_tile(const frame_stream_t * stream, const uint8_t * frame, uint32_t stride,
+                             frame_stream_src_t src, uint32_t col, uint32_t row)
+{
+  uint32_t x0 = col * FRAME_STREAM_TILE_SIZE;
+  uint32_t y0 = row * FRAME_STREAM_TILE_SIZE;
+  uint32_t w = (stream->width - x0 < FRAME_STREAM_TILE_SIZE) ? stream->width - x0 : FRAME_STREAM_TILE_SIZE;
+  uint32_t h = (stream->height - y0 < FRAME_STREAM_TILE_SIZE) ? stream->height - y0 : FRAME_STREAM_TILE_SIZE;
+  uint8_t * dst = stream->tile_px;
+
+  for (uint32_t y = 0; y < h; y++)
+  {
+    const uint8_t * line = frame + (size_t) (y0 + y) * stride;
+    if (src == FRAME_STREAM_SRC_RGB565)
+    {
+      memcpy(dst, line + (size_t) x0 * 2U, (size_t) w * 2U);
+      dst += w * 2U;
+    }
+    else
+    {
+      const uint8_t * px = line + (size_t) x0 * 4U;
+      for (uint32_t x = 0; x < w; x++)
+      {
+        dst[0] = px[0];
+        dst[1] = px[1];
+        dst[2] = px[2];
+        dst += 3;
+        px += 4;
+      }
+    }
+  }
+
+  return w * h;
+}
+
+/** FNV-1a over 64-bit words, then the tail bytes */
+static uint64_t hash_bytes(const uint8_t * data, size_t len)
+{
+  uint64_t hash = HASH_BASIS;
+  size_t i = 0;
+
+  for (; i + 8U <= len; i += 8U)
+  {
+    uint64_t word;
+    memcpy(&word, data + i, 8);
+    hash = (hash ^ word) * HASH_PRIME;
+  }
+  for (; i < len; i++)
+  {
+    hash = (hash ^ data[i]) * HASH_PRIME;
+  }
+
+  return hash ^ (hash >> 29);
+}
+
+static void put_le(uint8_t * dst, uint32_t value, uint32_t bytes)
+{
+  for (uint32_t i = 0; i < bytes; i++)
+  {
+    dst[i] = (uint8_t) (value >> (8U * i));
+  }
+}
+
+static uint32_t get_le(const uint8_t * src, uint32_t bytes)
+{
+  uint32_t value = 0;
+
+  for (uint32_t i = 0; i < bytes; i++)
+  {
+    value |= (uint32_t) src[i] << (8U * i);
+  }
+
+  return value;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file frame_stream.h
+ * Frame streaming to local viewers over a TCP or Unix socket.
+ *
+ * The frame is cut into tiles of FRAME_STREAM_TILE_SIZE pixels. Only tiles in
+ * areas marked dirty are looked at; a tile is sent when the hash of its
+ * pixels differs from the last one sent, compressed with a run-length code
+ * on whole pixels. A viewer that connects, or that fell behind, gets a key
+ * frame with every tile first. Pixels go as RGB565 when the display renders
+ * RGB565 and as 24-bit BGR otherwise, so the viewer sees the exact frame.
+ *
+ * Messages, little endian:
+ * - frame, server to viewer: "CLXF", u32 seq, u16 width, u16 height,
+ *   u8 format, u8 flags, u16 tile size, u32 tile count, u32 payload bytes,
+ *   then per tile u16 column, u16 row, u32 bytes and the compressed pixels
+ * - key, viewer to server: "CLXK", u8 length and the SDL key name
+ *
+ * The encoder and the socket code do not use LVGL, so the viewer shares them.
+ * POSIX only; on Windows frame_stream_open() and frame_stream_connect() fail.
+ */
+
+#ifndef FRAME_STREAM_H
+#define FRAME_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define FRAME_STREAM_TILE_SIZE 32U
+#define FRAME_STREAM_MAX_CLIENTS 8U
+#define FRAME_STREAM_HEADER_SIZE 24U
+#define FRAME_STREAM_TILE_HEADER_SIZE 8U
+#define FRAME_STREAM_FLAG_KEY 0x01U
+/** Unsent bytes a viewer may have queued before it is dropped */
+#define FRAME_STREAM_MAX_PENDING (4U * 1024U * 1024U)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+  FRAME_STREAM_RGB565 = 0,   /**< 2 bytes, as uint16_t */
+  FRAME_STREAM_BGR888 = 1,   /**< 3 bytes, blue first */
+} frame_stream_format_t;
+
+/** Layout of the frame handed to frame_stream_send() */
+typedef enum {
+  FRAME_STREAM_SRC_RGB565 = 0,
+  FRAME_STREAM_SRC_XRGB8888 = 1,
+} frame_stream_src_t;
+
+typedef struct {
+  uint32_t seq;
+  uint32_t width;
+  uint32_t height;
+  frame_stream_format_t format;
+  uint32_t flags;
+  uint32_t tile_size;
+  uint32_t tile_count;
+  uint32_t payload_bytes;
+} frame_stream_header_t;
+
+typedef struct {
+  uint64_t frames;             /**< delta frames with at least one tile */
+  uint64_t key_frames;
+  uint64_t tiles_sent;
+  uint64_t tiles_unchanged;    /**< dirty, but with the same hash */
+  uint64_t raw_bytes;          /**< of the sent tiles, before compression */
+  uint64_t bytes_sent;
+  uint64_t dropped;            /**< deltas a slow viewer missed */
+  uint32_t clients;
+} frame_stream_stats_t;
+
+typedef struct _frame_stream_t frame_stream_t;
+
+typedef void (*frame_stream_key_cb_t)(const char * key_name, void * user);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Listen on `address`: "unix:<path>", "<host>:<port>" or "<port>" (on
+ * 127.0.0.1), for frames of `width` x `height`. NULL on error.
+ */
+frame_stream_t * frame_stream_open(const char * address, uint32_t width, uint32_t height);
+
+void frame_stream_close(frame_stream_t * stream);
+
+/** Keys sent by the viewers, called from frame_stream_send() */
+void frame_stream_set_key_cb(frame_stream_t * stream, frame_stream_key_cb_t cb, void * user);
+
+/** The pixels of the area (inclusive coordinates) may have changed */
+void frame_stream_mark(frame_stream_t * stream, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+/**
+ * Accept viewers, read their keys and send them the changed tiles of
+ * `frame`, a full frame with `stride` bytes per row. Never blocks.
+ */
+void frame_stream_send(frame_stream_t * stream, const uint8_t * frame, uint32_t stride, frame_stream_src_t src);
+
+void frame_stream_get_stats(const frame_stream_t * stream, frame_stream_stats_t * stats);
+
+/** Connect a viewer to `address`, a blocking socket or -1 */
+int frame_stream_connect(const char * address);
+
+/** Send a key name from the viewer */
+bool frame_stream_send_key(int fd, const char * key_name);
+
+/** Parse a frame header, false if the magic or the sizes are wrong */
+bool frame_stream_parse_header(const uint8_t * data, frame_stream_header_t * header);
+
+/** Bytes per pixel of `format` */
+uint32_t frame_stream_pixel_size(frame_stream_format_t format);
+
+/** Compress `count` pixels of `pixel_size` bytes, returns the bytes written to `dst` */
+uint32_t frame_stream_rle_encode(uint8_t * dst, const uint8_t * src, uint32_t count, uint32_t pixel_size);
+
+/** Decompress exactly `count` pixels, false on malformed input */
+bool frame_stream_rle_decode(uint8_t * dst, uint32_t count, uint32_t pixel_size, const uint8_t * src,
+                             uint32_t src_len);
+
+/** Worst case size of frame_stream_rle_encode() */
+uint32_t frame_stream_rle_bound(uint32_t count, uint32_t pixel_size);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*FRAME_STREAM_H*/
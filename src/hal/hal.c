@@ -1,5 +1,82 @@
 #include "hal.h"
+#include "blit565.h"
+#include "lvgl/src/core/lv_obj_class_private.h"
+#include "lvgl/src/display/lv_display_private.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _MSC_VER
+  #include <Windows.h>
+#else
+  #include <time.h>
+#endif
+
+static bool write_le(FILE * f, uint32_t value, uint32_t bytes);
+static void headless_flush_cb(lv_display_t * disp, const lv_area_t * area, uint8_t * px_map);
+static uint32_t headless_tick_get_cb(void);
+static void redraw_invalidate_cb(lv_event_t * e);
+static void redraw_flush_start_cb(lv_event_t * e);
+static void redraw_refr_ready_cb(lv_event_t * e);
+static void redraw_obj_delete_cb(lv_event_t * e);
+static lv_obj_t * redraw_find_obj(lv_obj_t * parent, const lv_area_t * area);
+static int redraw_entry_cmp(const void * a, const void * b);
+static void rgb565_flush_cb(lv_display_t * disp, const lv_area_t * area, uint8_t * px_map);
+static void stream_flush_cb(lv_display_t * disp, const lv_area_t * area, uint8_t * px_map);
+static void stream_timer_cb(lv_timer_t * timer);
+static void stream_key_cb(const char * key_name, void * user);
+
+/*Redraw debugging, kept outside of the LVGL heap to not disturb its statistics*/
+#define REDRAW_CELL_SIZE 8
+#define REDRAW_MAX_OBJS 512
+
+typedef struct {
+  lv_obj_t * obj;         /**< NULL after the object was deleted */
+  const char * class_name;
+  lv_area_t coords;       /**< at the last invalidation */
+  uint32_t invalidations;
+  uint64_t pixels;
+} redraw_obj_t;
+
+typedef struct {
+  lv_display_t * disp;
+  uint16_t * heat;        /**< per cell, decays every frame, 256 = redrawn every frame */
+  int32_t cols;
+  int32_t rows;
+  uint64_t frames;
+  uint64_t flushed_pixels;
+  uint64_t frame_pixels;
+  uint64_t max_frame_pixels;
+  uint64_t full_frames;
+  uint64_t invalidated_pixels;
+  uint64_t unattributed_pixels;
+  redraw_obj_t objs[REDRAW_MAX_OBJS];
+  uint32_t obj_count;
+} redraw_debug_t;
+
+static redraw_debug_t * redraw;
+
+/*RGB565 rendering, one display per process*/
+typedef struct {
+  lv_display_t * disp;
+  lv_draw_buf_t * frame;          /**< 16-bit frame LVGL renders into */
+  lv_draw_buf_t out;              /**< the driver's 32-bit frame, a copy of its descriptor */
+  lv_display_flush_cb_t flush;    /**< the driver's flush */
+  uint64_t converted_pixels;
+} rgb565_t;
+
+static rgb565_t rgb565;
+
+/*Frame streaming, one display per process*/
+typedef struct {
+  lv_display_t * disp;
+  frame_stream_t * stream;
+  lv_display_flush_cb_t flush;    /**< the flush it wraps */
+  lv_timer_t * timer;
+  void (*key_cb)(const char * key_name);
+} stream_t;
+
+static stream_t stream;
 
 lv_display_t * sdl_hal_init(int32_t w, int32_t h)
 {
@@ -32,3 +109,565 @@ lv_display_t * sdl_hal_init(int32_t w, int32_t h)
 
   return disp;
 }
+
+lv_display_t * headless_hal_init(int32_t w, int32_t h)
+{
+  lv_group_set_default(lv_group_create());
+
+  /*Without SDL nobody else provides the tick*/
+  lv_tick_set_cb(headless_tick_get_cb);
+
+  lv_display_t * disp = lv_display_create(w, h);
+  if (disp == NULL)
+  {
+    return NULL;
+  }
+
+  /*One full frame, so the last rendered image is always complete in memory*/
+  lv_color_format_t cf = lv_display_get_color_format(disp);
+  lv_draw_buf_t * buf = lv_draw_buf_create(w, h, cf, LV_STRIDE_AUTO);
+  if (buf == NULL)
+  {
+    lv_display_delete(disp);
+    return NULL;
+  }
+  lv_display_set_draw_buffers(disp, buf, NULL);
+  lv_display_set_render_mode(disp, LV_DISPLAY_RENDER_MODE_DIRECT);
+  lv_display_set_flush_cb(disp, headless_flush_cb);
+  lv_display_set_default(disp);
+
+  return disp;
+}
+
+lv_display_t * stream_hal_init(int32_t w, int32_t h, const char * address)
+{
+  lv_display_t * disp = headless_hal_init(w, h);
+  if (disp == NULL)
+  {
+    return NULL;
+  }
+  if (!hal_stream_enable(disp, address))
+  {
+    lv_display_delete(disp);
+    return NULL;
+  }
+
+  return disp;
+}
+
+bool hal_stream_enable(lv_display_t * disp, const char * address)
+{
+  lv_draw_buf_t * buf = lv_display_get_buf_active(disp);
+  if (stream.disp != NULL || buf == NULL ||
+      (buf->header.cf != LV_COLOR_FORMAT_XRGB8888 && buf->header.cf != LV_COLOR_FORMAT_ARGB8888 &&
+       disp != rgb565.disp) ||
+      disp->render_mode != LV_DISPLAY_RENDER_MODE_DIRECT)
+  {
+    return false;
+  }
+
+  stream.stream = frame_stream_open(address, (uint32_t) lv_display_get_horizontal_resolution(disp),
+                                    (uint32_t) lv_display_get_vertical_resolution(disp));
+  if (stream.stream == NULL)
+  {
+    return false;
+  }
+  stream.timer = lv_timer_create(stream_timer_cb, HAL_STREAM_PERIOD_MS, NULL);
+  if (stream.timer == NULL)
+  {
+    frame_stream_close(stream.stream);
+    stream.stream = NULL;
+    return false;
+  }
+  stream.disp = disp;
+  stream.flush = disp->flush_cb;
+  frame_stream_set_key_cb(stream.stream, stream_key_cb, NULL);
+  lv_display_set_flush_cb(disp, stream_flush_cb);
+
+  return true;
+}
+
+void hal_stream_set_key_cb(void (*cb)(const char * key_name))
+{
+  stream.key_cb = cb;
+}
+
+bool hal_stream_get_stats(frame_stream_stats_t * stats)
+{
+  if (stream.stream == NULL)
+  {
+    return false;
+  }
+  frame_stream_get_stats(stream.stream, stats);
+
+  return true;
+}
+
+bool hal_screenshot_save(lv_display_t * disp, const char * path)
+{
+  lv_draw_buf_t * frame = (disp == rgb565.disp) ? &rgb565.out : lv_display_get_buf_active(disp);
+  if (frame == NULL || (frame->header.cf != LV_COLOR_FORMAT_XRGB8888 && frame->header.cf != LV_COLOR_FORMAT_ARGB8888))
+  {
+    return false;
+  }
+
+  FILE * f = fopen(path, "wb");
+  if (f == NULL)
+  {
+    return false;
+  }
+
+  uint32_t w = frame->header.w;
+  uint32_t h = frame->header.h;
+  uint32_t image_size = w * h * 4U;
+
+  /*BITMAPFILEHEADER + BITMAPINFOHEADER, BI_RGB with 32 bpp is BGRX like XRGB8888 in memory*/
+  /*A full disk must not leave a truncated file that counts as written*/
+  bool ok = fputc('B', f) != EOF && fputc('M', f) != EOF &&
+            write_le(f, 14U + 40U + image_size, 4) &&
+            write_le(f, 0, 4) &&
+            write_le(f, 14U + 40U, 4) &&
+            write_le(f, 40U, 4) &&
+            write_le(f, w, 4) &&
+            write_le(f, h, 4) &&
+            write_le(f, 1, 2) &&
+            write_le(f, 32, 2) &&
+            write_le(f, 0, 4) &&
+            write_le(f, image_size, 4) &&
+            write_le(f, 2835, 4) &&
+            write_le(f, 2835, 4) &&
+            write_le(f, 0, 4) &&
+            write_le(f, 0, 4);
+
+  /*Bottom-up rows*/
+  for (uint32_t y = h; y > 0 && ok; y--)
+  {
+    ok = fwrite(frame->data + (size_t)(y - 1) * frame->header.stride, 4, w, f) == w;
+  }
+
+  return (fclose(f) == 0) && ok;
+}
+
+bool hal_rgb565_enable(lv_display_t * disp)
+{
+  if (rgb565.disp != NULL)
+  {
+    return rgb565.disp == disp;
+  }
+
+  lv_draw_buf_t * out = lv_display_get_buf_active(disp);
+  int32_t w = lv_display_get_horizontal_resolution(disp);
+  int32_t h = lv_display_get_vertical_resolution(disp);
+  if (out == NULL || (out->header.cf != LV_COLOR_FORMAT_XRGB8888 && out->header.cf != LV_COLOR_FORMAT_ARGB8888) ||
+      (int32_t) out->header.w < w || (int32_t) out->header.h < h ||
+      disp->render_mode != LV_DISPLAY_RENDER_MODE_DIRECT)
+  {
+    return false;
+  }
+
+  lv_draw_buf_t * frame = lv_draw_buf_create(w, h, LV_COLOR_FORMAT_RGB565, LV_STRIDE_AUTO);
+  if (frame == NULL)
+  {
+    return false;
+  }
+  rgb565.disp = disp;
+  rgb565.frame = frame;
+  rgb565.out = *out;
+  rgb565.flush = disp->flush_cb;
+  rgb565.converted_pixels = 0;
+
+  /*Buffers first, changing the color format also retypes the active buffers*/
+  lv_display_set_draw_buffers(disp, frame, NULL);
+  lv_display_set_color_format(disp, LV_COLOR_FORMAT_RGB565);
+  lv_display_set_flush_cb(disp, rgb565_flush_cb);
+  lv_obj_invalidate(lv_display_get_screen_active(disp));
+
+  return true;
+}
+
+uint64_t hal_rgb565_get_converted_pixels(void)
+{
+  return rgb565.converted_pixels;
+}
+
+void hal_redraw_debug_enable(lv_display_t * disp, bool en)
+{
+  if (redraw != NULL)
+  {
+    lv_display_remove_event_cb_with_user_data(redraw->disp, redraw_invalidate_cb, NULL);
+    lv_display_remove_event_cb_with_user_data(redraw->disp, redraw_flush_start_cb, NULL);
+    lv_display_remove_event_cb_with_user_data(redraw->disp, redraw_refr_ready_cb, NULL);
+    for (uint32_t i = 0; i < redraw->obj_count; i++)
+    {
+      if (redraw->objs[i].obj != NULL)
+      {
+        lv_obj_remove_event_cb_with_user_data(redraw->objs[i].obj, redraw_obj_delete_cb, &redraw->objs[i]);
+      }
+    }
+    free(redraw->heat);
+    free(redraw);
+    redraw = NULL;
+  }
+  if (!en || disp == NULL)
+  {
+    return;
+  }
+
+  redraw = calloc(1, sizeof(redraw_debug_t));
+  if (redraw == NULL)
+  {
+    return;
+  }
+  redraw->disp = disp;
+  redraw->cols = (lv_display_get_horizontal_resolution(disp) + REDRAW_CELL_SIZE - 1) / REDRAW_CELL_SIZE;
+  redraw->rows = (lv_display_get_vertical_resolution(disp) + REDRAW_CELL_SIZE - 1) / REDRAW_CELL_SIZE;
+  redraw->heat = calloc((size_t)(redraw->cols * redraw->rows), sizeof(uint16_t));
+  if (redraw->heat == NULL)
+  {
+    free(redraw);
+    redraw = NULL;
+    return;
+  }
+
+  lv_display_add_event_cb(disp, redraw_invalidate_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+  lv_display_add_event_cb(disp, redraw_flush_start_cb, LV_EVENT_FLUSH_START, NULL);
+  lv_display_add_event_cb(disp, redraw_refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+  lv_obj_invalidate(lv_display_get_screen_active(disp));
+}
+
+bool hal_redraw_debug_dump(const char * path, uint32_t top_count)
+{
+  if (redraw == NULL)
+  {
+    return false;
+  }
+
+  FILE * f = fopen(path, "w");
+  if (f == NULL)
+  {
+    return false;
+  }
+
+  uint64_t screen_pixels = (uint64_t) lv_display_get_horizontal_resolution(redraw->disp) *
+                           (uint64_t) lv_display_get_vertical_resolution(redraw->disp);
+  uint64_t frames = (redraw->frames != 0U) ? redraw->frames : 1U;
+  fprintf(f, "frames %llu, full screen redraws %llu\n", (unsigned long long) redraw->frames,
+          (unsigned long long) redraw->full_frames);
+  fprintf(f, "flushed px/frame avg %llu (%.1f%% of screen), max %llu\n",
+          (unsigned long long) (redraw->flushed_pixels / frames),
+          100.0 * (double) redraw->flushed_pixels / (double) frames / (double) screen_pixels,
+          (unsigned long long) redraw->max_frame_pixels);
+  fprintf(f, "invalidated px %llu, not attributed %llu\n\n", (unsigned long long) redraw->invalidated_pixels,
+          (unsigned long long) redraw->unattributed_pixels);
+
+  /*Sort a copy, the table keeps its order for the delete callbacks*/
+  redraw_obj_t * sorted = malloc(sizeof(redraw_obj_t) * (redraw->obj_count + 1U));
+  if (sorted == NULL)
+  {
+    fclose(f);
+    return false;
+  }
+  memcpy(sorted, redraw->objs, sizeof(redraw_obj_t) * redraw->obj_count);
+  qsort(sorted, redraw->obj_count, sizeof(redraw_obj_t), redraw_entry_cmp);
+
+  fprintf(f, "%-4s %-12s %-18s %-22s %10s %14s %8s\n", "rank", "pixels/frame", "object", "area", "count",
+          "pixels", "share");
+  for (uint32_t i = 0; i < redraw->obj_count && i < top_count; i++)
+  {
+    const redraw_obj_t * o = &sorted[i];
+    char obj_text[24];
+    char area_text[32];
+    if (o->obj != NULL)
+    {
+      lv_snprintf(obj_text, sizeof(obj_text), "%p", (void *) o->obj);
+    }
+    else
+    {
+      lv_snprintf(obj_text, sizeof(obj_text), "(deleted)");
+    }
+    lv_snprintf(area_text, sizeof(area_text), "%" LV_PRId32 ",%" LV_PRId32 " %" LV_PRId32 "x%" LV_PRId32,
+                o->coords.x1, o->coords.y1, lv_area_get_width(&o->coords), lv_area_get_height(&o->coords));
+    fprintf(f, "%-4u %-12llu %-18s %-22s %10u %14llu %7.1f%%  %s\n", (unsigned) (i + 1U),
+            (unsigned long long) (o->pixels / frames), obj_text, area_text, (unsigned) o->invalidations,
+            (unsigned long long) o->pixels,
+            100.0 * (double) o->pixels / (double) (redraw->invalidated_pixels ? redraw->invalidated_pixels : 1U),
+            o->class_name);
+  }
+  free(sorted);
+
+  return fclose(f) == 0;
+}
+
+static bool write_le(FILE * f, uint32_t value, uint32_t bytes)
+{
+  for (uint32_t i = 0; i < bytes; i++)
+  {
+    if (fputc((int)((value >> (8U * i)) & 0xFFU), f) == EOF)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void headless_flush_cb(lv_display_t * disp, const lv_area_t * area, uint8_t * px_map)
+{
+  LV_UNUSED(area);
+  LV_UNUSED(px_map);
+  lv_display_flush_ready(disp);
+}
+
+/**
+ * Convert the flushed area into the driver's frame and let the driver show
+ * it. The driver sizes its texture upload by the display color format, so
+ * that reads 32 bits while it runs.
+ */
+static void rgb565_flush_cb(lv_display_t * disp, const lv_area_t * area, uint8_t * px_map)
+{
+  lv_area_t clipped;
+  lv_area_t screen = { 0, 0, lv_display_get_horizontal_resolution(disp) - 1,
+                       lv_display_get_vertical_resolution(disp) - 1 };
+  LV_UNUSED(px_map);
+
+  if (lv_area_intersect(&clipped, area, &screen))
+  {
+    uint32_t w = (uint32_t) lv_area_get_width(&clipped);
+    uint32_t h = (uint32_t) lv_area_get_height(&clipped);
+    blit565_rect(rgb565.out.data + (size_t) clipped.y1 * rgb565.out.header.stride + (size_t) clipped.x1 * 4U,
+                 rgb565.out.header.stride,
+                 rgb565.frame->data + (size_t) clipped.y1 * rgb565.frame->header.stride + (size_t) clipped.x1 * 2U,
+                 rgb565.frame->header.stride, w, h);
+    rgb565.converted_pixels += (uint64_t) w * h;
+  }
+
+  disp->color_format = rgb565.out.header.cf;
+  rgb565.flush(disp, area, rgb565.out.data);
+  disp->color_format = LV_COLOR_FORMAT_RGB565;
+}
+
+static void stream_flush_cb(lv_display_t * disp, const lv_area_t * area, uint8_t * px_map)
+{
+  frame_stream_mark(stream.stream, area->x1, area->y1, area->x2, area->y2);
+  stream.flush(disp, area, px_map);
+}
+
+/**
+ * Runs between refreshes, so the frame is complete. An RGB565 display is
+ * streamed from its 16-bit frame, exactly as rendered.
+ */
+static void stream_timer_cb(lv_timer_t * timer)
+{
+  LV_UNUSED(timer);
+
+  if (stream.disp == rgb565.disp)
+  {
+    frame_stream_send(stream.stream, rgb565.frame->data, rgb565.frame->header.stride, FRAME_STREAM_SRC_RGB565);
+    return;
+  }
+  lv_draw_buf_t * buf = lv_display_get_buf_active(stream.disp);
+  if (buf != NULL && (buf->header.cf == LV_COLOR_FORMAT_XRGB8888 || buf->header.cf == LV_COLOR_FORMAT_ARGB8888))
+  {
+    frame_stream_send(stream.stream, buf->data, buf->header.stride, FRAME_STREAM_SRC_XRGB8888);
+  }
+}
+
+static void stream_key_cb(const char * key_name, void * user)
+{
+  LV_UNUSED(user);
+
+  if (stream.key_cb != NULL)
+  {
+    stream.key_cb(key_name);
+  }
+}
+
+static uint32_t headless_tick_get_cb(void)
+{
+#ifdef _MSC_VER
+  return (uint32_t) GetTickCount();
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t) ((uint64_t) now.tv_sec * 1000U + (uint64_t) now.tv_nsec / 1000000U);
+#endif
+}
+
+static void redraw_invalidate_cb(lv_event_t * e)
+{
+  const lv_area_t * area = lv_event_get_param(e);
+  uint64_t pixels = (uint64_t) lv_area_get_size(area);
+  lv_obj_t * obj = NULL;
+
+  redraw->invalidated_pixels += pixels;
+
+  /*Topmost layer first, the system layer holds e.g. the mouse cursor*/
+  lv_obj_t * layers[3] = { lv_display_get_layer_sys(redraw->disp), lv_display_get_layer_top(redraw->disp),
+                           lv_display_get_screen_active(redraw->disp) };
+  for (uint32_t i = 0; i < 3U && obj == NULL; i++)
+  {
+    obj = (layers[i] != NULL) ? redraw_find_obj(layers[i], area) : NULL;
+  }
+
+  redraw_obj_t * entry = NULL;
+  for (uint32_t i = 0; i < redraw->obj_count && entry == NULL && obj != NULL; i++)
+  {
+    entry = (redraw->objs[i].obj == obj) ? &redraw->objs[i] : NULL;
+  }
+  if (entry == NULL && obj != NULL)
+  {
+    if (redraw->obj_count < REDRAW_MAX_OBJS)
+    {
+      entry = &redraw->objs[redraw->obj_count++];
+    }
+    else
+    {
+      /*Full: replace the deleted object with the least pixels*/
+      for (uint32_t i = 0; i < REDRAW_MAX_OBJS; i++)
+      {
+        redraw_obj_t * o = &redraw->objs[i];
+        if (o->obj == NULL && (entry == NULL || o->pixels < entry->pixels))
+        {
+          entry = o;
+        }
+      }
+    }
+  }
+  if (entry != NULL && entry->obj != obj)
+  {
+    memset(entry, 0, sizeof(*entry));
+    entry->obj = obj;
+    entry->class_name = lv_obj_get_class(obj)->name;
+    lv_obj_add_event_cb(obj, redraw_obj_delete_cb, LV_EVENT_DELETE, entry);
+  }
+  if (entry == NULL)
+  {
+    redraw->unattributed_pixels += pixels;
+    return;
+  }
+  if (entry->class_name == NULL)
+  {
+    entry->class_name = "?";
+  }
+  entry->coords = *area;
+  entry->invalidations++;
+  entry->pixels += pixels;
+}
+
+/**
+ * Deepest visible object whose drawing area (coordinates plus shadow, outline
+ * etc.) contains the invalidated area. NULL if not even `parent` does.
+ */
+static lv_obj_t * redraw_find_obj(lv_obj_t * parent, const lv_area_t * area)
+{
+  lv_area_t draw_area;
+  lv_obj_get_coords(parent, &draw_area);
+  lv_area_increase(&draw_area, lv_obj_get_ext_draw_size(parent), lv_obj_get_ext_draw_size(parent));
+  if (!lv_area_is_in(area, &draw_area, 0))
+  {
+    return NULL;
+  }
+
+  for (int32_t i = (int32_t) lv_obj_get_child_count(parent) - 1; i >= 0; i--)
+  {
+    lv_obj_t * child = lv_obj_get_child(parent, i);
+    if (lv_obj_has_flag(child, LV_OBJ_FLAG_HIDDEN))
+    {
+      continue;
+    }
+    lv_obj_t * found = redraw_find_obj(child, area);
+    if (found != NULL)
+    {
+      return found;
+    }
+  }
+
+  return parent;
+}
+
+/**
+ * Count the flushed area into the heat map and tint it. Only the pixels of
+ * the area are touched, so the tint vanishes with the next redraw there.
+ */
+static void redraw_flush_start_cb(lv_event_t * e)
+{
+  const lv_area_t * area = lv_event_get_param(e);
+  lv_draw_buf_t * buf = lv_display_get_buf_active(redraw->disp);
+
+  redraw->frame_pixels += (uint64_t) lv_area_get_size(area);
+  if (buf == NULL || (buf->header.cf != LV_COLOR_FORMAT_XRGB8888 && buf->header.cf != LV_COLOR_FORMAT_ARGB8888))
+  {
+    return;
+  }
+
+  int32_t cx1 = LV_MAX(area->x1, 0) / REDRAW_CELL_SIZE;
+  int32_t cy1 = LV_MAX(area->y1, 0) / REDRAW_CELL_SIZE;
+  int32_t cx2 = LV_MIN(area->x2 / REDRAW_CELL_SIZE, redraw->cols - 1);
+  int32_t cy2 = LV_MIN(area->y2 / REDRAW_CELL_SIZE, redraw->rows - 1);
+  for (int32_t cy = cy1; cy <= cy2; cy++)
+  {
+    for (int32_t cx = cx1; cx <= cx2; cx++)
+    {
+      uint16_t * cell = &redraw->heat[cy * redraw->cols + cx];
+      *cell = (uint16_t) LV_MIN(*cell + 32U, 256U);
+    }
+  }
+
+  /*Direct mode: the buffer is the full frame, other modes hold only the area*/
+  bool full_frame = (int32_t) buf->header.w >= lv_display_get_horizontal_resolution(redraw->disp) &&
+                    (int32_t) buf->header.h >= lv_display_get_vertical_resolution(redraw->disp);
+  int32_t ox = full_frame ? 0 : area->x1;
+  int32_t oy = full_frame ? 0 : area->y1;
+  for (int32_t y = area->y1; y <= area->y2; y++)
+  {
+    uint8_t * row = buf->data + (size_t)(y - oy) * buf->header.stride;
+    const uint16_t * heat_row = &redraw->heat[(y / REDRAW_CELL_SIZE) * redraw->cols];
+    for (int32_t x = area->x1; x <= area->x2; x++)
+    {
+      uint32_t heat = heat_row[x / REDRAW_CELL_SIZE];
+      uint8_t * px = row + (size_t)(x - ox) * 4U;
+      /*Blend 50 % with a blue to red ramp, BGRX byte order*/
+      px[0] = (uint8_t)((px[0] + (255U - LV_MIN(heat, 255U))) / 2U);
+      px[1] = (uint8_t)(px[1] / 2U);
+      px[2] = (uint8_t)((px[2] + LV_MIN(heat, 255U)) / 2U);
+    }
+  }
+}
+
+static void redraw_refr_ready_cb(lv_event_t * e)
+{
+  LV_UNUSED(e);
+
+  if (redraw->frame_pixels == 0U)
+  {
+    return;
+  }
+
+  uint64_t screen_pixels = (uint64_t) lv_display_get_horizontal_resolution(redraw->disp) *
+                           (uint64_t) lv_display_get_vertical_resolution(redraw->disp);
+  redraw->frames++;
+  redraw->flushed_pixels += redraw->frame_pixels;
+  redraw->max_frame_pixels = LV_MAX(redraw->max_frame_pixels, redraw->frame_pixels);
+  redraw->full_frames += (redraw->frame_pixels >= screen_pixels) ? 1U : 0U;
+  redraw->frame_pixels = 0;
+
+  /*Decay by 1/8 per drawn frame: a cell redrawn every frame settles near 224, deep red*/
+  for (int32_t i = 0; i < redraw->cols * redraw->rows; i++)
+  {
+    redraw->heat[i] = (uint16_t)(redraw->heat[i] - redraw->heat[i] / 8U);
+  }
+}
+
+static void redraw_obj_delete_cb(lv_event_t * e)
+{
+  redraw_obj_t * entry = lv_event_get_user_data(e);
+  entry->obj = NULL;
+}
+
+static int redraw_entry_cmp(const void * a, const void * b)
+{
+  const redraw_obj_t * ea = a;
+  const redraw_obj_t * eb = b;
+
+  return (ea->pixels < eb->pixels) - (ea->pixels > eb->pixels);
+}
@@ -7,6 +7,7 @@
 #define LV_VSCODE_HAL_H
 
 #include "lvgl/lvgl.h"
+#include "frame_stream.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -19,6 +20,9 @@ extern "C" {
  *      DEFINES
  *********************/
 
+/** Period of the frame stream, 30 frames per second at most */
+#define HAL_STREAM_PERIOD_MS 33
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -33,6 +37,68 @@ extern "C" {
  */
 lv_display_t * sdl_hal_init(int32_t w, int32_t h);
 
+/**
+ * Initialize a display without window and input devices. The frame is rendered
+ * into a full-size buffer (direct mode) which stays readable through
+ * `lv_display_get_buf_active()`; replace the flush callback to forward it.
+ */
+lv_display_t * headless_hal_init(int32_t w, int32_t h);
+
+/**
+ * Initialize a display without window that streams its frames to viewers
+ * listening on `address` (see frame_stream.h), instead of showing them.
+ * Input comes as keys from the viewers, see hal_stream_set_key_cb().
+ */
+lv_display_t * stream_hal_init(int32_t w, int32_t h, const char * address);
+
+/**
+ * Stream the frames of a display with a full 32-bit or RGB565 frame to
+ * viewers on `address`. The flushed areas are marked and every
+ * HAL_STREAM_PERIOD_MS the tiles that really changed are sent.
+ */
+bool hal_stream_enable(lv_display_t * disp, const char * address);
+
+/** Keys sent by the viewers */
+void hal_stream_set_key_cb(void (*cb)(const char * key_name));
+
+/** False if no display streams */
+bool hal_stream_get_stats(frame_stream_stats_t * stats);
+
+/**
+ * Save the last rendered frame of a display as 32-bit BMP file.
+ * Needs a display that keeps a full frame (direct or full render mode),
+ * 32-bit or RGB565 through hal_rgb565_enable().
+ */
+bool hal_screenshot_save(lv_display_t * disp, const char * path);
+
+/**
+ * Render the display in RGB565 like the 16-bit panel, with the same banding
+ * and rendering cost. The frame is drawn into a 16-bit buffer and only the
+ * flushed areas are converted (SIMD, see blit565.h) into the 32-bit frame of
+ * the driver before its flush runs. Needs a display in direct mode with a
+ * 32-bit frame and a fixed size, as created by sdl_hal_init() and
+ * headless_hal_init(). Screenshots are taken from the converted frame.
+ */
+bool hal_rgb565_enable(lv_display_t * disp);
+
+/** Pixels converted from RGB565 so far */
+uint64_t hal_rgb565_get_converted_pixels(void);
+
+/**
+ * Redraw debugging for a display with a 32-bit frame buffer. Every flushed
+ * area is tinted by how often its region was redrawn recently (blue: rare,
+ * red: every frame) and the tint stays until the region is drawn again.
+ * Invalidated areas are attributed to the deepest object whose drawing area
+ * contains them, so also invalidations of hidden parts are counted.
+ */
+void hal_redraw_debug_enable(lv_display_t * disp, bool en);
+
+/**
+ * Write frame statistics and the objects with the most invalidated pixels
+ * to a text file.
+ */
+bool hal_redraw_debug_dump(const char * path, uint32_t top_count);
+
 /**********************
  *      MACROS
  **********************/
@@ -0,0 +1,445 @@
+/**
+ * @file CompressedHistory.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "CompressedHistory.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TOKEN_LONG 0x80U
+#define TOKEN_RUN_MAX 0x7FU
+/** Long sample: marker and two varints of up to 10 bytes */
+#define LONG_SAMPLE_MAX_BYTES 21U
+#define NO_TOKEN 0xFFFFU
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  int64_t firstMs;
+  int32_t firstValue;
+  uint16_t count;
+  uint16_t bytes;
+  /* Encoder state after the last sample */
+  int64_t lastMs;
+  int64_t lastDelta;
+  int32_t lastValue;
+  uint16_t lastToken;  /**< last one-byte sample, NO_TOKEN after a long one */
+  uint16_t runPos;     /**< offset of the run byte following lastToken, NO_TOKEN if none */
+  uint8_t data[COMPRESSED_HISTORY_BLOCK_BYTES];
+} block_t;
+
+struct CompressedHistory {
+  block_t *blocks;
+  uint32_t capacity;
+  uint32_t head;       /**< oldest block */
+  uint32_t used;
+  uint64_t samples;
+};
+
+/** Decoder position, also used to walk several blocks */
+typedef struct {
+  const block_t *block;
+  uint32_t pos;
+  uint32_t left;       /**< samples still to decode in the block */
+  uint32_t run;        /**< pending repeats of token */
+  uint8_t token;
+  int64_t timeMs;
+  int64_t delta;
+  int32_t value;
+} decoder_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static block_t *block_at(const CompressedHistory_t *history, uint32_t index);
+static uint32_t block_find(const CompressedHistory_t *history, int64_t fromMs);
+static void block_start(block_t *block, int64_t timeMs, int32_t value);
+static bool block_encode(block_t *block, int64_t timeMs, int32_t value);
+static void decoder_init(decoder_t *d, const block_t *block);
+static bool decoder_next(decoder_t *d);
+static uint64_t zigzag(int64_t v);
+static int64_t unzigzag(uint64_t v);
+static uint32_t varint_put(uint8_t *out, uint64_t v);
+static uint64_t varint_get(const uint8_t *in, uint32_t *pos);
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+CompressedHistory_t *CompressedHistory_create(uint32_t blockCount)
+{
+  CompressedHistory_t *history = calloc(1, sizeof(CompressedHistory_t));
+
+  if (history == NULL || blockCount == 0)
+  {
+    free(history);
+    return NULL;
+  }
+  history->blocks = calloc(blockCount, sizeof(block_t));
+  if (history->blocks == NULL)
+  {
+    free(history);
+    return NULL;
+  }
+  history->capacity = blockCount;
+
+  return history;
+}
+
+void CompressedHistory_delete(CompressedHistory_t *history)
+{
+  if (history != NULL)
+  {
+    free(history->blocks);
+    free(history);
+  }
+}
+
+bool CompressedHistory_append(CompressedHistory_t *history, int64_t timeMs, int32_t value)
+{
+  block_t *last = (history->used != 0U) ? block_at(history, history->used - 1U) : NULL;
+
+  if (last != NULL && timeMs < last->lastMs)
+  {
+    return false;
+  }
+  if (last != NULL && block_encode(last, timeMs, value))
+  {
+    history->samples++;
+    return true;
+  }
+
+  /* New block, dropping the oldest one if the ring is full */
+  if (history->used == history->capacity)
+  {
+    history->samples -= block_at(history, 0)->count;
+    history->head = (history->head + 1U) % history->capacity;
+    history->used--;
+  }
+  block_start(block_at(history, history->used), timeMs, value);
+  history->used++;
+  history->samples++;
+
+  return true;
+}
+
+uint64_t CompressedHistory_get_sample_count(const CompressedHistory_t *history)
+{
+  return history->samples;
+}
+
+size_t CompressedHistory_get_memory(const CompressedHistory_t *history)
+{
+  return sizeof(CompressedHistory_t) + (size_t) history->capacity * sizeof(block_t);
+}
+
+size_t CompressedHistory_get_used_memory(const CompressedHistory_t *history)
+{
+  return (size_t) history->used * sizeof(block_t);
+}
+
+bool CompressedHistory_get_time_range(const CompressedHistory_t *history, int64_t *firstMs, int64_t *lastMs)
+{
+  if (history->used == 0U)
+  {
+    return false;
+  }
+  *firstMs = block_at(history, 0)->firstMs;
+  *lastMs = block_at(history, history->used - 1U)->lastMs;
+
+  return true;
+}
+
+uint32_t CompressedHistory_decode(const CompressedHistory_t *history, int64_t fromMs, int64_t toMs, int64_t *times,
+                                  int32_t *values, uint32_t max)
+{
+  uint32_t n = 0;
+
+  for (uint32_t b = block_find(history, fromMs); b < history->used && n < max; b++)
+  {
+    decoder_t d;
+    decoder_init(&d, block_at(history, b));
+    if (d.block->firstMs > toMs)
+    {
+      break;
+    }
+    while (n < max && decoder_next(&d))
+    {
+      if (d.timeMs > toMs)
+      {
+        return n;
+      }
+      if (d.timeMs >= fromMs)
+      {
+        if (times != NULL)
+        {
+          times[n] = d.timeMs;
+        }
+        values[n++] = d.value;
+      }
+    }
+  }
+
+  return n;
+}
+
+uint32_t CompressedHistory_read_chart(const CompressedHistory_t *history, int64_t fromMs, int64_t toMs,
+                                      int32_t *points, uint32_t pointCount)
+{
+  uint32_t filled = 0;
+
+  for (uint32_t i = 0; i < pointCount; i++)
+  {
+    points[i] = COMPRESSED_HISTORY_NO_POINT;
+  }
+  if (pointCount == 0U || toMs <= fromMs)
+  {
+    return 0;
+  }
+
+  int64_t range = toMs - fromMs;
+  for (uint32_t b = block_find(history, fromMs); b < history->used; b++)
+  {
+    decoder_t d;
+    decoder_init(&d, block_at(history, b));
+    if (d.block->firstMs > toMs)
+    {
+      break;
+    }
+    while (decoder_next(&d))
+    {
+      if (d.timeMs > toMs)
+      {
+        return filled;
+      }
+      if (d.timeMs < fromMs)
+      {
+        continue;
+      }
+      uint32_t bucket = (uint32_t) ((d.timeMs - fromMs) * (int64_t) pointCount / range);
+      bucket = (bucket < pointCount) ? bucket : pointCount - 1U;
+      if (points[bucket] == COMPRESSED_HISTORY_NO_POINT)
+      {
+        points[bucket] = d.value;
+        filled++;
+      }
+      else if (d.value > points[bucket])
+      {
+        points[bucket] = d.value;
+      }
+    }
+  }
+
+  return filled;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/** Block by age, 0 is the oldest */
+static block_t *block_at(const CompressedHistory_t *history, uint32_t index)
+{
+  return &history->blocks[(history->head + index) % history->capacity];
+}
+
+/**
+ * Last block starting before fromMs, 0 if none does. Samples at fromMs may
+ * end that block while the next one starts with fromMs.
+ */
+static uint32_t block_find(const CompressedHistory_t *history, int64_t fromMs)
+{
+  uint32_t lo = 0;
+  uint32_t hi = history->used;
+
+  while (hi - lo > 1U)
+  {
+    uint32_t mid = lo + (hi - lo) / 2U;
+    if (block_at(history, mid)->firstMs < fromMs)
+    {
+      lo = mid;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+static void block_start(block_t *block, int64_t timeMs, int32_t value)
+{
+  block->firstMs = timeMs;
+  block->firstValue = value;
+  block->count = 1;
+  block->bytes = 0;
+  block->lastMs = timeMs;
+  block->lastDelta = 0;
+  block->lastValue = value;
+  block->lastToken = NO_TOKEN;
+  block->runPos = NO_TOKEN;
+}
+
+/** Append to the block, false if it may not have room */
+static bool block_encode(block_t *block, int64_t timeMs, int32_t value)
+{
+  int64_t delta = timeMs - block->lastMs;
+  uint64_t dod = zigzag(delta - block->lastDelta);
+  uint64_t dv = zigzag((int64_t) value - (int64_t) block->lastValue);
+
+  if (block->count == UINT16_MAX)
+  {
+    return false;
+  }
+
+  if (dod < 8U && dv < 16U)
+  {
+    uint16_t token = (uint16_t) ((dod << 4) | dv);
+    if (token == block->lastToken && block->runPos != NO_TOKEN &&
+        (block->data[block->runPos] & TOKEN_RUN_MAX) < TOKEN_RUN_MAX)
+    {
+      block->data[block->runPos]++;
+    }
+    else if (token == block->lastToken && block->bytes < COMPRESSED_HISTORY_BLOCK_BYTES)
+    {
+      block->runPos = block->bytes;
+      block->data[block->bytes++] = (uint8_t) (TOKEN_LONG | 1U);
+    }
+    else if (block->bytes < COMPRESSED_HISTORY_BLOCK_BYTES)
+    {
+      block->data[block->bytes++] = (uint8_t) token;
+      block->lastToken = token;
+      block->runPos = NO_TOKEN;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  else
+  {
+    if (block->bytes + LONG_SAMPLE_MAX_BYTES > COMPRESSED_HISTORY_BLOCK_BYTES)
+    {
+      return false;
+    }
+    block->data[block->bytes++] = TOKEN_LONG;
+    block->bytes += (uint16_t) varint_put(&block->data[block->bytes], dod);
+    block->bytes += (uint16_t) varint_put(&block->data[block->bytes], dv);
+    block->lastToken = NO_TOKEN;
+    block->runPos = NO_TOKEN;
+  }
+
+  block->count++;
+  block->lastMs = timeMs;
+  block->lastDelta = delta;
+  block->lastValue = value;
+
+  return true;
+}
+
+static void decoder_init(decoder_t *d, const block_t *block)
+{
+  memset(d, 0, sizeof(*d));
+  d->block = block;
+  d->left = block->count;
+}
+
+/** Advance to the next sample of the block, false after the last one */
+static bool decoder_next(decoder_t *d)
+{
+  const block_t *block = d->block;
+  uint64_t dod;
+  uint64_t dv;
+
+  if (d->left == 0U)
+  {
+    return false;
+  }
+  if (d->left-- == block->count)
+  {
+    d->timeMs = block->firstMs;
+    d->value = block->firstValue;
+    return true;
+  }
+
+  if (d->run == 0U)
+  {
+    uint8_t byte = block->data[d->pos++];
+    if (byte == TOKEN_LONG)
+    {
+      dod = varint_get(block->data, &d->pos);
+      dv = varint_get(block->data, &d->pos);
+      d->delta += unzigzag(dod);
+      d->timeMs += d->delta;
+      d->value = (int32_t) ((int64_t) d->value + unzigzag(dv));
+      return true;
+    }
+    if ((byte & TOKEN_LONG) != 0U)
+    {
+      d->run = byte & TOKEN_RUN_MAX;
+    }
+    else
+    {
+      d->token = byte;
+      d->run = 1;
+    }
+  }
+
+  d->run--;
+  d->delta += unzigzag(d->token >> 4);
+  d->timeMs += d->delta;
+  d->value = (int32_t) ((int64_t) d->value + unzigzag(d->token & 0x0FU));
+
+  return true;
+}
+
+static uint64_t zigzag(int64_t v)
+{
+  return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+  return (int64_t) (v >> 1) ^ -(int64_t) (v & 1U);
+}
+
+static uint32_t varint_put(uint8_t *out, uint64_t v)
+{
+  uint32_t n = 0;
+
+  while (v >= 0x80U)
+  {
+    out[n++] = (uint8_t) (v | 0x80U);
+    v >>= 7;
+  }
+  out[n++] = (uint8_t) v;
+
+  return n;
+}
+
+static uint64_t varint_get(const uint8_t *in, uint32_t *pos)
+{
+  uint64_t v = 0;
+  uint32_t shift = 0;
+  uint8_t byte;
+
+  do
+  {
+    byte = in[(*pos)++];
+    v |= (uint64_t) (byte & 0x7FU) << shift;
+    shift += 7U;
+  } while ((byte & 0x80U) != 0U && shift < 64U);
+
+  return v;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file CompressedHistory.h
+ * In-memory sample history of one channel, delta compressed.
+ *
+ * Samples are packed into fixed-size blocks that form a ring, the oldest
+ * block is dropped when the ring is full. Inside a block each sample is the
+ * delta of its time delta (delta-of-delta) and the delta of its value, both
+ * zig-zag coded:
+ *   0xxxyyyy          time dod and value delta fit 3 and 4 bits
+ *   1nnnnnnn, n > 0   the previous one-byte sample repeats n times
+ *   10000000 v v      varint time dod, varint value delta
+ * A sensor sampled every second that does not change costs under a bit per
+ * sample, slow drift about one byte.
+ *
+ * Every block starts with a full sample in its header, so a time range is
+ * found by binary search over the blocks and decoded from there.
+ */
+
+#ifndef COMPRESSED_HISTORY_H
+#define COMPRESSED_HISTORY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/** Encoded bytes per block */
+#define COMPRESSED_HISTORY_BLOCK_BYTES 240U
+
+/** Chart point without samples, same value as LV_CHART_POINT_NONE */
+#define COMPRESSED_HISTORY_NO_POINT INT32_MAX
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct CompressedHistory CompressedHistory_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** History with a ring of `blockCount` blocks, NULL if out of memory */
+CompressedHistory_t *CompressedHistory_create(uint32_t blockCount);
+
+void CompressedHistory_delete(CompressedHistory_t *history);
+
+/** Append a sample, times must not decrease */
+bool CompressedHistory_append(CompressedHistory_t *history, int64_t timeMs, int32_t value);
+
+/** Samples currently held */
+uint64_t CompressedHistory_get_sample_count(const CompressedHistory_t *history);
+
+/** Bytes allocated for the history, independent of the fill level */
+size_t CompressedHistory_get_memory(const CompressedHistory_t *history);
+
+/** Bytes of the blocks holding samples */
+size_t CompressedHistory_get_used_memory(const CompressedHistory_t *history);
+
+/** Time of the oldest and newest sample held, false if empty */
+bool CompressedHistory_get_time_range(const CompressedHistory_t *history, int64_t *firstMs, int64_t *lastMs);
+
+/**
+ * Decode the samples from `fromMs` to `toMs` (inclusive), at most `max`.
+ * `times` may be NULL. Returns the number of samples written.
+ */
+uint32_t CompressedHistory_decode(const CompressedHistory_t *history, int64_t fromMs, int64_t toMs, int64_t *times,
+                                  int32_t *values, uint32_t max);
+
+/**
+ * Fill `points` with the maximum of each of `pointCount` equal time buckets
+ * between `fromMs` and `toMs`, COMPRESSED_HISTORY_NO_POINT for empty buckets.
+ * Decodes straight into the points, without an intermediate sample array.
+ */
+uint32_t CompressedHistory_read_chart(const CompressedHistory_t *history, int64_t fromMs, int64_t toMs,
+                                      int32_t *points, uint32_t pointCount);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*COMPRESSED_HISTORY_H*/
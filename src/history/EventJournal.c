@@ -0,0 +1,380 @@
+/**
+ * @file EventJournal.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "EventJournal.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define NO_SEQ UINT32_MAX
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+struct EventJournal {
+  EventJournal_event_t *events;
+  uint32_t capacity;
+  uint32_t nextSeq;
+  uint32_t pairHeads[EVENT_JOURNAL_MAX_SOURCES][EVENT_JOURNAL_LEVELS];
+  uint32_t sourceHeads[EVENT_JOURNAL_MAX_SOURCES];
+  uint32_t levelHeads[EVENT_JOURNAL_LEVELS];
+  uint32_t unackedHead;  /**< oldest unacknowledged trigger */
+  uint32_t unackedTail;  /**< newest */
+  uint32_t unackedCount;
+};
+
+typedef enum {
+  CHAIN_PAIR,
+  CHAIN_SOURCE,
+  CHAIN_LEVEL,
+  CHAIN_UNACKED,
+  CHAIN_ALL,
+} chain_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static EventJournal_event_t *event_at(const EventJournal_t *journal, uint32_t seq);
+static uint32_t oldest_seq(const EventJournal_t *journal);
+static void unacked_remove(EventJournal_t *journal, EventJournal_event_t *event);
+static bool event_matches(const EventJournal_event_t *event, const EventJournal_filter_t *filter);
+static uint32_t chain_prev(const EventJournal_event_t *event, chain_t chain);
+static uint32_t newest_at_or_before(const EventJournal_t *journal, int64_t timeMs);
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+EventJournal_t *EventJournal_create(uint32_t capacity)
+{
+  EventJournal_t *journal = malloc(sizeof(EventJournal_t));
+
+  if (journal == NULL || capacity == 0)
+  {
+    free(journal);
+    return NULL;
+  }
+  journal->events = malloc(sizeof(EventJournal_event_t) * capacity);
+  if (journal->events == NULL)
+  {
+    free(journal);
+    return NULL;
+  }
+  journal->capacity = capacity;
+  EventJournal_clear(journal);
+
+  return journal;
+}
+
+void EventJournal_delete(EventJournal_t *journal)
+{
+  if (journal != NULL)
+  {
+    free(journal->events);
+    free(journal);
+  }
+}
+
+void EventJournal_clear(EventJournal_t *journal)
+{
+  journal->nextSeq = 0;
+  /* All bytes 0xFF is NO_SEQ in every head */
+  memset(journal->pairHeads, 0xFF, sizeof(journal->pairHeads));
+  memset(journal->sourceHeads, 0xFF, sizeof(journal->sourceHeads));
+  memset(journal->levelHeads, 0xFF, sizeof(journal->levelHeads));
+  journal->unackedHead = NO_SEQ;
+  journal->unackedTail = NO_SEQ;
+  journal->unackedCount = 0;
+}
+
+uint32_t EventJournal_append(EventJournal_t *journal, int64_t timeMs, uint16_t source, uint8_t level,
+                             EventJournal_kind_t kind)
+{
+  uint32_t seq = journal->nextSeq;
+
+  if (source >= EVENT_JOURNAL_MAX_SOURCES || level >= EVENT_JOURNAL_LEVELS || seq == NO_SEQ)
+  {
+    return NO_SEQ;
+  }
+  if (seq != 0U && timeMs < event_at(journal, seq - 1U)->timeMs)
+  {
+    return NO_SEQ;
+  }
+
+  /* The slot still holds the oldest event, which must leave the unacked list */
+  EventJournal_event_t *event = &journal->events[seq % journal->capacity];
+  if (seq >= journal->capacity && event->kind == EVENT_JOURNAL_TRIGGER && !event->acked)
+  {
+    unacked_remove(journal, event);
+  }
+
+  memset(event, 0, sizeof(*event));
+  event->timeMs = timeMs;
+  event->seq = seq;
+  event->source = source;
+  event->level = level;
+  event->kind = (uint8_t) kind;
+  event->prevPair = journal->pairHeads[source][level];
+  event->prevSource = journal->sourceHeads[source];
+  event->prevLevel = journal->levelHeads[level];
+  event->unackedPrev = NO_SEQ;
+  event->unackedNext = NO_SEQ;
+  journal->pairHeads[source][level] = seq;
+  journal->sourceHeads[source] = seq;
+  journal->levelHeads[level] = seq;
+
+  if (kind == EVENT_JOURNAL_TRIGGER)
+  {
+    event->unackedPrev = journal->unackedTail;
+    if (journal->unackedTail != NO_SEQ)
+    {
+      event_at(journal, journal->unackedTail)->unackedNext = seq;
+    }
+    else
+    {
+      journal->unackedHead = seq;
+    }
+    journal->unackedTail = seq;
+    journal->unackedCount++;
+  }
+  journal->nextSeq++;
+
+  return seq;
+}
+
+bool EventJournal_ack(EventJournal_t *journal, uint32_t seq, int64_t timeMs)
+{
+  EventJournal_event_t *event = (EventJournal_event_t *) EventJournal_get(journal, seq);
+
+  if (event == NULL || event->kind != EVENT_JOURNAL_TRIGGER || event->acked)
+  {
+    return false;
+  }
+  unacked_remove(journal, event);
+  event->acked = 1;
+  EventJournal_append(journal, timeMs, event->source, event->level, EVENT_JOURNAL_ACK);
+
+  return true;
+}
+
+uint32_t EventJournal_ack_all(EventJournal_t *journal, int32_t source, int64_t timeMs)
+{
+  uint32_t count = 0;
+  uint32_t seq = journal->unackedHead;
+
+  while (seq != NO_SEQ)
+  {
+    const EventJournal_event_t *event = EventJournal_get(journal, seq);
+    if (event == NULL)
+    {
+      /* Overwritten by an ack record of this loop, the list head is valid again */
+      seq = journal->unackedHead;
+      continue;
+    }
+    uint32_t next = event->unackedNext;
+    if (source == EVENT_JOURNAL_ANY || event->source == (uint32_t) source)
+    {
+      count += EventJournal_ack(journal, seq, timeMs) ? 1U : 0U;
+    }
+    seq = next;
+  }
+
+  return count;
+}
+
+const EventJournal_event_t *EventJournal_get(const EventJournal_t *journal, uint32_t seq)
+{
+  if (seq == NO_SEQ || seq >= journal->nextSeq || seq < oldest_seq(journal))
+  {
+    return NULL;
+  }
+
+  return event_at(journal, seq);
+}
+
+uint32_t EventJournal_get_count(const EventJournal_t *journal)
+{
+  return journal->nextSeq - oldest_seq(journal);
+}
+
+uint32_t EventJournal_get_unacked_count(const EventJournal_t *journal)
+{
+  return journal->unackedCount;
+}
+
+uint32_t EventJournal_query(const EventJournal_t *journal, const EventJournal_filter_t *filter,
+                            const EventJournal_event_t **out, uint32_t max)
+{
+  uint32_t n = 0;
+  uint32_t seq;
+  chain_t chain;
+
+  /* Most selective chain first, the unacked list only when nothing narrower is given */
+  if (filter->source != EVENT_JOURNAL_ANY && filter->level != EVENT_JOURNAL_ANY)
+  {
+    if ((uint32_t) filter->source >= EVENT_JOURNAL_MAX_SOURCES || (uint32_t) filter->level >= EVENT_JOURNAL_LEVELS)
+    {
+      return 0;
+    }
+    chain = CHAIN_PAIR;
+    seq = journal->pairHeads[filter->source][filter->level];
+  }
+  else if (filter->source != EVENT_JOURNAL_ANY)
+  {
+    if ((uint32_t) filter->source >= EVENT_JOURNAL_MAX_SOURCES)
+    {
+      return 0;
+    }
+    chain = CHAIN_SOURCE;
+    seq = journal->sourceHeads[filter->source];
+  }
+  else if (filter->level != EVENT_JOURNAL_ANY)
+  {
+    if ((uint32_t) filter->level >= EVENT_JOURNAL_LEVELS)
+    {
+      return 0;
+    }
+    chain = CHAIN_LEVEL;
+    seq = journal->levelHeads[filter->level];
+  }
+  else if (filter->unackedOnly)
+  {
+    chain = CHAIN_UNACKED;
+    seq = journal->unackedTail;
+  }
+  else
+  {
+    chain = CHAIN_ALL;
+    seq = newest_at_or_before(journal, filter->toMs);
+  }
+
+  uint32_t oldest = oldest_seq(journal);
+  while (n < max && seq != NO_SEQ && seq >= oldest && seq < journal->nextSeq)
+  {
+    const EventJournal_event_t *event = event_at(journal, seq);
+    if (event->timeMs < filter->fromMs)
+    {
+      break;
+    }
+    if (event->timeMs <= filter->toMs && event_matches(event, filter))
+    {
+      out[n++] = event;
+    }
+    seq = chain_prev(event, chain);
+  }
+
+  return n;
+}
+
+void EventJournal_filter_init(EventJournal_filter_t *filter)
+{
+  memset(filter, 0, sizeof(*filter));
+  filter->fromMs = INT64_MIN;
+  filter->toMs = INT64_MAX;
+  filter->source = EVENT_JOURNAL_ANY;
+  filter->level = EVENT_JOURNAL_ANY;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static EventJournal_event_t *event_at(const EventJournal_t *journal, uint32_t seq)
+{
+  return &journal->events[seq % journal->capacity];
+}
+
+static uint32_t oldest_seq(const EventJournal_t *journal)
+{
+  return (journal->nextSeq > journal->capacity) ? journal->nextSeq - journal->capacity : 0U;
+}
+
+static void unacked_remove(EventJournal_t *journal, EventJournal_event_t *event)
+{
+  if (event->unackedPrev != NO_SEQ)
+  {
+    event_at(journal, event->unackedPrev)->unackedNext = event->unackedNext;
+  }
+  else
+  {
+    journal->unackedHead = event->unackedNext;
+  }
+  if (event->unackedNext != NO_SEQ)
+  {
+    event_at(journal, event->unackedNext)->unackedPrev = event->unackedPrev;
+  }
+  else
+  {
+    journal->unackedTail = event->unackedPrev;
+  }
+  event->unackedPrev = NO_SEQ;
+  event->unackedNext = NO_SEQ;
+  journal->unackedCount--;
+}
+
+static bool event_matches(const EventJournal_event_t *event, const EventJournal_filter_t *filter)
+{
+  if (filter->source != EVENT_JOURNAL_ANY && event->source != (uint32_t) filter->source)
+  {
+    return false;
+  }
+  if (filter->level != EVENT_JOURNAL_ANY && event->level != (uint32_t) filter->level)
+  {
+    return false;
+  }
+  if (filter->kinds != 0U && (filter->kinds & (1U << event->kind)) == 0U)
+  {
+    return false;
+  }
+
+  return !filter->unackedOnly || (event->kind == EVENT_JOURNAL_TRIGGER && !event->acked);
+}
+
+static uint32_t chain_prev(const EventJournal_event_t *event, chain_t chain)
+{
+  switch (chain)
+  {
+  case CHAIN_PAIR:
+    return event->prevPair;
+  case CHAIN_SOURCE:
+    return event->prevSource;
+  case CHAIN_LEVEL:
+    return event->prevLevel;
+  case CHAIN_UNACKED:
+    return event->unackedPrev;
+  case CHAIN_ALL:
+  default:
+    return (event->seq != 0U) ? event->seq - 1U : NO_SEQ;
+  }
+}
+
+/** Binary search over the ring, which is sorted by time */
+static uint32_t newest_at_or_before(const EventJournal_t *journal, int64_t timeMs)
+{
+  uint32_t lo = oldest_seq(journal);
+  uint32_t hi = journal->nextSeq;
+
+  while (lo < hi)
+  {
+    uint32_t mid = lo + (hi - lo) / 2U;
+    if (event_at(journal, mid)->timeMs <= timeMs)
+    {
+      lo = mid + 1U;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  return (lo > oldest_seq(journal)) ? lo - 1U : NO_SEQ;
+}
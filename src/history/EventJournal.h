@@ -0,0 +1,126 @@
+/**
+ * @file EventJournal.h
+ * Ring journal of alarm, fault and relay events with indexed queries.
+ *
+ * Events are fixed-size records in a ring; when it is full the oldest event
+ * is overwritten. Every record links back to the previous record of the same
+ * source and level, of the same source, and of the same level, and
+ * unacknowledged triggers are kept in a list of their own. A query walks the
+ * most selective of these chains from the newest event backwards and stops at
+ * the start of the time window, so its cost follows the number of matching
+ * events, not the size of the journal.
+ *
+ * Event times must not decrease.
+ */
+
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/** Sensors 0..511, relays after them */
+#define EVENT_JOURNAL_MAX_SOURCES 640U
+#define EVENT_JOURNAL_RELAY_SOURCE(relay) (512U + (relay))
+
+/** Levels 0..3, the fault (4) and relay events (5) */
+#define EVENT_JOURNAL_LEVELS 6U
+#define EVENT_JOURNAL_LEVEL_FAULT 4U
+#define EVENT_JOURNAL_LEVEL_RELAY 5U
+
+#define EVENT_JOURNAL_ANY (-1)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+  EVENT_JOURNAL_TRIGGER = 0,
+  EVENT_JOURNAL_RELEASE,
+  EVENT_JOURNAL_ACK,
+  EVENT_JOURNAL_RELAY_ON,
+  EVENT_JOURNAL_RELAY_OFF,
+} EventJournal_kind_t;
+
+typedef struct {
+  int64_t timeMs;
+  uint32_t seq;       /**< running number, identifies the event */
+  uint16_t source;
+  uint8_t level;
+  uint8_t kind;       /**< EventJournal_kind_t */
+  uint8_t acked;      /**< triggers only */
+  uint8_t reserved[3];
+  /* Index links, seq of the previous record in the chain or UINT32_MAX */
+  uint32_t prevPair;
+  uint32_t prevSource;
+  uint32_t prevLevel;
+  uint32_t unackedPrev;
+  uint32_t unackedNext;
+} EventJournal_event_t;
+
+typedef struct {
+  int64_t fromMs;     /**< inclusive */
+  int64_t toMs;       /**< inclusive */
+  int32_t source;     /**< EVENT_JOURNAL_ANY or a source */
+  int32_t level;      /**< EVENT_JOURNAL_ANY or a level */
+  uint32_t kinds;     /**< bit per EventJournal_kind_t, 0 for all */
+  bool unackedOnly;   /**< only triggers that were not acknowledged */
+} EventJournal_filter_t;
+
+typedef struct EventJournal EventJournal_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Journal of `capacity` events, NULL if out of memory */
+EventJournal_t *EventJournal_create(uint32_t capacity);
+
+void EventJournal_delete(EventJournal_t *journal);
+
+void EventJournal_clear(EventJournal_t *journal);
+
+/** Append an event, returns its seq or UINT32_MAX if rejected */
+uint32_t EventJournal_append(EventJournal_t *journal, int64_t timeMs, uint16_t source, uint8_t level,
+                             EventJournal_kind_t kind);
+
+/**
+ * Acknowledge a trigger and record the acknowledgement at `timeMs`. False if
+ * the event is no unacknowledged trigger or no longer in the journal.
+ */
+bool EventJournal_ack(EventJournal_t *journal, uint32_t seq, int64_t timeMs);
+
+/** Acknowledge all triggers of a source (EVENT_JOURNAL_ANY: all), returns the count */
+uint32_t EventJournal_ack_all(EventJournal_t *journal, int32_t source, int64_t timeMs);
+
+/** Event by seq, NULL if it was overwritten */
+const EventJournal_event_t *EventJournal_get(const EventJournal_t *journal, uint32_t seq);
+
+uint32_t EventJournal_get_count(const EventJournal_t *journal);
+
+/** Triggers still waiting for an acknowledgement */
+uint32_t EventJournal_get_unacked_count(const EventJournal_t *journal);
+
+/** Matching events, newest first, up to `max`. Returns the number written to `out` */
+uint32_t EventJournal_query(const EventJournal_t *journal, const EventJournal_filter_t *filter,
+                            const EventJournal_event_t **out, uint32_t max);
+
+/** Filter for everything, to be narrowed down by the caller */
+void EventJournal_filter_init(EventJournal_filter_t *filter);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*EVENT_JOURNAL_H*/
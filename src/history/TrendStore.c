@@ -0,0 +1,469 @@
+/**
+ * @file TrendStore.c
+ *
+ * File layout, all little endian as written by the host:
+ *   header      TREND_STORE_HEADER_SIZE bytes, see store_header_t
+ *   block 0..n  block_header_t, int64 times[ROWS], int32 values[channels][ROWS]
+ * Blocks have a fixed size, so block i starts at header + i * blockSize.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#ifndef _DEFAULT_SOURCE
+  #define _DEFAULT_SOURCE /* needed for ftruncate() */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "TrendStore.h"
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TREND_STORE_MAGIC "CLX2TRND"
+#define TREND_STORE_VERSION 1U
+#define TREND_STORE_HEADER_SIZE 4096U
+#define BLOCK_HEADER_SIZE 64U
+/** Blocks added to the file when it is full, doubled up to this limit */
+#define GROW_MAX_BLOCKS 1024U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t channelCount;
+  uint32_t blockRows;
+  uint32_t reserved;
+  uint64_t blockCount;   /**< blocks holding rows, the last one may be partial */
+  uint64_t rowCount;
+} store_header_t;
+
+typedef struct {
+  uint32_t rows;
+  uint32_t reserved;
+  int64_t firstMs;
+  int64_t lastMs;
+} block_header_t;
+
+struct TrendStore {
+  int fd;
+  uint8_t *map;
+  uint64_t mapSize;
+  uint64_t blockSize;
+  uint64_t blockCapacity; /**< blocks the file has room for */
+  uint32_t generation;
+  store_header_t *header;
+};
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+#ifndef _WIN32
+static bool store_map(TrendStore_t *store, uint64_t blockCapacity);
+#endif
+static block_header_t *block_get(const TrendStore_t *store, uint64_t block);
+static const int64_t *block_times(const TrendStore_t *store, uint64_t block);
+static const int32_t *block_values(const TrendStore_t *store, uint64_t block, uint32_t channel);
+static uint32_t rows_before(const int64_t *times, uint32_t count, int64_t timeMs);
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+#ifndef _WIN32
+
+TrendStore_t *TrendStore_open(const char *path, uint32_t channelCount)
+{
+  struct stat st;
+
+  if (channelCount == 0)
+  {
+    return NULL;
+  }
+
+  TrendStore_t *store = calloc(1, sizeof(TrendStore_t));
+  if (store == NULL)
+  {
+    return NULL;
+  }
+  store->fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (store->fd < 0 || fstat(store->fd, &st) != 0)
+  {
+    TrendStore_close(store);
+    return NULL;
+  }
+
+  store->blockSize = BLOCK_HEADER_SIZE + (uint64_t) TREND_STORE_BLOCK_ROWS * (sizeof(int64_t) +
+                                                                             sizeof(int32_t) * channelCount);
+  /* Only an empty file is a new store; anything else must be one already, before it is resized */
+  bool created = st.st_size == 0;
+  store_header_t existing;
+  if (!created &&
+      ((uint64_t) st.st_size < TREND_STORE_HEADER_SIZE ||
+       pread(store->fd, &existing, sizeof(existing), 0) != (ssize_t) sizeof(existing) ||
+       memcmp(existing.magic, TREND_STORE_MAGIC, sizeof(existing.magic)) != 0 ||
+       existing.version != TREND_STORE_VERSION || existing.channelCount != channelCount ||
+       existing.blockRows != TREND_STORE_BLOCK_ROWS ||
+       existing.blockCount > ((uint64_t) st.st_size - TREND_STORE_HEADER_SIZE) / store->blockSize))
+  {
+    TrendStore_close(store);
+    return NULL;
+  }
+
+  uint64_t capacity = created ? 1U : ((uint64_t) st.st_size - TREND_STORE_HEADER_SIZE) / store->blockSize;
+  if (!store_map(store, (capacity != 0U) ? capacity : 1U))
+  {
+    TrendStore_close(store);
+    return NULL;
+  }
+
+  store_header_t *header = store->header;
+  if (created)
+  {
+    memcpy(header->magic, TREND_STORE_MAGIC, sizeof(header->magic));
+    header->version = TREND_STORE_VERSION;
+    header->channelCount = channelCount;
+    header->blockRows = TREND_STORE_BLOCK_ROWS;
+  }
+
+  return store;
+}
+
+void TrendStore_close(TrendStore_t *store)
+{
+  if (store == NULL)
+  {
+    return;
+  }
+  if (store->map != NULL)
+  {
+    munmap(store->map, store->mapSize);
+  }
+  if (store->fd >= 0)
+  {
+    close(store->fd);
+  }
+  free(store);
+}
+
+bool TrendStore_append(TrendStore_t *store, int64_t timeMs, const int32_t *values)
+{
+  store_header_t *header = store->header;
+  uint64_t block = (header->blockCount != 0U) ? header->blockCount - 1U : 0U;
+  block_header_t *bh = (header->blockCount != 0U) ? block_get(store, block) : NULL;
+
+  if (bh != NULL && bh->rows != 0U && timeMs < bh->lastMs)
+  {
+    return false;
+  }
+  if (bh == NULL || bh->rows == TREND_STORE_BLOCK_ROWS)
+  {
+    block = header->blockCount;
+    if (block == store->blockCapacity)
+    {
+      uint64_t grow = (store->blockCapacity < GROW_MAX_BLOCKS) ? store->blockCapacity : GROW_MAX_BLOCKS;
+      if (!store_map(store, store->blockCapacity + grow))
+      {
+        return false;
+      }
+      header = store->header;
+    }
+    bh = block_get(store, block);
+    memset(bh, 0, BLOCK_HEADER_SIZE);
+    bh->firstMs = timeMs;
+    header->blockCount = block + 1U;
+  }
+
+  uint8_t *base = (uint8_t *) bh + BLOCK_HEADER_SIZE;
+  uint32_t row = bh->rows;
+  ((int64_t *) base)[row] = timeMs;
+  int32_t *columns = (int32_t *) (base + sizeof(int64_t) * TREND_STORE_BLOCK_ROWS);
+  for (uint32_t c = 0; c < header->channelCount; c++)
+  {
+    columns[(size_t) c * TREND_STORE_BLOCK_ROWS + row] = values[c];
+  }
+
+  /* Row count last, a reader never sees a row before its data */
+  bh->lastMs = timeMs;
+  bh->rows = row + 1U;
+  header->rowCount++;
+
+  return true;
+}
+
+void TrendStore_flush(TrendStore_t *store)
+{
+  msync(store->map, store->mapSize, MS_ASYNC);
+}
+
+#else
+
+/* No mmap backend for Windows yet */
+TrendStore_t *TrendStore_open(const char *path, uint32_t channelCount)
+{
+  (void) path;
+  (void) channelCount;
+  return NULL;
+}
+
+void TrendStore_close(TrendStore_t *store)
+{
+  (void) store;
+}
+
+bool TrendStore_append(TrendStore_t *store, int64_t timeMs, const int32_t *values)
+{
+  (void) store;
+  (void) timeMs;
+  (void) values;
+  return false;
+}
+
+void TrendStore_flush(TrendStore_t *store)
+{
+  (void) store;
+}
+
+#endif
+
+uint64_t TrendStore_get_row_count(const TrendStore_t *store)
+{
+  return store->header->rowCount;
+}
+
+uint32_t TrendStore_get_channel_count(const TrendStore_t *store)
+{
+  return store->header->channelCount;
+}
+
+bool TrendStore_get_time_range(const TrendStore_t *store, int64_t *firstMs, int64_t *lastMs)
+{
+  if (store->header->rowCount == 0U)
+  {
+    return false;
+  }
+  *firstMs = block_get(store, 0)->firstMs;
+  *lastMs = block_get(store, store->header->blockCount - 1U)->lastMs;
+
+  return true;
+}
+
+uint32_t TrendStore_get_generation(const TrendStore_t *store)
+{
+  return store->generation;
+}
+
+bool TrendStore_seek(const TrendStore_t *store, TrendStore_cursor_t *cursor, uint32_t channel, int64_t fromMs,
+                     int64_t toMs)
+{
+  uint64_t blocks = store->header->blockCount;
+
+  memset(cursor, 0, sizeof(*cursor));
+  if (channel >= store->header->channelCount || blocks == 0U)
+  {
+    return false;
+  }
+
+  /*
+   * Last block starting before fromMs, its tail may still be before fromMs.
+   * Rows at fromMs may end that block while the next one starts with fromMs.
+   */
+  uint64_t lo = 0;
+  uint64_t hi = blocks;
+  while (hi - lo > 1U)
+  {
+    uint64_t mid = lo + (hi - lo) / 2U;
+    if (block_get(store, mid)->firstMs < fromMs)
+    {
+      lo = mid;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  const block_header_t *bh = block_get(store, lo);
+  uint32_t row = rows_before(block_times(store, lo), bh->rows, fromMs);
+  if (row == bh->rows)
+  {
+    lo++;
+    row = 0;
+  }
+
+  cursor->store = store;
+  cursor->channel = channel;
+  cursor->block = lo;
+  cursor->row = row;
+  cursor->toMs = toMs;
+
+  return lo < blocks;
+}
+
+bool TrendStore_next(TrendStore_cursor_t *cursor, TrendStore_span_t *span)
+{
+  const TrendStore_t *store = cursor->store;
+
+  if (store == NULL || cursor->block >= store->header->blockCount)
+  {
+    return false;
+  }
+
+  const block_header_t *bh = block_get(store, cursor->block);
+  const int64_t *times = block_times(store, cursor->block);
+  uint32_t end = bh->rows;
+  if (bh->lastMs > cursor->toMs)
+  {
+    /* Rows up to and including toMs */
+    end = rows_before(times, bh->rows, cursor->toMs + 1);
+  }
+  if (cursor->row >= end)
+  {
+    cursor->block = store->header->blockCount;
+    return false;
+  }
+
+  span->times = times + cursor->row;
+  span->values = block_values(store, cursor->block, cursor->channel) + cursor->row;
+  span->count = end - cursor->row;
+
+  if (end == bh->rows)
+  {
+    cursor->block++;
+    cursor->row = 0;
+  }
+  else
+  {
+    cursor->block = store->header->blockCount;
+  }
+
+  return true;
+}
+
+uint32_t TrendStore_read_chart(const TrendStore_t *store, uint32_t channel, int64_t fromMs, int64_t toMs,
+                               int32_t *points, uint32_t pointCount)
+{
+  TrendStore_cursor_t cursor;
+  TrendStore_span_t span;
+  uint32_t filled = 0;
+
+  for (uint32_t i = 0; i < pointCount; i++)
+  {
+    points[i] = TREND_STORE_NO_POINT;
+  }
+  if (pointCount == 0U || toMs <= fromMs || !TrendStore_seek(store, &cursor, channel, fromMs, toMs))
+  {
+    return 0;
+  }
+
+  int64_t range = toMs - fromMs;
+  while (TrendStore_next(&cursor, &span))
+  {
+    for (uint32_t i = 0; i < span.count; i++)
+    {
+      uint32_t bucket = (uint32_t) ((span.times[i] - fromMs) * (int64_t) pointCount / range);
+      bucket = (bucket < pointCount) ? bucket : pointCount - 1U;
+      if (points[bucket] == TREND_STORE_NO_POINT)
+      {
+        points[bucket] = span.values[i];
+        filled++;
+      }
+      else if (span.values[i] > points[bucket])
+      {
+        points[bucket] = span.values[i];
+      }
+    }
+  }
+
+  return filled;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#ifndef _WIN32
+/** Size the file for `blockCapacity` blocks and map all of it */
+static bool store_map(TrendStore_t *store, uint64_t blockCapacity)
+{
+  uint64_t size = TREND_STORE_HEADER_SIZE + blockCapacity * store->blockSize;
+  struct stat st;
+
+  if (fstat(store->fd, &st) != 0)
+  {
+    return false;
+  }
+  if ((uint64_t) st.st_size < size && ftruncate(store->fd, (off_t) size) != 0)
+  {
+    return false;
+  }
+
+  void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, store->fd, 0);
+  if (map == MAP_FAILED)
+  {
+    return false;
+  }
+  if (store->map != NULL)
+  {
+    munmap(store->map, store->mapSize);
+  }
+  store->map = map;
+  store->mapSize = size;
+  store->blockCapacity = blockCapacity;
+  store->header = (store_header_t *) map;
+  store->generation++;
+
+  return true;
+}
+#endif
+
+static block_header_t *block_get(const TrendStore_t *store, uint64_t block)
+{
+  return (block_header_t *) (store->map + TREND_STORE_HEADER_SIZE + block * store->blockSize);
+}
+
+static const int64_t *block_times(const TrendStore_t *store, uint64_t block)
+{
+  return (const int64_t *) ((const uint8_t *) block_get(store, block) + BLOCK_HEADER_SIZE);
+}
+
+static const int32_t *block_values(const TrendStore_t *store, uint64_t block, uint32_t channel)
+{
+  const uint8_t *columns = (const uint8_t *) block_times(store, block) + sizeof(int64_t) * TREND_STORE_BLOCK_ROWS;
+
+  return (const int32_t *) columns + (size_t) channel * TREND_STORE_BLOCK_ROWS;
+}
+
+/** Number of rows with a time before `timeMs` */
+static uint32_t rows_before(const int64_t *times, uint32_t count, int64_t timeMs)
+{
+  uint32_t lo = 0;
+  uint32_t hi = count;
+
+  while (lo < hi)
+  {
+    uint32_t mid = lo + (hi - lo) / 2U;
+    if (times[mid] < timeMs)
+    {
+      lo = mid + 1U;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file TrendStore.h
+ * Append-only on-disk history of all sensor values.
+ *
+ * One file holds rows of (time, value of every channel), stored column-wise
+ * in fixed-size blocks: per block the timestamps, then the values of channel
+ * 0, channel 1, ... The file is memory mapped, so opening it costs the same
+ * for an hour and for a month of history, and range reads hand out pointers
+ * straight into the mapping.
+ *
+ * Seeking is a binary search over the block start times and then inside the
+ * block. Times must not decrease from row to row.
+ *
+ * Spans returned by a cursor stay valid until the next append that grows
+ * the file (see TrendStore_get_generation()).
+ */
+
+#ifndef TREND_STORE_H
+#define TREND_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/** Rows per block */
+#define TREND_STORE_BLOCK_ROWS 1024U
+
+/** Chart point without samples, same value as LV_CHART_POINT_NONE */
+#define TREND_STORE_NO_POINT INT32_MAX
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct TrendStore TrendStore_t;
+
+/** Consecutive samples of one channel, pointing into the file mapping */
+typedef struct {
+  const int64_t *times;
+  const int32_t *values;
+  uint32_t count;
+} TrendStore_span_t;
+
+typedef struct {
+  const TrendStore_t *store;
+  uint32_t channel;
+  uint64_t block;
+  uint32_t row;
+  int64_t toMs;
+} TrendStore_cursor_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Open or create a store. A new store is only created in a missing or empty
+ * file; an existing file must be a store with the same channel count and is
+ * left untouched otherwise. Returns NULL on error.
+ */
+TrendStore_t *TrendStore_open(const char *path, uint32_t channelCount);
+
+void TrendStore_close(TrendStore_t *store);
+
+/** Append one row, `values` holds one value per channel */
+bool TrendStore_append(TrendStore_t *store, int64_t timeMs, const int32_t *values);
+
+/** Schedule writing the dirty pages, does not wait */
+void TrendStore_flush(TrendStore_t *store);
+
+uint64_t TrendStore_get_row_count(const TrendStore_t *store);
+
+uint32_t TrendStore_get_channel_count(const TrendStore_t *store);
+
+/** Time of the first and last row, false if the store is empty */
+bool TrendStore_get_time_range(const TrendStore_t *store, int64_t *firstMs, int64_t *lastMs);
+
+/** Changes whenever the mapping moved, spans of an older generation are invalid */
+uint32_t TrendStore_get_generation(const TrendStore_t *store);
+
+/** Position a cursor at the first row of `channel` at or after `fromMs` */
+bool TrendStore_seek(const TrendStore_t *store, TrendStore_cursor_t *cursor, uint32_t channel, int64_t fromMs,
+                     int64_t toMs);
+
+/** Next run of samples up to the `toMs` of the seek, false at the end */
+bool TrendStore_next(TrendStore_cursor_t *cursor, TrendStore_span_t *span);
+
+/**
+ * Fill `points` with the maximum of each of `pointCount` equal time buckets
+ * between `fromMs` and `toMs`, TREND_STORE_NO_POINT for buckets without
+ * samples. Suits lv_chart_set_ext_y_array() or copying into a series.
+ */
+uint32_t TrendStore_read_chart(const TrendStore_t *store, uint32_t channel, int64_t fromMs, int64_t toMs,
+                               int32_t *points, uint32_t pointCount);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*TREND_STORE_H*/
@@ -13,6 +13,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #ifdef _MSC_VER
   #include <Windows.h>
 #else
@@ -33,11 +34,28 @@
 #include "CANLineX2Graphics/RingBuffer.h"
 #include "CANLineX2Interface/TimeoutServer/TimeoutServer.h"
 #include "CANLineX2Interface/ConfigurationHandler.h"
-#include "TimerLib.h"
+#include "sim/SimScenario.h"
+#include "ui/SensorBinding.h"
+#include "ui/Startup.h"
+#include "ui/ViewModel.h"
+#include "ui/FramePacer.h"
+#include "ui/TargetBudget.h"
+#include "sim/SimSignals.h"
+#include "sim/SimSensors.h"
+#include "sim/SensorIngest.h"
+#include "sim/SimFlash.h"
+#include "sim/SimSettings.h"
+#include "history/TrendStore.h"
 /*********************
  *      DEFINES
  *********************/
 
+/** Period of the application thread, independent of the frame time */
+#define APP_THREAD_PERIOD_MS 5U
+
+/** Period of ChartData_handler() */
+#define CHART_DATA_PERIOD_MS 1000U
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -46,10 +64,48 @@
  *  STATIC PROTOTYPES
  **********************/
 static int keyboard_event_watcher(void *userdata, SDL_Event *event);
+static int run_scenario(const char *dir, const char *report, const char *screenshot, bool rgb565);
+static void scenario_pointer_read_cb(lv_indev_t *indev, lv_indev_data_t *data);
+static void remote_key_cb(const char *keyName);
+static uint32_t scenario_tick_get_cb(void);
+static uint64_t wall_time_us(void);
+static void redraw_debug_dump(void);
+static bool history_open(void);
+static void history_sample_cb(const int32_t *values, uint32_t count, uint64_t timeUs);
+static void chart_data_init_cb(void *user);
+static void startup_trace_write(void);
+static bool settings_flash_open(void);
+#if LV_USE_OS == LV_OS_PTHREAD
+static void *app_thread_main(void *arg);
+#endif
+static void app_commands_handle(void);
+static void app_thread_stop(void);
+static void key_post(const char *keyName);
+static void settings_flash_close(void);
+static void frame_pacer_start(lv_display_t *disp);
+static void frame_stats_print(void);
+static void stream_stats_print(void);
+static bool target_budget_start(lv_display_t *disp);
+static void target_budget_print(void);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+static uint32_t scenarioNowMs;
+static const char *redrawDumpPath;
+static const char *historyPath;
+static TrendStore_t *history;
+static int64_t historyOffsetMs;
+static const char *startupTracePath;
+static const char *flashPath;
+static SimFlash_t *settingsFlash;
+static const char *streamAddress;
+static const char *targetPath;
+static bool targetThrottle;
+#if LV_USE_OS == LV_OS_PTHREAD
+static pthread_t appThread;
+static bool appRunning;
+#endif
 
 /**********************
  *   GLOBAL FUNCTIONS
@@ -59,14 +115,156 @@ static int keyboard_event_watcher(void *userdata, SDL_Event *event);
 
 int main(int argc, char **argv)
 {
-  (void)argc; /*Unused*/
-  (void)argv; /*Unused*/
+  const char *scenario = NULL;
+  const char *report = NULL;
+  const char *screenshot = NULL;
+  bool lazyInit = false;
+  bool rgb565 = false;
+
+  for (int i = 1; i < argc; i += 2)
+  {
+    const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    if (strcmp(argv[i], "--lazy-init") == 0)
+    {
+      /* No value */
+      lazyInit = true;
+      i--;
+    }
+    else if (strcmp(argv[i], "--rgb565") == 0)
+    {
+      rgb565 = true;
+      i--;
+    }
+    else if (strcmp(argv[i], "--frame-stats") == 0)
+    {
+      atexit(frame_stats_print);
+      i--;
+    }
+    else if (strcmp(argv[i], "--throttle") == 0)
+    {
+      targetThrottle = true;
+      i--;
+    }
+    else if (value != NULL && strcmp(argv[i], "--scenario") == 0)
+    {
+      scenario = value;
+    }
+    else if (value != NULL && strcmp(argv[i], "--report") == 0)
+    {
+      report = value;
+    }
+    else if (value != NULL && strcmp(argv[i], "--screenshot") == 0)
+    {
+      screenshot = value;
+    }
+    else if (value != NULL && strcmp(argv[i], "--redraw-debug") == 0)
+    {
+      redrawDumpPath = value;
+    }
+    else if (value != NULL && strcmp(argv[i], "--history") == 0)
+    {
+      historyPath = value;
+    }
+    else if (value != NULL && strcmp(argv[i], "--startup-trace") == 0)
+    {
+      startupTracePath = value;
+    }
+    else if (value != NULL && strcmp(argv[i], "--flash") == 0)
+    {
+      flashPath = value;
+    }
+    else if (value != NULL && strcmp(argv[i], "--stream") == 0)
+    {
+      streamAddress = value;
+    }
+    else if (value != NULL && strcmp(argv[i], "--target") == 0)
+    {
+      targetPath = value;
+    }
+    else
+    {
+      fprintf(stderr,
+              "usage: %s [options]\n"
+              "  --lazy-init\n"
+              "  --rgb565\n"
+              "  --frame-stats\n"
+              "  --target <calibration.txt> [--throttle]\n"
+              "  --startup-trace <trace.json>\n"
+              "  --flash <settings.bin>\n"
+              "  --stream <address>\n"
+              "  --redraw-debug <dump.txt>\n"
+              "  --scenario <dir> [--report <file.json>] [--screenshot <file.bmp>] [--history <trend.bin>]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  Startup_init(lazyInit);
+  if (startupTracePath != NULL)
+  {
+    atexit(startup_trace_write);
+  }
 
   /*Initialize LVGL*/
+  Startup_phase_begin("lv_init");
   lv_init();
+  Startup_phase_end();
+
+  if (flashPath != NULL)
+  {
+    Startup_phase_begin("settings_flash_open");
+    bool flashOpened = settings_flash_open();
+    Startup_phase_end();
+    if (!flashOpened)
+    {
+      fprintf(stderr, "Cannot open flash %s\n", flashPath);
+      return 1;
+    }
+  }
+
+  if (scenario != NULL)
+  {
+    return run_scenario(scenario, report, screenshot, rgb565);
+  }
 
   /*Initialize the HAL (display, input devices, tick) for LVGL*/
-  sdl_hal_init(800, 480);
+  lv_display_t *disp;
+  if (streamAddress != NULL)
+  {
+    /* No window, the frames go to viewers and their keys come back */
+    Startup_phase_begin("stream_hal_init");
+    disp = stream_hal_init(800, 480, streamAddress);
+    Startup_phase_end();
+    if (disp == NULL)
+    {
+      fprintf(stderr, "Cannot stream to %s\n", streamAddress);
+      return 1;
+    }
+    hal_stream_set_key_cb(remote_key_cb);
+    atexit(stream_stats_print);
+  }
+  else
+  {
+    Startup_phase_begin("sdl_hal_init");
+    disp = sdl_hal_init(800, 480);
+    Startup_phase_end();
+  }
+  if (rgb565 && !hal_rgb565_enable(disp))
+  {
+    fprintf(stderr, "RGB565 rendering is not available on this display\n");
+  }
+  Startup_watch_first_frame(disp);
+  frame_pacer_start(disp);
+  if (!target_budget_start(disp))
+  {
+    return 1;
+  }
+  if (redrawDumpPath != NULL)
+  {
+    /* Tinted redraws, the top offenders are written on F12 and at exit */
+    hal_redraw_debug_enable(disp, true);
+    atexit(redraw_debug_dump);
+  }
 
   /* Run the default demo */
   /* To try a different demo or example, replace this with one of: */
@@ -78,34 +276,76 @@ int main(int argc, char **argv)
   //SpielWiese_init();
   //SpielWiese_load();
 
- ChartData_init();
- DisplayStateMachine_init();
+  /* The first screen does not show charts, in lazy mode they start after the first frame */
+  Startup_defer("ChartData_init", chart_data_init_cb, NULL);
+  Startup_phase_begin("DisplayStateMachine_init");
+  DisplayStateMachine_init();
+  Startup_phase_end();
 
   SDL_AddEventWatch(keyboard_event_watcher, NULL);
 
+#if LV_USE_OS == LV_OS_PTHREAD
+  /*
+   * CAN, timeout, configuration and settings processing leave this thread. The
+   * UI reads sensors as snapshots and sends keys as commands, neither thread
+   * ever waits for the other.
+   */
+  ViewModel_init(true);
+  appRunning = true;
+  if (pthread_create(&appThread, NULL, app_thread_main, NULL) != 0)
+  {
+    appRunning = false;
+    fprintf(stderr, "Cannot start the application thread\n");
+    return 1;
+  }
+  /* Runs before the handlers registered earlier, such as closing the settings flash */
+  atexit(app_thread_stop);
+#else
+  ViewModel_init(false);
+#endif
+
   while(1)
   {
     /* Periodically call the lv_task handler.
      * It could be done in a timer interrupt or an OS task too.*/
 
-   static uint32_t refTime = 0;
-   static uint32_t delay = 0;
+   static uint32_t chartRefMs = 0;
 
+   uint32_t nowMs = lv_tick_get();
+#if LV_USE_OS == LV_OS_PTHREAD
+   /* One snapshot for everything drawn in this pass */
+   ViewModel_acquire();
+#else
+   uint64_t appUs = TargetBudget_app_begin();
    TimeoutServer_handler();
-   delay += TimerLib_ref_delay(&refTime);
-   if (delay > 1000)
+   app_commands_handle();
+   SimSettings_handler(nowMs);
+   SensorIngest_update(nowMs);
+   TargetBudget_app_end(appUs);
+#endif
+   if (lv_tick_elaps(chartRefMs) >= CHART_DATA_PERIOD_MS)
    {
-    delay = 0;
+    chartRefMs = nowMs;
+    Startup_require("ChartData_init");
+    /* ChartData feeds the chart widgets, so it stays with LVGL */
+    lv_lock();
+    uint64_t chartUs = TargetBudget_app_begin();
     ChartData_handler();
+    TargetBudget_app_end(chartUs);
+    lv_unlock();
    }
 
     uint32_t sleep_time_ms = lv_timer_handler();
     if(sleep_time_ms == LV_NO_TIMER_READY){
-	      sleep_time_ms =  LV_DEF_REFR_PERIOD;
+	      sleep_time_ms =  FramePacer_get_period();
 
     }
 
+   lv_lock();
+   uint64_t stateUs = TargetBudget_app_begin();
    DisplayStateMachine_handler();
+   TargetBudget_app_end(stateUs);
+   lv_unlock();
 
    #ifdef _MSC_VER
     Sleep(sleep_time_ms);
@@ -124,6 +364,163 @@ int main(int argc, char **argv)
  *   STATIC FUNCTIONS
  **********************/
 
+/**
+ * Run a scenario headless on a simulated clock: instead of sleeping, the clock
+ * jumps ahead by the time LVGL would have slept.
+ */
+static int run_scenario(const char *dir, const char *report, const char *screenshot, bool rgb565)
+{
+  SimScenario_timing_t timing = { 0 };
+  uint32_t chartRefMs = 0;
+  uint32_t historyRefMs = 0;
+
+  Startup_phase_begin("headless_hal_init");
+  lv_display_t *disp = headless_hal_init(800, 480);
+  Startup_phase_end();
+  if (disp != NULL && rgb565 && !hal_rgb565_enable(disp))
+  {
+    fprintf(stderr, "RGB565 rendering is not available on this display\n");
+  }
+  if (disp != NULL && streamAddress != NULL)
+  {
+    if (!hal_stream_enable(disp, streamAddress))
+    {
+      fprintf(stderr, "Cannot stream to %s\n", streamAddress);
+      return 1;
+    }
+    atexit(stream_stats_print);
+  }
+  Startup_phase_begin("SimScenario_load");
+  bool loaded = disp != NULL && SimScenario_load(dir);
+  Startup_phase_end();
+  if (!loaded)
+  {
+    return 1;
+  }
+  lv_tick_set_cb(scenario_tick_get_cb);
+  SimScenario_set_key_cb(remote_key_cb);
+  Startup_watch_first_frame(disp);
+  /* Scenarios stay on one thread, their clock is simulated anyway */
+  ViewModel_init(false);
+  Startup_phase_begin("SensorBinding_init");
+  SensorBinding_init(disp);
+  Startup_phase_end();
+  Startup_phase_begin("history_open");
+  bool historyOpened = historyPath == NULL || history_open();
+  Startup_phase_end();
+  if (!historyOpened)
+  {
+    fprintf(stderr, "Cannot open history %s\n", historyPath);
+    return 1;
+  }
+
+  lv_indev_t *pointer = lv_indev_create();
+  lv_indev_set_type(pointer, LV_INDEV_TYPE_POINTER);
+  lv_indev_set_read_cb(pointer, scenario_pointer_read_cb);
+  lv_indev_set_display(pointer, disp);
+  lv_indev_set_group(pointer, lv_group_get_default());
+  frame_pacer_start(disp);
+  if (!target_budget_start(disp))
+  {
+    return 1;
+  }
+
+  Startup_defer("ChartData_init", chart_data_init_cb, NULL);
+  Startup_phase_begin("DisplayStateMachine_init");
+  DisplayStateMachine_init();
+  Startup_phase_end();
+
+  uint64_t startUs = wall_time_us();
+  while (!SimScenario_done(scenarioNowMs))
+  {
+    uint64_t loopStartUs = wall_time_us();
+
+    SimScenario_step(scenarioNowMs);
+    if (history != NULL && !SimSignals_active() && scenarioNowMs - historyRefMs >= 1000U)
+    {
+      /* Without signals only the scripted values exist, one row per second is enough */
+      historyRefMs = scenarioNowMs;
+      history_sample_cb(SimSensors_get_values(), TrendStore_get_channel_count(history),
+                        (uint64_t) scenarioNowMs * 1000U);
+    }
+    uint64_t appUs = TargetBudget_app_begin();
+    TimeoutServer_handler();
+    app_commands_handle();
+    SimSettings_handler(scenarioNowMs);
+    if (scenarioNowMs - chartRefMs > 1000)
+    {
+      chartRefMs = scenarioNowMs;
+      Startup_require("ChartData_init");
+      ChartData_handler();
+    }
+    TargetBudget_app_end(appUs);
+
+    uint32_t sleep_time_ms = lv_timer_handler();
+    if (sleep_time_ms == LV_NO_TIMER_READY)
+    {
+      sleep_time_ms = FramePacer_get_period();
+    }
+
+    appUs = TargetBudget_app_begin();
+    DisplayStateMachine_handler();
+    TargetBudget_app_end(appUs);
+
+    uint32_t loopUs = (uint32_t)(wall_time_us() - loopStartUs);
+    timing.loops++;
+    timing.loopBusyUs += loopUs;
+    if (loopUs > timing.maxLoopUs)
+    {
+      timing.maxLoopUs = loopUs;
+    }
+    scenarioNowMs += (sleep_time_ms != 0) ? sleep_time_ms : 1U;
+  }
+  timing.wallUs = wall_time_us() - startUs;
+  TrendStore_close(history);
+  history = NULL;
+
+  lv_refr_now(disp);
+  if (screenshot != NULL && !hal_screenshot_save(disp, screenshot))
+  {
+    fprintf(stderr, "Cannot write screenshot %s\n", screenshot);
+    screenshot = NULL;
+  }
+  if (report != NULL && !SimScenario_write_report(report, &timing, screenshot))
+  {
+    fprintf(stderr, "Cannot write report %s\n", report);
+    return 1;
+  }
+
+  return 0;
+}
+
+static void scenario_pointer_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+  bool pressed;
+
+  (void)indev;
+  SimScenario_get_pointer(&data->point.x, &data->point.y, &pressed);
+  data->state = pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+/** Keys of a scenario script or of a stream viewer */
+static void remote_key_cb(const char *keyName)
+{
+  /* A key may lead to a chart screen */
+  Startup_require("ChartData_init");
+  FramePacer_notify_input();
+  key_post(keyName);
+}
+
+static uint32_t scenario_tick_get_cb(void)
+{
+  return scenarioNowMs;
+}
+
+static uint64_t wall_time_us(void)
+{
+  return (uint64_t)((double)SDL_GetPerformanceCounter() * 1e6 / (double)SDL_GetPerformanceFrequency());
+}
+
 static int keyboard_event_watcher(void *userdata, SDL_Event *event)
 {
   (void)userdata;
@@ -134,9 +531,286 @@ static int keyboard_event_watcher(void *userdata, SDL_Event *event)
     printf("Key pressed: %s (scancode: %d, keycode: %d)\n",
            keyName, event->key.keysym.scancode, event->key.keysym.sym);
 
-    ConfigurationHandler_SetKeyValue(keyName);
+    if (redrawDumpPath != NULL && event->key.keysym.sym == SDLK_F12)
+    {
+      redraw_debug_dump();
+      return 1;
+    }
+    Startup_require("ChartData_init");
+    /* Keys bypass the LVGL input devices, the answer must not wait for an idle frame */
+    FramePacer_notify_input();
+    key_post(keyName);
   }
 
   return 1;
 }
 
+static void redraw_debug_dump(void)
+{
+  if (hal_redraw_debug_dump(redrawDumpPath, 50))
+  {
+    printf("Redraw statistics written to %s\n", redrawDumpPath);
+  }
+}
+
+/** Record into the trend store, a run continues the history after its last row */
+static bool history_open(void)
+{
+  int64_t firstMs;
+  int64_t lastMs;
+  uint32_t channels = SimDescriptor_get()->sensorCount;
+
+  history = TrendStore_open(historyPath, (channels != 0U) ? channels : 1U);
+  if (history == NULL)
+  {
+    return false;
+  }
+  historyOffsetMs = TrendStore_get_time_range(history, &firstMs, &lastMs) ? lastMs + 1000 : 0;
+  SimSignals_set_sample_cb(history_sample_cb);
+
+  return true;
+}
+
+static void history_sample_cb(const int32_t *values, uint32_t count, uint64_t timeUs)
+{
+  if (history != NULL && count >= TrendStore_get_channel_count(history))
+  {
+    TrendStore_append(history, historyOffsetMs + (int64_t) (timeUs / 1000U), values);
+  }
+}
+
+static void chart_data_init_cb(void *user)
+{
+  (void)user;
+  ChartData_init();
+}
+
+static void startup_trace_write(void)
+{
+  if (Startup_write_trace(startupTracePath))
+  {
+    printf("Startup trace written to %s, first frame after %.1f ms\n", startupTracePath,
+           (double) Startup_get_first_frame_us() / 1000.0);
+  }
+}
+
+#if LV_USE_OS == LV_OS_PTHREAD
+/**
+ * Application work on a fixed period, so its timing does not depend on how
+ * long a frame takes. Never calls LVGL.
+ */
+static void *app_thread_main(void *arg)
+{
+  (void)arg;
+
+  while (__atomic_load_n(&appRunning, __ATOMIC_ACQUIRE))
+  {
+    uint32_t startMs = lv_tick_get();
+    uint64_t appUs = TargetBudget_app_begin();
+
+    TimeoutServer_handler();
+    app_commands_handle();
+    SimSettings_handler(startMs);
+    SensorIngest_update(startMs);
+    ViewModel_publish(startMs);
+    TargetBudget_app_end(appUs);
+
+    uint32_t spentMs = lv_tick_elaps(startMs);
+    if (spentMs < APP_THREAD_PERIOD_MS)
+    {
+      usleep((APP_THREAD_PERIOD_MS - spentMs) * 1000U);
+    }
+  }
+
+  return NULL;
+}
+#endif
+
+/** Let the application thread finish its period and wait for it, the state it owns is then free */
+static void app_thread_stop(void)
+{
+#if LV_USE_OS == LV_OS_PTHREAD
+  if (__atomic_exchange_n(&appRunning, false, __ATOMIC_ACQ_REL) && !pthread_equal(pthread_self(), appThread))
+  {
+    pthread_join(appThread, NULL);
+  }
+#endif
+}
+
+/** Keys change the configuration, which belongs to the application */
+static void key_post(const char *keyName)
+{
+  ViewModel_cmd_t cmd = { VIEW_MODEL_CMD_KEY, 0, { 0 } };
+
+  if (strlen(keyName) >= sizeof(cmd.keyName))
+  {
+    fprintf(stderr, "Key name too long: %s\n", keyName);
+    return;
+  }
+  strcpy(cmd.keyName, keyName);
+  if (!ViewModel_post_command(&cmd))
+  {
+    fprintf(stderr, "Command queue full, key %s dropped\n", keyName);
+  }
+}
+
+/** Commands the UI queued for the application */
+static void app_commands_handle(void)
+{
+  ViewModel_cmd_t cmd;
+  EventJournal_t *journal = SimScenario_get_journal();
+
+  while (ViewModel_poll_command(&cmd))
+  {
+    switch (cmd.type)
+    {
+    case VIEW_MODEL_CMD_ACK_SENSOR:
+      if (journal != NULL)
+      {
+        EventJournal_ack_all(journal, (int32_t) cmd.arg, (int64_t) lv_tick_get());
+      }
+      break;
+    case VIEW_MODEL_CMD_ACK_ALL:
+      if (journal != NULL)
+      {
+        EventJournal_ack_all(journal, EVENT_JOURNAL_ANY, (int64_t) lv_tick_get());
+      }
+      break;
+    case VIEW_MODEL_CMD_KEY:
+      ConfigurationHandler_SetKeyValue(cmd.keyName);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+/** Keep the settings descriptor in a simulated flash, restored from there if saved before */
+static bool settings_flash_open(void)
+{
+  Configuration_SettingsDescriptor_t *settings;
+
+  settingsFlash = SimFlash_open(flashPath, 0);
+  if (settingsFlash == NULL || !ConfigurationHandler_SettingsDescriptor_get(&settings) ||
+      !SimSettings_attach(settingsFlash, settings, (uint32_t) sizeof(*settings)))
+  {
+    SimFlash_close(settingsFlash);
+    settingsFlash = NULL;
+    return false;
+  }
+  printf("Settings %s %s\n", SimSettings_was_restored() ? "restored from" : "saved to", flashPath);
+  atexit(settings_flash_close);
+
+  return true;
+}
+
+static void settings_flash_close(void)
+{
+  SimFlash_stats_t stats;
+
+  /* Usually stopped already, see main(); SimSettings belongs to the application thread */
+  app_thread_stop();
+  SimSettings_detach();
+  SimFlash_get_stats(settingsFlash, &stats);
+  printf("Flash: %llu bytes written, %llu programmed (amplification %.2f), %llu sector erases, %u checkpoints, "
+         "wear max %u mean %u, busy %.1f ms\n",
+         (unsigned long long) stats.hostBytes, (unsigned long long) stats.programBytes,
+         SimFlash_get_write_amplification(settingsFlash), (unsigned long long) stats.sectorErases,
+         (unsigned) stats.checkpoints, (unsigned) stats.maxWear, (unsigned) stats.meanWear,
+         (double) stats.busyUs / 1000.0);
+  SimFlash_close(settingsFlash);
+  settingsFlash = NULL;
+}
+
+/** Adaptive refresh period on `disp`, every input device of it wakes it up */
+static void frame_pacer_start(lv_display_t *disp)
+{
+  FramePacer_init(disp, NULL);
+  for (lv_indev_t *indev = lv_indev_get_next(NULL); indev != NULL; indev = lv_indev_get_next(indev))
+  {
+    if (lv_indev_get_display(indev) == disp)
+    {
+      FramePacer_watch_indev(indev);
+    }
+  }
+}
+
+static void frame_stats_print(void)
+{
+  static const char *const modeNames[FRAME_PACER_MODES] = { "idle", "interactive" };
+  FramePacer_stats_t stats;
+
+  FramePacer_get_stats(&stats);
+  for (uint32_t i = 0; i < FRAME_PACER_MODES; i++)
+  {
+    printf("Frames %s: %u refreshes, %u drawn, %u late starts, %u render overruns\n", modeNames[i],
+           (unsigned) stats.refreshes[i], (unsigned) stats.frames[i], (unsigned) stats.lateStarts[i],
+           (unsigned) stats.renderOverruns[i]);
+  }
+  printf("Frames: render max %u ms, %u inputs, latency mean %.1f max %u ms, %u over one frame, "
+         "%u data updates in %u frames, %u mode switches\n",
+         (unsigned) stats.renderMsMax, (unsigned) stats.inputs,
+         (stats.inputs != 0U) ? (double) stats.inputLatencyMsTotal / stats.inputs : 0.0,
+         (unsigned) stats.inputLatencyMsMax, (unsigned) stats.inputLatencyMisses, (unsigned) stats.dataUpdates,
+         (unsigned) stats.dataFrames, (unsigned) stats.modeSwitches);
+}
+
+static void stream_stats_print(void)
+{
+  frame_stream_stats_t stats;
+
+  if (hal_stream_get_stats(&stats))
+  {
+    printf("Stream: %llu frames, %llu key frames, %llu tiles sent, %llu unchanged, %llu KB sent "
+           "(%llu KB uncompressed), %llu dropped\n",
+           (unsigned long long) stats.frames, (unsigned long long) stats.key_frames,
+           (unsigned long long) stats.tiles_sent, (unsigned long long) stats.tiles_unchanged,
+           (unsigned long long) (stats.bytes_sent / 1024U), (unsigned long long) (stats.raw_bytes / 1024U),
+           (unsigned long long) stats.dropped);
+  }
+}
+
+/** Predict the target's frame times if a calibration was given, and run at its speed with --throttle */
+static bool target_budget_start(lv_display_t *disp)
+{
+  TargetBudget_calibration_t cal;
+
+  if (targetPath == NULL)
+  {
+    return true;
+  }
+  TargetBudget_calibration_init(&cal);
+  if (!TargetBudget_load_calibration(targetPath, &cal))
+  {
+    return false;
+  }
+  TargetBudget_init(disp, &cal, targetThrottle ? TARGET_BUDGET_THROTTLE : TARGET_BUDGET_REPORT);
+  atexit(target_budget_print);
+
+  return true;
+}
+
+static void target_budget_print(void)
+{
+  const TargetBudget_calibration_t *cal = TargetBudget_get_calibration();
+  TargetBudget_screen_t screen;
+
+  printf("Target %s: factors layout %.2f render %.2f flush %.2f app %.2f, deadline %s\n", cal->target,
+         (double) cal->factor[TARGET_BUDGET_LAYOUT], (double) cal->factor[TARGET_BUDGET_RENDER],
+         (double) cal->factor[TARGET_BUDGET_FLUSH], (double) cal->factor[TARGET_BUDGET_APP],
+         (cal->deadlineMs != 0U) ? "fixed" : "refresh period");
+  for (uint32_t i = 0; TargetBudget_get_screen(i, &screen); i++)
+  {
+    double frames = (screen.frames != 0U) ? (double) screen.frames : 1.0;
+    double refreshes = (screen.refreshes != 0U) ? (double) screen.refreshes : 1.0;
+    printf("Target %s: %u frames, %.1f fps predicted, frame mean %.1f max %.1f ms, "
+           "per refresh layout %.2f render %.2f flush %.2f app %.2f ms, %u of %u refreshes over the deadline\n",
+           screen.name, (unsigned) screen.frames, (double) TargetBudget_get_predicted_fps(&screen),
+           (double) screen.frameTargetUs / frames / 1000.0, (double) screen.frameTargetUsMax / 1000.0,
+           (double) screen.targetUs[TARGET_BUDGET_LAYOUT] / refreshes / 1000.0,
+           (double) screen.targetUs[TARGET_BUDGET_RENDER] / refreshes / 1000.0,
+           (double) screen.targetUs[TARGET_BUDGET_FLUSH] / refreshes / 1000.0,
+           (double) screen.targetUs[TARGET_BUDGET_APP] / refreshes / 1000.0, (unsigned) screen.misses,
+           (unsigned) screen.refreshes);
+  }
+}
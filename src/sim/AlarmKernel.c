@@ -0,0 +1,418 @@
+/**
+ * @file AlarmKernel.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define ALARM_KERNEL_SSE2 1
+#else
+  #define ALARM_KERNEL_SSE2 0
+#endif
+
+#include "AlarmKernel.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define FUZZ_MAX_EVENTS (SIM_DESCRIPTOR_MAX_SENSORS * ALARM_KERNEL_ENTRIES)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  uint32_t count;
+  uint32_t events[FUZZ_MAX_EVENTS]; /**< sensor << 8 | entry << 1 | active */
+} event_log_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void entry_scalar(const AlarmKernel_levels_t *levels, AlarmKernel_state_t *state, uint32_t sensor,
+                         uint8_t entry, bool condition, bool release, uint32_t nowMs, AlarmKernel_event_cb_t cb);
+static void fuzz_event_cb(uint32_t sensor, uint8_t entry, bool active, uint32_t nowMs);
+static uint32_t fuzz_random(uint32_t *seed);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static event_log_t *fuzzLog;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void AlarmKernel_load(AlarmKernel_levels_t *levels, const SimDescriptor_t *desc)
+{
+  memset(levels, 0, sizeof(*levels));
+  levels->sensorCount = desc->sensorCount;
+
+  for (uint32_t s = 0; s < desc->sensorCount; s++)
+  {
+    const SimDescriptor_sensor_t *sensor = &desc->sensors[s];
+    levels->sensorActive[s] = sensor->active ? -1 : 0;
+    for (uint32_t e = 0; e < ALARM_KERNEL_ENTRIES; e++)
+    {
+      const SimDescriptor_level_t *level = (e == ALARM_KERNEL_FAULT) ? &sensor->fault : &sensor->levels[e];
+      levels->threshold[e][s] = level->threshold;
+      levels->hysteresis[e][s] = level->hysteresis;
+      levels->rising[e][s] = SimDescriptor_level_rising(sensor->mode, level) ? -1 : 0;
+      levels->armed[e][s] = (sensor->active && level->enabled) ? -1 : 0;
+      levels->delayMs[e][s] = level->delayS * 1000U;
+      levels->timeoutMs[e][s] = level->timeoutS * 1000U;
+    }
+  }
+}
+
+void AlarmKernel_reset(AlarmKernel_state_t *state)
+{
+  memset(state, 0, sizeof(*state));
+}
+
+void AlarmKernel_update_scalar(const AlarmKernel_levels_t *levels, AlarmKernel_state_t *state,
+                               const int32_t *values, const bool *faults, uint32_t nowMs,
+                               AlarmKernel_event_cb_t cb)
+{
+  for (uint32_t s = 0; s < levels->sensorCount; s++)
+  {
+    bool fault = levels->sensorActive[s] != 0 && faults[s];
+    int32_t value = values[s];
+
+    entry_scalar(levels, state, s, ALARM_KERNEL_FAULT, fault, !fault, nowMs, cb);
+    if (fault)
+    {
+      continue;
+    }
+
+    for (uint8_t l = 0; l < SIM_DESCRIPTOR_LEVELS; l++)
+    {
+      bool condition;
+      bool release;
+
+      if (levels->rising[l][s] != 0)
+      {
+        condition = value >= levels->threshold[l][s];
+        release = value < levels->hysteresis[l][s];
+      }
+      else
+      {
+        condition = value <= levels->threshold[l][s];
+        release = value > levels->hysteresis[l][s];
+      }
+      entry_scalar(levels, state, s, l, condition, release, nowMs, cb);
+    }
+  }
+}
+
+#if ALARM_KERNEL_SSE2
+
+/** (mask & a) | (~mask & b) */
+static inline __m128i select_epi32(__m128i mask, __m128i a, __m128i b)
+{
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/** Unsigned a >= b per lane */
+static inline __m128i uge_epi32(__m128i a, __m128i b)
+{
+  const __m128i bias = _mm_set1_epi32(INT32_MIN);
+  return _mm_xor_si128(_mm_cmpgt_epi32(_mm_xor_si128(b, bias), _mm_xor_si128(a, bias)), _mm_set1_epi32(-1));
+}
+
+static inline int lane_bits(__m128i mask)
+{
+  return _mm_movemask_ps(_mm_castsi128_ps(mask));
+}
+
+/**
+ * Four lanes of entry_scalar(): `condition` and `release` are lane masks, the
+ * state only changes where `update` is set. Returns the lanes that
+ * triggered in `on` and released in `off`.
+ */
+static inline void entry_sse2(const AlarmKernel_levels_t *levels, AlarmKernel_state_t *state, uint32_t entry,
+                              uint32_t s, __m128i condition, __m128i release, __m128i update, __m128i now, int *on,
+                              int *off)
+{
+  const __m128i armed = _mm_loadu_si128((const __m128i *) &levels->armed[entry][s]);
+  const __m128i delay = _mm_loadu_si128((const __m128i *) &levels->delayMs[entry][s]);
+  const __m128i timeout = _mm_loadu_si128((const __m128i *) &levels->timeoutMs[entry][s]);
+  __m128i active = _mm_loadu_si128((const __m128i *) &state->active[entry][s]);
+  __m128i pending = _mm_loadu_si128((const __m128i *) &state->pending[entry][s]);
+  __m128i since = _mm_loadu_si128((const __m128i *) &state->sinceMs[entry][s]);
+
+  /* A disabled entry never triggers and always may release */
+  condition = _mm_and_si128(condition, armed);
+  release = _mm_or_si128(release, _mm_xor_si128(armed, _mm_set1_epi32(-1)));
+
+  /* Inactive: the delay starts with the condition, the entry fires once it elapsed */
+  __m128i started = select_epi32(_mm_andnot_si128(pending, condition), now, since);
+  __m128i fire = _mm_and_si128(condition, uge_epi32(_mm_sub_epi32(now, started), delay));
+  __m128i pendingIn = _mm_andnot_si128(fire, condition);
+  __m128i sinceIn = select_epi32(fire, now, started);
+
+  /* Active: released once the hold time is over */
+  __m128i drop = _mm_and_si128(release, uge_epi32(_mm_sub_epi32(now, since), timeout));
+
+  __m128i newActive = select_epi32(active, _mm_andnot_si128(drop, active), fire);
+  __m128i newPending = select_epi32(active, pending, pendingIn);
+  __m128i newSince = select_epi32(active, since, sinceIn);
+
+  _mm_storeu_si128((__m128i *) &state->active[entry][s], select_epi32(update, newActive, active));
+  _mm_storeu_si128((__m128i *) &state->pending[entry][s], select_epi32(update, newPending, pending));
+  _mm_storeu_si128((__m128i *) &state->sinceMs[entry][s], select_epi32(update, newSince, since));
+
+  *on = lane_bits(_mm_and_si128(update, _mm_andnot_si128(active, fire)));
+  *off = lane_bits(_mm_and_si128(update, _mm_and_si128(active, drop)));
+}
+
+void AlarmKernel_update(const AlarmKernel_levels_t *levels, AlarmKernel_state_t *state, const int32_t *values,
+                        const bool *faults, uint32_t nowMs, AlarmKernel_event_cb_t cb)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i count = _mm_set1_epi32((int32_t) levels->sensorCount);
+  const __m128i now = _mm_set1_epi32((int32_t) nowMs);
+
+  for (uint32_t s = 0; s < levels->sensorCount; s += 4U)
+  {
+    int on[ALARM_KERNEL_ENTRIES];
+    int off[ALARM_KERNEL_ENTRIES];
+    int changed = 0;
+    uint32_t faultBytes;
+
+    /* Lanes past the sensor count are left alone, the arrays are padded to the maximum */
+    __m128i valid = _mm_cmpgt_epi32(count, _mm_setr_epi32((int32_t) s, (int32_t) s + 1, (int32_t) s + 2,
+                                                          (int32_t) s + 3));
+    __m128i value = _mm_loadu_si128((const __m128i *) &values[s]);
+    memcpy(&faultBytes, &faults[s], sizeof(faultBytes));
+    __m128i fault = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int32_t) faultBytes), zero), zero);
+    fault = _mm_andnot_si128(_mm_cmpeq_epi32(fault, zero),
+                             _mm_loadu_si128((const __m128i *) &levels->sensorActive[s]));
+
+    entry_sse2(levels, state, ALARM_KERNEL_FAULT, s, fault, _mm_xor_si128(fault, _mm_set1_epi32(-1)), valid, now,
+               &on[ALARM_KERNEL_FAULT], &off[ALARM_KERNEL_FAULT]);
+    changed |= on[ALARM_KERNEL_FAULT] | off[ALARM_KERNEL_FAULT];
+
+    /* Faulted sensors keep their level state */
+    __m128i update = _mm_andnot_si128(fault, valid);
+    for (uint32_t l = 0; l < SIM_DESCRIPTOR_LEVELS; l++)
+    {
+      __m128i threshold = _mm_loadu_si128((const __m128i *) &levels->threshold[l][s]);
+      __m128i hysteresis = _mm_loadu_si128((const __m128i *) &levels->hysteresis[l][s]);
+      __m128i rising = _mm_loadu_si128((const __m128i *) &levels->rising[l][s]);
+      /* value >= threshold is !(threshold > value), value < hysteresis is hysteresis > value */
+      __m128i condRising = _mm_cmpgt_epi32(threshold, value);
+      __m128i condFalling = _mm_cmpgt_epi32(value, threshold);
+      __m128i condition = _mm_xor_si128(select_epi32(rising, condRising, condFalling), _mm_set1_epi32(-1));
+      __m128i release = select_epi32(rising, _mm_cmpgt_epi32(hysteresis, value), _mm_cmpgt_epi32(value, hysteresis));
+
+      entry_sse2(levels, state, l, s, condition, release, update, now, &on[l], &off[l]);
+      changed |= on[l] | off[l];
+    }
+
+    /* Events in the order of the scalar code */
+    for (uint32_t lane = 0; changed != 0 && cb != NULL && lane < 4U; lane++)
+    {
+      int bit = 1 << lane;
+      for (uint32_t i = 0; i < ALARM_KERNEL_ENTRIES; i++)
+      {
+        uint32_t e = (i == 0) ? ALARM_KERNEL_FAULT : i - 1U;
+        if ((on[e] | off[e]) & bit)
+        {
+          cb(s + lane, (uint8_t) e, (on[e] & bit) != 0, nowMs);
+        }
+      }
+    }
+  }
+}
+
+bool AlarmKernel_is_vectorized(void)
+{
+  return true;
+}
+
+#else
+
+void AlarmKernel_update(const AlarmKernel_levels_t *levels, AlarmKernel_state_t *state, const int32_t *values,
+                        const bool *faults, uint32_t nowMs, AlarmKernel_event_cb_t cb)
+{
+  AlarmKernel_update_scalar(levels, state, values, faults, nowMs, cb);
+}
+
+bool AlarmKernel_is_vectorized(void)
+{
+  return false;
+}
+
+#endif /*ALARM_KERNEL_SSE2*/
+
+uint8_t AlarmKernel_get_state(const AlarmKernel_state_t *state, uint32_t sensor)
+{
+  uint8_t bits = 0;
+
+  if (sensor >= SIM_DESCRIPTOR_MAX_SENSORS)
+  {
+    return 0;
+  }
+  for (uint32_t e = 0; e < ALARM_KERNEL_ENTRIES; e++)
+  {
+    bits |= (uint8_t) ((state->active[e][sensor] != 0) ? (1U << e) : 0U);
+  }
+
+  return bits;
+}
+
+uint32_t AlarmKernel_fuzz_compare(uint32_t seed, uint32_t steps)
+{
+  AlarmKernel_levels_t *levels = malloc(sizeof(AlarmKernel_levels_t));
+  AlarmKernel_state_t *reference = malloc(sizeof(AlarmKernel_state_t));
+  AlarmKernel_state_t *kernel = malloc(sizeof(AlarmKernel_state_t));
+  event_log_t *logs = malloc(sizeof(event_log_t) * 2U);
+  int32_t values[SIM_DESCRIPTOR_MAX_SENSORS];
+  bool faults[SIM_DESCRIPTOR_MAX_SENSORS];
+  uint32_t mismatches = 0;
+
+  if (levels == NULL || reference == NULL || kernel == NULL || logs == NULL)
+  {
+    free(levels);
+    free(reference);
+    free(kernel);
+    free(logs);
+    return steps;
+  }
+  seed = (seed != 0U) ? seed : 1U;
+
+  /* Small value range so that values hit thresholds and hystereses exactly */
+  memset(levels, 0, sizeof(*levels));
+  levels->sensorCount = 1U + fuzz_random(&seed) % SIM_DESCRIPTOR_MAX_SENSORS;
+  for (uint32_t s = 0; s < levels->sensorCount; s++)
+  {
+    levels->sensorActive[s] = (fuzz_random(&seed) % 8U != 0U) ? -1 : 0;
+    for (uint32_t e = 0; e < ALARM_KERNEL_ENTRIES; e++)
+    {
+      levels->threshold[e][s] = (int32_t) (fuzz_random(&seed) % 41U) - 20;
+      levels->hysteresis[e][s] = levels->threshold[e][s] + (int32_t) (fuzz_random(&seed) % 11U) - 5;
+      levels->rising[e][s] = (fuzz_random(&seed) & 1U) ? -1 : 0;
+      levels->armed[e][s] = (levels->sensorActive[s] != 0 && fuzz_random(&seed) % 6U != 0U) ? -1 : 0;
+      levels->delayMs[e][s] = (fuzz_random(&seed) % 4U) * 1000U;
+      levels->timeoutMs[e][s] = (fuzz_random(&seed) % 4U) * 1000U;
+    }
+  }
+  AlarmKernel_reset(reference);
+  AlarmKernel_reset(kernel);
+  memset(values, 0, sizeof(values));
+  memset(faults, 0, sizeof(faults));
+
+  /* Start close to the wrap of the millisecond clock */
+  uint32_t nowMs = UINT32_MAX - 20000U;
+  for (uint32_t step = 0; step < steps; step++)
+  {
+    nowMs += fuzz_random(&seed) % 700U;
+    for (uint32_t s = 0; s < levels->sensorCount; s++)
+    {
+      uint32_t r = fuzz_random(&seed);
+      if (r % 4U == 0U)
+      {
+        values[s] = (int32_t) ((r >> 8) % 51U) - 25;
+      }
+      if (r % 97U == 0U)
+      {
+        faults[s] = !faults[s];
+      }
+    }
+
+    fuzzLog = &logs[0];
+    fuzzLog->count = 0;
+    AlarmKernel_update_scalar(levels, reference, values, faults, nowMs, fuzz_event_cb);
+    fuzzLog = &logs[1];
+    fuzzLog->count = 0;
+    AlarmKernel_update(levels, kernel, values, faults, nowMs, fuzz_event_cb);
+    fuzzLog = NULL;
+
+    if (memcmp(reference, kernel, sizeof(*kernel)) != 0 || logs[0].count != logs[1].count ||
+        memcmp(logs[0].events, logs[1].events, sizeof(uint32_t) * logs[0].count) != 0)
+    {
+      mismatches++;
+      /* Continue from the same state to count further differences only */
+      memcpy(kernel, reference, sizeof(*kernel));
+    }
+  }
+
+  free(levels);
+  free(reference);
+  free(kernel);
+  free(logs);
+
+  return mismatches;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void entry_scalar(const AlarmKernel_levels_t *levels, AlarmKernel_state_t *state, uint32_t sensor,
+                         uint8_t entry, bool condition, bool release, uint32_t nowMs, AlarmKernel_event_cb_t cb)
+{
+  if (levels->armed[entry][sensor] == 0)
+  {
+    condition = false;
+    release = true;
+  }
+
+  if (state->active[entry][sensor] == 0)
+  {
+    if (!condition)
+    {
+      state->pending[entry][sensor] = 0;
+      return;
+    }
+    if (state->pending[entry][sensor] == 0)
+    {
+      state->pending[entry][sensor] = -1;
+      state->sinceMs[entry][sensor] = nowMs;
+    }
+    if (nowMs - state->sinceMs[entry][sensor] >= levels->delayMs[entry][sensor])
+    {
+      state->pending[entry][sensor] = 0;
+      state->active[entry][sensor] = -1;
+      state->sinceMs[entry][sensor] = nowMs;
+      if (cb != NULL)
+      {
+        cb(sensor, entry, true, nowMs);
+      }
+    }
+  }
+  else if (release && nowMs - state->sinceMs[entry][sensor] >= levels->timeoutMs[entry][sensor])
+  {
+    state->active[entry][sensor] = 0;
+    if (cb != NULL)
+    {
+      cb(sensor, entry, false, nowMs);
+    }
+  }
+}
+
+static void fuzz_event_cb(uint32_t sensor, uint8_t entry, bool active, uint32_t nowMs)
+{
+  (void) nowMs;
+  if (fuzzLog != NULL && fuzzLog->count < FUZZ_MAX_EVENTS)
+  {
+    fuzzLog->events[fuzzLog->count++] = (sensor << 8) | ((uint32_t) entry << 1) | (active ? 1U : 0U);
+  }
+}
+
+/** xorshift32 */
+static uint32_t fuzz_random(uint32_t *seed)
+{
+  uint32_t x = *seed;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *seed = x;
+  return x;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file AlarmKernel.h
+ * Threshold and hysteresis evaluation of all sensor levels at once.
+ *
+ * The descriptor levels are copied into one array per field and entry
+ * (structure of arrays), and the per-level state is kept the same way, one
+ * 32-bit lane per sensor. AlarmKernel_update() then evaluates a level of four
+ * sensors with a few SSE2 compares and blends, without branches, and walks
+ * only the lanes that changed to report events. AlarmKernel_update_scalar()
+ * is the reference implementation on the same state; both give the same
+ * state and the same events in the same order (sensor by sensor, fault
+ * first, then levels 0..3).
+ *
+ * Without SSE2 AlarmKernel_update() falls back to the scalar code.
+ */
+
+#ifndef ALARM_KERNEL_H
+#define ALARM_KERNEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "SimDescriptor.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/** Entry of the fault next to the levels 0..3 */
+#define ALARM_KERNEL_FAULT SIM_DESCRIPTOR_LEVELS
+#define ALARM_KERNEL_ENTRIES (SIM_DESCRIPTOR_LEVELS + 1)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef void (*AlarmKernel_event_cb_t)(uint32_t sensor, uint8_t entry, bool active, uint32_t nowMs);
+
+/** Levels of all sensors, a lane is all ones for true */
+typedef struct {
+  uint32_t sensorCount;
+  int32_t threshold[ALARM_KERNEL_ENTRIES][SIM_DESCRIPTOR_MAX_SENSORS];
+  int32_t hysteresis[ALARM_KERNEL_ENTRIES][SIM_DESCRIPTOR_MAX_SENSORS];
+  int32_t rising[ALARM_KERNEL_ENTRIES][SIM_DESCRIPTOR_MAX_SENSORS];
+  int32_t armed[ALARM_KERNEL_ENTRIES][SIM_DESCRIPTOR_MAX_SENSORS];   /**< sensor active and entry enabled */
+  int32_t sensorActive[SIM_DESCRIPTOR_MAX_SENSORS];
+  uint32_t delayMs[ALARM_KERNEL_ENTRIES][SIM_DESCRIPTOR_MAX_SENSORS];
+  uint32_t timeoutMs[ALARM_KERNEL_ENTRIES][SIM_DESCRIPTOR_MAX_SENSORS];
+} AlarmKernel_levels_t;
+
+typedef struct {
+  int32_t active[ALARM_KERNEL_ENTRIES][SIM_DESCRIPTOR_MAX_SENSORS];
+  int32_t pending[ALARM_KERNEL_ENTRIES][SIM_DESCRIPTOR_MAX_SENSORS];  /**< condition holds, delay running */
+  uint32_t sinceMs[ALARM_KERNEL_ENTRIES][SIM_DESCRIPTOR_MAX_SENSORS];
+} AlarmKernel_state_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Copy the levels of `desc` */
+void AlarmKernel_load(AlarmKernel_levels_t *levels, const SimDescriptor_t *desc);
+
+void AlarmKernel_reset(AlarmKernel_state_t *state);
+
+/**
+ * Evaluate all entries for the sensor `values` and `faults` (both indexed by
+ * sensor, at least SIM_DESCRIPTOR_MAX_SENSORS long). `cb` may be NULL.
+ */
+void AlarmKernel_update(const AlarmKernel_levels_t *levels, AlarmKernel_state_t *state, const int32_t *values,
+                        const bool *faults, uint32_t nowMs, AlarmKernel_event_cb_t cb);
+
+/** Scalar reference of AlarmKernel_update() */
+void AlarmKernel_update_scalar(const AlarmKernel_levels_t *levels, AlarmKernel_state_t *state,
+                               const int32_t *values, const bool *faults, uint32_t nowMs,
+                               AlarmKernel_event_cb_t cb);
+
+/** Active entries of a sensor, bit per entry */
+uint8_t AlarmKernel_get_state(const AlarmKernel_state_t *state, uint32_t sensor);
+
+/** true if AlarmKernel_update() uses vector instructions */
+bool AlarmKernel_is_vectorized(void);
+
+/**
+ * Run both implementations side by side on random levels, values and faults
+ * for `steps` updates and return the number of steps whose state or events
+ * differ. Meant for the bench and for checks after changes to either one.
+ */
+uint32_t AlarmKernel_fuzz_compare(uint32_t seed, uint32_t steps);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*ALARM_KERNEL_H*/
@@ -0,0 +1,141 @@
+/**
+ * @file SensorIngest.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "SensorIngest.h"
+#include "SimSensors.h"
+#include "SimAlarms.h"
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static int32_t saturate(int64_t value);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/* The conversion plan, one entry per sensor */
+static int32_t displayMul[SIM_DESCRIPTOR_MAX_SENSORS];
+static int32_t displayDiv[SIM_DESCRIPTOR_MAX_SENSORS];
+static int32_t ranges[SIM_DESCRIPTOR_MAX_SENSORS];
+static uint32_t fillScale[SIM_DESCRIPTOR_MAX_SENSORS]; /**< SENSOR_INGEST_FILL_ONE / range, Q16 */
+static uint32_t planCount;
+static bool planLoaded;
+
+static SensorIngest_snapshot_t snapshot;
+
+/** Most severe level of the level bits of an alarm state */
+static const uint8_t highestLevel[1U << SIM_DESCRIPTOR_LEVELS] = {
+  0, 1, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4,
+};
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void SensorIngest_reset(void)
+{
+  const SimDescriptor_t *desc = SimDescriptor_get();
+
+  memset(&snapshot, 0, sizeof(snapshot));
+  planCount = (desc != NULL) ? desc->sensorCount : 0U;
+  for (uint32_t s = 0; s < SIM_DESCRIPTOR_MAX_SENSORS; s++)
+  {
+    const SimDescriptor_sensor_t *sensor = (s < planCount) ? &desc->sensors[s] : NULL;
+    uint8_t decimals = (sensor != NULL) ? sensor->decimals : 0U;
+    int32_t range = (sensor != NULL && sensor->range > 0) ? sensor->range : 100;
+
+    /* Raw units to thousandths, a multiply for up to three decimals, a divide beyond */
+    displayMul[s] = 1;
+    displayDiv[s] = 1;
+    for (uint8_t d = decimals; d < SENSOR_INGEST_DISPLAY_DECIMALS; d++)
+    {
+      displayMul[s] *= 10;
+    }
+    for (uint8_t d = SENSOR_INGEST_DISPLAY_DECIMALS; d < decimals && d < 9U; d++)
+    {
+      displayDiv[s] *= 10;
+    }
+    ranges[s] = range;
+    /* Rounded up, so full scale gives SENSOR_INGEST_FILL_ONE */
+    fillScale[s] = (uint32_t) ((((uint64_t) SENSOR_INGEST_FILL_ONE << 16) + (uint32_t) range - 1U) / (uint32_t) range);
+    snapshot.modes[s] = (uint8_t) ((sensor != NULL) ? sensor->mode : SIM_SENSOR_MODE_NORMAL);
+  }
+  snapshot.sensorCount = planCount;
+  planLoaded = true;
+}
+
+void SensorIngest_update(uint32_t nowMs)
+{
+  if (!planLoaded)
+  {
+    SensorIngest_reset();
+  }
+
+  const int32_t *values = SimSensors_get_values();
+  const uint32_t *timestamps = SimSensors_get_timestamps();
+  memcpy(snapshot.values, values, planCount * sizeof(snapshot.values[0]));
+  memcpy(snapshot.faults, SimSensors_get_faults(), planCount * sizeof(snapshot.faults[0]));
+  memcpy(snapshot.timestamps, timestamps, planCount * sizeof(snapshot.timestamps[0]));
+
+  /* One pass per field, each a plain loop over the arrays */
+  for (uint32_t s = 0; s < planCount; s++)
+  {
+    snapshot.display[s] = saturate((int64_t) values[s] * displayMul[s] / displayDiv[s]);
+  }
+  for (uint32_t s = 0; s < planCount; s++)
+  {
+    int32_t clamped = (values[s] < 0) ? 0 : ((values[s] > ranges[s]) ? ranges[s] : values[s]);
+    uint64_t fill = ((uint64_t) (uint32_t) clamped * fillScale[s]) >> 16;
+    snapshot.fill[s] = (uint16_t) ((fill > SENSOR_INGEST_FILL_ONE) ? SENSOR_INGEST_FILL_ONE : fill);
+  }
+  for (uint32_t s = 0; s < planCount; s++)
+  {
+    uint8_t state = SimAlarms_get_state(s);
+    snapshot.alarmStates[s] = state;
+    snapshot.levels[s] = highestLevel[state & ((1U << SIM_DESCRIPTOR_LEVELS) - 1U)];
+  }
+
+  snapshot.timeMs = nowMs;
+  snapshot.seq++;
+}
+
+const SensorIngest_snapshot_t *SensorIngest_get(void)
+{
+  if (!planLoaded)
+  {
+    SensorIngest_reset();
+  }
+
+  return &snapshot;
+}
+
+int32_t SensorIngest_to_display(uint32_t sensor, int32_t raw)
+{
+  if (!planLoaded)
+  {
+    SensorIngest_reset();
+  }
+  if (sensor >= SIM_DESCRIPTOR_MAX_SENSORS)
+  {
+    return 0;
+  }
+
+  return saturate((int64_t) raw * displayMul[sensor] / displayDiv[sensor]);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static int32_t saturate(int64_t value)
+{
+  return (value > INT32_MAX) ? INT32_MAX : ((value < INT32_MIN) ? INT32_MIN : (int32_t) value);
+}
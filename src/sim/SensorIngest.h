@@ -0,0 +1,88 @@
+/**
+ * @file SensorIngest.h
+ * Sensor readings converted once into a fixed-point snapshot.
+ *
+ * Every consumer used to look up the descriptor range, decimals and mode of a
+ * sensor and scale its raw value on its own. SensorIngest_reset() turns the
+ * descriptor into a conversion plan, and SensorIngest_update() applies it to
+ * SimSensors and SimAlarms once per step, for all sensors, into arrays indexed
+ * by sensor (structure of arrays):
+ *
+ * - `values`: raw descriptor units, as SimSensors
+ * - `display`: thousandths of the unit, the same fixed point for all sensors
+ * - `fill`: position within the range, 0..SENSOR_INGEST_FILL_ONE
+ * - `levels`: most severe active level, 1..SIM_DESCRIPTOR_LEVELS, 0 for none
+ * - `alarmStates`: active entries as SimAlarms_get_state()
+ * - `faults`, `timestamps`
+ *
+ * Levels come from the alarm evaluation, which already applies the sensor
+ * mode: oxygen sensors alarm on falling values, window sensors per level.
+ * The plan keeps the mode with it, `modes`, so readers need no descriptor.
+ *
+ * Readers take the snapshot by pointer, nothing is copied; it is valid until
+ * the next update, on the thread that runs the updates.
+ */
+
+#ifndef SENSOR_INGEST_H
+#define SENSOR_INGEST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "SimDescriptor.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/** `fill` of a value at full scale (Q15) */
+#define SENSOR_INGEST_FILL_ONE 32767U
+
+/** Decimal places of `display` */
+#define SENSOR_INGEST_DISPLAY_DECIMALS 3U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  uint32_t seq;         /**< updates so far */
+  uint32_t timeMs;      /**< time of the last update */
+  uint32_t sensorCount;
+  int32_t values[SIM_DESCRIPTOR_MAX_SENSORS];
+  int32_t display[SIM_DESCRIPTOR_MAX_SENSORS];
+  uint32_t timestamps[SIM_DESCRIPTOR_MAX_SENSORS];
+  uint16_t fill[SIM_DESCRIPTOR_MAX_SENSORS];
+  uint8_t levels[SIM_DESCRIPTOR_MAX_SENSORS];
+  uint8_t alarmStates[SIM_DESCRIPTOR_MAX_SENSORS];
+  uint8_t modes[SIM_DESCRIPTOR_MAX_SENSORS];  /**< SimDescriptor_mode_t */
+  bool faults[SIM_DESCRIPTOR_MAX_SENSORS];
+} SensorIngest_snapshot_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Build the conversion plan of the current descriptor and clear the snapshot */
+void SensorIngest_reset(void);
+
+/** Convert the current readings and alarm states, after SimAlarms_update() */
+void SensorIngest_update(uint32_t nowMs);
+
+/** The snapshot of the last update */
+const SensorIngest_snapshot_t *SensorIngest_get(void);
+
+/** Raw value of `sensor` in thousandths of its unit, as `display` */
+int32_t SensorIngest_to_display(uint32_t sensor, int32_t raw);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SENSOR_INGEST_H*/
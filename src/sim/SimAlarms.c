@@ -0,0 +1,75 @@
+/**
+ * @file SimAlarms.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "SimAlarms.h"
+#include "SimSensors.h"
+#include "AlarmKernel.h"
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static AlarmKernel_levels_t levels;
+static AlarmKernel_state_t state;
+static bool levelsLoaded;
+static SimAlarms_event_cb_t eventCb;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void SimAlarms_reset(void)
+{
+  AlarmKernel_load(&levels, SimDescriptor_get());
+  AlarmKernel_reset(&state);
+  levelsLoaded = true;
+}
+
+void SimAlarms_set_event_cb(SimAlarms_event_cb_t cb)
+{
+  eventCb = cb;
+}
+
+void SimAlarms_update(uint32_t nowMs)
+{
+  if (!levelsLoaded)
+  {
+    SimAlarms_reset();
+  }
+  AlarmKernel_update(&levels, &state, SimSensors_get_values(), SimSensors_get_faults(), nowMs, eventCb);
+}
+
+uint8_t SimAlarms_get_state(uint32_t sensor)
+{
+  return AlarmKernel_get_state(&state, sensor);
+}
+
+void SimAlarms_get_relay_demand(SimDescriptor_relayMask_t demand)
+{
+  const SimDescriptor_t *desc = SimDescriptor_get();
+
+  memset(demand, 0, sizeof(SimDescriptor_relayMask_t));
+  for (uint32_t s = 0; s < levels.sensorCount; s++)
+  {
+    uint8_t active = AlarmKernel_get_state(&state, s);
+    for (uint8_t e = 0; active != 0 && e < SIM_ALARMS_ENTRIES; e++)
+    {
+      if ((active & (1U << e)) == 0)
+      {
+        continue;
+      }
+      const SimDescriptor_level_t *level =
+          (e == SIM_ALARMS_FAULT) ? &desc->sensors[s].fault : &desc->sensors[s].levels[e];
+      for (uint32_t w = 0; w < SIM_DESCRIPTOR_RELAY_WORDS; w++)
+      {
+        demand[w] |= level->relays[w];
+      }
+    }
+  }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file SimAlarms.h
+ * Reference evaluation of the descriptor alarm levels.
+ *
+ * Each sensor has four levels and a fault entry. A level triggers once its
+ * condition held for `delayS` and releases when the value crossed back over
+ * the hysteresis, but not before it was active for `timeoutS`. While a sensor
+ * is faulted its levels keep their state.
+ *
+ * The evaluation runs in AlarmKernel on a copy of the levels that is taken
+ * by SimAlarms_reset(), vectorized where the target supports it.
+ */
+
+#ifndef SIM_ALARMS_H
+#define SIM_ALARMS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "SimDescriptor.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/** Index of the fault entry next to the levels 0..3 */
+#define SIM_ALARMS_FAULT SIM_DESCRIPTOR_LEVELS
+
+#define SIM_ALARMS_ENTRIES (SIM_DESCRIPTOR_LEVELS + 1)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/** Called for every level or fault that triggers (`active`) or releases */
+typedef void (*SimAlarms_event_cb_t)(uint32_t sensor, uint8_t level, bool active, uint32_t nowMs);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Release all levels and copy the levels of the current descriptor, needed after a new descriptor was loaded */
+void SimAlarms_reset(void);
+
+void SimAlarms_set_event_cb(SimAlarms_event_cb_t cb);
+
+/** Evaluate all configured sensors of the current descriptor against SimSensors */
+void SimAlarms_update(uint32_t nowMs);
+
+/** Active entries of a sensor, bit n for level n and bit SIM_ALARMS_FAULT for the fault */
+uint8_t SimAlarms_get_state(uint32_t sensor);
+
+/** Relays requested by all active levels and faults */
+void SimAlarms_get_relay_demand(SimDescriptor_relayMask_t demand);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SIM_ALARMS_H*/
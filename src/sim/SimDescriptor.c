@@ -0,0 +1,642 @@
+/**
+ * @file SimDescriptor.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "SimDescriptor.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#ifndef SIM_DESCRIPTOR_DEFAULT_PATH
+  #define SIM_DESCRIPTOR_DEFAULT_PATH "src/Configuration.inc"
+#endif
+
+/** Positions inside the settings block of the descriptor */
+#define SETTINGS_DATE 0
+#define SETTINGS_NAME 1
+#define SETTINGS_ALARM_TEXT 4
+#define SETTINGS_FAULT_TEXT 5
+#define SETTINGS_TEMPERATURE_LOW 8
+#define SETTINGS_TEMPERATURE_HIGH 9
+#define SETTINGS_STARTUP_TIME 12
+#define SETTINGS_SENSOR_COUNT 15
+#define SETTINGS_RELAY_COUNT 16
+#define SETTINGS_SENSORS 18
+#define SETTINGS_RELAYS 19
+#define SETTINGS_TIMERS 20
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+  NODE_NUMBER,
+  NODE_STRING,
+  NODE_IDENT,
+  NODE_LIST,
+} node_type_t;
+
+/** Parsed initializer. List children are linked through `next` */
+typedef struct node {
+  node_type_t type;
+  int64_t number;
+  char text[SIM_DESCRIPTOR_TEXT_LEN];
+  struct node *child;
+  struct node *next;
+} node_t;
+
+typedef struct {
+  const char *pos;
+  uint32_t line;
+  bool failed;
+} parser_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static char *read_file(const char *path);
+static void skip_space(parser_t *p);
+static bool accept(parser_t *p, const char *token);
+static node_t *parse_value(parser_t *p);
+static node_t *parse_list(parser_t *p);
+static node_t *parse_expr(parser_t *p);
+static node_t *parse_shift(parser_t *p);
+static node_t *parse_add(parser_t *p);
+static node_t *parse_mul(parser_t *p);
+static node_t *parse_unary(parser_t *p);
+static node_t *parse_primary(parser_t *p);
+static node_t *node_new(node_type_t type);
+static void node_free(node_t *node);
+static const node_t *node_at(const node_t *list, uint32_t index);
+static int64_t node_int(const node_t *node);
+static void node_text(const node_t *node, char *dst);
+static void read_relay_mask(const node_t *list, SimDescriptor_relayMask_t mask);
+static void read_level(const node_t *list, SimDescriptor_level_t *level);
+static void read_sensor(const node_t *list, SimDescriptor_sensor_t *sensor);
+static bool read_descriptor(const node_t *root, SimDescriptor_t *desc);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static SimDescriptor_t descriptor;
+static bool descriptorLoaded;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+bool SimDescriptor_load(const char *path)
+{
+  char *source = read_file(path);
+  if (source == NULL)
+  {
+    fprintf(stderr, "SimDescriptor: cannot read %s\n", path);
+    return false;
+  }
+
+  parser_t parser = { source, 1, false };
+  node_t *root = parse_value(&parser);
+  skip_space(&parser);
+  if (parser.failed || root == NULL || root->type != NODE_LIST)
+  {
+    fprintf(stderr, "SimDescriptor: %s:%u: syntax error\n", path, (unsigned) parser.line);
+    node_free(root);
+    free(source);
+    return false;
+  }
+
+  SimDescriptor_t *loaded = calloc(1, sizeof(SimDescriptor_t));
+  bool ok = (loaded != NULL) && read_descriptor(root, loaded);
+  if (ok)
+  {
+    descriptor = *loaded;
+    descriptorLoaded = true;
+  }
+  else
+  {
+    fprintf(stderr, "SimDescriptor: %s is not a settings descriptor\n", path);
+  }
+
+  free(loaded);
+  node_free(root);
+  free(source);
+
+  return ok;
+}
+
+const SimDescriptor_t *SimDescriptor_get(void)
+{
+  if (!descriptorLoaded && !SimDescriptor_load(SIM_DESCRIPTOR_DEFAULT_PATH))
+  {
+    /* Keep an empty descriptor instead of failing on every call */
+    descriptorLoaded = true;
+  }
+
+  return &descriptor;
+}
+
+bool SimDescriptor_level_rising(SimDescriptor_mode_t mode, const SimDescriptor_level_t *level)
+{
+  switch (mode)
+  {
+  case SIM_SENSOR_MODE_OXYGEN:
+    return false;
+  case SIM_SENSOR_MODE_WINDOW:
+    /* Lower window levels release above their threshold, upper ones below */
+    return level->hysteresis <= level->threshold;
+  case SIM_SENSOR_MODE_NORMAL:
+  default:
+    return true;
+  }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static char *read_file(const char *path)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == NULL)
+  {
+    return NULL;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  char *text = (size >= 0) ? malloc((size_t) size + 1U) : NULL;
+  if (text != NULL)
+  {
+    size_t n = fread(text, 1, (size_t) size, file);
+    text[n] = '\0';
+  }
+  fclose(file);
+
+  return text;
+}
+
+static void skip_space(parser_t *p)
+{
+  for (;;)
+  {
+    if (*p->pos == '\n')
+    {
+      p->line++;
+      p->pos++;
+    }
+    else if (isspace((unsigned char) *p->pos))
+    {
+      p->pos++;
+    }
+    else if (p->pos[0] == '/' && p->pos[1] == '/')
+    {
+      while (*p->pos != '\0' && *p->pos != '\n')
+      {
+        p->pos++;
+      }
+    }
+    else if (p->pos[0] == '/' && p->pos[1] == '*')
+    {
+      p->pos += 2;
+      while (*p->pos != '\0' && !(p->pos[0] == '*' && p->pos[1] == '/'))
+      {
+        p->line += (*p->pos == '\n') ? 1U : 0U;
+        p->pos++;
+      }
+      p->pos += (*p->pos != '\0') ? 2 : 0;
+    }
+    else if (*p->pos == '#')
+    {
+      /* Preprocessor lines carry no values */
+      while (*p->pos != '\0' && *p->pos != '\n')
+      {
+        p->pos++;
+      }
+    }
+    else
+    {
+      return;
+    }
+  }
+}
+
+static bool accept(parser_t *p, const char *token)
+{
+  size_t len = strlen(token);
+
+  skip_space(p);
+  if (strncmp(p->pos, token, len) == 0)
+  {
+    p->pos += len;
+    return true;
+  }
+
+  return false;
+}
+
+static node_t *parse_value(parser_t *p)
+{
+  skip_space(p);
+  if (*p->pos == '{')
+  {
+    return parse_list(p);
+  }
+
+  return parse_expr(p);
+}
+
+static node_t *parse_list(parser_t *p)
+{
+  node_t *list = node_new(NODE_LIST);
+  node_t **tail = &list->child;
+
+  p->pos++; /* '{' */
+  while (!p->failed && !accept(p, "}"))
+  {
+    node_t *item = parse_value(p);
+    if (item == NULL)
+    {
+      p->failed = true;
+      break;
+    }
+    *tail = item;
+    tail = &item->next;
+
+    if (!accept(p, ","))
+    {
+      if (!accept(p, "}"))
+      {
+        p->failed = true;
+      }
+      break;
+    }
+  }
+
+  return list;
+}
+
+/**
+ * Constant expressions as they appear in descriptors, e.g. casts and the
+ * password hash. Identifiers keep their name when they stand alone and count
+ * as 0 inside arithmetic, the simulator does not know the firmware constants.
+ */
+static node_t *parse_expr(parser_t *p)
+{
+  return parse_shift(p);
+}
+
+static node_t *parse_shift(parser_t *p)
+{
+  node_t *left = parse_add(p);
+
+  while (left != NULL)
+  {
+    bool shiftLeft = accept(p, "<<");
+    if (!shiftLeft && !accept(p, ">>"))
+    {
+      break;
+    }
+    node_t *right = parse_add(p);
+    int64_t value = shiftLeft ? node_int(left) << node_int(right) : node_int(left) >> node_int(right);
+    node_free(left);
+    node_free(right);
+    left = node_new(NODE_NUMBER);
+    left->number = value;
+  }
+
+  return left;
+}
+
+static node_t *parse_add(parser_t *p)
+{
+  node_t *left = parse_mul(p);
+
+  while (left != NULL)
+  {
+    bool plus = accept(p, "+");
+    if (!plus && !accept(p, "-"))
+    {
+      break;
+    }
+    node_t *right = parse_mul(p);
+    int64_t value = plus ? node_int(left) + node_int(right) : node_int(left) - node_int(right);
+    node_free(left);
+    node_free(right);
+    left = node_new(NODE_NUMBER);
+    left->number = value;
+  }
+
+  return left;
+}
+
+static node_t *parse_mul(parser_t *p)
+{
+  node_t *left = parse_unary(p);
+
+  while (left != NULL && accept(p, "*"))
+  {
+    node_t *right = parse_unary(p);
+    int64_t value = node_int(left) * node_int(right);
+    node_free(left);
+    node_free(right);
+    left = node_new(NODE_NUMBER);
+    left->number = value;
+  }
+
+  return left;
+}
+
+static node_t *parse_unary(parser_t *p)
+{
+  if (accept(p, "-"))
+  {
+    node_t *operand = parse_unary(p);
+    node_t *result = node_new(NODE_NUMBER);
+    result->number = -node_int(operand);
+    node_free(operand);
+    return result;
+  }
+
+  if (accept(p, "("))
+  {
+    /* Cast: '(' type name ')' */
+    const char *start = p->pos;
+    skip_space(p);
+    while (isalnum((unsigned char) *p->pos) || *p->pos == '_')
+    {
+      p->pos++;
+    }
+    if (p->pos != start && accept(p, ")") && strstr(start, "_t") != NULL && strstr(start, "_t") < p->pos)
+    {
+      return parse_unary(p);
+    }
+
+    p->pos = start;
+    node_t *inner = parse_expr(p);
+    if (!accept(p, ")"))
+    {
+      p->failed = true;
+    }
+    return inner;
+  }
+
+  return parse_primary(p);
+}
+
+static node_t *parse_primary(parser_t *p)
+{
+  node_t *node = NULL;
+
+  skip_space(p);
+  if (*p->pos == '"')
+  {
+    node = node_new(NODE_STRING);
+    size_t len = 0;
+    p->pos++;
+    while (*p->pos != '\0' && *p->pos != '"')
+    {
+      if (*p->pos == '\\' && p->pos[1] != '\0')
+      {
+        p->pos++;
+      }
+      if (len + 1U < sizeof(node->text))
+      {
+        node->text[len++] = *p->pos;
+      }
+      p->pos++;
+    }
+    node->text[len] = '\0';
+    p->pos += (*p->pos == '"') ? 1 : 0;
+  }
+  else if (isdigit((unsigned char) *p->pos))
+  {
+    char *end;
+    node = node_new(NODE_NUMBER);
+    node->number = (int64_t) strtoull(p->pos, &end, 0);
+    p->pos = end;
+    while (*p->pos == 'u' || *p->pos == 'U' || *p->pos == 'l' || *p->pos == 'L')
+    {
+      p->pos++;
+    }
+  }
+  else if (isalpha((unsigned char) *p->pos) || *p->pos == '_')
+  {
+    size_t len = 0;
+    node = node_new(NODE_IDENT);
+    while (isalnum((unsigned char) *p->pos) || *p->pos == '_')
+    {
+      if (len + 1U < sizeof(node->text))
+      {
+        node->text[len++] = *p->pos;
+      }
+      p->pos++;
+    }
+    node->text[len] = '\0';
+    if (strcmp(node->text, "true") == 0 || strcmp(node->text, "false") == 0)
+    {
+      node->type = NODE_NUMBER;
+      node->number = (node->text[0] == 't') ? 1 : 0;
+    }
+  }
+  else
+  {
+    p->failed = true;
+  }
+
+  return node;
+}
+
+static node_t *node_new(node_type_t type)
+{
+  node_t *node = calloc(1, sizeof(node_t));
+  if (node == NULL)
+  {
+    fprintf(stderr, "SimDescriptor: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  node->type = type;
+
+  return node;
+}
+
+static void node_free(node_t *node)
+{
+  while (node != NULL)
+  {
+    node_t *next = node->next;
+    node_free(node->child);
+    free(node);
+    node = next;
+  }
+}
+
+static const node_t *node_at(const node_t *list, uint32_t index)
+{
+  if (list == NULL || list->type != NODE_LIST)
+  {
+    return NULL;
+  }
+
+  const node_t *item = list->child;
+  while (item != NULL && index-- > 0)
+  {
+    item = item->next;
+  }
+
+  return item;
+}
+
+static int64_t node_int(const node_t *node)
+{
+  return (node != NULL && node->type == NODE_NUMBER) ? node->number : 0;
+}
+
+static void node_text(const node_t *node, char *dst)
+{
+  if (node != NULL && node->type != NODE_LIST && node->type != NODE_NUMBER)
+  {
+    memcpy(dst, node->text, SIM_DESCRIPTOR_TEXT_LEN);
+  }
+  else
+  {
+    dst[0] = '\0';
+  }
+}
+
+static void read_relay_mask(const node_t *list, SimDescriptor_relayMask_t mask)
+{
+  for (uint32_t i = 0; i < SIM_DESCRIPTOR_RELAY_WORDS; i++)
+  {
+    mask[i] = (uint32_t) node_int(node_at(list, i));
+  }
+}
+
+/** { state, threshold, hysteresis, delay, timeout, { relays } } */
+static void read_level(const node_t *list, SimDescriptor_level_t *level)
+{
+  const node_t *state = node_at(list, 0);
+
+  level->enabled = (state != NULL && state->type == NODE_IDENT && strcmp(state->text, "GD_VS_NORMAL") == 0);
+  level->threshold = (int32_t) node_int(node_at(list, 1));
+  level->hysteresis = (int32_t) node_int(node_at(list, 2));
+  level->delayS = (uint32_t) node_int(node_at(list, 3));
+  level->timeoutS = (uint32_t) node_int(node_at(list, 4));
+  read_relay_mask(node_at(list, 5), level->relays);
+}
+
+/**
+ * { active, mode, range, offset, decimals, reserved, unit, gas, name, { levels },
+ *   fault state, { fault params }, fault delay, fault timeout, { fault relays } }
+ */
+static void read_sensor(const node_t *list, SimDescriptor_sensor_t *sensor)
+{
+  const node_t *mode = node_at(list, 1);
+
+  sensor->active = node_int(node_at(list, 0)) != 0;
+  sensor->mode = SIM_SENSOR_MODE_NORMAL;
+  if (mode != NULL && strcmp(mode->text, "GD_M_OXYGEN") == 0)
+  {
+    sensor->mode = SIM_SENSOR_MODE_OXYGEN;
+  }
+  else if (mode != NULL && strcmp(mode->text, "GD_M_WINDOW") == 0)
+  {
+    sensor->mode = SIM_SENSOR_MODE_WINDOW;
+  }
+  sensor->range = (int32_t) node_int(node_at(list, 2));
+  sensor->offset = (int32_t) node_int(node_at(list, 3));
+  sensor->decimals = (uint8_t) node_int(node_at(list, 4));
+  node_text(node_at(list, 6), sensor->unit);
+  node_text(node_at(list, 7), sensor->gas);
+  node_text(node_at(list, 8), sensor->name);
+
+  for (uint32_t i = 0; i < SIM_DESCRIPTOR_LEVELS; i++)
+  {
+    read_level(node_at(node_at(list, 9), i), &sensor->levels[i]);
+  }
+
+  const node_t *faultState = node_at(list, 10);
+  sensor->fault.enabled = (faultState != NULL && strcmp(faultState->text, "GD_VS_NORMAL") == 0);
+  sensor->fault.delayS = (uint32_t) node_int(node_at(list, 12));
+  sensor->fault.timeoutS = (uint32_t) node_int(node_at(list, 13));
+  read_relay_mask(node_at(list, 14), sensor->fault.relays);
+}
+
+/** { magic, version, { settings }, magic, erased marker } */
+static bool read_descriptor(const node_t *root, SimDescriptor_t *desc)
+{
+  const node_t *settings = node_at(root, 2);
+  const node_t *sensors = node_at(settings, SETTINGS_SENSORS);
+  const node_t *relays = node_at(settings, SETTINGS_RELAYS);
+  const node_t *timers = node_at(settings, SETTINGS_TIMERS);
+
+  if (settings == NULL || settings->type != NODE_LIST || sensors == NULL || sensors->type != NODE_LIST)
+  {
+    return false;
+  }
+
+  desc->version = (uint32_t) node_int(node_at(root, 1));
+  node_text(node_at(settings, SETTINGS_DATE), desc->date);
+  node_text(node_at(settings, SETTINGS_NAME), desc->deviceName);
+  for (uint32_t i = 0; i < SIM_DESCRIPTOR_LEVELS; i++)
+  {
+    node_text(node_at(node_at(settings, SETTINGS_ALARM_TEXT), i), desc->alarmText[i]);
+  }
+  node_text(node_at(settings, SETTINGS_FAULT_TEXT), desc->faultText);
+  desc->temperatureRangeLow = (int32_t) node_int(node_at(settings, SETTINGS_TEMPERATURE_LOW));
+  desc->temperatureRangeHigh = (int32_t) node_int(node_at(settings, SETTINGS_TEMPERATURE_HIGH));
+  desc->startupTimeS = (uint32_t) node_int(node_at(settings, SETTINGS_STARTUP_TIME));
+
+  uint32_t entries = 0;
+  for (const node_t *item = sensors->child; item != NULL && entries < SIM_DESCRIPTOR_MAX_SENSORS; item = item->next)
+  {
+    read_sensor(item, &desc->sensors[entries++]);
+  }
+  desc->sensorCount = (uint32_t) node_int(node_at(settings, SETTINGS_SENSOR_COUNT));
+  if (desc->sensorCount > entries)
+  {
+    desc->sensorCount = entries;
+  }
+
+  uint32_t relayEntries = 0;
+  for (const node_t *item = (relays != NULL) ? relays->child : NULL;
+       item != NULL && relayEntries < SIM_DESCRIPTOR_MAX_RELAYS; item = item->next)
+  {
+    SimDescriptor_relay_t *relay = &desc->relays[relayEntries++];
+    relay->active = node_int(node_at(item, 0)) != 0;
+    relay->energized = node_int(node_at(item, 1)) != 0;
+    relay->pulse = node_int(node_at(item, 2)) != 0;
+    relay->manualReset = node_int(node_at(item, 3)) != 0;
+    relay->immediateReset = node_int(node_at(item, 4)) != 0;
+    relay->beeper = node_int(node_at(item, 5)) != 0;
+    relay->maxOnTime = (uint32_t) node_int(node_at(item, 6));
+  }
+  desc->relayCount = (uint32_t) node_int(node_at(settings, SETTINGS_RELAY_COUNT));
+  if (desc->relayCount > relayEntries)
+  {
+    desc->relayCount = relayEntries;
+  }
+
+  for (const node_t *item = (timers != NULL) ? timers->child : NULL;
+       item != NULL && desc->timerCount < SIM_DESCRIPTOR_MAX_TIMERS; item = item->next)
+  {
+    SimDescriptor_timer_t *timer = &desc->timers[desc->timerCount++];
+    for (uint32_t i = 0; i < 3; i++)
+    {
+      timer->params[i] = (uint32_t) node_int(node_at(item, i));
+    }
+    read_relay_mask(node_at(item, 3), timer->relays);
+  }
+
+  return true;
+}
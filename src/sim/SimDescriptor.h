@@ -0,0 +1,122 @@
+/**
+ * @file SimDescriptor.h
+ * Flat, simulator-side view of a CANLineX2 settings descriptor.
+ *
+ * The view is read from a descriptor source file in the Configuration.inc
+ * format, so simulator tooling (scenarios, alarm evaluation, load generators)
+ * can work on any customer configuration without being rebuilt. Values keep
+ * the raw units of the descriptor, e.g. 190 with one decimal means 19.0.
+ */
+
+#ifndef SIM_DESCRIPTOR_H
+#define SIM_DESCRIPTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define SIM_DESCRIPTOR_MAX_SENSORS 512
+#define SIM_DESCRIPTOR_LEVELS 4
+#define SIM_DESCRIPTOR_RELAY_WORDS 4
+#define SIM_DESCRIPTOR_MAX_RELAYS (SIM_DESCRIPTOR_RELAY_WORDS * 32)
+#define SIM_DESCRIPTOR_MAX_TIMERS 16
+#define SIM_DESCRIPTOR_TEXT_LEN 24
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+  SIM_SENSOR_MODE_NORMAL = 0, /**< GD_M_NORMAL: levels trigger on rising values */
+  SIM_SENSOR_MODE_OXYGEN,     /**< GD_M_OXYGEN: levels trigger on falling values */
+  SIM_SENSOR_MODE_WINDOW,     /**< GD_M_WINDOW: direction per level, see SimDescriptor_level_rising() */
+} SimDescriptor_mode_t;
+
+/** One relay bit per relay, word 0 holds relays 0..31 (segment 1) */
+typedef uint32_t SimDescriptor_relayMask_t[SIM_DESCRIPTOR_RELAY_WORDS];
+
+typedef struct {
+  bool enabled;         /**< level state is GD_VS_NORMAL */
+  int32_t threshold;
+  int32_t hysteresis;   /**< value at which the level releases again */
+  uint32_t delayS;      /**< condition must hold this long before the level triggers */
+  uint32_t timeoutS;    /**< a triggered level stays active at least this long, 0: no hold */
+  SimDescriptor_relayMask_t relays;
+} SimDescriptor_level_t;
+
+typedef struct {
+  bool active;
+  SimDescriptor_mode_t mode;
+  int32_t range;        /**< full scale in raw units */
+  int32_t offset;       /**< second range parameter of the descriptor, unused by the simulator */
+  uint8_t decimals;     /**< decimal places of the raw value */
+  char unit[SIM_DESCRIPTOR_TEXT_LEN];
+  char gas[SIM_DESCRIPTOR_TEXT_LEN];
+  char name[SIM_DESCRIPTOR_TEXT_LEN];
+  SimDescriptor_level_t levels[SIM_DESCRIPTOR_LEVELS];
+  SimDescriptor_level_t fault; /**< fault entry, threshold/hysteresis unused */
+} SimDescriptor_sensor_t;
+
+typedef struct {
+  bool active;
+  bool energized;
+  bool pulse;
+  bool manualReset;
+  bool immediateReset;
+  bool beeper;
+  uint32_t maxOnTime;
+} SimDescriptor_relay_t;
+
+typedef struct {
+  uint32_t params[3];
+  SimDescriptor_relayMask_t relays;
+} SimDescriptor_timer_t;
+
+typedef struct {
+  uint32_t version;
+  char date[SIM_DESCRIPTOR_TEXT_LEN];
+  char deviceName[SIM_DESCRIPTOR_TEXT_LEN];
+  char alarmText[SIM_DESCRIPTOR_LEVELS][SIM_DESCRIPTOR_TEXT_LEN];
+  char faultText[SIM_DESCRIPTOR_TEXT_LEN];
+  int32_t temperatureRangeLow;
+  int32_t temperatureRangeHigh;
+  uint32_t startupTimeS;
+  uint32_t sensorCount; /**< configured sensors, never more than the entries read */
+  uint32_t relayCount;
+  uint32_t timerCount;
+  SimDescriptor_sensor_t sensors[SIM_DESCRIPTOR_MAX_SENSORS];
+  SimDescriptor_relay_t relays[SIM_DESCRIPTOR_MAX_RELAYS];
+  SimDescriptor_timer_t timers[SIM_DESCRIPTOR_MAX_TIMERS];
+} SimDescriptor_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Read a descriptor source file (Configuration.inc format) and make it the
+ * current descriptor. On failure the current descriptor is left untouched.
+ */
+bool SimDescriptor_load(const char *path);
+
+/** Current descriptor. Loads SIM_DESCRIPTOR_DEFAULT_PATH on first use */
+const SimDescriptor_t *SimDescriptor_get(void);
+
+/** true if the level triggers on rising values for the given sensor mode */
+bool SimDescriptor_level_rising(SimDescriptor_mode_t mode, const SimDescriptor_level_t *level);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SIM_DESCRIPTOR_H*/
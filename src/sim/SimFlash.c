@@ -0,0 +1,526 @@
+/**
+ * @file SimFlash.c
+ *
+ * File layout:
+ *   header   FILE_HEADER_SIZE bytes, file_header_t followed by the erase
+ *            count of every sector
+ *   flash    the device content, every byte inverted
+ * The journal occupies the last SIM_FLASH_JOURNAL_SECTORS sectors of the
+ * device, a sequence of record_t each followed by its data padded to 4 bytes.
+ * The CRC of a record covers its header and data, so a record torn while its
+ * data was programmed is not replayed.
+ * An erased record header (addr 0xFFFFFFFF) ends the journal.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#ifndef _DEFAULT_SOURCE
+  #define _DEFAULT_SOURCE /* needed for usleep() */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+  #include <Windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+#include "SimFlash.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define FILE_MAGIC "CLX2FLSH"
+#define FILE_VERSION 2U
+#define FILE_HEADER_SIZE 4096U
+#define MAX_SECTORS ((FILE_HEADER_SIZE - sizeof(file_header_t)) / sizeof(uint32_t))
+#define MAX_PENDING 32U
+/** Pending ranges closer than a record header are cheaper as one record */
+#define MERGE_GAP ((uint32_t) sizeof(record_t))
+#define RECORD_MAX_LEN 0xFFFFU
+#define ERASED_ADDR 0xFFFFFFFFU
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t size;
+  uint32_t sectorSize;
+  uint32_t pageSize;
+} file_header_t;
+
+typedef struct {
+  uint32_t addr;
+  uint16_t len;
+  uint16_t reserved;  /**< left erased */
+  uint32_t crc;       /**< CRC-32 of the fields above and the data */
+} record_t;
+
+typedef struct {
+  uint32_t start;
+  uint32_t end;
+} range_t;
+
+struct SimFlash {
+  FILE *file;
+  uint32_t size;
+  uint32_t sectorCount;
+  uint32_t dataSize;        /**< device bytes before the journal */
+  uint32_t journalSize;
+  uint32_t journalOffset;   /**< next record, relative to the journal start */
+  uint8_t *device;          /**< device content as programmed */
+  uint8_t *image;           /**< data area as the application sees it */
+  uint32_t *wear;
+  range_t pending[MAX_PENDING];
+  uint32_t pendingCount;
+  bool written;             /**< SimFlash_write() since the last handler call */
+  uint32_t lastWriteMs;
+  bool stall;
+  SimFlash_stats_t stats;
+};
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bool file_write(SimFlash_t *flash, uint32_t offset, const uint8_t *data, uint32_t len, bool invert);
+static bool device_program(SimFlash_t *flash, uint32_t addr, const uint8_t *data, uint32_t len);
+static bool device_erase(SimFlash_t *flash, uint32_t sector);
+static bool checkpoint(SimFlash_t *flash);
+static bool journal_replay(SimFlash_t *flash);
+static uint32_t record_crc(const record_t *header, const uint8_t *data);
+static void pending_add(SimFlash_t *flash, uint32_t start, uint32_t end);
+static void busy(SimFlash_t *flash, uint32_t us);
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+SimFlash_t *SimFlash_open(const char *path, uint32_t size)
+{
+  file_header_t header;
+  SimFlash_t *flash = calloc(1, sizeof(SimFlash_t));
+
+  if (flash == NULL)
+  {
+    return NULL;
+  }
+
+  flash->file = fopen(path, "r+b");
+  if (flash->file != NULL)
+  {
+    if (fread(&header, sizeof(header), 1, flash->file) != 1 || memcmp(header.magic, FILE_MAGIC, 8) != 0 ||
+        header.version != FILE_VERSION || header.sectorSize != SIM_FLASH_SECTOR_SIZE ||
+        header.pageSize != SIM_FLASH_PAGE_SIZE)
+    {
+      fclose(flash->file);
+      free(flash);
+      return NULL;
+    }
+  }
+  else
+  {
+    /* New device: header and a hole up to the end, the hole reads as erased */
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FILE_MAGIC, 8);
+    header.version = FILE_VERSION;
+    header.size = (size != 0U) ? size : SIM_FLASH_DEFAULT_SIZE;
+    header.sectorSize = SIM_FLASH_SECTOR_SIZE;
+    header.pageSize = SIM_FLASH_PAGE_SIZE;
+    flash->file = fopen(path, "w+b");
+    uint8_t zero = 0;
+    if (flash->file == NULL || fwrite(&header, sizeof(header), 1, flash->file) != 1 ||
+        fseek(flash->file, (long) (FILE_HEADER_SIZE + header.size - 1U), SEEK_SET) != 0 ||
+        fwrite(&zero, 1, 1, flash->file) != 1)
+    {
+      if (flash->file != NULL)
+      {
+        fclose(flash->file);
+      }
+      free(flash);
+      return NULL;
+    }
+  }
+
+  flash->size = header.size;
+  flash->sectorCount = header.size / SIM_FLASH_SECTOR_SIZE;
+  if (header.size % SIM_FLASH_SECTOR_SIZE != 0U || flash->sectorCount <= SIM_FLASH_JOURNAL_SECTORS ||
+      flash->sectorCount > MAX_SECTORS)
+  {
+    fclose(flash->file);
+    free(flash);
+    return NULL;
+  }
+  flash->journalSize = SIM_FLASH_JOURNAL_SECTORS * SIM_FLASH_SECTOR_SIZE;
+  flash->dataSize = flash->size - flash->journalSize;
+  flash->device = malloc(flash->size);
+  flash->image = malloc(flash->dataSize);
+  flash->wear = malloc(sizeof(uint32_t) * flash->sectorCount);
+  if (flash->device == NULL || flash->image == NULL || flash->wear == NULL ||
+      fseek(flash->file, (long) sizeof(file_header_t), SEEK_SET) != 0 ||
+      fread(flash->wear, sizeof(uint32_t), flash->sectorCount, flash->file) != flash->sectorCount ||
+      fseek(flash->file, (long) FILE_HEADER_SIZE, SEEK_SET) != 0 ||
+      fread(flash->device, 1, flash->size, flash->file) != flash->size)
+  {
+    free(flash->device);
+    free(flash->image);
+    free(flash->wear);
+    fclose(flash->file);
+    free(flash);
+    return NULL;
+  }
+  for (uint32_t i = 0; i < flash->size; i++)
+  {
+    flash->device[i] = (uint8_t) ~flash->device[i];
+  }
+  memcpy(flash->image, flash->device, flash->dataSize);
+  if (!journal_replay(flash))
+  {
+    /* Appending behind a torn record would lose the appends on the next open */
+    checkpoint(flash);
+  }
+
+  return flash;
+}
+
+void SimFlash_close(SimFlash_t *flash)
+{
+  if (flash == NULL)
+  {
+    return;
+  }
+  SimFlash_sync(flash);
+  fclose(flash->file);
+  free(flash->device);
+  free(flash->image);
+  free(flash->wear);
+  free(flash);
+}
+
+uint32_t SimFlash_get_capacity(const SimFlash_t *flash)
+{
+  return flash->dataSize;
+}
+
+bool SimFlash_read(const SimFlash_t *flash, uint32_t addr, void *data, uint32_t len)
+{
+  if (addr > flash->dataSize || len > flash->dataSize - addr)
+  {
+    return false;
+  }
+  memcpy(data, &flash->image[addr], len);
+
+  return true;
+}
+
+bool SimFlash_write(SimFlash_t *flash, uint32_t addr, const void *data, uint32_t len)
+{
+  if (addr > flash->dataSize || len > flash->dataSize - addr)
+  {
+    return false;
+  }
+  if (len == 0U)
+  {
+    return true;
+  }
+  memcpy(&flash->image[addr], data, len);
+  flash->stats.hostBytes += len;
+  flash->written = true;
+  pending_add(flash, addr, addr + len);
+
+  return true;
+}
+
+void SimFlash_handler(SimFlash_t *flash, uint32_t nowMs)
+{
+  if (flash->written)
+  {
+    flash->written = false;
+    flash->lastWriteMs = nowMs;
+  }
+  else if (flash->pendingCount != 0U && nowMs - flash->lastWriteMs >= SIM_FLASH_COALESCE_MS)
+  {
+    SimFlash_sync(flash);
+  }
+}
+
+bool SimFlash_sync(SimFlash_t *flash)
+{
+  uint8_t record[sizeof(record_t) + RECORD_MAX_LEN + 3U];
+  bool ok = true;
+
+  for (uint32_t i = 0; i < flash->pendingCount && ok; i++)
+  {
+    const range_t *range = &flash->pending[i];
+    for (uint32_t addr = range->start; addr < range->end && ok;)
+    {
+      uint32_t len = range->end - addr;
+      len = (len > RECORD_MAX_LEN) ? RECORD_MAX_LEN : len;
+      uint32_t padded = (uint32_t) sizeof(record_t) + ((len + 3U) & ~3U);
+      if (flash->journalOffset + padded > flash->journalSize)
+      {
+        /* The checkpoint writes the whole image, the remaining ranges included */
+        ok = checkpoint(flash);
+        flash->pendingCount = 0;
+        break;
+      }
+
+      record_t header = { addr, (uint16_t) len, 0xFFFFU, 0 };
+      header.crc = record_crc(&header, &flash->image[addr]);
+      memcpy(record, &header, sizeof(header));
+      memcpy(&record[sizeof(header)], &flash->image[addr], len);
+      memset(&record[sizeof(header) + len], 0xFF, padded - sizeof(header) - len);
+      ok = device_program(flash, flash->dataSize + flash->journalOffset, record, padded);
+      flash->journalOffset += padded;
+      addr += len;
+    }
+  }
+  if (flash->pendingCount != 0U)
+  {
+    flash->stats.journalFlushes++;
+  }
+  flash->pendingCount = 0;
+  fflush(flash->file);
+
+  return ok;
+}
+
+void SimFlash_set_stall(SimFlash_t *flash, bool stall)
+{
+  flash->stall = stall;
+}
+
+void SimFlash_get_stats(const SimFlash_t *flash, SimFlash_stats_t *stats)
+{
+  uint64_t total = 0;
+
+  *stats = flash->stats;
+  stats->maxWear = 0;
+  for (uint32_t s = 0; s < flash->sectorCount; s++)
+  {
+    total += flash->wear[s];
+    stats->maxWear = (flash->wear[s] > stats->maxWear) ? flash->wear[s] : stats->maxWear;
+  }
+  stats->meanWear = (uint32_t) (total / flash->sectorCount);
+}
+
+double SimFlash_get_write_amplification(const SimFlash_t *flash)
+{
+  return (flash->stats.hostBytes != 0U) ? (double) flash->stats.programBytes / (double) flash->stats.hostBytes : 0.0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool file_write(SimFlash_t *flash, uint32_t offset, const uint8_t *data, uint32_t len, bool invert)
+{
+  uint8_t buf[SIM_FLASH_SECTOR_SIZE];
+
+  if (fseek(flash->file, (long) offset, SEEK_SET) != 0)
+  {
+    return false;
+  }
+  while (len > 0U)
+  {
+    uint32_t chunk = (len > sizeof(buf)) ? (uint32_t) sizeof(buf) : len;
+    for (uint32_t i = 0; i < chunk; i++)
+    {
+      buf[i] = invert ? (uint8_t) ~data[i] : data[i];
+    }
+    if (fwrite(buf, 1, chunk, flash->file) != chunk)
+    {
+      return false;
+    }
+    data += chunk;
+    len -= chunk;
+  }
+
+  return true;
+}
+
+/** NOR program: bits can only be cleared */
+static bool device_program(SimFlash_t *flash, uint32_t addr, const uint8_t *data, uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++)
+  {
+    if ((flash->device[addr + i] & data[i]) != data[i])
+    {
+      return false;
+    }
+  }
+  memcpy(&flash->device[addr], data, len);
+
+  uint32_t pages = (addr + len - 1U) / SIM_FLASH_PAGE_SIZE - addr / SIM_FLASH_PAGE_SIZE + 1U;
+  flash->stats.programBytes += len;
+  flash->stats.pagePrograms += pages;
+  busy(flash, pages * SIM_FLASH_PAGE_PROGRAM_US);
+
+  return file_write(flash, FILE_HEADER_SIZE + addr, data, len, true);
+}
+
+static bool device_erase(SimFlash_t *flash, uint32_t sector)
+{
+  uint32_t addr = sector * SIM_FLASH_SECTOR_SIZE;
+
+  memset(&flash->device[addr], 0xFF, SIM_FLASH_SECTOR_SIZE);
+  flash->wear[sector]++;
+  flash->stats.sectorErases++;
+  busy(flash, SIM_FLASH_SECTOR_ERASE_US);
+
+  return file_write(flash, FILE_HEADER_SIZE + addr, &flash->device[addr], SIM_FLASH_SECTOR_SIZE, true) &&
+         file_write(flash, (uint32_t) (sizeof(file_header_t) + sector * sizeof(uint32_t)),
+                    (const uint8_t *) &flash->wear[sector], sizeof(uint32_t), false);
+}
+
+/**
+ * Bring the data sectors up to the image, then start an empty journal. The
+ * journal is erased only after all data sectors read back as the image, so a
+ * failed checkpoint keeps it for the next replay. A crash between the erase
+ * and the programs of a data sector still loses what of the sector the
+ * journal does not hold, the checkpoint is not crash-safe.
+ */
+static bool checkpoint(SimFlash_t *flash)
+{
+  bool ok = true;
+
+  for (uint32_t addr = 0; addr < flash->dataSize && ok; addr += SIM_FLASH_SECTOR_SIZE)
+  {
+    const uint8_t *want = &flash->image[addr];
+    const uint8_t *have = &flash->device[addr];
+    if (memcmp(want, have, SIM_FLASH_SECTOR_SIZE) == 0)
+    {
+      continue;
+    }
+
+    /* Erase only if some bit has to go from 0 back to 1 */
+    bool erase = false;
+    for (uint32_t i = 0; i < SIM_FLASH_SECTOR_SIZE && !erase; i++)
+    {
+      erase = (have[i] & want[i]) != want[i];
+    }
+    if (erase)
+    {
+      ok = device_erase(flash, addr / SIM_FLASH_SECTOR_SIZE);
+    }
+
+    /* Program the pages that differ from the (erased) sector */
+    for (uint32_t page = 0; page < SIM_FLASH_SECTOR_SIZE && ok; page += SIM_FLASH_PAGE_SIZE)
+    {
+      if (memcmp(&want[page], &have[page], SIM_FLASH_PAGE_SIZE) != 0)
+      {
+        ok = device_program(flash, addr + page, &want[page], SIM_FLASH_PAGE_SIZE);
+      }
+    }
+  }
+
+  /* The journal goes only once every data sector reads back as the image */
+  ok = ok && memcmp(flash->device, flash->image, flash->dataSize) == 0;
+  for (uint32_t s = 0; s < SIM_FLASH_JOURNAL_SECTORS && ok && flash->journalOffset != 0U; s++)
+  {
+    ok = device_erase(flash, flash->dataSize / SIM_FLASH_SECTOR_SIZE + s);
+  }
+  if (ok)
+  {
+    flash->journalOffset = 0;
+    flash->stats.checkpoints++;
+  }
+
+  return ok;
+}
+
+/**
+ * Apply the journal records to the image, stops at the first erased or torn
+ * record. False if programmed bytes follow the last valid record.
+ */
+static bool journal_replay(SimFlash_t *flash)
+{
+  const uint8_t *journal = &flash->device[flash->dataSize];
+  uint32_t offset = 0;
+
+  while (offset + sizeof(record_t) <= flash->journalSize)
+  {
+    record_t header;
+    memcpy(&header, &journal[offset], sizeof(header));
+    uint32_t padded = (uint32_t) sizeof(record_t) + ((header.len + 3U) & ~3U);
+    if (header.addr == ERASED_ADDR || header.addr > flash->dataSize || header.len > flash->dataSize - header.addr ||
+        offset + padded > flash->journalSize || header.crc != record_crc(&header, &journal[offset + sizeof(record_t)]))
+    {
+      break;
+    }
+    memcpy(&flash->image[header.addr], &journal[offset + sizeof(record_t)], header.len);
+    offset += padded;
+  }
+
+  uint32_t end = flash->journalSize;
+  while (end > offset && journal[end - 1U] == 0xFFU)
+  {
+    end--;
+  }
+  /* Past the torn record, so a checkpoint erases the journal */
+  flash->journalOffset = (end + 3U) & ~3U;
+
+  return end == offset;
+}
+
+static uint32_t record_crc(const record_t *header, const uint8_t *data)
+{
+  const uint8_t *bytes = (const uint8_t *) header;
+  uint32_t crc = 0xFFFFFFFFU;
+
+  for (uint32_t i = 0; i < (uint32_t) offsetof(record_t, crc) + header->len; i++)
+  {
+    crc ^= (i < offsetof(record_t, crc)) ? bytes[i] : data[i - offsetof(record_t, crc)];
+    for (uint32_t b = 0; b < 8U; b++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+    }
+  }
+
+  return ~crc;
+}
+
+/** Merge [start, end) into the pending ranges */
+static void pending_add(SimFlash_t *flash, uint32_t start, uint32_t end)
+{
+  for (uint32_t i = 0; i < flash->pendingCount;)
+  {
+    range_t *range = &flash->pending[i];
+    if (start <= range->end + MERGE_GAP && range->start <= end + MERGE_GAP)
+    {
+      start = (range->start < start) ? range->start : start;
+      end = (range->end > end) ? range->end : end;
+      *range = flash->pending[--flash->pendingCount];
+      i = 0;
+    }
+    else
+    {
+      i++;
+    }
+  }
+  if (flash->pendingCount == MAX_PENDING)
+  {
+    SimFlash_sync(flash);
+  }
+  flash->pending[flash->pendingCount].start = start;
+  flash->pending[flash->pendingCount].end = end;
+  flash->pendingCount++;
+}
+
+static void busy(SimFlash_t *flash, uint32_t us)
+{
+  flash->stats.busyUs += us;
+  if (flash->stall)
+  {
+#ifdef _WIN32
+    Sleep(us / 1000U);
+#else
+    usleep(us);
+#endif
+  }
+}
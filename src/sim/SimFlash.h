@@ -0,0 +1,116 @@
+/**
+ * @file SimFlash.h
+ * File-backed NOR flash emulation for settings persistence.
+ *
+ * The device is a sparse file: the data is stored inverted, so the holes of
+ * a new file read as erased cells (0xFF) and only written sectors take disk
+ * space. Programming can only clear bits, a sector erase sets them again and
+ * counts towards the wear of that sector. Page programs and sector erases
+ * add their typical latency to a simulated busy time, optionally also as a
+ * real delay.
+ *
+ * SimFlash_write() does not program at once. Writes are merged in RAM, and
+ * once no write came for the coalescing window, the merged ranges are
+ * appended as records to a journal in the last two sectors. Only when the
+ * journal is full are the data sectors rewritten from the RAM image, each
+ * changed sector with one erase, and the journal is erased. Opening a device
+ * replays the journal over the data sectors; records carry a CRC over their
+ * data, so a torn one is not replayed.
+ *
+ * Checkpoints are not crash-safe: a data sector is erased in place, and a
+ * power loss before it is programmed again loses its content, as it would on
+ * a device without a spare sector. The journal survives until the whole data
+ * area has been written and verified.
+ *
+ * The statistics compare the bytes written by the application with the bytes
+ * programmed and erased, the write amplification.
+ */
+
+#ifndef SIM_FLASH_H
+#define SIM_FLASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SIM_FLASH_DEFAULT_SIZE (1024U * 1024U)
+#define SIM_FLASH_SECTOR_SIZE 4096U
+#define SIM_FLASH_PAGE_SIZE 256U
+#define SIM_FLASH_JOURNAL_SECTORS 2U
+
+/** Typical serial NOR timings */
+#define SIM_FLASH_PAGE_PROGRAM_US 700U
+#define SIM_FLASH_SECTOR_ERASE_US 45000U
+
+/** Writes closer together than this are merged before they reach the journal */
+#define SIM_FLASH_COALESCE_MS 500U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  uint64_t hostBytes;       /**< bytes passed to SimFlash_write() */
+  uint64_t programBytes;    /**< bytes programmed, journal and sectors */
+  uint64_t pagePrograms;
+  uint64_t sectorErases;
+  uint64_t busyUs;          /**< simulated time the device was busy */
+  uint32_t journalFlushes;
+  uint32_t checkpoints;     /**< journal full, data sectors rewritten */
+  uint32_t maxWear;         /**< highest erase count of a sector, over the device lifetime */
+  uint32_t meanWear;
+} SimFlash_stats_t;
+
+typedef struct SimFlash SimFlash_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Open or create the device file. `size` (0: SIM_FLASH_DEFAULT_SIZE) is only
+ * used for a new file. NULL on error or if the file is no flash image.
+ */
+SimFlash_t *SimFlash_open(const char *path, uint32_t size);
+
+/** Flush pending writes and close */
+void SimFlash_close(SimFlash_t *flash);
+
+/** Bytes usable by the application, the device minus the journal */
+uint32_t SimFlash_get_capacity(const SimFlash_t *flash);
+
+/** Current content, pending writes included */
+bool SimFlash_read(const SimFlash_t *flash, uint32_t addr, void *data, uint32_t len);
+
+/** Write bytes, applied to the device later, see SimFlash_handler() */
+bool SimFlash_write(SimFlash_t *flash, uint32_t addr, const void *data, uint32_t len);
+
+/** Journal the pending writes once the coalescing window passed */
+void SimFlash_handler(SimFlash_t *flash, uint32_t nowMs);
+
+/** Journal the pending writes now */
+bool SimFlash_sync(SimFlash_t *flash);
+
+/** Really wait for the simulated program and erase times */
+void SimFlash_set_stall(SimFlash_t *flash, bool stall);
+
+void SimFlash_get_stats(const SimFlash_t *flash, SimFlash_stats_t *stats);
+
+/** Programmed bytes per written byte, 0 before the first write */
+double SimFlash_get_write_amplification(const SimFlash_t *flash);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SIM_FLASH_H*/
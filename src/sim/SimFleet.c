@@ -0,0 +1,656 @@
+/**
+ * @file SimFleet.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#ifndef _DEFAULT_SOURCE
+  #define _DEFAULT_SOURCE /* needed for mkstemp() and usleep() */
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <SDL.h>
+
+#include "SimFleet.h"
+#include "SimPanel.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/** Refresh period of the tiled window */
+#define FLEET_PRESENT_PERIOD_MS 33
+
+/** Width the tiled window is fit into when no scale is given */
+#define FLEET_AUTO_FIT_WIDTH 1920
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  uint32_t index;
+  void *handle;
+  const SimPanel_api_t *api;
+  bool created;
+  bool failed;
+  uint64_t dueUs;
+  int32_t tileX;
+  int32_t tileY;
+  SimPanel_input_t input; /**< guarded by inputLock */
+  uint64_t steps;
+  uint64_t busyUs;
+  uint64_t maxStepUs;
+} fleet_instance_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bool fleet_load(void);
+static void *fleet_module_copy_load(const char *path, uint32_t index);
+static void *fleet_worker(void *arg);
+static void fleet_instance_step(fleet_instance_t *instance);
+static void fleet_present_cb(void *user, int32_t x1, int32_t y1, int32_t x2, int32_t y2, const uint8_t *pixels,
+                             uint32_t stride);
+static void fleet_queue_push(fleet_instance_t *instance);
+static fleet_instance_t *fleet_queue_pop(void);
+static void fleet_window_run(void);
+static void fleet_window_handle_event(const SDL_Event *event);
+static void fleet_wait_headless(void);
+static void fleet_report(void);
+static void fleet_signal_handler(int sig);
+static int32_t fleet_clamp(int32_t v, int32_t max);
+static uint64_t fleet_now_us(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static struct {
+  SimFleet_config_t config;
+  fleet_instance_t instances[SIM_FLEET_MAX_INSTANCES];
+  pthread_t workers[SIM_FLEET_MAX_INSTANCES];
+  uint32_t workerCount;
+
+  /* Min-heap of the instances waiting for their next step, ordered by dueUs */
+  pthread_mutex_t queueLock;
+  pthread_cond_t queueCond;
+  fleet_instance_t *queue[SIM_FLEET_MAX_INSTANCES];
+  uint32_t queueCount;
+  bool running;
+
+  pthread_mutex_t inputLock;
+  int32_t focus;
+
+  /* Tiled frame of all instances, uploaded to SDL by the main thread */
+  pthread_mutex_t frameLock;
+  uint32_t *frame;
+  int32_t frameWidth;
+  int32_t frameHeight;
+  uint32_t columns;
+  bool frameDirty;
+
+  uint64_t startUs;
+} fleet;
+
+static volatile sig_atomic_t fleetStopRequested;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void SimFleet_config_init(SimFleet_config_t *config)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+  memset(config, 0, sizeof(*config));
+  config->instanceCount = (cpus > 0) ? (uint32_t) cpus : 1U;
+  config->width = 800;
+  config->height = 480;
+}
+
+bool SimFleet_run(const SimFleet_config_t *config)
+{
+  bool ok = true;
+
+  memset(&fleet, 0, sizeof(fleet));
+  fleet.config = *config;
+  fleet.focus = -1;
+  if (fleet.config.instanceCount == 0 || fleet.config.instanceCount > SIM_FLEET_MAX_INSTANCES)
+  {
+    fprintf(stderr, "fleet: instance count must be 1..%d\n", SIM_FLEET_MAX_INSTANCES);
+    return false;
+  }
+  if (fleet.config.threadCount == 0)
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    fleet.config.threadCount = (cpus > 0) ? (uint32_t) cpus : 1U;
+  }
+  if (fleet.config.threadCount > fleet.config.instanceCount)
+  {
+    fleet.config.threadCount = fleet.config.instanceCount;
+  }
+
+  fleet.columns = fleet.config.columns;
+  if (fleet.columns == 0)
+  {
+    /* Roughly square arrangement of the tiles */
+    while (fleet.columns * fleet.columns < fleet.config.instanceCount)
+    {
+      fleet.columns++;
+    }
+  }
+  uint32_t rows = (fleet.config.instanceCount + fleet.columns - 1U) / fleet.columns;
+  fleet.frameWidth = (int32_t) fleet.columns * fleet.config.width;
+  fleet.frameHeight = (int32_t) rows * fleet.config.height;
+
+  pthread_condattr_t condAttr;
+  pthread_condattr_init(&condAttr);
+  pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+  pthread_cond_init(&fleet.queueCond, &condAttr);
+  pthread_condattr_destroy(&condAttr);
+  pthread_mutex_init(&fleet.queueLock, NULL);
+  pthread_mutex_init(&fleet.inputLock, NULL);
+  pthread_mutex_init(&fleet.frameLock, NULL);
+
+  if (!fleet.config.headless)
+  {
+    fleet.frame = calloc((size_t) fleet.frameWidth * (size_t) fleet.frameHeight, sizeof(uint32_t));
+    if (fleet.frame == NULL)
+    {
+      fprintf(stderr, "fleet: out of memory for a %dx%d frame\n", (int) fleet.frameWidth, (int) fleet.frameHeight);
+      return false;
+    }
+  }
+
+  if (!fleet_load())
+  {
+    free(fleet.frame);
+    return false;
+  }
+
+  signal(SIGINT, fleet_signal_handler);
+  fleetStopRequested = 0;
+  fleet.startUs = fleet_now_us();
+  fleet.running = true;
+  for (uint32_t i = 0; i < fleet.config.instanceCount; i++)
+  {
+    fleet.instances[i].dueUs = fleet.startUs;
+    fleet_queue_push(&fleet.instances[i]);
+  }
+  for (uint32_t i = 0; i < fleet.config.threadCount; i++)
+  {
+    if (pthread_create(&fleet.workers[i], NULL, fleet_worker, NULL) != 0)
+    {
+      fprintf(stderr, "fleet: could not start worker %u\n", (unsigned) i);
+      break;
+    }
+    fleet.workerCount++;
+  }
+
+  if (fleet.workerCount == 0)
+  {
+    ok = false;
+  }
+  else if (fleet.config.headless)
+  {
+    fleet_wait_headless();
+  }
+  else
+  {
+    fleet_window_run();
+  }
+
+  pthread_mutex_lock(&fleet.queueLock);
+  fleet.running = false;
+  pthread_cond_broadcast(&fleet.queueCond);
+  pthread_mutex_unlock(&fleet.queueLock);
+  for (uint32_t i = 0; i < fleet.workerCount; i++)
+  {
+    pthread_join(fleet.workers[i], NULL);
+  }
+
+  fleet_report();
+
+  for (uint32_t i = 0; i < fleet.config.instanceCount; i++)
+  {
+    ok = ok && !fleet.instances[i].failed;
+    dlclose(fleet.instances[i].handle);
+  }
+  free(fleet.frame);
+  signal(SIGINT, SIG_DFL);
+
+  return ok;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool fleet_load(void)
+{
+  for (uint32_t i = 0; i < fleet.config.instanceCount; i++)
+  {
+    fleet_instance_t *instance = &fleet.instances[i];
+
+    instance->index = i;
+    instance->tileX = (int32_t) (i % fleet.columns) * fleet.config.width;
+    instance->tileY = (int32_t) (i / fleet.columns) * fleet.config.height;
+    instance->handle = fleet_module_copy_load(fleet.config.modulePath, i);
+    if (instance->handle == NULL)
+    {
+      fprintf(stderr, "fleet: could not load %s: %s\n", fleet.config.modulePath, dlerror());
+      return false;
+    }
+
+    SimPanel_entry_t entry = (SimPanel_entry_t) dlsym(instance->handle, SIM_PANEL_ENTRY_NAME);
+    instance->api = (entry != NULL) ? entry() : NULL;
+    if (instance->api == NULL || instance->api->version != SIM_PANEL_API_VERSION)
+    {
+      fprintf(stderr, "fleet: %s is not a compatible panel module\n", fleet.config.modulePath);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * The dynamic loader maps a file only once per process, so every instance gets
+ * its own copy of the module. The copy is unlinked right after loading.
+ */
+static void *fleet_module_copy_load(const char *path, uint32_t index)
+{
+  const char *tmpDir = getenv("TMPDIR");
+  char copyPath[PATH_MAX];
+  char chunk[64 * 1024];
+  void *handle = NULL;
+  bool copied = true;
+
+  snprintf(copyPath, sizeof(copyPath), "%s/clx2panel-%u-XXXXXX", (tmpDir != NULL) ? tmpDir : "/tmp",
+           (unsigned) index);
+
+  int src = open(path, O_RDONLY);
+  if (src < 0)
+  {
+    return NULL;
+  }
+  int dst = mkstemp(copyPath);
+  if (dst < 0)
+  {
+    close(src);
+    return NULL;
+  }
+
+  ssize_t n;
+  while ((n = read(src, chunk, sizeof(chunk))) > 0)
+  {
+    if (write(dst, chunk, (size_t) n) != n)
+    {
+      copied = false;
+      break;
+    }
+  }
+  copied = copied && (n == 0);
+  close(src);
+  close(dst);
+
+  if (copied)
+  {
+    handle = dlopen(copyPath, RTLD_NOW | RTLD_LOCAL);
+  }
+  unlink(copyPath);
+
+  return handle;
+}
+
+static void *fleet_worker(void *arg)
+{
+  (void) arg;
+
+  pthread_mutex_lock(&fleet.queueLock);
+  while (fleet.running)
+  {
+    if (fleet.queueCount == 0)
+    {
+      pthread_cond_wait(&fleet.queueCond, &fleet.queueLock);
+      continue;
+    }
+
+    uint64_t dueUs = fleet.queue[0]->dueUs;
+    if (dueUs > fleet_now_us())
+    {
+      struct timespec until;
+      until.tv_sec = (time_t) (dueUs / 1000000U);
+      until.tv_nsec = (long) (dueUs % 1000000U) * 1000L;
+      pthread_cond_timedwait(&fleet.queueCond, &fleet.queueLock, &until);
+      continue;
+    }
+
+    fleet_instance_t *instance = fleet_queue_pop();
+    pthread_mutex_unlock(&fleet.queueLock);
+
+    fleet_instance_step(instance);
+
+    pthread_mutex_lock(&fleet.queueLock);
+    if (!instance->failed)
+    {
+      fleet_queue_push(instance);
+      pthread_cond_signal(&fleet.queueCond);
+    }
+  }
+  pthread_mutex_unlock(&fleet.queueLock);
+
+  return NULL;
+}
+
+static void fleet_instance_step(fleet_instance_t *instance)
+{
+  if (!instance->created)
+  {
+    SimPanel_config_t panelConfig = {
+      fleet.config.width,
+      fleet.config.height,
+      fleet.config.headless ? NULL : fleet_present_cb,
+      instance,
+    };
+
+    instance->created = true;
+    instance->failed = !instance->api->create(&panelConfig);
+    if (instance->failed)
+    {
+      fprintf(stderr, "fleet: instance %u failed to start\n", (unsigned) instance->index);
+    }
+    instance->dueUs = fleet_now_us();
+    return;
+  }
+
+  SimPanel_input_t input;
+  pthread_mutex_lock(&fleet.inputLock);
+  input = instance->input;
+  instance->input.keyName[0] = '\0';
+  pthread_mutex_unlock(&fleet.inputLock);
+
+  uint64_t startUs = fleet_now_us();
+  uint32_t sleepMs = instance->api->step(&input);
+  uint64_t endUs = fleet_now_us();
+
+  instance->steps++;
+  instance->busyUs += endUs - startUs;
+  if (endUs - startUs > instance->maxStepUs)
+  {
+    instance->maxStepUs = endUs - startUs;
+  }
+  instance->dueUs = endUs + (uint64_t) sleepMs * 1000U;
+}
+
+static void fleet_present_cb(void *user, int32_t x1, int32_t y1, int32_t x2, int32_t y2, const uint8_t *pixels,
+                             uint32_t stride)
+{
+  const fleet_instance_t *instance = user;
+  size_t rowBytes = (size_t) (x2 - x1 + 1) * sizeof(uint32_t);
+
+  pthread_mutex_lock(&fleet.frameLock);
+  for (int32_t y = y1; y <= y2; y++)
+  {
+    const uint8_t *src = pixels + (size_t) y * stride + (size_t) x1 * sizeof(uint32_t);
+    uint32_t *dst = fleet.frame + (size_t) (instance->tileY + y) * (size_t) fleet.frameWidth + instance->tileX + x1;
+    memcpy(dst, src, rowBytes);
+  }
+  fleet.frameDirty = true;
+  pthread_mutex_unlock(&fleet.frameLock);
+}
+
+static void fleet_queue_push(fleet_instance_t *instance)
+{
+  uint32_t i = fleet.queueCount++;
+
+  while (i > 0)
+  {
+    uint32_t parent = (i - 1U) / 2U;
+    if (fleet.queue[parent]->dueUs <= instance->dueUs)
+    {
+      break;
+    }
+    fleet.queue[i] = fleet.queue[parent];
+    i = parent;
+  }
+  fleet.queue[i] = instance;
+}
+
+static fleet_instance_t *fleet_queue_pop(void)
+{
+  fleet_instance_t *top = fleet.queue[0];
+  fleet_instance_t *last = fleet.queue[--fleet.queueCount];
+  uint32_t i = 0;
+
+  for (;;)
+  {
+    uint32_t child = 2U * i + 1U;
+    if (child >= fleet.queueCount)
+    {
+      break;
+    }
+    if (child + 1U < fleet.queueCount && fleet.queue[child + 1U]->dueUs < fleet.queue[child]->dueUs)
+    {
+      child++;
+    }
+    if (last->dueUs <= fleet.queue[child]->dueUs)
+    {
+      break;
+    }
+    fleet.queue[i] = fleet.queue[child];
+    i = child;
+  }
+  if (fleet.queueCount > 0)
+  {
+    fleet.queue[i] = last;
+  }
+
+  return top;
+}
+
+static void fleet_window_run(void)
+{
+  float scale = fleet.config.scale;
+  if (scale <= 0.0f)
+  {
+    scale = (fleet.frameWidth > FLEET_AUTO_FIT_WIDTH) ? (float) FLEET_AUTO_FIT_WIDTH / (float) fleet.frameWidth : 1.0f;
+  }
+
+  if (SDL_Init(SDL_INIT_VIDEO) != 0)
+  {
+    fprintf(stderr, "fleet: SDL_Init failed: %s\n", SDL_GetError());
+    return;
+  }
+
+  SDL_Window *window = SDL_CreateWindow("CANLineX2 fleet", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                                        (int) ((float) fleet.frameWidth * scale),
+                                        (int) ((float) fleet.frameHeight * scale), 0);
+  SDL_Renderer *renderer = (window != NULL) ? SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED) : NULL;
+  SDL_Texture *texture = (renderer != NULL) ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                                SDL_TEXTUREACCESS_STREAMING, fleet.frameWidth,
+                                                                fleet.frameHeight)
+                                            : NULL;
+  if (texture == NULL)
+  {
+    fprintf(stderr, "fleet: could not create the window: %s\n", SDL_GetError());
+  }
+  else
+  {
+    /* Mouse coordinates arrive in frame pixels regardless of the scale */
+    SDL_RenderSetLogicalSize(renderer, fleet.frameWidth, fleet.frameHeight);
+
+    uint32_t nextPresent = SDL_GetTicks();
+    while (!fleetStopRequested)
+    {
+      SDL_Event event;
+      if (SDL_WaitEventTimeout(&event, 5))
+      {
+        do
+        {
+          fleet_window_handle_event(&event);
+        } while (SDL_PollEvent(&event));
+      }
+
+      if (fleet.config.runTimeMs != 0 && fleet_now_us() - fleet.startUs >= (uint64_t) fleet.config.runTimeMs * 1000U)
+      {
+        break;
+      }
+      if ((int32_t) (SDL_GetTicks() - nextPresent) < 0)
+      {
+        continue;
+      }
+      nextPresent += FLEET_PRESENT_PERIOD_MS;
+
+      pthread_mutex_lock(&fleet.frameLock);
+      bool dirty = fleet.frameDirty;
+      if (dirty)
+      {
+        SDL_UpdateTexture(texture, NULL, fleet.frame, fleet.frameWidth * (int) sizeof(uint32_t));
+        fleet.frameDirty = false;
+      }
+      pthread_mutex_unlock(&fleet.frameLock);
+
+      if (dirty)
+      {
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, texture, NULL, NULL);
+        SDL_RenderPresent(renderer);
+      }
+    }
+  }
+
+  if (texture != NULL)
+  {
+    SDL_DestroyTexture(texture);
+  }
+  if (renderer != NULL)
+  {
+    SDL_DestroyRenderer(renderer);
+  }
+  if (window != NULL)
+  {
+    SDL_DestroyWindow(window);
+  }
+  SDL_Quit();
+}
+
+static void fleet_window_handle_event(const SDL_Event *event)
+{
+  int32_t x = 0;
+  int32_t y = 0;
+  bool isPointer = false;
+  bool pressed = false;
+
+  switch (event->type)
+  {
+  case SDL_QUIT:
+    fleetStopRequested = 1;
+    return;
+  case SDL_MOUSEMOTION:
+    x = event->motion.x;
+    y = event->motion.y;
+    pressed = (event->motion.state & SDL_BUTTON_LMASK) != 0;
+    isPointer = true;
+    break;
+  case SDL_MOUSEBUTTONDOWN:
+  case SDL_MOUSEBUTTONUP:
+    if (event->button.button != SDL_BUTTON_LEFT)
+    {
+      return;
+    }
+    x = event->button.x;
+    y = event->button.y;
+    pressed = (event->type == SDL_MOUSEBUTTONDOWN);
+    isPointer = true;
+    break;
+  case SDL_KEYDOWN:
+    pthread_mutex_lock(&fleet.inputLock);
+    if (fleet.focus >= 0 && (uint32_t) fleet.focus < fleet.config.instanceCount)
+    {
+      SimPanel_input_t *input = &fleet.instances[fleet.focus].input;
+      snprintf(input->keyName, sizeof(input->keyName), "%s", SDL_GetKeyName(event->key.keysym.sym));
+    }
+    pthread_mutex_unlock(&fleet.inputLock);
+    return;
+  default:
+    return;
+  }
+
+  if (!isPointer || x < 0 || y < 0 || x >= fleet.frameWidth || y >= fleet.frameHeight)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&fleet.inputLock);
+  /* A press selects the tile, dragging keeps feeding the selected one */
+  uint32_t tile = (uint32_t) (y / fleet.config.height) * fleet.columns + (uint32_t) (x / fleet.config.width);
+  if (event->type == SDL_MOUSEBUTTONDOWN && tile < fleet.config.instanceCount)
+  {
+    fleet.focus = (int32_t) tile;
+  }
+  if (fleet.focus >= 0 && (uint32_t) fleet.focus < fleet.config.instanceCount)
+  {
+    fleet_instance_t *instance = &fleet.instances[fleet.focus];
+    instance->input.pointerX = fleet_clamp(x - instance->tileX, fleet.config.width - 1);
+    instance->input.pointerY = fleet_clamp(y - instance->tileY, fleet.config.height - 1);
+    instance->input.pointerPressed = pressed;
+  }
+  pthread_mutex_unlock(&fleet.inputLock);
+}
+
+static void fleet_wait_headless(void)
+{
+  while (!fleetStopRequested)
+  {
+    if (fleet.config.runTimeMs != 0 && fleet_now_us() - fleet.startUs >= (uint64_t) fleet.config.runTimeMs * 1000U)
+    {
+      break;
+    }
+    usleep(10 * 1000);
+  }
+}
+
+static void fleet_report(void)
+{
+  double seconds = (double) (fleet_now_us() - fleet.startUs) / 1e6;
+
+  printf("fleet: %u instances on %u threads for %.1f s\n", (unsigned) fleet.config.instanceCount,
+         (unsigned) fleet.workerCount, seconds);
+  for (uint32_t i = 0; i < fleet.config.instanceCount; i++)
+  {
+    const fleet_instance_t *instance = &fleet.instances[i];
+    double avgMs = (instance->steps != 0) ? (double) instance->busyUs / (double) instance->steps / 1000.0 : 0.0;
+    printf("  #%-3u steps %-8llu avg %.3f ms  max %.3f ms%s\n", (unsigned) i, (unsigned long long) instance->steps,
+           avgMs, (double) instance->maxStepUs / 1000.0, instance->failed ? "  FAILED" : "");
+  }
+}
+
+static void fleet_signal_handler(int sig)
+{
+  (void) sig;
+  fleetStopRequested = 1;
+}
+
+static int32_t fleet_clamp(int32_t v, int32_t max)
+{
+  return (v < 0) ? 0 : ((v > max) ? max : v);
+}
+
+static uint64_t fleet_now_us(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000U + (uint64_t) now.tv_nsec / 1000U;
+}
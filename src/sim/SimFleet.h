@@ -0,0 +1,64 @@
+/**
+ * @file SimFleet.h
+ * Runs many independent CANLineX2 panels in one process.
+ *
+ * Every instance is a private copy of the panel module (see SimPanel.h), so
+ * LVGL, the descriptor and the CANLineX2Graphics module statics exist once per
+ * instance. Instances are stepped by a pool of worker threads; an instance is
+ * only ever owned by one worker at a time.
+ */
+
+#ifndef SIM_FLEET_H
+#define SIM_FLEET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define SIM_FLEET_MAX_INSTANCES 256
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  const char *modulePath;  /**< path of the panel module to load */
+  uint32_t instanceCount;  /**< number of panels, 1..SIM_FLEET_MAX_INSTANCES */
+  uint32_t threadCount;    /**< worker threads, 0: one per online CPU */
+  int32_t width;           /**< resolution of one panel */
+  int32_t height;
+  bool headless;           /**< true: no window at all */
+  uint32_t columns;        /**< tiles per row in the SDL window, 0: automatic */
+  float scale;             /**< window scale of the tiled frame, 0: fit to 1920 px */
+  uint32_t runTimeMs;      /**< stop after this time, 0: until the window is closed */
+} SimFleet_config_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Fill `config` with the defaults (one 800x480 panel per CPU in a window) */
+void SimFleet_config_init(SimFleet_config_t *config);
+
+/**
+ * Load, run and tear down the fleet. Blocks until the run time elapsed or the
+ * window was closed. Must be called from the main thread (SDL).
+ * @return false if the module could not be loaded or an instance failed to start
+ */
+bool SimFleet_run(const SimFleet_config_t *config);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SIM_FLEET_H*/
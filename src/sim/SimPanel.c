@@ -0,0 +1,139 @@
+/**
+ * @file SimPanel.c
+ * One CANLineX2 panel, built as a loadable module for the fleet simulator.
+ *
+ * Everything in here runs on whichever fleet worker currently owns the
+ * instance, never on two threads at the same time.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+#include "lvgl/lvgl.h"
+
+#include "SimPanel.h"
+#include "../hal/hal.h"
+#include "CANLineX2Graphics/DisplayStateMachine.h"
+#include "CANLineX2Graphics/ChartData.h"
+#include "CANLineX2Interface/TimeoutServer/TimeoutServer.h"
+#include "CANLineX2Interface/ConfigurationHandler.h"
+#include "TimerLib.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/** Same cadence as the superloop in main.c */
+#define CHART_UPDATE_PERIOD_MS 1000
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bool panel_create(const SimPanel_config_t *config);
+static uint32_t panel_step(const SimPanel_input_t *input);
+static void panel_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map);
+static void panel_pointer_read_cb(lv_indev_t *indev, lv_indev_data_t *data);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static const SimPanel_api_t panelApi = {
+  SIM_PANEL_API_VERSION,
+  panel_create,
+  panel_step,
+};
+
+static SimPanel_config_t panelConfig;
+static SimPanel_input_t panelInput;
+static uint32_t chartRefTime;
+static uint32_t chartDelay;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+__attribute__((visibility("default"))) const SimPanel_api_t *SimPanel_api(void)
+{
+  return &panelApi;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool panel_create(const SimPanel_config_t *config)
+{
+  panelConfig = *config;
+
+  lv_init();
+
+  lv_display_t *disp = headless_hal_init(config->width, config->height);
+  if (disp == NULL)
+  {
+    return false;
+  }
+  lv_display_set_flush_cb(disp, panel_flush_cb);
+
+  lv_indev_t *pointer = lv_indev_create();
+  lv_indev_set_type(pointer, LV_INDEV_TYPE_POINTER);
+  lv_indev_set_read_cb(pointer, panel_pointer_read_cb);
+  lv_indev_set_display(pointer, disp);
+  lv_indev_set_group(pointer, lv_group_get_default());
+
+  ChartData_init();
+  DisplayStateMachine_init();
+
+  return true;
+}
+
+static uint32_t panel_step(const SimPanel_input_t *input)
+{
+  panelInput = *input;
+  if (panelInput.keyName[0] != '\0')
+  {
+    ConfigurationHandler_SetKeyValue(panelInput.keyName);
+  }
+
+  TimeoutServer_handler();
+  chartDelay += TimerLib_ref_delay(&chartRefTime);
+  if (chartDelay > CHART_UPDATE_PERIOD_MS)
+  {
+    chartDelay = 0;
+    ChartData_handler();
+  }
+
+  uint32_t sleep_time_ms = lv_timer_handler();
+  if (sleep_time_ms == LV_NO_TIMER_READY)
+  {
+    sleep_time_ms = LV_DEF_REFR_PERIOD;
+  }
+
+  DisplayStateMachine_handler();
+
+  return sleep_time_ms;
+}
+
+static void panel_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+  LV_UNUSED(px_map);
+
+  if (panelConfig.presentCb != NULL)
+  {
+    /*Direct mode: the active buffer is the whole frame*/
+    lv_draw_buf_t *frame = lv_display_get_buf_active(disp);
+    panelConfig.presentCb(panelConfig.user, area->x1, area->y1, area->x2, area->y2, frame->data,
+                          frame->header.stride);
+  }
+
+  lv_display_flush_ready(disp);
+}
+
+static void panel_pointer_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+  LV_UNUSED(indev);
+
+  data->point.x = panelInput.pointerX;
+  data->point.y = panelInput.pointerY;
+  data->state = panelInput.pointerPressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file SimPanel.h
+ * Interface of the loadable panel module used by the fleet simulator.
+ *
+ * The module bundles LVGL, the CANLineX2 application and the descriptor. The
+ * fleet host loads one private copy of it per instance, so each instance owns
+ * its complete module state. Only plain C types cross this boundary.
+ */
+
+#ifndef SIM_PANEL_H
+#define SIM_PANEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/** Bump when SimPanel_api_t changes, the host refuses mismatching modules */
+#define SIM_PANEL_API_VERSION 1
+
+/** Name of the entry point exported by the module */
+#define SIM_PANEL_ENTRY_NAME "SimPanel_api"
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**
+ * Called from the instance's worker thread whenever LVGL flushed an area.
+ * `pixels` is the complete XRGB8888 frame of the instance, only the area
+ * x1..x2 / y1..y2 (inclusive) changed.
+ */
+typedef void (*SimPanel_present_cb_t)(void *user, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                                      const uint8_t *pixels, uint32_t stride);
+
+typedef struct {
+  int32_t width;
+  int32_t height;
+  SimPanel_present_cb_t presentCb; /**< may be NULL for fully headless instances */
+  void *user;
+} SimPanel_config_t;
+
+/** Input state handed to the instance on every step */
+typedef struct {
+  int32_t pointerX;
+  int32_t pointerY;
+  bool pointerPressed;
+  char keyName[16]; /**< SDL key name of a pending key press, empty if none */
+} SimPanel_input_t;
+
+typedef struct {
+  uint32_t version; /**< SIM_PANEL_API_VERSION */
+  /** Initialize LVGL, the display and the application. Returns false on failure */
+  bool (*create)(const SimPanel_config_t *config);
+  /** Run one superloop pass. Returns the time in ms until the next pass is due */
+  uint32_t (*step)(const SimPanel_input_t *input);
+} SimPanel_api_t;
+
+typedef const SimPanel_api_t *(*SimPanel_entry_t)(void);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Entry point of the module, looked up by SIM_PANEL_ENTRY_NAME */
+const SimPanel_api_t *SimPanel_api(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SIM_PANEL_H*/
@@ -0,0 +1,517 @@
+/**
+ * @file SimScenario.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "SimScenario.h"
+#include "SimDescriptor.h"
+#include "SimSensors.h"
+#include "SimAlarms.h"
+#include "SimSignals.h"
+#include "SensorIngest.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SCENARIO_PATH_LEN 512
+#define ALL_SENSORS UINT32_MAX
+#define JOURNAL_CAPACITY 131072U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+  EVENT_VALUE,
+  EVENT_FAULT,
+  EVENT_FAULT_CLEAR,
+  EVENT_PRESS,
+  EVENT_RELEASE,
+  EVENT_MOVE,
+  EVENT_KEY,
+} event_type_t;
+
+typedef struct {
+  uint32_t timeMs;
+  uint32_t order; /**< keeps the file order of events with equal time */
+  event_type_t type;
+  uint32_t sensor;
+  double value;
+  int32_t x;
+  int32_t y;
+  char keyName[32]; /**< SDL key name, may contain spaces ("Keypad Backspace") */
+} event_t;
+
+typedef struct {
+  uint32_t triggers;
+  uint32_t firstMs;
+} level_stats_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bool load_events(const char *dir, const char *file, bool sensors);
+static bool add_event(const event_t *event);
+static int compare_events(const void *a, const void *b);
+static void apply_event(const event_t *event);
+static void alarm_event_cb(uint32_t sensor, uint8_t level, bool active, uint32_t nowMs);
+static void json_string(FILE *out, const char *text);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static char scenarioDir[SCENARIO_PATH_LEN];
+static event_t *events;
+static uint32_t eventCount;
+static uint32_t eventCapacity;
+static uint32_t nextEvent;
+static uint32_t endMs;
+static bool endGiven;
+static uint32_t lastStepMs;
+
+static int32_t pointerX;
+static int32_t pointerY;
+static bool pointerPressed;
+static SimScenario_key_cb_t keyCb;
+
+static level_stats_t levelStats[SIM_DESCRIPTOR_MAX_SENSORS][SIM_ALARMS_ENTRIES];
+static SimDescriptor_relayMask_t relayDemand;
+static uint32_t relaySwitches;
+static EventJournal_t *journal;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+bool SimScenario_load(const char *dir)
+{
+  char path[SCENARIO_PATH_LEN];
+  FILE *probe;
+
+  snprintf(scenarioDir, sizeof(scenarioDir), "%s", dir);
+  free(events);
+  events = NULL;
+  eventCount = 0;
+  eventCapacity = 0;
+  nextEvent = 0;
+  endMs = 0;
+  endGiven = false;
+  lastStepMs = 0;
+  pointerX = 0;
+  pointerY = 0;
+  pointerPressed = false;
+  relaySwitches = 0;
+  memset(relayDemand, 0, sizeof(relayDemand));
+  memset(levelStats, 0, sizeof(levelStats));
+
+  snprintf(path, sizeof(path), "%s/Configuration.inc", dir);
+  probe = fopen(path, "r");
+  if (probe != NULL)
+  {
+    fclose(probe);
+    if (!SimDescriptor_load(path))
+    {
+      return false;
+    }
+  }
+
+  if (!load_events(dir, "sensors.txt", true) || !load_events(dir, "input.txt", false) || !SimSignals_load(dir))
+  {
+    return false;
+  }
+  if (eventCount > 0)
+  {
+    qsort(events, eventCount, sizeof(event_t), compare_events);
+  }
+  if (!endGiven)
+  {
+    endMs = (eventCount > 0) ? events[eventCount - 1U].timeMs : 0U;
+    endMs = ((SimSignals_get_end_ms() > endMs) ? SimSignals_get_end_ms() : endMs) + SIM_SCENARIO_SETTLE_MS;
+  }
+
+  SimSensors_reset();
+  SimAlarms_reset();
+  SensorIngest_reset();
+  SimAlarms_set_event_cb(alarm_event_cb);
+  if (journal == NULL)
+  {
+    journal = EventJournal_create(JOURNAL_CAPACITY);
+  }
+  else
+  {
+    EventJournal_clear(journal);
+  }
+
+  return true;
+}
+
+void SimScenario_set_key_cb(SimScenario_key_cb_t cb)
+{
+  keyCb = cb;
+}
+
+void SimScenario_step(uint32_t nowMs)
+{
+  while (nextEvent < eventCount && events[nextEvent].timeMs <= nowMs)
+  {
+    apply_event(&events[nextEvent++]);
+  }
+
+  /* Signals evaluate the alarms at every sample of their own */
+  SimSignals_step(nowMs);
+  SimAlarms_update(nowMs);
+  SensorIngest_update(nowMs);
+
+  SimDescriptor_relayMask_t demand;
+  SimAlarms_get_relay_demand(demand);
+  for (uint32_t w = 0; w < SIM_DESCRIPTOR_RELAY_WORDS; w++)
+  {
+    uint32_t changed = demand[w] ^ relayDemand[w];
+    for (uint32_t bit = 0; changed != 0; bit++)
+    {
+      if ((changed & (1U << bit)) == 0)
+      {
+        continue;
+      }
+      changed &= ~(1U << bit);
+      relaySwitches++;
+      if (journal != NULL)
+      {
+        EventJournal_append(journal, nowMs, (uint16_t) EVENT_JOURNAL_RELAY_SOURCE(w * 32U + bit),
+                            EVENT_JOURNAL_LEVEL_RELAY,
+                            (demand[w] & (1U << bit)) ? EVENT_JOURNAL_RELAY_ON : EVENT_JOURNAL_RELAY_OFF);
+      }
+    }
+    relayDemand[w] = demand[w];
+  }
+  lastStepMs = nowMs;
+}
+
+EventJournal_t *SimScenario_get_journal(void)
+{
+  return journal;
+}
+
+bool SimScenario_done(uint32_t nowMs)
+{
+  return nowMs >= endMs;
+}
+
+void SimScenario_get_pointer(int32_t *x, int32_t *y, bool *pressed)
+{
+  *x = pointerX;
+  *y = pointerY;
+  *pressed = pointerPressed;
+}
+
+bool SimScenario_write_report(const char *path, const SimScenario_timing_t *timing, const char *screenshot)
+{
+  const SimDescriptor_t *desc = SimDescriptor_get();
+  FILE *out = fopen(path, "w");
+  if (out == NULL)
+  {
+    return false;
+  }
+
+  fprintf(out, "{\n  \"scenario\": ");
+  json_string(out, scenarioDir);
+  fprintf(out, ",\n  \"device\": ");
+  json_string(out, desc->deviceName);
+  fprintf(out, ",\n  \"simulatedMs\": %u,\n", (unsigned) lastStepMs);
+  fprintf(out, "  \"wallMs\": %.3f,\n", (double) timing->wallUs / 1000.0);
+  fprintf(out, "  \"loops\": %u,\n", (unsigned) timing->loops);
+  fprintf(out, "  \"avgLoopUs\": %.1f,\n",
+          (timing->loops != 0) ? (double) timing->loopBusyUs / (double) timing->loops : 0.0);
+  fprintf(out, "  \"maxLoopUs\": %u,\n", (unsigned) timing->maxLoopUs);
+  fprintf(out, "  \"signalSamples\": %llu,\n", (unsigned long long) SimSignals_get_sample_count());
+
+  fprintf(out, "  \"alarms\": [");
+  bool first = true;
+  for (uint32_t s = 0; s < desc->sensorCount; s++)
+  {
+    uint8_t state = SimAlarms_get_state(s);
+    for (uint8_t e = 0; e < SIM_ALARMS_ENTRIES; e++)
+    {
+      const level_stats_t *stats = &levelStats[s][e];
+      if (stats->triggers == 0 && (state & (1U << e)) == 0)
+      {
+        continue;
+      }
+      fprintf(out, "%s\n    { \"sensor\": %u, \"name\": ", first ? "" : ",", (unsigned) (s + 1U));
+      json_string(out, desc->sensors[s].name);
+      fprintf(out, ", \"level\": ");
+      json_string(out, (e == SIM_ALARMS_FAULT) ? desc->faultText : desc->alarmText[e]);
+      fprintf(out, ", \"triggers\": %u, \"firstMs\": %u, \"active\": %s }", (unsigned) stats->triggers,
+              (unsigned) stats->firstMs, (state & (1U << e)) ? "true" : "false");
+      first = false;
+    }
+  }
+  fprintf(out, "%s],\n", first ? "" : "\n  ");
+
+  fprintf(out, "  \"relays\": { \"final\": [");
+  for (uint32_t w = 0; w < SIM_DESCRIPTOR_RELAY_WORDS; w++)
+  {
+    fprintf(out, "%s\"0x%08x\"", (w != 0) ? ", " : "", (unsigned) relayDemand[w]);
+  }
+  fprintf(out, "], \"switches\": %u },\n", (unsigned) relaySwitches);
+
+  if (journal != NULL)
+  {
+    fprintf(out, "  \"journal\": { \"events\": %u, \"unacked\": %u },\n", (unsigned) EventJournal_get_count(journal),
+            (unsigned) EventJournal_get_unacked_count(journal));
+  }
+
+  fprintf(out, "  \"screenshot\": ");
+  if (screenshot != NULL)
+  {
+    json_string(out, screenshot);
+  }
+  else
+  {
+    fprintf(out, "null");
+  }
+  fprintf(out, "\n}\n");
+
+  return fclose(out) == 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool load_events(const char *dir, const char *file, bool sensors)
+{
+  char path[SCENARIO_PATH_LEN];
+  char line[256];
+  uint32_t lineNr = 0;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, file);
+  FILE *in = fopen(path, "r");
+  if (in == NULL)
+  {
+    return true; /* every file is optional */
+  }
+
+  while (fgets(line, sizeof(line), in) != NULL)
+  {
+    char word[32];
+    char arg[32];
+    unsigned long timeMs;
+    event_t event;
+    int n;
+
+    lineNr++;
+    memset(&event, 0, sizeof(event));
+    if (line[0] == '#' || sscanf(line, "%31s", word) != 1)
+    {
+      continue;
+    }
+    if (sensors && strcmp(word, "end") == 0 && sscanf(line, "%*s %lu", &timeMs) == 1)
+    {
+      endMs = (uint32_t) timeMs;
+      endGiven = true;
+      continue;
+    }
+
+    n = sscanf(line, "%lu %31s %31s %d %d", &timeMs, word, arg, &event.x, &event.y);
+    event.timeMs = (uint32_t) timeMs;
+    event.order = eventCount;
+
+    bool ok = (n >= 3);
+    if (ok && sensors)
+    {
+      unsigned long number = strtoul(word, NULL, 10);
+      event.sensor = (strcmp(word, "*") == 0) ? ALL_SENSORS : (uint32_t) number - 1U;
+      ok = (event.sensor == ALL_SENSORS) || (number >= 1U && number <= SIM_DESCRIPTOR_MAX_SENSORS);
+      if (strcmp(arg, "fault") == 0)
+      {
+        event.type = EVENT_FAULT;
+      }
+      else if (strcmp(arg, "ok") == 0)
+      {
+        event.type = EVENT_FAULT_CLEAR;
+      }
+      else
+      {
+        event.type = EVENT_VALUE;
+        event.value = strtod(arg, NULL);
+      }
+    }
+    else if (ok && strcmp(word, "key") == 0)
+    {
+      /* The name is the rest of the line, too long a name is an error rather than another key */
+      int nameOffset = 0;
+      event.type = EVENT_KEY;
+      (void) sscanf(line, "%*s %*s %n", &nameOffset);
+      size_t nameLen = strcspn(&line[nameOffset], "\r\n");
+      while (nameLen > 0U && (line[nameOffset + nameLen - 1U] == ' ' || line[nameOffset + nameLen - 1U] == '\t'))
+      {
+        nameLen--;
+      }
+      ok = nameOffset > 0 && nameLen > 0U && nameLen < sizeof(event.keyName);
+      if (ok)
+      {
+        memcpy(event.keyName, &line[nameOffset], nameLen);
+      }
+    }
+    else if (ok)
+    {
+      /* "<ms> press <x> <y>": arg holds x */
+      event.y = event.x;
+      event.x = (int32_t) strtol(arg, NULL, 10);
+      ok = (n >= 4);
+      if (strcmp(word, "press") == 0)
+      {
+        event.type = EVENT_PRESS;
+      }
+      else if (strcmp(word, "release") == 0)
+      {
+        event.type = EVENT_RELEASE;
+      }
+      else if (strcmp(word, "move") == 0)
+      {
+        event.type = EVENT_MOVE;
+      }
+      else
+      {
+        ok = false;
+      }
+    }
+
+    if (!ok)
+    {
+      fprintf(stderr, "SimScenario: %s:%u: cannot parse \"%s\"\n", path, (unsigned) lineNr, strtok(line, "\r\n"));
+      fclose(in);
+      return false;
+    }
+    if (!add_event(&event))
+    {
+      fclose(in);
+      return false;
+    }
+  }
+
+  fclose(in);
+  return true;
+}
+
+static bool add_event(const event_t *event)
+{
+  if (eventCount == eventCapacity)
+  {
+    uint32_t capacity = (eventCapacity != 0) ? eventCapacity * 2U : 256U;
+    event_t *grown = realloc(events, capacity * sizeof(event_t));
+    if (grown == NULL)
+    {
+      fprintf(stderr, "SimScenario: out of memory\n");
+      return false;
+    }
+    events = grown;
+    eventCapacity = capacity;
+  }
+  events[eventCount++] = *event;
+
+  return true;
+}
+
+static int compare_events(const void *a, const void *b)
+{
+  const event_t *ea = a;
+  const event_t *eb = b;
+
+  if (ea->timeMs != eb->timeMs)
+  {
+    return (ea->timeMs < eb->timeMs) ? -1 : 1;
+  }
+
+  return (ea->order < eb->order) ? -1 : 1;
+}
+
+static void apply_event(const event_t *event)
+{
+  const SimDescriptor_t *desc = SimDescriptor_get();
+  uint32_t first = (event->sensor == ALL_SENSORS) ? 0U : event->sensor;
+  uint32_t last = (event->sensor == ALL_SENSORS) ? desc->sensorCount : event->sensor + 1U;
+
+  switch (event->type)
+  {
+  case EVENT_VALUE:
+    for (uint32_t s = first; s < last; s++)
+    {
+      double raw = event->value * pow(10.0, desc->sensors[s].decimals);
+      SimSensors_set_value(s, (int32_t) lround(raw), event->timeMs);
+    }
+    break;
+  case EVENT_FAULT:
+  case EVENT_FAULT_CLEAR:
+    for (uint32_t s = first; s < last; s++)
+    {
+      SimSensors_set_fault(s, event->type == EVENT_FAULT, event->timeMs);
+    }
+    break;
+  case EVENT_PRESS:
+  case EVENT_RELEASE:
+  case EVENT_MOVE:
+    pointerX = event->x;
+    pointerY = event->y;
+    pointerPressed = (event->type == EVENT_PRESS) || (event->type == EVENT_MOVE && pointerPressed);
+    break;
+  case EVENT_KEY:
+    if (keyCb != NULL)
+    {
+      keyCb(event->keyName);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+static void alarm_event_cb(uint32_t sensor, uint8_t level, bool active, uint32_t nowMs)
+{
+  level_stats_t *stats = &levelStats[sensor][level];
+
+  if (journal != NULL)
+  {
+    EventJournal_append(journal, nowMs, (uint16_t) sensor, level,
+                        active ? EVENT_JOURNAL_TRIGGER : EVENT_JOURNAL_RELEASE);
+  }
+  if (active)
+  {
+    if (stats->triggers == 0)
+    {
+      stats->firstMs = nowMs;
+    }
+    stats->triggers++;
+  }
+}
+
+static void json_string(FILE *out, const char *text)
+{
+  fputc('"', out);
+  for (; *text != '\0'; text++)
+  {
+    if (*text == '"' || *text == '\\')
+    {
+      fputc('\\', out);
+      fputc(*text, out);
+    }
+    else if ((unsigned char) *text < 0x20)
+    {
+      fprintf(out, "\\u%04x", (unsigned) (unsigned char) *text);
+    }
+    else
+    {
+      fputc(*text, out);
+    }
+  }
+  fputc('"', out);
+}
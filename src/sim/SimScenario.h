@@ -0,0 +1,78 @@
+/**
+ * @file SimScenario.h
+ * Scripted, headless simulator run.
+ *
+ * A scenario is a directory with optional files:
+ *  - Configuration.inc  descriptor used instead of the default one
+ *  - sensors.txt        "<ms> <sensor> <value>|fault|ok" per line, sensors are
+ *                       1-based or `*` for all, values in display units (20.9)
+ *                       "end <ms>" sets the scenario length
+ *  - input.txt          "<ms> press|release|move <x> <y>" or "<ms> key <name>"
+ *                       the SDL key name, the rest of the line ("Keypad Backspace")
+ *  - signals.txt        synthetic waveforms, see SimSignals.h
+ * Scenarios run on a simulated clock, so a day of plant time does not take a day.
+ */
+
+#ifndef SIM_SCENARIO_H
+#define SIM_SCENARIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "../history/EventJournal.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/** Time the scenario keeps running after its last event if it has no "end" */
+#define SIM_SCENARIO_SETTLE_MS 5000U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/** Called for every key event of the input recording */
+typedef void (*SimScenario_key_cb_t)(const char *keyName);
+
+typedef struct {
+  uint64_t wallUs;     /**< real time the run took */
+  uint32_t loops;      /**< superloop passes */
+  uint64_t loopBusyUs; /**< time spent in the handlers of all passes */
+  uint32_t maxLoopUs;
+} SimScenario_timing_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Load the scenario files from `dir` and reset sensors and alarms */
+bool SimScenario_load(const char *dir);
+
+void SimScenario_set_key_cb(SimScenario_key_cb_t cb);
+
+/** Apply all events due at `nowMs` and evaluate the alarms */
+void SimScenario_step(uint32_t nowMs);
+
+/** Alarm and relay events of the run, for alarm list screens to query and acknowledge */
+EventJournal_t *SimScenario_get_journal(void);
+
+bool SimScenario_done(uint32_t nowMs);
+
+/** Pointer state of the input recording, for a pointer input device */
+void SimScenario_get_pointer(int32_t *x, int32_t *y, bool *pressed);
+
+/** Write the outcome of the run as JSON */
+bool SimScenario_write_report(const char *path, const SimScenario_timing_t *timing, const char *screenshot);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SIM_SCENARIO_H*/
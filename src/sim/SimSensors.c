@@ -0,0 +1,77 @@
+/**
+ * @file SimSensors.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "SimSensors.h"
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static int32_t values[SIM_DESCRIPTOR_MAX_SENSORS];
+static bool faults[SIM_DESCRIPTOR_MAX_SENSORS];
+static uint32_t timestamps[SIM_DESCRIPTOR_MAX_SENSORS];
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void SimSensors_reset(void)
+{
+  memset(values, 0, sizeof(values));
+  memset(faults, 0, sizeof(faults));
+  memset(timestamps, 0, sizeof(timestamps));
+}
+
+void SimSensors_set_value(uint32_t sensor, int32_t value, uint32_t nowMs)
+{
+  if (sensor < SIM_DESCRIPTOR_MAX_SENSORS)
+  {
+    values[sensor] = value;
+    timestamps[sensor] = nowMs;
+  }
+}
+
+void SimSensors_set_fault(uint32_t sensor, bool fault, uint32_t nowMs)
+{
+  if (sensor < SIM_DESCRIPTOR_MAX_SENSORS)
+  {
+    faults[sensor] = fault;
+    timestamps[sensor] = nowMs;
+  }
+}
+
+int32_t SimSensors_get_value(uint32_t sensor)
+{
+  return (sensor < SIM_DESCRIPTOR_MAX_SENSORS) ? values[sensor] : 0;
+}
+
+const int32_t *SimSensors_get_values(void)
+{
+  return values;
+}
+
+bool SimSensors_get_fault(uint32_t sensor)
+{
+  return (sensor < SIM_DESCRIPTOR_MAX_SENSORS) && faults[sensor];
+}
+
+const bool *SimSensors_get_faults(void)
+{
+  return faults;
+}
+
+uint32_t SimSensors_get_timestamp(uint32_t sensor)
+{
+  return (sensor < SIM_DESCRIPTOR_MAX_SENSORS) ? timestamps[sensor] : 0;
+}
+
+const uint32_t *SimSensors_get_timestamps(void)
+{
+  return timestamps;
+}
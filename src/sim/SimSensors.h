@@ -0,0 +1,54 @@
+/**
+ * @file SimSensors.h
+ * Current sensor readings of the simulated plant.
+ *
+ * Values are raw descriptor units (see SimDescriptor.h). Sources such as
+ * scenario scripts write here, alarm evaluation and views read from here.
+ */
+
+#ifndef SIM_SENSORS_H
+#define SIM_SENSORS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "SimDescriptor.h"
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Zero all values and clear all faults */
+void SimSensors_reset(void);
+
+void SimSensors_set_value(uint32_t sensor, int32_t value, uint32_t nowMs);
+
+void SimSensors_set_fault(uint32_t sensor, bool fault, uint32_t nowMs);
+
+int32_t SimSensors_get_value(uint32_t sensor);
+
+/** All SIM_DESCRIPTOR_MAX_SENSORS values, packed by sensor index, for views that read many at once */
+const int32_t *SimSensors_get_values(void);
+
+bool SimSensors_get_fault(uint32_t sensor);
+
+/** All SIM_DESCRIPTOR_MAX_SENSORS fault flags, packed by sensor index */
+const bool *SimSensors_get_faults(void);
+
+/** Time of the last write to the sensor */
+uint32_t SimSensors_get_timestamp(uint32_t sensor);
+
+/** All SIM_DESCRIPTOR_MAX_SENSORS timestamps, packed by sensor index */
+const uint32_t *SimSensors_get_timestamps(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SIM_SENSORS_H*/
@@ -0,0 +1,166 @@
+/**
+ * @file SimSettings.c
+ *
+ * Flash layout: settings_header_t at address 0, the struct right after it.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "SimSettings.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SETTINGS_MAGIC 0x53584C43U /* "CLXS" */
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  uint32_t magic;
+  uint32_t size;
+  uint32_t crc;
+  uint32_t reserved;
+} settings_header_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static uint32_t crc32(const uint8_t *data, uint32_t len);
+static void save_changes(void);
+static void write_header(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static SimFlash_t *settingsFlash;
+static uint8_t *settingsData;
+static uint8_t *savedData;
+static uint32_t settingsSize;
+static uint32_t lastPollMs;
+static bool restored;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+bool SimSettings_attach(SimFlash_t *flash, void *data, uint32_t size)
+{
+  settings_header_t header;
+
+  SimSettings_detach();
+  if (size > SimFlash_get_capacity(flash) - sizeof(header))
+  {
+    return false;
+  }
+  savedData = malloc(size);
+  if (savedData == NULL)
+  {
+    return false;
+  }
+  settingsFlash = flash;
+  settingsData = data;
+  settingsSize = size;
+
+  restored = SimFlash_read(flash, 0, &header, sizeof(header)) && header.magic == SETTINGS_MAGIC &&
+             header.size == size && SimFlash_read(flash, sizeof(header), savedData, size) &&
+             crc32(savedData, size) == header.crc;
+  if (restored)
+  {
+    memcpy(data, savedData, size);
+  }
+  else
+  {
+    /* First copy, written where it differs from what the flash holds */
+    SimFlash_read(flash, sizeof(header), savedData, size);
+    save_changes();
+    write_header();
+    SimFlash_sync(flash);
+  }
+
+  return true;
+}
+
+void SimSettings_handler(uint32_t nowMs)
+{
+  if (settingsFlash == NULL)
+  {
+    return;
+  }
+  if (nowMs - lastPollMs >= SIM_SETTINGS_POLL_MS)
+  {
+    lastPollMs = nowMs;
+    save_changes();
+  }
+  SimFlash_handler(settingsFlash, nowMs);
+}
+
+bool SimSettings_was_restored(void)
+{
+  return restored;
+}
+
+void SimSettings_detach(void)
+{
+  if (settingsFlash != NULL)
+  {
+    save_changes();
+    SimFlash_sync(settingsFlash);
+  }
+  free(savedData);
+  savedData = NULL;
+  settingsFlash = NULL;
+  settingsData = NULL;
+  settingsSize = 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static uint32_t crc32(const uint8_t *data, uint32_t len)
+{
+  uint32_t crc = 0xFFFFFFFFU;
+
+  for (uint32_t i = 0; i < len; i++)
+  {
+    crc ^= data[i];
+    for (uint32_t b = 0; b < 8U; b++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+    }
+  }
+
+  return ~crc;
+}
+
+/** Write the chunks that differ from the saved state, then the header with the new CRC */
+static void save_changes(void)
+{
+  if (memcmp(settingsData, savedData, settingsSize) == 0)
+  {
+    return;
+  }
+
+  for (uint32_t offset = 0; offset < settingsSize; offset += SIM_SETTINGS_CHUNK)
+  {
+    uint32_t len = (settingsSize - offset < SIM_SETTINGS_CHUNK) ? settingsSize - offset : SIM_SETTINGS_CHUNK;
+    if (memcmp(&settingsData[offset], &savedData[offset], len) != 0)
+    {
+      SimFlash_write(settingsFlash, (uint32_t) sizeof(settings_header_t) + offset, &settingsData[offset], len);
+      memcpy(&savedData[offset], &settingsData[offset], len);
+    }
+  }
+  write_header();
+}
+
+static void write_header(void)
+{
+  settings_header_t header = { SETTINGS_MAGIC, settingsSize, crc32(savedData, settingsSize), 0 };
+  SimFlash_write(settingsFlash, 0, &header, sizeof(header));
+}
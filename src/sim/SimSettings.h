@@ -0,0 +1,61 @@
+/**
+ * @file SimSettings.h
+ * Persists a settings struct to a SimFlash device.
+ *
+ * On attach the struct is restored from the flash if the flash holds a valid
+ * copy of the same size, otherwise the current content is written as the
+ * first copy. Afterwards the handler compares the struct with the last saved
+ * state and writes only the chunks that changed, so edits made anywhere (e.g.
+ * by ConfigurationHandler_SetKeyValue) end up in flash without a save call.
+ * The flash merges and journals these writes.
+ */
+
+#ifndef SIM_SETTINGS_H
+#define SIM_SETTINGS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "SimFlash.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/** Granularity of the change detection */
+#define SIM_SETTINGS_CHUNK 32U
+
+/** Time between two comparisons of the struct */
+#define SIM_SETTINGS_POLL_MS 100U
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Restore `data` from `flash` or save it there. Returns false if the struct
+ * does not fit or is out of memory. Only one struct is attached at a time.
+ */
+bool SimSettings_attach(SimFlash_t *flash, void *data, uint32_t size);
+
+/** Save changed chunks, call periodically */
+void SimSettings_handler(uint32_t nowMs);
+
+/** true if attach found and restored a saved copy */
+bool SimSettings_was_restored(void);
+
+/** Save the last changes, flush the flash and forget the struct */
+void SimSettings_detach(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SIM_SETTINGS_H*/
@@ -0,0 +1,405 @@
+/**
+ * @file SimSignals.c
+ *
+ * Every sample evaluates the components one after another over contiguous
+ * float arrays of all channels, so the inner loops stay simple enough for the
+ * compiler to vectorize.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "SimSignals.h"
+#include "SimDescriptor.h"
+#include "SimSensors.h"
+#include "SimAlarms.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SIGNALS_PATH_LEN 512
+#define DEFAULT_RATE_HZ 10U
+#define END_NEVER UINT32_MAX
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+  COMPONENT_LEVEL,
+  COMPONENT_RAMP,
+  COMPONENT_SINE,
+  COMPONENT_NOISE,
+  COMPONENT_PLUME,
+  COMPONENT_FAULT,
+  COMPONENT_STUCK,
+} component_type_t;
+
+typedef struct {
+  component_type_t type;
+  uint32_t startMs;
+  uint32_t endMs;
+  uint32_t first;     /**< 0-based sensor range first..last-1 */
+  uint32_t last;
+  float params[3];
+} component_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bool parse_line(char *line, component_t *component);
+static bool parse_sensors(const char *text, uint32_t *first, uint32_t *last);
+static void generate(uint64_t timeUs);
+static bool component_sets(const component_t *c);
+static void apply_component(const component_t *c, uint32_t timeMs);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static component_t components[SIM_SIGNALS_MAX_COMPONENTS];
+static uint32_t componentCount;
+static uint32_t rateHz = DEFAULT_RATE_HZ;
+static uint64_t sampleIndex;
+static SimSignals_sample_cb_t sampleCb;
+
+/* Channel arrays, SoA */
+static float base[SIM_DESCRIPTOR_MAX_SENSORS];   /**< last value set by level or ramp */
+static float values[SIM_DESCRIPTOR_MAX_SENSORS];
+static float frozen[SIM_DESCRIPTOR_MAX_SENSORS];
+static float scales[SIM_DESCRIPTOR_MAX_SENSORS];
+static uint32_t noiseState[SIM_DESCRIPTOR_MAX_SENSORS];
+static uint8_t faultNow[SIM_DESCRIPTOR_MAX_SENSORS];
+static uint8_t stuckNow[SIM_DESCRIPTOR_MAX_SENSORS];
+static uint8_t faultShown[SIM_DESCRIPTOR_MAX_SENSORS];
+static uint8_t driven[SIM_DESCRIPTOR_MAX_SENSORS]; /**< channel has any component, others keep sensors.txt values */
+static int32_t raw[SIM_DESCRIPTOR_MAX_SENSORS];
+static uint32_t channelCount;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+bool SimSignals_load(const char *dir)
+{
+  char path[SIGNALS_PATH_LEN];
+  char line[256];
+  uint32_t lineNr = 0;
+
+  SimSignals_clear();
+
+  snprintf(path, sizeof(path), "%s/signals.txt", dir);
+  FILE *in = fopen(path, "r");
+  if (in == NULL)
+  {
+    return true;
+  }
+
+  while (fgets(line, sizeof(line), in) != NULL)
+  {
+    char word[32];
+    unsigned long rate;
+
+    lineNr++;
+    if (line[0] == '#' || sscanf(line, "%31s", word) != 1)
+    {
+      continue;
+    }
+    if (strcmp(word, "rate") == 0 && sscanf(line, "%*s %lu", &rate) == 1 && rate >= 1U &&
+        rate <= SIM_SIGNALS_MAX_RATE_HZ)
+    {
+      rateHz = (uint32_t) rate;
+      continue;
+    }
+    if (componentCount == SIM_SIGNALS_MAX_COMPONENTS || !parse_line(line, &components[componentCount]))
+    {
+      fprintf(stderr, "SimSignals: %s:%u: cannot parse \"%s\"\n", path, (unsigned) lineNr, strtok(line, "\r\n"));
+      fclose(in);
+      SimSignals_clear();
+      return false;
+    }
+    const component_t *c = &components[componentCount++];
+    for (uint32_t ch = c->first; ch < c->last; ch++)
+    {
+      driven[ch] = 1;
+    }
+  }
+  fclose(in);
+
+  return true;
+}
+
+void SimSignals_clear(void)
+{
+  const SimDescriptor_t *desc = SimDescriptor_get();
+
+  componentCount = 0;
+  rateHz = DEFAULT_RATE_HZ;
+  sampleIndex = 0;
+  channelCount = (desc != NULL) ? desc->sensorCount : 0U;
+  for (uint32_t s = 0; s < SIM_DESCRIPTOR_MAX_SENSORS; s++)
+  {
+    uint8_t decimals = (desc != NULL) ? desc->sensors[s].decimals : 0U;
+    scales[s] = powf(10.0f, (float) decimals);
+    noiseState[s] = 0x9E3779B9U ^ (s * 0x85EBCA6BU);
+    base[s] = 0.0f;
+    values[s] = 0.0f;
+    frozen[s] = 0.0f;
+    faultShown[s] = 0;
+    driven[s] = 0;
+  }
+}
+
+void SimSignals_set_sample_cb(SimSignals_sample_cb_t cb)
+{
+  sampleCb = cb;
+}
+
+void SimSignals_step(uint32_t nowMs)
+{
+  if (componentCount == 0)
+  {
+    return;
+  }
+
+  /* Sample n is due at n / rate seconds, integer math so the rate does not drift */
+  uint64_t nowUs = (uint64_t) nowMs * 1000U;
+  for (;;)
+  {
+    uint64_t timeUs = sampleIndex * 1000000U / rateHz;
+    if (timeUs > nowUs)
+    {
+      break;
+    }
+    generate(timeUs);
+    sampleIndex++;
+  }
+}
+
+bool SimSignals_active(void)
+{
+  return componentCount != 0;
+}
+
+uint32_t SimSignals_get_end_ms(void)
+{
+  uint32_t endMs = 0;
+
+  for (uint32_t i = 0; i < componentCount; i++)
+  {
+    if (components[i].endMs != END_NEVER && components[i].endMs > endMs)
+    {
+      endMs = components[i].endMs;
+    }
+  }
+
+  return endMs;
+}
+
+uint64_t SimSignals_get_sample_count(void)
+{
+  return sampleIndex;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool parse_line(char *line, component_t *component)
+{
+  char start[16];
+  char end[16];
+  char sensors[32];
+  char type[16];
+  float p[3] = { 0 };
+
+  memset(component, 0, sizeof(*component));
+  int n = sscanf(line, "%15s %15s %31s %15s %f %f %f", start, end, sensors, type, &p[0], &p[1], &p[2]);
+  if (n < 4 || !parse_sensors(sensors, &component->first, &component->last))
+  {
+    return false;
+  }
+  component->startMs = (uint32_t) strtoul(start, NULL, 10);
+  component->endMs = (strcmp(end, "-") == 0) ? END_NEVER : (uint32_t) strtoul(end, NULL, 10);
+  memcpy(component->params, p, sizeof(p));
+
+  static const struct {
+    const char *name;
+    component_type_t type;
+    int params;
+  } types[] = {
+    { "level", COMPONENT_LEVEL, 1 },
+    { "ramp", COMPONENT_RAMP, 2 },
+    { "sine", COMPONENT_SINE, 2 },
+    { "noise", COMPONENT_NOISE, 1 },
+    { "plume", COMPONENT_PLUME, 3 },
+    { "fault", COMPONENT_FAULT, 0 },
+    { "stuck", COMPONENT_STUCK, 0 },
+  };
+  for (uint32_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+  {
+    if (strcmp(type, types[i].name) == 0)
+    {
+      component->type = types[i].type;
+      return n >= 4 + types[i].params && component->endMs > component->startMs;
+    }
+  }
+
+  return false;
+}
+
+static bool parse_sensors(const char *text, uint32_t *first, uint32_t *last)
+{
+  unsigned long a;
+  unsigned long b;
+
+  if (strcmp(text, "*") == 0)
+  {
+    *first = 0;
+    *last = SIM_DESCRIPTOR_MAX_SENSORS;
+    return true;
+  }
+  int n = sscanf(text, "%lu-%lu", &a, &b);
+  if (n == 1)
+  {
+    b = a;
+  }
+  if (n < 1 || a < 1U || b < a || b > SIM_DESCRIPTOR_MAX_SENSORS)
+  {
+    return false;
+  }
+  *first = (uint32_t) a - 1U;
+  *last = (uint32_t) b;
+
+  return true;
+}
+
+static void generate(uint64_t timeUs)
+{
+  uint32_t timeMs = (uint32_t) (timeUs / 1000U);
+  uint32_t count = channelCount;
+
+  memset(faultNow, 0, count);
+  memset(stuckNow, 0, count);
+
+  /* Level and ramp first, they define the base the other components add to */
+  for (uint32_t pass = 0; pass < 2U; pass++)
+  {
+    if (pass == 1U)
+    {
+      memcpy(values, base, count * sizeof(float));
+    }
+    for (uint32_t i = 0; i < componentCount; i++)
+    {
+      const component_t *c = &components[i];
+      if (component_sets(c) == (pass == 0U) && timeMs >= c->startMs && timeMs < c->endMs && c->first < count)
+      {
+        apply_component(c, timeMs);
+      }
+    }
+  }
+
+  for (uint32_t s = 0; s < count; s++)
+  {
+    /* A stuck sensor keeps reporting what it had when it got stuck */
+    frozen[s] = stuckNow[s] ? frozen[s] : values[s];
+    raw[s] = driven[s] ? (int32_t) lrintf(frozen[s] * scales[s]) : SimSensors_get_value(s);
+  }
+  for (uint32_t s = 0; s < count; s++)
+  {
+    if (!driven[s])
+    {
+      continue;
+    }
+    SimSensors_set_value(s, raw[s], timeMs);
+    if (faultNow[s] != faultShown[s])
+    {
+      SimSensors_set_fault(s, faultNow[s] != 0U, timeMs);
+      faultShown[s] = faultNow[s];
+    }
+  }
+  SimAlarms_update(timeMs);
+
+  if (sampleCb != NULL)
+  {
+    sampleCb(raw, count, timeUs);
+  }
+}
+
+static bool component_sets(const component_t *c)
+{
+  return c->type == COMPONENT_LEVEL || c->type == COMPONENT_RAMP;
+}
+
+static void apply_component(const component_t *c, uint32_t timeMs)
+{
+  uint32_t last = (c->last < channelCount) ? c->last : channelCount;
+  float elapsedS = (float) (timeMs - c->startMs) / 1000.0f;
+
+  switch (c->type)
+  {
+  case COMPONENT_LEVEL:
+    for (uint32_t s = c->first; s < last; s++)
+    {
+      base[s] = c->params[0];
+    }
+    break;
+  case COMPONENT_RAMP:
+  {
+    /* An endless ramp changes by (to - from) per second */
+    float t = (c->endMs == END_NEVER) ? elapsedS : (float) (timeMs - c->startMs) / (float) (c->endMs - c->startMs);
+    float v = c->params[0] + (c->params[1] - c->params[0]) * t;
+    for (uint32_t s = c->first; s < last; s++)
+    {
+      base[s] = v;
+    }
+    break;
+  }
+  case COMPONENT_SINE:
+  {
+    float v = c->params[0] * sinf(2.0f * 3.14159265f * (float) (timeMs - c->startMs) / fmaxf(c->params[1], 1.0f));
+    for (uint32_t s = c->first; s < last; s++)
+    {
+      values[s] += v;
+    }
+    break;
+  }
+  case COMPONENT_NOISE:
+    for (uint32_t s = c->first; s < last; s++)
+    {
+      /* xorshift32 per channel */
+      uint32_t x = noiseState[s];
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      noiseState[s] = x;
+      values[s] += c->params[0] * ((float) (x >> 8) * (2.0f / 16777216.0f) - 1.0f);
+    }
+    break;
+  case COMPONENT_PLUME:
+  {
+    /* Gaussian over the room distance, widening with the spread speed */
+    float center = c->params[0] - 1.0f;
+    float sigma = 0.5f + c->params[2] * elapsedS;
+    float k = -1.0f / (2.0f * sigma * sigma);
+    for (uint32_t s = c->first; s < last; s++)
+    {
+      float d = (float) s - center;
+      values[s] += c->params[1] * expf(d * d * k);
+    }
+    break;
+  }
+  case COMPONENT_FAULT:
+    memset(&faultNow[c->first], 1, last - c->first);
+    break;
+  case COMPONENT_STUCK:
+    memset(&stuckNow[c->first], 1, last - c->first);
+    break;
+  default:
+    break;
+  }
+}
@@ -0,0 +1,82 @@
+/**
+ * @file SimSignals.h
+ * Synthetic sensor waveforms at high sample rates.
+ *
+ * `signals.txt` of a scenario describes per-channel signal components, one
+ * per line, values in display units like sensors.txt:
+ *
+ *   rate <Hz>                                   samples per second and channel, default 10
+ *   <start> <end> <sensors> level <v>           constant value
+ *   <start> <end> <sensors> ramp <from> <to>    linear from start to end
+ *   <start> <end> <sensors> sine <amp> <periodMs>
+ *   <start> <end> <sensors> noise <amp>         uniform noise in [-amp, amp]
+ *   <start> <end> <sensors> plume <center> <peak> <rooms/s>
+ *                                               leak at sensor <center> spreading to the
+ *                                               neighbouring sensors (rooms) over time
+ *   <start> <end> <sensors> fault               sensor fault during the window
+ *   <start> <end> <sensors> stuck               value frozen during the window
+ *
+ * Times are ms, `-` as end means forever (an endless ramp keeps changing by
+ * to - from per second). Sensors are `*`, `n` or `a-b`, 1-based. level and
+ * ramp set the value, later lines win, and it is kept after their window
+ * ends; sine, noise and plume add to it. Sensors without any line keep the
+ * values of sensors.txt. Every sample is written to SimSensors and evaluated by
+ * SimAlarms at its own time, like readings coming from the bus.
+ */
+
+#ifndef SIM_SIGNALS_H
+#define SIM_SIGNALS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define SIM_SIGNALS_MAX_COMPONENTS 1024
+#define SIM_SIGNALS_MAX_RATE_HZ 20000U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/** Called after every generated sample with the raw values of all sensors */
+typedef void (*SimSignals_sample_cb_t)(const int32_t *values, uint32_t count, uint64_t timeUs);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Load `<dir>/signals.txt`, a missing file means no signals */
+bool SimSignals_load(const char *dir);
+
+/** Remove all components */
+void SimSignals_clear(void);
+
+void SimSignals_set_sample_cb(SimSignals_sample_cb_t cb);
+
+/** Generate and ingest all samples up to `nowMs` */
+void SimSignals_step(uint32_t nowMs);
+
+/** True if signals.txt had any component */
+bool SimSignals_active(void);
+
+/** Latest end of a component with a finite window, 0 if none */
+uint32_t SimSignals_get_end_ms(void);
+
+/** Samples generated per channel since the load */
+uint64_t SimSignals_get_sample_count(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SIM_SIGNALS_H*/
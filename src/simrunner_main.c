@@ -0,0 +1,505 @@
+/**
+ * @file simrunner_main.c
+ * Runs a directory of scenarios in parallel worker processes.
+ *
+ * Every subdirectory of the scenario directory is one scenario (see
+ * sim/SimScenario.h). Each scenario runs in its own `main --scenario`
+ * process; the per-scenario results, logs and screenshots are collected in
+ * the output directory and merged into one report.json.
+ *
+ * Usage: simrunner <scenario-dir> [-j jobs] [-o output-dir] [-t timeout-s] [-m main-executable]
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#ifndef _DEFAULT_SOURCE
+  #define _DEFAULT_SOURCE /* needed for usleep() and d_type */
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#ifndef SIM_MAIN_PATH
+  #define SIM_MAIN_PATH "main"
+#endif
+
+#define RUNNER_PATH_LEN 1024
+#define RUNNER_NAME_LEN 256
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+  JOB_QUEUED,
+  JOB_RUNNING,
+  JOB_DONE,
+} job_state_t;
+
+typedef struct {
+  char name[RUNNER_NAME_LEN];
+  job_state_t state;
+  pid_t pid;
+  uint64_t startUs;
+  uint64_t wallUs;
+  int exitCode;     /**< -1: killed by a signal */
+  bool timedOut;
+  bool resultBroken; /**< the result file is not complete JSON, e.g. the worker crashed writing it */
+} job_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bool collect_jobs(const char *scenarioDir);
+static int compare_jobs(const void *a, const void *b);
+static bool start_job(job_t *job);
+static void finish_job(pid_t pid, int status);
+static bool write_report(void);
+static void append_file(FILE *out, const char *path);
+static bool json_file_broken(const char *path);
+static void write_string(FILE *out, const char *text);
+static void print_usage(const char *program);
+static uint64_t now_us(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static const char *mainPath = SIM_MAIN_PATH;
+static const char *scenarioRoot;
+static const char *outputDir = "simrunner-report";
+static job_t *jobs;
+static uint32_t jobCount;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+int main(int argc, char **argv)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t maxJobs = (cpus > 0) ? (uint32_t) cpus : 1U;
+  uint32_t timeoutS = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+    if (argv[i][0] != '-')
+    {
+      scenarioRoot = argv[i];
+      continue;
+    }
+    if (value == NULL)
+    {
+      print_usage(argv[0]);
+      return 2;
+    }
+    if (strcmp(argv[i], "-j") == 0)
+    {
+      maxJobs = (uint32_t) strtoul(value, NULL, 10);
+    }
+    else if (strcmp(argv[i], "-o") == 0)
+    {
+      outputDir = value;
+    }
+    else if (strcmp(argv[i], "-t") == 0)
+    {
+      timeoutS = (uint32_t) strtoul(value, NULL, 10);
+    }
+    else if (strcmp(argv[i], "-m") == 0)
+    {
+      mainPath = value;
+    }
+    else
+    {
+      print_usage(argv[0]);
+      return 2;
+    }
+    i++;
+  }
+  if (scenarioRoot == NULL || maxJobs == 0)
+  {
+    print_usage(argv[0]);
+    return 2;
+  }
+
+  if (mkdir(outputDir, 0755) != 0 && errno != EEXIST)
+  {
+    fprintf(stderr, "simrunner: cannot create %s\n", outputDir);
+    return 2;
+  }
+  if (!collect_jobs(scenarioRoot))
+  {
+    return 2;
+  }
+  printf("simrunner: %u scenarios, %u parallel jobs\n", (unsigned) jobCount, (unsigned) maxJobs);
+
+  /* Job queue: keep up to maxJobs workers busy until every scenario is done */
+  uint64_t startUs = now_us();
+  uint32_t next = 0;
+  uint32_t running = 0;
+  uint32_t done = 0;
+  while (done < jobCount)
+  {
+    while (running < maxJobs && next < jobCount)
+    {
+      if (start_job(&jobs[next]))
+      {
+        running++;
+      }
+      else
+      {
+        done++;
+      }
+      next++;
+    }
+
+    int status;
+    pid_t pid = waitpid(-1, &status, WNOHANG);
+    if (pid > 0)
+    {
+      finish_job(pid, status);
+      running--;
+      done++;
+      continue;
+    }
+
+    if (timeoutS != 0)
+    {
+      for (uint32_t i = 0; i < jobCount; i++)
+      {
+        if (jobs[i].state == JOB_RUNNING && !jobs[i].timedOut &&
+            now_us() - jobs[i].startUs > (uint64_t) timeoutS * 1000000U)
+        {
+          jobs[i].timedOut = true;
+          kill(jobs[i].pid, SIGKILL);
+        }
+      }
+    }
+    usleep(10 * 1000);
+  }
+
+  uint32_t failed = 0;
+  for (uint32_t i = 0; i < jobCount; i++)
+  {
+    failed += (jobs[i].exitCode != 0 || jobs[i].resultBroken) ? 1U : 0U;
+  }
+  printf("simrunner: %u passed, %u failed in %.1f s\n", (unsigned) (jobCount - failed), (unsigned) failed,
+         (double) (now_us() - startUs) / 1e6);
+
+  bool reportOk = write_report();
+  free(jobs);
+
+  return (failed == 0 && reportOk) ? 0 : 1;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool collect_jobs(const char *scenarioDir)
+{
+  DIR *dir = opendir(scenarioDir);
+  if (dir == NULL)
+  {
+    fprintf(stderr, "simrunner: cannot open %s\n", scenarioDir);
+    return false;
+  }
+
+  struct dirent *entry;
+  uint32_t capacity = 0;
+  while ((entry = readdir(dir)) != NULL)
+  {
+    char path[RUNNER_PATH_LEN];
+    struct stat st;
+
+    if (entry->d_name[0] == '.')
+    {
+      continue;
+    }
+    snprintf(path, sizeof(path), "%s/%s", scenarioDir, entry->d_name);
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+      continue;
+    }
+
+    if (jobCount == capacity)
+    {
+      capacity = (capacity != 0) ? capacity * 2U : 32U;
+      job_t *grown = realloc(jobs, capacity * sizeof(job_t));
+      if (grown == NULL)
+      {
+        closedir(dir);
+        return false;
+      }
+      jobs = grown;
+    }
+    memset(&jobs[jobCount], 0, sizeof(job_t));
+    snprintf(jobs[jobCount].name, RUNNER_NAME_LEN, "%s", entry->d_name);
+    jobCount++;
+  }
+  closedir(dir);
+
+  if (jobCount == 0)
+  {
+    fprintf(stderr, "simrunner: no scenarios in %s\n", scenarioDir);
+    return false;
+  }
+  qsort(jobs, jobCount, sizeof(job_t), compare_jobs);
+
+  return true;
+}
+
+static int compare_jobs(const void *a, const void *b)
+{
+  return strcmp(((const job_t *) a)->name, ((const job_t *) b)->name);
+}
+
+static bool start_job(job_t *job)
+{
+  char scenario[RUNNER_PATH_LEN];
+  char report[RUNNER_PATH_LEN];
+  char screenshot[RUNNER_PATH_LEN];
+  char log[RUNNER_PATH_LEN];
+
+  snprintf(scenario, sizeof(scenario), "%s/%s", scenarioRoot, job->name);
+  snprintf(report, sizeof(report), "%s/%s.json", outputDir, job->name);
+  snprintf(screenshot, sizeof(screenshot), "%s/%s.bmp", outputDir, job->name);
+  snprintf(log, sizeof(log), "%s/%s.log", outputDir, job->name);
+  /* Nothing of an earlier run may pass for this one */
+  unlink(report);
+  unlink(screenshot);
+
+  job->startUs = now_us();
+  job->pid = fork();
+  if (job->pid == 0)
+  {
+    int fd = open(log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0)
+    {
+      dup2(fd, STDOUT_FILENO);
+      dup2(fd, STDERR_FILENO);
+      close(fd);
+    }
+    execl(mainPath, mainPath, "--scenario", scenario, "--report", report, "--screenshot", screenshot, (char *) NULL);
+    fprintf(stderr, "simrunner: cannot execute %s\n", mainPath);
+    _exit(127);
+  }
+  if (job->pid < 0)
+  {
+    fprintf(stderr, "simrunner: fork failed for %s\n", job->name);
+    job->state = JOB_DONE;
+    job->exitCode = 127;
+    return false;
+  }
+
+  job->state = JOB_RUNNING;
+  return true;
+}
+
+static void finish_job(pid_t pid, int status)
+{
+  for (uint32_t i = 0; i < jobCount; i++)
+  {
+    job_t *job = &jobs[i];
+    if (job->state != JOB_RUNNING || job->pid != pid)
+    {
+      continue;
+    }
+
+    job->state = JOB_DONE;
+    job->wallUs = now_us() - job->startUs;
+    job->exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    char result[RUNNER_PATH_LEN];
+    snprintf(result, sizeof(result), "%s/%s.json", outputDir, job->name);
+    job->resultBroken = json_file_broken(result);
+    printf("  %-32s %s  %.2f s\n", job->name,
+           (job->exitCode == 0 && !job->resultBroken) ? "ok    " : (job->timedOut ? "TIMEOUT" : "FAILED"),
+           (double) job->wallUs / 1e6);
+    return;
+  }
+}
+
+static bool write_report(void)
+{
+  char path[RUNNER_PATH_LEN];
+
+  snprintf(path, sizeof(path), "%s/report.json", outputDir);
+  FILE *out = fopen(path, "w");
+  if (out == NULL)
+  {
+    fprintf(stderr, "simrunner: cannot write %s\n", path);
+    return false;
+  }
+
+  fprintf(out, "{\n\"scenarios\": [\n");
+  for (uint32_t i = 0; i < jobCount; i++)
+  {
+    const job_t *job = &jobs[i];
+    char result[RUNNER_PATH_LEN];
+
+    snprintf(result, sizeof(result), "%s/%s.json", outputDir, job->name);
+    fprintf(out, "{ \"name\": ");
+    write_string(out, job->name);
+    fprintf(out, ", \"exitCode\": %d, \"timedOut\": %s, \"resultBroken\": %s, \"wallMs\": %.1f,\n  \"result\": ",
+            job->exitCode, job->timedOut ? "true" : "false", job->resultBroken ? "true" : "false",
+            (double) job->wallUs / 1000.0);
+    if (job->resultBroken)
+    {
+      fprintf(out, "null\n");
+    }
+    else
+    {
+      append_file(out, result);
+    }
+    fprintf(out, "}%s\n", (i + 1U < jobCount) ? "," : "");
+  }
+  fprintf(out, "]\n}\n");
+
+  printf("simrunner: report written to %s\n", path);
+  return fclose(out) == 0;
+}
+
+/** Inline a per-scenario result, `null` if the scenario did not write one */
+static void append_file(FILE *out, const char *path)
+{
+  char chunk[4096];
+  size_t n;
+  bool any = false;
+
+  FILE *in = fopen(path, "r");
+  if (in != NULL)
+  {
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+    {
+      fwrite(chunk, 1, n, out);
+      any = true;
+    }
+    fclose(in);
+  }
+  if (!any)
+  {
+    fprintf(out, "null\n");
+  }
+}
+
+/**
+ * True if `path` exists but does not hold one complete JSON value; only the
+ * nesting and the strings are checked, enough to catch a truncated write
+ */
+static bool json_file_broken(const char *path)
+{
+  FILE *in = fopen(path, "r");
+  if (in == NULL)
+  {
+    return false;
+  }
+
+  uint32_t depth = 0;
+  bool inString = false;
+  bool escaped = false;
+  bool any = false;
+  bool broken = false;
+  int c;
+  while ((c = fgetc(in)) != EOF && !broken)
+  {
+    if (inString)
+    {
+      if (escaped)
+      {
+        escaped = false;
+      }
+      else if (c == '\\')
+      {
+        escaped = true;
+      }
+      else if (c == '"')
+      {
+        inString = false;
+      }
+      continue;
+    }
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+    {
+      continue;
+    }
+    /* The result is one object or array, nothing may follow it */
+    if ((!any && c != '{' && c != '[') || (any && depth == 0U))
+    {
+      broken = true;
+    }
+    else if (c == '{' || c == '[')
+    {
+      depth++;
+    }
+    else if (c == '}' || c == ']')
+    {
+      broken = depth == 0U;
+      depth--;
+    }
+    else if (c == '"')
+    {
+      inString = true;
+    }
+    any = true;
+  }
+  fclose(in);
+
+  return broken || !any || inString || depth != 0U;
+}
+
+/** `text` as a JSON string literal */
+static void write_string(FILE *out, const char *text)
+{
+  fputc('"', out);
+  for (const char *p = text; *p != '\0'; p++)
+  {
+    if (*p == '"' || *p == '\\')
+    {
+      fprintf(out, "\\%c", *p);
+    }
+    else if ((unsigned char) *p < 0x20U)
+    {
+      fprintf(out, "\\u%04x", (unsigned) (unsigned char) *p);
+    }
+    else
+    {
+      fputc(*p, out);
+    }
+  }
+  fputc('"', out);
+}
+
+static void print_usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s <scenario-dir> [-j jobs] [-o output-dir] [-t timeout-s] [-m main-executable]\n"
+          "  -j  parallel worker processes (default: one per CPU)\n"
+          "  -o  output directory for results, logs and screenshots (default: simrunner-report)\n"
+          "  -t  kill a scenario after this many seconds (default: no limit)\n"
+          "  -m  simulator executable (default: %s)\n",
+          program, SIM_MAIN_PATH);
+}
+
+static uint64_t now_us(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000U + (uint64_t) now.tv_nsec / 1000U;
+}
@@ -0,0 +1,393 @@
+/**
+ * @file BarBank.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "BarBank.h"
+#include "lvgl/lvgl_private.h"
+#include "../sim/SimDescriptor.h"
+#include "ViewModel.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define MY_CLASS (&BarBank_class)
+
+/** Level index stored for bars below every configured level */
+#define LEVEL_NONE 0xFFU
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  lv_obj_t obj;
+  const int32_t *values;
+  BarBank_bar_t *bars;
+  int16_t *drawnHeights; /**< fill height in pixels of the last refresh */
+  uint8_t *drawnLevels;
+  uint32_t count;
+  int32_t gap;
+  lv_color_t normalColor;
+  lv_color_t levelColors[BAR_BANK_LEVELS];
+  lv_display_t *boundDisplay;
+  uint32_t boundFirst;
+} BarBank_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void BarBank_constructor(const lv_obj_class_t *class_p, lv_obj_t *obj);
+static void BarBank_destructor(const lv_obj_class_t *class_p, lv_obj_t *obj);
+static void BarBank_event(const lv_obj_class_t *class_p, lv_event_t *e);
+static void draw_bars(lv_event_t *e);
+static uint8_t bar_level(const BarBank_bar_t *bar, int32_t value);
+static int16_t bar_height(const BarBank_bar_t *bar, int32_t value, int32_t contentH);
+static void bar_column(lv_obj_t *obj, uint32_t index, lv_area_t *column);
+static void refr_start_cb(lv_event_t *e);
+static void unbind(BarBank_t *bank);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+const lv_obj_class_t BarBank_class = {
+  .constructor_cb = BarBank_constructor,
+  .destructor_cb = BarBank_destructor,
+  .event_cb = BarBank_event,
+  .width_def = LV_PCT(100),
+  .height_def = 120,
+  .instance_size = sizeof(BarBank_t),
+  .base_class = &lv_obj_class,
+  .name = "BarBank",
+};
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_obj_t *BarBank_create(lv_obj_t *parent)
+{
+  lv_obj_t *obj = lv_obj_class_create_obj(MY_CLASS, parent);
+  lv_obj_class_init_obj(obj);
+
+  return obj;
+}
+
+void BarBank_set_count(lv_obj_t *obj, uint32_t count)
+{
+  BarBank_t *bank = (BarBank_t *) obj;
+
+  lv_free(bank->bars);
+  lv_free(bank->drawnHeights);
+  lv_free(bank->drawnLevels);
+  bank->bars = lv_malloc_zeroed(sizeof(BarBank_bar_t) * LV_MAX(count, 1U));
+  bank->drawnHeights = lv_malloc_zeroed(sizeof(int16_t) * LV_MAX(count, 1U));
+  bank->drawnLevels = lv_malloc(sizeof(uint8_t) * LV_MAX(count, 1U));
+  LV_ASSERT_MALLOC(bank->bars);
+  LV_ASSERT_MALLOC(bank->drawnHeights);
+  LV_ASSERT_MALLOC(bank->drawnLevels);
+  bank->count = count;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    bank->bars[i].range = 100;
+    bank->drawnLevels[i] = LEVEL_NONE;
+  }
+  /* Without values the bars stay empty */
+  bank->values = NULL;
+
+  lv_obj_invalidate(obj);
+}
+
+void BarBank_set_bar(lv_obj_t *obj, uint32_t index, const BarBank_bar_t *bar)
+{
+  BarBank_t *bank = (BarBank_t *) obj;
+
+  if (index < bank->count)
+  {
+    bank->bars[index] = *bar;
+    if (bank->bars[index].range <= 0)
+    {
+      bank->bars[index].range = 1;
+    }
+    lv_obj_invalidate(obj);
+  }
+}
+
+void BarBank_set_colors(lv_obj_t *obj, lv_color_t normal, const lv_color_t levels[BAR_BANK_LEVELS])
+{
+  BarBank_t *bank = (BarBank_t *) obj;
+
+  bank->normalColor = normal;
+  lv_memcpy(bank->levelColors, levels, sizeof(bank->levelColors));
+  lv_obj_invalidate(obj);
+}
+
+void BarBank_set_gap(lv_obj_t *obj, int32_t gap)
+{
+  BarBank_t *bank = (BarBank_t *) obj;
+
+  bank->gap = LV_MAX(gap, 0);
+  lv_obj_invalidate(obj);
+}
+
+void BarBank_set_values(lv_obj_t *obj, const int32_t *values)
+{
+  BarBank_t *bank = (BarBank_t *) obj;
+
+  bank->values = values;
+  BarBank_refresh(obj);
+}
+
+void BarBank_refresh(lv_obj_t *obj)
+{
+  BarBank_t *bank = (BarBank_t *) obj;
+  int32_t contentH = lv_obj_get_content_height(obj);
+
+  if (bank->values == NULL)
+  {
+    return;
+  }
+
+  for (uint32_t i = 0; i < bank->count; i++)
+  {
+    const BarBank_bar_t *bar = &bank->bars[i];
+    int32_t value = bank->values[i];
+    int16_t height = bar_height(bar, value, contentH);
+    uint8_t level = bar_level(bar, value);
+    int16_t drawn = bank->drawnHeights[i];
+
+    if (height == drawn && level == bank->drawnLevels[i])
+    {
+      continue;
+    }
+
+    /* Only the rows between the old and new top, all of the fill if the color changed */
+    lv_area_t column;
+    bar_column(obj, i, &column);
+    int32_t bottom = column.y2;
+    column.y1 = bottom + 1 - LV_MAX(height, drawn);
+    if (level == bank->drawnLevels[i])
+    {
+      column.y2 = bottom - LV_MIN(height, drawn);
+    }
+    if (column.y1 <= column.y2)
+    {
+      lv_obj_invalidate_area(obj, &column);
+    }
+    bank->drawnHeights[i] = height;
+    bank->drawnLevels[i] = level;
+  }
+}
+
+void BarBank_bind_sensors(lv_obj_t *obj, uint32_t first, uint32_t count)
+{
+  BarBank_t *bank = (BarBank_t *) obj;
+  const SimDescriptor_t *descriptor = SimDescriptor_get();
+
+  if (descriptor == NULL || first >= SIM_DESCRIPTOR_MAX_SENSORS)
+  {
+    return;
+  }
+  count = LV_MIN(count, SIM_DESCRIPTOR_MAX_SENSORS - first);
+
+  BarBank_set_count(obj, count);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    const SimDescriptor_sensor_t *sensor = &descriptor->sensors[first + i];
+    BarBank_bar_t bar = { .range = sensor->range };
+    for (uint32_t l = 0; l < BAR_BANK_LEVELS; l++)
+    {
+      if (!sensor->levels[l].enabled)
+      {
+        continue;
+      }
+      bar.thresholds[l] = sensor->levels[l].threshold;
+      bar.levelMask |= (uint8_t) (1U << l);
+      if (SimDescriptor_level_rising(sensor->mode, &sensor->levels[l]))
+      {
+        bar.risingMask |= (uint8_t) (1U << l);
+      }
+    }
+    BarBank_set_bar(obj, i, &bar);
+  }
+  bank->boundFirst = first;
+  BarBank_set_values(obj, ViewModel_get_values() + first);
+
+  unbind(bank);
+  bank->boundDisplay = lv_obj_get_display(obj);
+  lv_display_add_event_cb(bank->boundDisplay, refr_start_cb, LV_EVENT_REFR_START, obj);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void BarBank_constructor(const lv_obj_class_t *class_p, lv_obj_t *obj)
+{
+  LV_UNUSED(class_p);
+  BarBank_t *bank = (BarBank_t *) obj;
+
+  bank->gap = 2;
+  bank->normalColor = lv_palette_main(LV_PALETTE_GREEN);
+  bank->levelColors[0] = lv_palette_main(LV_PALETTE_YELLOW);
+  bank->levelColors[1] = lv_palette_main(LV_PALETTE_ORANGE);
+  bank->levelColors[2] = lv_palette_main(LV_PALETTE_RED);
+  bank->levelColors[3] = lv_palette_darken(LV_PALETTE_RED, 3);
+  lv_obj_remove_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICK_FOCUSABLE);
+}
+
+static void BarBank_destructor(const lv_obj_class_t *class_p, lv_obj_t *obj)
+{
+  LV_UNUSED(class_p);
+  BarBank_t *bank = (BarBank_t *) obj;
+
+  unbind(bank);
+  lv_free(bank->bars);
+  lv_free(bank->drawnHeights);
+  lv_free(bank->drawnLevels);
+  bank->bars = NULL;
+  bank->drawnHeights = NULL;
+  bank->drawnLevels = NULL;
+}
+
+static void BarBank_event(const lv_obj_class_t *class_p, lv_event_t *e)
+{
+  LV_UNUSED(class_p);
+
+  if (lv_obj_event_base(MY_CLASS, e) != LV_RESULT_OK)
+  {
+    return;
+  }
+
+  lv_event_code_t code = lv_event_get_code(e);
+  lv_obj_t *obj = lv_event_get_current_target(e);
+  if (code == LV_EVENT_DRAW_MAIN)
+  {
+    draw_bars(e);
+  }
+  else if (code == LV_EVENT_SIZE_CHANGED || code == LV_EVENT_STYLE_CHANGED)
+  {
+    /* Heights depend on the content height: redraw all, the next refresh compares to the new heights */
+    BarBank_t *bank = (BarBank_t *) obj;
+    int32_t contentH = lv_obj_get_content_height(obj);
+    for (uint32_t i = 0; i < bank->count && bank->values != NULL; i++)
+    {
+      bank->drawnHeights[i] = bar_height(&bank->bars[i], bank->values[i], contentH);
+      bank->drawnLevels[i] = bar_level(&bank->bars[i], bank->values[i]);
+    }
+    lv_obj_invalidate(obj);
+  }
+}
+
+/**
+ * Tracks and fills of the bars inside the clip area. The values are read at
+ * draw time, so a bar is always drawn as it is now, not as it was at the last
+ * refresh.
+ */
+static void draw_bars(lv_event_t *e)
+{
+  lv_obj_t *obj = lv_event_get_current_target(e);
+  BarBank_t *bank = (BarBank_t *) obj;
+  lv_layer_t *layer = lv_event_get_layer(e);
+  const lv_area_t *clip = &layer->_clip_area;
+  int32_t contentH = lv_obj_get_content_height(obj);
+
+  lv_draw_rect_dsc_t track;
+  lv_draw_rect_dsc_init(&track);
+  lv_obj_init_draw_rect_dsc(obj, LV_PART_ITEMS, &track);
+
+  lv_draw_rect_dsc_t fill;
+  lv_draw_rect_dsc_init(&fill);
+  fill.bg_opa = LV_OPA_COVER;
+
+  for (uint32_t i = 0; i < bank->count; i++)
+  {
+    lv_area_t column;
+    bar_column(obj, i, &column);
+    if (column.x2 < clip->x1 || column.x1 > clip->x2)
+    {
+      continue;
+    }
+
+    int32_t value = (bank->values != NULL) ? bank->values[i] : 0;
+    int16_t height = bar_height(&bank->bars[i], value, contentH);
+    uint8_t level = bar_level(&bank->bars[i], value);
+    lv_area_t area = column;
+
+    if (track.bg_opa > LV_OPA_MIN && height < contentH)
+    {
+      area.y2 = column.y2 - height;
+      lv_draw_rect(layer, &track, &area);
+    }
+    if (height > 0)
+    {
+      area.y1 = column.y2 + 1 - height;
+      area.y2 = column.y2;
+      fill.bg_color = (level == LEVEL_NONE) ? bank->normalColor : bank->levelColors[level];
+      lv_draw_rect(layer, &fill, &area);
+    }
+  }
+}
+
+/** Highest configured level the value reaches, LEVEL_NONE if none */
+static uint8_t bar_level(const BarBank_bar_t *bar, int32_t value)
+{
+  for (int32_t l = BAR_BANK_LEVELS - 1; l >= 0; l--)
+  {
+    uint8_t bit = (uint8_t) (1U << l);
+    if ((bar->levelMask & bit) == 0U)
+    {
+      continue;
+    }
+    bool rising = (bar->risingMask & bit) != 0U;
+    if (rising ? value >= bar->thresholds[l] : value <= bar->thresholds[l])
+    {
+      return (uint8_t) l;
+    }
+  }
+
+  return LEVEL_NONE;
+}
+
+static int16_t bar_height(const BarBank_bar_t *bar, int32_t value, int32_t contentH)
+{
+  int64_t height = (int64_t) LV_CLAMP(0, value, bar->range) * contentH / bar->range;
+
+  return (int16_t) height;
+}
+
+/** Screen area of bar `index`, top to bottom of the content area */
+static void bar_column(lv_obj_t *obj, uint32_t index, lv_area_t *column)
+{
+  BarBank_t *bank = (BarBank_t *) obj;
+  lv_area_t content;
+  lv_obj_get_content_coords(obj, &content);
+
+  /* Distribute the rounding over the bars so the bank fills the width exactly */
+  int32_t width = lv_area_get_width(&content) + bank->gap;
+  column->x1 = content.x1 + (int32_t) (((int64_t) width * index) / bank->count);
+  column->x2 = content.x1 + (int32_t) (((int64_t) width * (index + 1U)) / bank->count) - bank->gap - 1;
+  column->x2 = LV_MAX(column->x2, column->x1);
+  column->y1 = content.y1;
+  column->y2 = content.y2;
+}
+
+/** The snapshot behind the values may have changed since the last frame */
+static void refr_start_cb(lv_event_t *e)
+{
+  lv_obj_t *obj = lv_event_get_user_data(e);
+
+  BarBank_set_values(obj, ViewModel_get_values() + ((BarBank_t *) obj)->boundFirst);
+}
+
+static void unbind(BarBank_t *bank)
+{
+  if (bank->boundDisplay != NULL)
+  {
+    lv_display_remove_event_cb_with_user_data(bank->boundDisplay, refr_start_cb, bank);
+    bank->boundDisplay = NULL;
+  }
+}
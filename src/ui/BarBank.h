@@ -0,0 +1,80 @@
+/**
+ * @file BarBank.h
+ * A bank of vertical bars drawn by one widget.
+ *
+ * Replaces one `lv_bar` per sensor on overview screens: the bars are drawn in
+ * a single draw callback straight from a packed value array, colored by the
+ * highest alarm level their value reaches. A refresh invalidates only the bars
+ * whose fill height in pixels or color changed.
+ *
+ * The main part style (background, border, padding) frames the whole bank,
+ * LV_PART_ITEMS bg_color is the empty track of a bar.
+ */
+
+#ifndef BAR_BANK_H
+#define BAR_BANK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define BAR_BANK_LEVELS 4
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  int32_t range;                       /**< value of a full bar */
+  int32_t thresholds[BAR_BANK_LEVELS]; /**< alarm levels in ascending level order */
+  uint8_t levelMask;                   /**< bit n: level n is configured */
+  uint8_t risingMask;                  /**< bit n: level n triggers at or above its threshold, else at or below */
+} BarBank_bar_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+lv_obj_t *BarBank_create(lv_obj_t *parent);
+
+/** Number of bars, every bar starts with range 100 and no levels */
+void BarBank_set_count(lv_obj_t *obj, uint32_t count);
+
+void BarBank_set_bar(lv_obj_t *obj, uint32_t index, const BarBank_bar_t *bar);
+
+/** Fill color of the bars below the first level and at level 0..3 */
+void BarBank_set_colors(lv_obj_t *obj, lv_color_t normal, const lv_color_t levels[BAR_BANK_LEVELS]);
+
+/** Gap between two bars in pixels */
+void BarBank_set_gap(lv_obj_t *obj, int32_t gap);
+
+/**
+ * Read the bar values from `values[0..count-1]`. The array is not copied, it
+ * has to stay valid while the bank exists and is read on every refresh.
+ */
+void BarBank_set_values(lv_obj_t *obj, const int32_t *values);
+
+/** Compare the values with what was drawn and invalidate the changed bars */
+void BarBank_refresh(lv_obj_t *obj);
+
+/**
+ * Show sensors first..first+count-1 of the simulator: ranges and levels from
+ * the descriptor, values read in place from the ViewModel and refreshed
+ * before every frame of the bank's display.
+ */
+void BarBank_bind_sensors(lv_obj_t *obj, uint32_t first, uint32_t count);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*BAR_BANK_H*/
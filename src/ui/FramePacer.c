@@ -0,0 +1,308 @@
+/**
+ * @file FramePacer.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "FramePacer.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void refr_start_cb(lv_event_t *e);
+static void render_start_cb(lv_event_t *e);
+static void refr_ready_cb(lv_event_t *e);
+static void indev_event_cb(lv_event_t *e);
+static void enter_interactive(void);
+static void set_mode(FramePacer_mode_t next);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_display_t *display;
+static lv_timer_t *refrTimer;
+static FramePacer_config_t cfg;
+static FramePacer_mode_t mode;
+static FramePacer_stats_t stats;
+
+static uint32_t lastInputMs;
+static bool inputPending;
+static uint32_t inputPendingMs;
+
+static bool frameOpen;
+static bool frameRendered;
+static FramePacer_mode_t frameMode;
+static uint32_t framePeriodMs;
+static uint32_t renderStartMs;
+static bool havePrevStart;
+static uint32_t prevStartMs;
+static uint32_t prevPeriodMs;
+static uint32_t pendingData;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void FramePacer_init(lv_display_t *disp, const FramePacer_config_t *config)
+{
+  FramePacer_deinit();
+  if (config != NULL)
+  {
+    cfg = *config;
+  }
+  else
+  {
+    FramePacer_config_init(&cfg);
+  }
+  if (cfg.interactivePeriodMs == 0U)
+  {
+    cfg.interactivePeriodMs = 1U;
+  }
+  if (cfg.idlePeriodMs < cfg.interactivePeriodMs)
+  {
+    cfg.idlePeriodMs = cfg.interactivePeriodMs;
+  }
+
+  display = disp;
+  refrTimer = lv_display_get_refr_timer(disp);
+  FramePacer_reset_stats();
+  havePrevStart = false;
+  frameOpen = false;
+  inputPending = false;
+  pendingData = 0;
+  /* The first screen is drawn as if it answered input */
+  lastInputMs = lv_tick_get();
+  mode = FRAME_PACER_IDLE;
+  set_mode(FRAME_PACER_INTERACTIVE);
+  stats.modeSwitches = 0;
+
+  lv_display_add_event_cb(disp, refr_start_cb, LV_EVENT_REFR_START, NULL);
+  lv_display_add_event_cb(disp, render_start_cb, LV_EVENT_RENDER_START, NULL);
+  lv_display_add_event_cb(disp, refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+}
+
+void FramePacer_deinit(void)
+{
+  if (display == NULL)
+  {
+    return;
+  }
+  lv_display_remove_event_cb_with_user_data(display, refr_start_cb, NULL);
+  lv_display_remove_event_cb_with_user_data(display, render_start_cb, NULL);
+  lv_display_remove_event_cb_with_user_data(display, refr_ready_cb, NULL);
+  if (refrTimer != NULL)
+  {
+    lv_timer_set_period(refrTimer, LV_DEF_REFR_PERIOD);
+  }
+  display = NULL;
+  refrTimer = NULL;
+}
+
+void FramePacer_config_init(FramePacer_config_t *config)
+{
+  config->interactivePeriodMs = FRAME_PACER_INTERACTIVE_PERIOD_MS;
+  config->idlePeriodMs = FRAME_PACER_IDLE_PERIOD_MS;
+  config->holdMs = FRAME_PACER_HOLD_MS;
+  config->inputPollMs = FRAME_PACER_INPUT_POLL_MS;
+}
+
+void FramePacer_watch_indev(lv_indev_t *indev)
+{
+  lv_timer_t *readTimer = lv_indev_get_read_timer(indev);
+
+  if (readTimer != NULL && cfg.inputPollMs != 0U)
+  {
+    lv_timer_set_period(readTimer, cfg.inputPollMs);
+  }
+  lv_indev_add_event_cb(indev, indev_event_cb, LV_EVENT_PRESSED, NULL);
+  lv_indev_add_event_cb(indev, indev_event_cb, LV_EVENT_PRESSING, NULL);
+  lv_indev_add_event_cb(indev, indev_event_cb, LV_EVENT_RELEASED, NULL);
+}
+
+void FramePacer_notify_input(void)
+{
+  if (display == NULL)
+  {
+    return;
+  }
+  enter_interactive();
+}
+
+void FramePacer_notify_data(uint32_t count)
+{
+  pendingData += count;
+}
+
+FramePacer_mode_t FramePacer_get_mode(void)
+{
+  return mode;
+}
+
+uint32_t FramePacer_get_period(void)
+{
+  if (display == NULL)
+  {
+    return LV_DEF_REFR_PERIOD;
+  }
+  return (mode == FRAME_PACER_INTERACTIVE) ? cfg.interactivePeriodMs : cfg.idlePeriodMs;
+}
+
+void FramePacer_get_stats(FramePacer_stats_t *out)
+{
+  *out = stats;
+}
+
+void FramePacer_reset_stats(void)
+{
+  memset(&stats, 0, sizeof(stats));
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void refr_start_cb(lv_event_t *e)
+{
+  LV_UNUSED(e);
+  uint32_t nowMs = lv_tick_get();
+
+  /* Leave interactive mode only between frames and only when nothing moves */
+  if (mode == FRAME_PACER_INTERACTIVE && lv_tick_diff(nowMs, lastInputMs) >= cfg.holdMs
+      && lv_anim_count_running() == 0U)
+  {
+    set_mode(FRAME_PACER_IDLE);
+  }
+
+  /* A start is late against the period the previous start scheduled it for */
+  if (havePrevStart && lv_tick_diff(nowMs, prevStartMs) > prevPeriodMs + prevPeriodMs / 2U)
+  {
+    stats.lateStarts[mode]++;
+  }
+  havePrevStart = true;
+  prevStartMs = nowMs;
+  prevPeriodMs = FramePacer_get_period();
+
+  frameOpen = true;
+  frameRendered = false;
+  frameMode = mode;
+  framePeriodMs = prevPeriodMs;
+  stats.refreshes[mode]++;
+}
+
+static void render_start_cb(lv_event_t *e)
+{
+  LV_UNUSED(e);
+
+  if (frameOpen && !frameRendered)
+  {
+    frameRendered = true;
+    renderStartMs = lv_tick_get();
+  }
+}
+
+static void refr_ready_cb(lv_event_t *e)
+{
+  LV_UNUSED(e);
+  uint32_t nowMs = lv_tick_get();
+
+  if (!frameOpen)
+  {
+    return;
+  }
+  frameOpen = false;
+
+  /* The bindings sync at the refresh start, their changes belong to this frame */
+  if (pendingData != 0U)
+  {
+    stats.dataUpdates += pendingData;
+    stats.dataFrames++;
+    pendingData = 0;
+  }
+
+  if (frameRendered)
+  {
+    uint32_t renderMs = lv_tick_diff(nowMs, renderStartMs);
+
+    stats.frames[frameMode]++;
+    stats.renderMsTotal += renderMs;
+    if (renderMs > stats.renderMsMax)
+    {
+      stats.renderMsMax = renderMs;
+    }
+    if (renderMs > framePeriodMs)
+    {
+      stats.renderOverruns[frameMode]++;
+    }
+  }
+
+  /* The first refresh after input answers it, drawn or not */
+  if (inputPending)
+  {
+    uint32_t latencyMs = lv_tick_diff(nowMs, inputPendingMs);
+
+    inputPending = false;
+    stats.inputLatencyMsTotal += latencyMs;
+    if (latencyMs > stats.inputLatencyMsMax)
+    {
+      stats.inputLatencyMsMax = latencyMs;
+    }
+    if (latencyMs > cfg.interactivePeriodMs)
+    {
+      stats.inputLatencyMisses++;
+    }
+  }
+}
+
+static void indev_event_cb(lv_event_t *e)
+{
+  LV_UNUSED(e);
+  enter_interactive();
+}
+
+static void enter_interactive(void)
+{
+  uint32_t nowMs = lv_tick_get();
+
+  lastInputMs = nowMs;
+  if (!inputPending)
+  {
+    inputPending = true;
+    inputPendingMs = nowMs;
+    stats.inputs++;
+  }
+  if (mode != FRAME_PACER_INTERACTIVE)
+  {
+    set_mode(FRAME_PACER_INTERACTIVE);
+    /* Do not wait out the rest of the long idle period */
+    if (refrTimer != NULL)
+    {
+      lv_timer_ready(refrTimer);
+    }
+  }
+}
+
+static void set_mode(FramePacer_mode_t next)
+{
+  if (next == mode)
+  {
+    return;
+  }
+  mode = next;
+  stats.modeSwitches++;
+  if (refrTimer != NULL)
+  {
+    lv_timer_set_period(refrTimer, FramePacer_get_period());
+  }
+}
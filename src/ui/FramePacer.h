@@ -0,0 +1,107 @@
+/**
+ * @file FramePacer.h
+ * Adaptive refresh period with deadline accounting.
+ *
+ * The display refresh timer runs at one of two periods. After input, and as
+ * long as an animation runs, the pacer is interactive: the refresh timer is
+ * made ready at once, so the frame answering a key or touch does not wait for
+ * the rest of the period, and then runs every interactivePeriodMs. Once the
+ * hold time after the last input has passed, only sensor data changes the
+ * screen; the refresh timer slows down to idlePeriodMs and everything that
+ * changed in that window is drawn in one frame, since the bindings sync once
+ * per refresh.
+ *
+ * Every refresh is checked against the period it was scheduled for: a start
+ * more than half a period late, or a render longer than the period, counts as
+ * a missed deadline, and so does input that took longer than one interactive
+ * period to reach the screen.
+ */
+
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define FRAME_PACER_INTERACTIVE_PERIOD_MS 16U
+#define FRAME_PACER_IDLE_PERIOD_MS 100U
+#define FRAME_PACER_HOLD_MS 1000U
+/** Read period of watched input devices, shorter than LV_DEF_REFR_PERIOD */
+#define FRAME_PACER_INPUT_POLL_MS 10U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+  FRAME_PACER_IDLE = 0,
+  FRAME_PACER_INTERACTIVE,
+  FRAME_PACER_MODES
+} FramePacer_mode_t;
+
+typedef struct {
+  uint32_t interactivePeriodMs;
+  uint32_t idlePeriodMs;
+  uint32_t holdMs; /**< interactive time after the last input */
+  uint32_t inputPollMs;
+} FramePacer_config_t;
+
+typedef struct {
+  uint32_t refreshes[FRAME_PACER_MODES]; /**< refresh timer runs */
+  uint32_t frames[FRAME_PACER_MODES];    /**< runs that rendered something */
+  uint32_t lateStarts[FRAME_PACER_MODES];
+  uint32_t renderOverruns[FRAME_PACER_MODES];
+  uint32_t renderMsTotal;
+  uint32_t renderMsMax;
+  uint32_t inputs;
+  uint32_t inputLatencyMsTotal;
+  uint32_t inputLatencyMsMax;
+  uint32_t inputLatencyMisses;
+  uint32_t dataUpdates;   /**< changed values handed to the widgets */
+  uint32_t dataFrames;    /**< frames that carried data updates */
+  uint32_t modeSwitches;
+} FramePacer_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Pace the refresh timer of `disp`, `config` NULL for the defaults */
+void FramePacer_init(lv_display_t *disp, const FramePacer_config_t *config);
+
+void FramePacer_deinit(void);
+
+void FramePacer_config_init(FramePacer_config_t *config);
+
+/** Switch to interactive on the presses of `indev` and poll it faster */
+void FramePacer_watch_indev(lv_indev_t *indev);
+
+/** Input LVGL does not see, e.g. keys handled by the application */
+void FramePacer_notify_input(void);
+
+/** `count` values changed for the next frame, for the statistics only */
+void FramePacer_notify_data(uint32_t count);
+
+FramePacer_mode_t FramePacer_get_mode(void);
+
+/** Refresh period in use, the longest sensible sleep of the main loop */
+uint32_t FramePacer_get_period(void);
+
+void FramePacer_get_stats(FramePacer_stats_t *stats);
+
+void FramePacer_reset_stats(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*FRAME_PACER_H*/
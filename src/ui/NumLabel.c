@@ -0,0 +1,603 @@
+/**
+ * @file NumLabel.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "NumLabel.h"
+#include "lvgl/lvgl_private.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define MY_CLASS (&NumLabel_class)
+
+/** Sign, digits, point, decimals */
+#define MAX_SLOTS (1U + NUM_LABEL_MAX_INT_DIGITS + 1U + NUM_LABEL_MAX_DECIMALS)
+
+/** Characters of the glyph strip, in strip order */
+#define STRIP_CHARS "0123456789-.+"
+#define STRIP_GLYPHS (sizeof(STRIP_CHARS) - 1U)
+#define GLYPH_MINUS 10U
+#define GLYPH_POINT 11U
+#define GLYPH_PLUS 12U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  char text[NUM_LABEL_UNIT_LEN];
+  lv_draw_buf_t *buf;
+  int32_t width;
+} unit_run_t;
+
+/** Everything the labels of one font draw from */
+typedef struct {
+  const lv_font_t *font;
+  lv_draw_buf_t *strip;
+  int32_t glyphX[STRIP_GLYPHS];
+  int32_t glyphW[STRIP_GLYPHS];
+  int32_t digitW;  /**< widest digit, the width of a digit slot */
+  int32_t signW;
+  int32_t spaceW;  /**< gap before the unit */
+  int32_t height;
+  unit_run_t units[NUM_LABEL_MAX_UNITS];
+  uint32_t unitCount;
+} font_runs_t;
+
+typedef struct {
+  lv_obj_t obj;
+  int32_t value;
+  uint8_t intDigits;
+  uint8_t decimals;
+  bool sign;
+  char unit[NUM_LABEL_UNIT_LEN];
+  char shown[MAX_SLOTS]; /**< character per slot, ' ' for a blank one */
+} NumLabel_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void NumLabel_constructor(const lv_obj_class_t *class_p, lv_obj_t *obj);
+static void NumLabel_event(const lv_obj_class_t *class_p, lv_event_t *e);
+static void draw_main(lv_event_t *e);
+static void draw_as_text(NumLabel_t *label, lv_layer_t *layer, const lv_area_t *content);
+static void blit(lv_layer_t *layer, lv_draw_image_dsc_t *dsc, const lv_area_t *runArea, const lv_area_t *cell);
+static uint32_t slot_count(const NumLabel_t *label);
+static void slots_format(const NumLabel_t *label, char *slots);
+static int32_t slot_width(const NumLabel_t *label, const font_runs_t *runs, uint32_t slot);
+static int32_t value_width(const NumLabel_t *label, const font_runs_t *runs);
+static int32_t glyph_index(char c);
+static void update_shown(lv_obj_t *obj);
+static void prepare(lv_obj_t *obj);
+static font_runs_t *font_runs_get(const lv_font_t *font, bool create);
+static unit_run_t *unit_run_get(font_runs_t *runs, const char *unit, bool create);
+static lv_draw_buf_t *render_run(const lv_font_t *font, const char *const *texts, const int32_t *xs, uint32_t count,
+                                 int32_t width, int32_t height);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+const lv_obj_class_t NumLabel_class = {
+  .constructor_cb = NumLabel_constructor,
+  .event_cb = NumLabel_event,
+  .width_def = LV_SIZE_CONTENT,
+  .height_def = LV_SIZE_CONTENT,
+  .instance_size = sizeof(NumLabel_t),
+  .base_class = &lv_obj_class,
+  .name = "NumLabel",
+};
+
+static font_runs_t fontRuns[NUM_LABEL_MAX_FONTS];
+static uint32_t fontCount;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_obj_t *NumLabel_create(lv_obj_t *parent)
+{
+  lv_obj_t *obj = lv_obj_class_create_obj(MY_CLASS, parent);
+  lv_obj_class_init_obj(obj);
+
+  return obj;
+}
+
+void NumLabel_set_format(lv_obj_t *obj, uint8_t intDigits, uint8_t decimals, bool sign)
+{
+  NumLabel_t *label = (NumLabel_t *) obj;
+
+  label->intDigits = (uint8_t) LV_CLAMP(1U, intDigits, NUM_LABEL_MAX_INT_DIGITS);
+  label->decimals = (uint8_t) LV_MIN(decimals, NUM_LABEL_MAX_DECIMALS);
+  label->sign = sign;
+  prepare(obj);
+}
+
+void NumLabel_set_unit(lv_obj_t *obj, const char *unit)
+{
+  NumLabel_t *label = (NumLabel_t *) obj;
+
+  if (lv_strcmp(label->unit, unit) == 0)
+  {
+    return;
+  }
+  lv_strlcpy(label->unit, unit, sizeof(label->unit));
+  prepare(obj);
+}
+
+void NumLabel_set_value(lv_obj_t *obj, int32_t value)
+{
+  NumLabel_t *label = (NumLabel_t *) obj;
+
+  if (value != label->value)
+  {
+    label->value = value;
+    update_shown(obj);
+  }
+}
+
+int32_t NumLabel_get_value(const lv_obj_t *obj)
+{
+  return ((const NumLabel_t *) obj)->value;
+}
+
+size_t NumLabel_get_cache_bytes(void)
+{
+  size_t bytes = 0;
+
+  for (uint32_t f = 0; f < fontCount; f++)
+  {
+    bytes += fontRuns[f].strip->data_size;
+    for (uint32_t u = 0; u < fontRuns[f].unitCount; u++)
+    {
+      bytes += fontRuns[f].units[u].buf->data_size;
+    }
+  }
+
+  return bytes;
+}
+
+void NumLabel_clear_cache(void)
+{
+  for (uint32_t f = 0; f < fontCount; f++)
+  {
+    lv_image_cache_drop(fontRuns[f].strip);
+    lv_draw_buf_destroy(fontRuns[f].strip);
+    for (uint32_t u = 0; u < fontRuns[f].unitCount; u++)
+    {
+      lv_image_cache_drop(fontRuns[f].units[u].buf);
+      lv_draw_buf_destroy(fontRuns[f].units[u].buf);
+    }
+  }
+  lv_memzero(fontRuns, sizeof(fontRuns));
+  fontCount = 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void NumLabel_constructor(const lv_obj_class_t *class_p, lv_obj_t *obj)
+{
+  LV_UNUSED(class_p);
+  NumLabel_t *label = (NumLabel_t *) obj;
+
+  label->intDigits = 3;
+  label->value = 0;
+  lv_memset(label->shown, ' ', sizeof(label->shown));
+  lv_obj_remove_flag(obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICK_FOCUSABLE);
+  prepare(obj);
+}
+
+static void NumLabel_event(const lv_obj_class_t *class_p, lv_event_t *e)
+{
+  LV_UNUSED(class_p);
+
+  if (lv_obj_event_base(MY_CLASS, e) != LV_RESULT_OK)
+  {
+    return;
+  }
+
+  lv_event_code_t code = lv_event_get_code(e);
+  lv_obj_t *obj = lv_event_get_current_target(e);
+  if (code == LV_EVENT_DRAW_MAIN)
+  {
+    draw_main(e);
+  }
+  else if (code == LV_EVENT_GET_SELF_SIZE)
+  {
+    NumLabel_t *label = (NumLabel_t *) obj;
+    lv_point_t *size = lv_event_get_param(e);
+    font_runs_t *runs = font_runs_get(lv_obj_get_style_text_font(obj, LV_PART_MAIN), true);
+    if (runs != NULL)
+    {
+      size->x = LV_MAX(size->x, value_width(label, runs));
+      size->y = LV_MAX(size->y, runs->height);
+    }
+  }
+  else if (code == LV_EVENT_STYLE_CHANGED)
+  {
+    /* The font may be another one */
+    prepare(obj);
+  }
+}
+
+/** Slot by slot from the glyph strip, then the unit run, all tinted with the text color */
+static void draw_main(lv_event_t *e)
+{
+  lv_obj_t *obj = lv_event_get_current_target(e);
+  NumLabel_t *label = (NumLabel_t *) obj;
+  lv_layer_t *layer = lv_event_get_layer(e);
+  const lv_font_t *font = lv_obj_get_style_text_font(obj, LV_PART_MAIN);
+  font_runs_t *runs = font_runs_get(font, false);
+  unit_run_t *unit = (runs != NULL && label->unit[0] != '\0') ? unit_run_get(runs, label->unit, false) : NULL;
+  lv_area_t content;
+
+  lv_obj_get_content_coords(obj, &content);
+  /* Runs are only rendered outside of drawing; a font or unit without one is drawn as text */
+  if (runs == NULL || (label->unit[0] != '\0' && unit == NULL))
+  {
+    draw_as_text(label, layer, &content);
+    return;
+  }
+
+  lv_draw_image_dsc_t dsc;
+  lv_draw_image_dsc_init(&dsc);
+  dsc.recolor = lv_obj_get_style_text_color_filtered(obj, LV_PART_MAIN);
+  dsc.recolor_opa = LV_OPA_COVER;
+  dsc.opa = lv_obj_get_style_text_opa(obj, LV_PART_MAIN);
+  dsc.src = runs->strip;
+
+  lv_area_t strip = { 0, content.y1, (int32_t) runs->strip->header.w - 1, content.y1 + runs->height - 1 };
+  int32_t x = content.x1;
+  for (uint32_t i = 0; i < slot_count(label); i++)
+  {
+    int32_t slotW = slot_width(label, runs, i);
+    int32_t g = glyph_index(label->shown[i]);
+    if (g >= 0)
+    {
+      /* Centered in the slot, so digits of different width stay in their column */
+      lv_area_t cell;
+      cell.x1 = x + (slotW - runs->glyphW[g]) / 2;
+      cell.x2 = cell.x1 + runs->glyphW[g] - 1;
+      cell.y1 = strip.y1;
+      cell.y2 = strip.y2;
+      strip.x1 = cell.x1 - runs->glyphX[g];
+      strip.x2 = strip.x1 + (int32_t) runs->strip->header.w - 1;
+      blit(layer, &dsc, &strip, &cell);
+    }
+    x += slotW;
+  }
+
+  if (unit != NULL)
+  {
+    lv_area_t area = { x + runs->spaceW, content.y1, x + runs->spaceW + unit->width - 1, content.y1 + runs->height - 1 };
+    dsc.src = unit->buf;
+    blit(layer, &dsc, &area, &area);
+  }
+}
+
+/** The slow path, one label draw of the composed text */
+static void draw_as_text(NumLabel_t *label, lv_layer_t *layer, const lv_area_t *content)
+{
+  char text[MAX_SLOTS + NUM_LABEL_UNIT_LEN + 2U];
+  uint32_t len = slot_count(label);
+
+  lv_memcpy(text, label->shown, len);
+  text[len] = '\0';
+  if (label->unit[0] != '\0')
+  {
+    text[len] = ' ';
+    lv_strlcpy(&text[len + 1U], label->unit, sizeof(text) - len - 1U);
+  }
+
+  lv_draw_label_dsc_t dsc;
+  lv_draw_label_dsc_init(&dsc);
+  lv_obj_init_draw_label_dsc(&label->obj, LV_PART_MAIN, &dsc);
+  dsc.text = text;
+  dsc.text_local = 1;
+  lv_draw_label(layer, &dsc, content);
+}
+
+/** Draw the part of the run at `runArea` that falls into `cell` */
+static void blit(lv_layer_t *layer, lv_draw_image_dsc_t *dsc, const lv_area_t *runArea, const lv_area_t *cell)
+{
+  lv_area_t clip = layer->_clip_area;
+
+  if (!lv_area_intersect(&layer->_clip_area, &clip, cell))
+  {
+    layer->_clip_area = clip;
+    return;
+  }
+  lv_draw_image(layer, dsc, runArea);
+  layer->_clip_area = clip;
+}
+
+static uint32_t slot_count(const NumLabel_t *label)
+{
+  return (label->sign ? 1U : 0U) + label->intDigits + ((label->decimals != 0U) ? 1U + label->decimals : 0U);
+}
+
+/** The characters of the current value, right aligned in the integer slots */
+static void slots_format(const NumLabel_t *label, char *slots)
+{
+  uint32_t count = slot_count(label);
+  uint32_t first = label->sign ? 1U : 0U;
+  uint32_t point = first + label->intDigits;
+  uint32_t magnitude = (label->value < 0) ? 0U - (uint32_t) label->value : (uint32_t) label->value;
+  uint32_t i = count;
+  bool fits = label->value != NUM_LABEL_NO_VALUE;
+
+  lv_memset(slots, ' ', count);
+  if (label->decimals != 0U)
+  {
+    slots[point] = '.';
+  }
+  /* Decimals, then at least one integer digit */
+  while (fits && i > point + 1U)
+  {
+    slots[--i] = (char) ('0' + magnitude % 10U);
+    magnitude /= 10U;
+  }
+  i = point;
+  do
+  {
+    if (fits && i > first)
+    {
+      slots[--i] = (char) ('0' + magnitude % 10U);
+      magnitude /= 10U;
+    }
+    else
+    {
+      fits = false;
+    }
+  } while (fits && magnitude != 0U);
+
+  /* The minus goes into the sign slot, or in front of the digits if there is room */
+  if (fits && label->value < 0)
+  {
+    if (label->sign)
+    {
+      slots[0] = '-';
+    }
+    else if (i > 0U)
+    {
+      slots[i - 1U] = '-';
+    }
+    else
+    {
+      fits = false;
+    }
+  }
+
+  if (!fits)
+  {
+    for (i = first; i < count; i++)
+    {
+      slots[i] = (slots[i] == '.') ? '.' : '-';
+    }
+    slots[0] = label->sign ? ' ' : slots[0];
+  }
+}
+
+static int32_t slot_width(const NumLabel_t *label, const font_runs_t *runs, uint32_t slot)
+{
+  if (label->sign && slot == 0U)
+  {
+    return runs->signW;
+  }
+  if (label->decimals != 0U && slot == (label->sign ? 1U : 0U) + label->intDigits)
+  {
+    return runs->glyphW[GLYPH_POINT];
+  }
+  return runs->digitW;
+}
+
+static int32_t value_width(const NumLabel_t *label, const font_runs_t *runs)
+{
+  int32_t width = 0;
+
+  for (uint32_t i = 0; i < slot_count(label); i++)
+  {
+    width += slot_width(label, runs, i);
+  }
+  if (label->unit[0] != '\0')
+  {
+    unit_run_t *unit = unit_run_get((font_runs_t *) runs, label->unit, false);
+    width += runs->spaceW + ((unit != NULL) ? unit->width
+                             : lv_text_get_width(label->unit, (uint32_t) lv_strlen(label->unit), runs->font, 0));
+  }
+
+  return width;
+}
+
+static int32_t glyph_index(char c)
+{
+  for (uint32_t g = 0; g < STRIP_GLYPHS; g++)
+  {
+    if (STRIP_CHARS[g] == c)
+    {
+      return (int32_t) g;
+    }
+  }
+
+  return -1;
+}
+
+/** Invalidate the span of slots whose character changed */
+static void update_shown(lv_obj_t *obj)
+{
+  NumLabel_t *label = (NumLabel_t *) obj;
+  char slots[MAX_SLOTS];
+  uint32_t count = slot_count(label);
+  int32_t firstChanged = -1;
+  int32_t lastChanged = -1;
+
+  slots_format(label, slots);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    if (slots[i] != label->shown[i])
+    {
+      firstChanged = (firstChanged < 0) ? (int32_t) i : firstChanged;
+      lastChanged = (int32_t) i;
+    }
+  }
+  if (firstChanged < 0)
+  {
+    return;
+  }
+  lv_memcpy(label->shown, slots, count);
+
+  font_runs_t *runs = font_runs_get(lv_obj_get_style_text_font(obj, LV_PART_MAIN), false);
+  if (runs == NULL)
+  {
+    lv_obj_invalidate(obj);
+    return;
+  }
+  lv_area_t area;
+  lv_obj_get_content_coords(obj, &area);
+  int32_t x = area.x1;
+  for (int32_t i = 0; i <= lastChanged; i++)
+  {
+    if (i == firstChanged)
+    {
+      area.x1 = x;
+    }
+    x += slot_width(label, runs, (uint32_t) i);
+  }
+  area.x2 = x - 1;
+  lv_obj_invalidate_area(obj, &area);
+}
+
+/** The runs of the font and unit exist, the size and all slots are redone */
+static void prepare(lv_obj_t *obj)
+{
+  NumLabel_t *label = (NumLabel_t *) obj;
+  font_runs_t *runs = font_runs_get(lv_obj_get_style_text_font(obj, LV_PART_MAIN), true);
+
+  if (runs != NULL && label->unit[0] != '\0')
+  {
+    (void) unit_run_get(runs, label->unit, true);
+  }
+  slots_format(label, label->shown);
+  lv_obj_refresh_self_size(obj);
+  lv_obj_invalidate(obj);
+}
+
+static font_runs_t *font_runs_get(const lv_font_t *font, bool create)
+{
+  for (uint32_t f = 0; f < fontCount; f++)
+  {
+    if (fontRuns[f].font == font)
+    {
+      return &fontRuns[f];
+    }
+  }
+  if (!create || font == NULL || fontCount == NUM_LABEL_MAX_FONTS)
+  {
+    return NULL;
+  }
+
+  font_runs_t *runs = &fontRuns[fontCount];
+  const char *texts[STRIP_GLYPHS];
+  char chars[STRIP_GLYPHS][2];
+  int32_t x = 0;
+
+  lv_memzero(runs, sizeof(*runs));
+  runs->font = font;
+  runs->height = lv_font_get_line_height(font);
+  for (uint32_t g = 0; g < STRIP_GLYPHS; g++)
+  {
+    chars[g][0] = STRIP_CHARS[g];
+    chars[g][1] = '\0';
+    texts[g] = chars[g];
+    runs->glyphX[g] = x;
+    runs->glyphW[g] = LV_MAX(lv_font_get_glyph_width(font, (uint32_t) STRIP_CHARS[g], 0), 1);
+    x += runs->glyphW[g];
+    if (g < GLYPH_MINUS)
+    {
+      runs->digitW = LV_MAX(runs->digitW, runs->glyphW[g]);
+    }
+  }
+  runs->signW = LV_MAX(runs->glyphW[GLYPH_MINUS], runs->glyphW[GLYPH_PLUS]);
+  runs->spaceW = lv_font_get_glyph_width(font, ' ', 0);
+  runs->strip = render_run(font, texts, runs->glyphX, STRIP_GLYPHS, x, runs->height);
+  if (runs->strip == NULL)
+  {
+    return NULL;
+  }
+  fontCount++;
+
+  return runs;
+}
+
+static unit_run_t *unit_run_get(font_runs_t *runs, const char *unit, bool create)
+{
+  for (uint32_t u = 0; u < runs->unitCount; u++)
+  {
+    if (lv_strcmp(runs->units[u].text, unit) == 0)
+    {
+      return &runs->units[u];
+    }
+  }
+  if (!create || runs->unitCount == NUM_LABEL_MAX_UNITS)
+  {
+    return NULL;
+  }
+
+  unit_run_t *run = &runs->units[runs->unitCount];
+  const char *texts[1] = { run->text };
+  int32_t x = 0;
+
+  lv_strlcpy(run->text, unit, sizeof(run->text));
+  run->width = LV_MAX(lv_text_get_width(run->text, (uint32_t) lv_strlen(run->text), runs->font, 0), 1);
+  run->buf = render_run(runs->font, texts, &x, 1, run->width, runs->height);
+  if (run->buf == NULL)
+  {
+    return NULL;
+  }
+  runs->unitCount++;
+
+  return run;
+}
+
+/**
+ * White text with its coverage as alpha, so drawing it recolored gives the
+ * text in any color. Rendered through a temporary canvas, never while a
+ * frame is drawn.
+ */
+static lv_draw_buf_t *render_run(const lv_font_t *font, const char *const *texts, const int32_t *xs, uint32_t count,
+                                 int32_t width, int32_t height)
+{
+  lv_draw_buf_t *buf = lv_draw_buf_create((uint32_t) width, (uint32_t) height, LV_COLOR_FORMAT_ARGB8888,
+                                          LV_STRIDE_AUTO);
+  if (buf == NULL)
+  {
+    return NULL;
+  }
+  lv_draw_buf_clear(buf, NULL);
+
+  lv_obj_t *canvas = lv_canvas_create(lv_layer_sys());
+  lv_obj_add_flag(canvas, LV_OBJ_FLAG_HIDDEN);
+  lv_canvas_set_draw_buf(canvas, buf);
+
+  lv_layer_t layer;
+  lv_canvas_init_layer(canvas, &layer);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    lv_draw_label_dsc_t dsc;
+    lv_draw_label_dsc_init(&dsc);
+    dsc.font = font;
+    dsc.color = lv_color_white();
+    dsc.text = texts[i];
+    lv_area_t area = { xs[i], 0, (i + 1U < count) ? xs[i + 1U] - 1 : width - 1, height - 1 };
+    lv_draw_label(&layer, &dsc, &area);
+  }
+  lv_canvas_finish_layer(canvas, &layer);
+  lv_obj_delete(canvas);
+
+  return buf;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file NumLabel.h
+ * Fixed-point value label drawn from cached glyph runs.
+ *
+ * For value labels that change several times per second. Instead of setting
+ * a text, which measures, breaks and shapes it on every change, the label has
+ * a fixed format: an optional sign slot, `intDigits` digit slots, the decimal
+ * point with `decimals` digits and a unit. The digits, sign and point of each
+ * font are rendered once into a shared glyph strip, each unit into a run of
+ * its own, and a value is drawn by blitting slot by slot out of them, tinted
+ * with the text color. Digit slots are as wide as the widest digit, so the
+ * size never depends on the value: a change invalidates only the slots whose
+ * character changed and never causes a relayout.
+ *
+ * Values that do not fit, and NUM_LABEL_NO_VALUE, show dashes. Font and color
+ * come from the LV_PART_MAIN text style.
+ */
+
+#ifndef NUM_LABEL_H
+#define NUM_LABEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define NUM_LABEL_MAX_INT_DIGITS 9U
+#define NUM_LABEL_MAX_DECIMALS 6U
+#define NUM_LABEL_UNIT_LEN 16U
+/** Fonts and units with a cached run, further ones are drawn as text */
+#define NUM_LABEL_MAX_FONTS 8U
+#define NUM_LABEL_MAX_UNITS 16U
+
+/** Shown as dashes, e.g. for a faulty sensor */
+#define NUM_LABEL_NO_VALUE INT32_MIN
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+lv_obj_t *NumLabel_create(lv_obj_t *parent);
+
+/**
+ * Slots for the value: `intDigits` integer digits, `decimals` after the point,
+ * and a sign slot if `sign`. Without it a minus takes a free leading slot.
+ */
+void NumLabel_set_format(lv_obj_t *obj, uint8_t intDigits, uint8_t decimals, bool sign);
+
+/** Text after the value, e.g. "PPM" or "%VOL"; "" for none */
+void NumLabel_set_unit(lv_obj_t *obj, const char *unit);
+
+/** Raw value with the format's decimals, e.g. 209 with one decimal shows 20.9 */
+void NumLabel_set_value(lv_obj_t *obj, int32_t value);
+
+int32_t NumLabel_get_value(const lv_obj_t *obj);
+
+/** LVGL heap bytes of all cached glyph runs */
+size_t NumLabel_get_cache_bytes(void);
+
+/** Free the glyph runs, e.g. after a font was unloaded; they are rebuilt on use */
+void NumLabel_clear_cache(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*NUM_LABEL_H*/
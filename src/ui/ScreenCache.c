@@ -0,0 +1,305 @@
+/**
+ * @file ScreenCache.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "ScreenCache.h"
+#include "lvgl/lvgl_private.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define PREBUILD_PERIOD_MS 100
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  const ScreenCache_desc_t *desc;
+  lv_obj_t *screen;
+  size_t costBytes;
+  uint32_t lastUse;
+} cache_entry_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static cache_entry_t *entry_find(const ScreenCache_desc_t *desc);
+static cache_entry_t *entry_build(const ScreenCache_desc_t *desc);
+static void entry_drop(cache_entry_t *entry);
+static void evict(const cache_entry_t *keep);
+static size_t heap_used(void);
+static void screen_delete_cb(lv_event_t *e);
+static void prebuild_timer_cb(lv_timer_t *timer);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static cache_entry_t entries[SCREEN_CACHE_MAX_ENTRIES];
+static size_t budget;
+static uint32_t useClock;
+
+static const ScreenCache_desc_t *const *prebuildDescs;
+static uint32_t prebuildCount;
+static uint32_t prebuildNext;
+static lv_timer_t *prebuildTimer;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void ScreenCache_set_budget(size_t bytes)
+{
+  budget = bytes;
+  evict(NULL);
+}
+
+lv_obj_t *ScreenCache_load(const ScreenCache_desc_t *desc)
+{
+  cache_entry_t *entry = entry_find(desc);
+
+  if (entry == NULL)
+  {
+    entry = entry_build(desc);
+    if (entry == NULL)
+    {
+      return NULL;
+    }
+  }
+  entry->lastUse = ++useClock;
+
+  if (desc->update != NULL)
+  {
+    desc->update(entry->screen, desc->user);
+  }
+  if (lv_screen_active() != entry->screen)
+  {
+    lv_screen_load(entry->screen);
+  }
+  evict(entry);
+
+  return entry->screen;
+}
+
+void ScreenCache_refresh(void)
+{
+  lv_obj_t *active = lv_screen_active();
+
+  for (uint32_t i = 0; i < SCREEN_CACHE_MAX_ENTRIES; i++)
+  {
+    cache_entry_t *entry = &entries[i];
+    if (entry->screen != NULL && entry->screen == active && entry->desc->update != NULL)
+    {
+      entry->desc->update(entry->screen, entry->desc->user);
+    }
+  }
+}
+
+void ScreenCache_prebuild(const ScreenCache_desc_t *const *descs, uint32_t count)
+{
+  prebuildDescs = descs;
+  prebuildCount = count;
+  prebuildNext = 0;
+
+  if (prebuildTimer == NULL)
+  {
+    prebuildTimer = lv_timer_create(prebuild_timer_cb, PREBUILD_PERIOD_MS, NULL);
+  }
+}
+
+void ScreenCache_invalidate(const ScreenCache_desc_t *desc)
+{
+  cache_entry_t *entry = entry_find(desc);
+
+  if (entry != NULL && entry->screen != lv_screen_active())
+  {
+    entry_drop(entry);
+  }
+}
+
+size_t ScreenCache_get_cached_bytes(void)
+{
+  size_t sum = 0;
+
+  for (uint32_t i = 0; i < SCREEN_CACHE_MAX_ENTRIES; i++)
+  {
+    sum += (entries[i].screen != NULL) ? entries[i].costBytes : 0U;
+  }
+
+  return sum;
+}
+
+const char *ScreenCache_get_name(const lv_obj_t *screen)
+{
+  for (uint32_t i = 0; i < SCREEN_CACHE_MAX_ENTRIES; i++)
+  {
+    if (screen != NULL && entries[i].screen == screen)
+    {
+      return entries[i].desc->name;
+    }
+  }
+
+  return NULL;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static cache_entry_t *entry_find(const ScreenCache_desc_t *desc)
+{
+  for (uint32_t i = 0; i < SCREEN_CACHE_MAX_ENTRIES; i++)
+  {
+    if (entries[i].screen != NULL && entries[i].desc == desc)
+    {
+      return &entries[i];
+    }
+  }
+
+  return NULL;
+}
+
+static cache_entry_t *entry_build(const ScreenCache_desc_t *desc)
+{
+  cache_entry_t *entry = NULL;
+
+  for (uint32_t i = 0; i < SCREEN_CACHE_MAX_ENTRIES && entry == NULL; i++)
+  {
+    entry = (entries[i].screen == NULL) ? &entries[i] : NULL;
+  }
+  if (entry == NULL)
+  {
+    /* Table full: reuse the least recently used slot */
+    for (uint32_t i = 0; i < SCREEN_CACHE_MAX_ENTRIES; i++)
+    {
+      if (entries[i].screen != lv_screen_active() && (entry == NULL || entries[i].lastUse < entry->lastUse))
+      {
+        entry = &entries[i];
+      }
+    }
+    if (entry == NULL)
+    {
+      return NULL;
+    }
+    entry_drop(entry);
+  }
+
+  size_t before = heap_used();
+  lv_obj_t *screen = desc->create(desc->user);
+  if (screen == NULL)
+  {
+    return NULL;
+  }
+  /* Resolve styles and layout now, not on the first frame */
+  lv_obj_update_layout(screen);
+  size_t after = heap_used();
+
+  entry->desc = desc;
+  entry->screen = screen;
+  entry->costBytes = (after > before) ? after - before : 0U;
+  entry->lastUse = ++useClock;
+  lv_obj_add_event_cb(screen, screen_delete_cb, LV_EVENT_DELETE, entry);
+  LV_LOG_INFO("%s cached, %u bytes", desc->name, (unsigned) entry->costBytes);
+
+  return entry;
+}
+
+static void entry_drop(cache_entry_t *entry)
+{
+  lv_obj_t *screen = entry->screen;
+
+  entry->screen = NULL;
+  if (screen != NULL)
+  {
+    lv_obj_remove_event_cb_with_user_data(screen, screen_delete_cb, entry);
+    lv_obj_delete(screen);
+  }
+}
+
+static void evict(const cache_entry_t *keep)
+{
+  size_t limit = budget;
+  lv_obj_t *active = lv_screen_active();
+
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
+  if (limit == 0)
+  {
+    limit = (size_t) LV_MEM_SIZE / 4U * 3U;
+  }
+#endif
+  if (limit == 0)
+  {
+    return;
+  }
+
+  while (heap_used() > limit)
+  {
+    cache_entry_t *victim = NULL;
+    for (uint32_t i = 0; i < SCREEN_CACHE_MAX_ENTRIES; i++)
+    {
+      cache_entry_t *entry = &entries[i];
+      if (entry->screen == NULL || entry == keep || entry->screen == active)
+      {
+        continue;
+      }
+      if (victim == NULL || entry->lastUse < victim->lastUse)
+      {
+        victim = entry;
+      }
+    }
+    if (victim == NULL)
+    {
+      return;
+    }
+    LV_LOG_INFO("%s evicted", victim->desc->name);
+    entry_drop(victim);
+  }
+}
+
+static size_t heap_used(void)
+{
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+  return mon.total_size - mon.free_size;
+#else
+  return 0;
+#endif
+}
+
+static void screen_delete_cb(lv_event_t *e)
+{
+  cache_entry_t *entry = lv_event_get_user_data(e);
+
+  if (entry->screen == lv_event_get_target(e))
+  {
+    entry->screen = NULL;
+  }
+}
+
+static void prebuild_timer_cb(lv_timer_t *timer)
+{
+  /* One screen per period, skipped while areas wait to be drawn or the user is busy */
+  lv_display_t *display = lv_display_get_default();
+  if (display != NULL && (display->inv_p != 0U || lv_display_get_inactive_time(display) < PREBUILD_PERIOD_MS))
+  {
+    return;
+  }
+  while (prebuildNext < prebuildCount && entry_find(prebuildDescs[prebuildNext]) != NULL)
+  {
+    prebuildNext++;
+  }
+  if (prebuildNext < prebuildCount)
+  {
+    entry_build(prebuildDescs[prebuildNext++]);
+    evict(NULL);
+    return;
+  }
+
+  lv_timer_delete(timer);
+  prebuildTimer = NULL;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file ScreenCache.h
+ * Retained screens for fast screen switches.
+ *
+ * A screen registered here is built once, kept hidden while another screen is
+ * shown and only refreshed by its update callback when it is loaded again.
+ * Least recently used screens are deleted when the LVGL heap grows over the
+ * budget. Deleting a cached screen from outside is allowed, the cache notices.
+ */
+
+#ifndef SCREEN_CACHE_H
+#define SCREEN_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define SCREEN_CACHE_MAX_ENTRIES 16
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  const char *name;
+  /** Build the screen with `lv_obj_create(NULL)`, do not load it */
+  lv_obj_t *(*create)(void *user);
+  /** Bring the widgets up to date with the current data, may be NULL */
+  void (*update)(lv_obj_t *screen, void *user);
+  void *user;
+} ScreenCache_desc_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Limit for the used LVGL heap. Cached screens are evicted while the heap is
+ * above it. 0 selects 3/4 of LV_MEM_SIZE.
+ */
+void ScreenCache_set_budget(size_t bytes);
+
+/** Load the screen, building it only if it is not cached */
+lv_obj_t *ScreenCache_load(const ScreenCache_desc_t *desc);
+
+/** Run the update callback of the active screen if it is a cached one */
+void ScreenCache_refresh(void);
+
+/**
+ * Build the given screens hidden in the background, one per idle timer
+ * period, so the first visit is already fast.
+ */
+void ScreenCache_prebuild(const ScreenCache_desc_t *const *descs, uint32_t count);
+
+/** Drop a cached screen, e.g. after its layout depends on changed settings */
+void ScreenCache_invalidate(const ScreenCache_desc_t *desc);
+
+/** Heap bytes the cached screens took when they were built */
+size_t ScreenCache_get_cached_bytes(void);
+
+/** Name of the descriptor `screen` was built from, NULL if it is not a cached screen */
+const char *ScreenCache_get_name(const lv_obj_t *screen);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SCREEN_CACHE_H*/
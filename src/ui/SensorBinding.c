@@ -0,0 +1,242 @@
+/**
+ * @file SensorBinding.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include "SensorBinding.h"
+#include "ViewModel.h"
+#include "FramePacer.h"
+#include "NumLabel.h"
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void refr_start_cb(lv_event_t *e);
+static bool subject_update(lv_subject_t *subject, int32_t value);
+static void label_observer_cb(lv_observer_t *observer, lv_subject_t *subject);
+static void num_label_observer_cb(lv_observer_t *observer, lv_subject_t *subject);
+static void bar_observer_cb(lv_observer_t *observer, lv_subject_t *subject);
+static void state_observer_cb(lv_observer_t *observer, lv_subject_t *subject);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_subject_t valueSubjects[SIM_DESCRIPTOR_MAX_SENSORS];
+static lv_subject_t alarmSubjects[SIM_DESCRIPTOR_MAX_SENSORS];
+static lv_subject_t relaySubjects[SIM_DESCRIPTOR_MAX_RELAYS];
+static uint32_t sensorCount;
+static uint32_t relayCount;
+static bool initialized;
+static lv_display_t *syncDisplay;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void SensorBinding_init(lv_display_t *disp)
+{
+  const SimDescriptor_t *descriptor = SimDescriptor_get();
+
+  if (initialized)
+  {
+    for (uint32_t i = 0; i < SIM_DESCRIPTOR_MAX_SENSORS; i++)
+    {
+      lv_subject_deinit(&valueSubjects[i]);
+      lv_subject_deinit(&alarmSubjects[i]);
+    }
+    for (uint32_t i = 0; i < SIM_DESCRIPTOR_MAX_RELAYS; i++)
+    {
+      lv_subject_deinit(&relaySubjects[i]);
+    }
+  }
+  if (syncDisplay != NULL)
+  {
+    lv_display_remove_event_cb_with_user_data(syncDisplay, refr_start_cb, NULL);
+  }
+
+  /* All subjects exist so out of range bindings stay harmless, only the configured ones are synchronized */
+  for (uint32_t i = 0; i < SIM_DESCRIPTOR_MAX_SENSORS; i++)
+  {
+    lv_subject_init_int(&valueSubjects[i], ViewModel_get_value(i));
+    lv_subject_init_int(&alarmSubjects[i], ViewModel_get_alarm_state(i));
+  }
+  for (uint32_t i = 0; i < SIM_DESCRIPTOR_MAX_RELAYS; i++)
+  {
+    lv_subject_init_int(&relaySubjects[i], 0);
+  }
+  sensorCount = (descriptor != NULL) ? descriptor->sensorCount : 0U;
+  relayCount = (descriptor != NULL) ? descriptor->relayCount : 0U;
+  initialized = true;
+
+  syncDisplay = disp;
+  if (disp != NULL)
+  {
+    lv_display_add_event_cb(disp, refr_start_cb, LV_EVENT_REFR_START, NULL);
+  }
+  SensorBinding_sync();
+}
+
+void SensorBinding_sync(void)
+{
+  SimDescriptor_relayMask_t demand;
+  uint32_t changed = 0;
+
+  for (uint32_t i = 0; i < sensorCount; i++)
+  {
+    changed += subject_update(&valueSubjects[i], ViewModel_get_value(i));
+    changed += subject_update(&alarmSubjects[i], ViewModel_get_alarm_state(i));
+  }
+
+  ViewModel_get_relay_demand(demand);
+  for (uint32_t i = 0; i < relayCount; i++)
+  {
+    changed += subject_update(&relaySubjects[i], (int32_t) ((demand[i / 32U] >> (i % 32U)) & 1U));
+  }
+  FramePacer_notify_data(changed);
+}
+
+lv_subject_t *SensorBinding_value_subject(uint32_t sensor)
+{
+  return &valueSubjects[sensor < SIM_DESCRIPTOR_MAX_SENSORS ? sensor : 0U];
+}
+
+lv_subject_t *SensorBinding_alarm_subject(uint32_t sensor)
+{
+  return &alarmSubjects[sensor < SIM_DESCRIPTOR_MAX_SENSORS ? sensor : 0U];
+}
+
+lv_subject_t *SensorBinding_relay_subject(uint32_t relay)
+{
+  return &relaySubjects[relay < SIM_DESCRIPTOR_MAX_RELAYS ? relay : 0U];
+}
+
+void SensorBinding_format_value(uint32_t sensor, int32_t raw, char *buf, uint32_t len)
+{
+  const SimDescriptor_t *descriptor = SimDescriptor_get();
+  const SimDescriptor_sensor_t *config = (descriptor != NULL && sensor < SIM_DESCRIPTOR_MAX_SENSORS)
+                                         ? &descriptor->sensors[sensor] : NULL;
+  uint8_t decimals = (config != NULL) ? config->decimals : 0U;
+  const char *unit = (config != NULL) ? config->unit : "";
+  int32_t scale = 1;
+
+  for (uint8_t d = 0; d < decimals && d < 6U; d++)
+  {
+    scale *= 10;
+  }
+  if (scale == 1)
+  {
+    snprintf(buf, len, "%" LV_PRId32 " %s", raw, unit);
+    return;
+  }
+
+  /* Sign separately, -0.5 has an integer part of 0 */
+  uint32_t magnitude = (raw < 0) ? 0U - (uint32_t) raw : (uint32_t) raw;
+  snprintf(buf, len, "%s%" LV_PRIu32 ".%0*" LV_PRIu32 " %s", (raw < 0) ? "-" : "", magnitude / (uint32_t) scale,
+           (int) decimals, magnitude % (uint32_t) scale, unit);
+}
+
+void SensorBinding_bind_label(lv_obj_t *label, uint32_t sensor)
+{
+  lv_subject_add_observer_obj(SensorBinding_value_subject(sensor), label_observer_cb, label,
+                              (void *) (uintptr_t) sensor);
+}
+
+void SensorBinding_format_num_label(lv_obj_t *numLabel, uint32_t sensor)
+{
+  const SimDescriptor_t *descriptor = SimDescriptor_get();
+  const SimDescriptor_sensor_t *config = (descriptor != NULL && sensor < SIM_DESCRIPTOR_MAX_SENSORS)
+                                         ? &descriptor->sensors[sensor] : NULL;
+  uint8_t decimals = (config != NULL) ? config->decimals : 0U;
+  int32_t whole = (config != NULL && config->range > 0) ? config->range : 100;
+  uint8_t digits = 1U;
+
+  for (uint8_t d = 0; d < decimals && d < 6U; d++)
+  {
+    whole /= 10;
+  }
+  for (; whole >= 10; whole /= 10)
+  {
+    digits++;
+  }
+  NumLabel_set_format(numLabel, (uint8_t) (digits + 1U), decimals, false);
+  NumLabel_set_unit(numLabel, (config != NULL) ? config->unit : "");
+}
+
+void SensorBinding_bind_num_label(lv_obj_t *numLabel, uint32_t sensor)
+{
+  SensorBinding_format_num_label(numLabel, sensor);
+  lv_subject_add_observer_obj(SensorBinding_value_subject(sensor), num_label_observer_cb, numLabel, NULL);
+}
+
+void SensorBinding_bind_bar(lv_obj_t *bar, uint32_t sensor)
+{
+  const SimDescriptor_t *descriptor = SimDescriptor_get();
+  int32_t range = (descriptor != NULL && sensor < SIM_DESCRIPTOR_MAX_SENSORS) ? descriptor->sensors[sensor].range : 0;
+
+  lv_bar_set_range(bar, 0, (range > 0) ? range : 100);
+  lv_subject_add_observer_obj(SensorBinding_value_subject(sensor), bar_observer_cb, bar, NULL);
+}
+
+void SensorBinding_bind_alarm_state(lv_obj_t *obj, uint32_t sensor, lv_state_t state)
+{
+  lv_subject_add_observer_obj(SensorBinding_alarm_subject(sensor), state_observer_cb, obj,
+                              (void *) (uintptr_t) state);
+}
+
+void SensorBinding_bind_relay_state(lv_obj_t *obj, uint32_t relay, lv_state_t state)
+{
+  lv_subject_add_observer_obj(SensorBinding_relay_subject(relay), state_observer_cb, obj,
+                              (void *) (uintptr_t) state);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/** Runs before the refresh draws the dirty areas, so the invalidations land in this frame */
+static void refr_start_cb(lv_event_t *e)
+{
+  LV_UNUSED(e);
+  SensorBinding_sync();
+}
+
+static bool subject_update(lv_subject_t *subject, int32_t value)
+{
+  if (lv_subject_get_int(subject) == value)
+  {
+    return false;
+  }
+  lv_subject_set_int(subject, value);
+
+  return true;
+}
+
+static void label_observer_cb(lv_observer_t *observer, lv_subject_t *subject)
+{
+  char text[32];
+  uint32_t sensor = (uint32_t) (uintptr_t) lv_observer_get_user_data(observer);
+
+  SensorBinding_format_value(sensor, lv_subject_get_int(subject), text, sizeof(text));
+  lv_label_set_text(lv_observer_get_target_obj(observer), text);
+}
+
+static void num_label_observer_cb(lv_observer_t *observer, lv_subject_t *subject)
+{
+  NumLabel_set_value(lv_observer_get_target_obj(observer), lv_subject_get_int(subject));
+}
+
+static void bar_observer_cb(lv_observer_t *observer, lv_subject_t *subject)
+{
+  lv_bar_set_value(lv_observer_get_target_obj(observer), lv_subject_get_int(subject), LV_ANIM_OFF);
+}
+
+static void state_observer_cb(lv_observer_t *observer, lv_subject_t *subject)
+{
+  lv_state_t state = (lv_state_t) (uintptr_t) lv_observer_get_user_data(observer);
+
+  lv_obj_set_state(lv_observer_get_target_obj(observer), state, lv_subject_get_int(subject) != 0);
+}
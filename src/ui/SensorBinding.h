@@ -0,0 +1,76 @@
+/**
+ * @file SensorBinding.h
+ * LVGL observer subjects for the simulated plant.
+ *
+ * Every sensor value, sensor alarm state and relay of the descriptor is an
+ * integer `lv_subject_t`. The subjects are synchronized from the ViewModel once
+ * per display refresh, right before the dirty areas are drawn, and only
+ * subjects whose value changed notify their observers. Bound widgets therefore
+ * invalidate only when their own sensor changed, and at most once per frame
+ * however often the sensor was written.
+ */
+
+#ifndef SENSOR_BINDING_H
+#define SENSOR_BINDING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+#include "../sim/SimDescriptor.h"
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * (Re)create the subjects for the current descriptor and synchronize them on
+ * every refresh of `disp`. Observers of earlier subjects are removed.
+ */
+void SensorBinding_init(lv_display_t *disp);
+
+/** Pull changed values into the subjects now instead of at the next refresh */
+void SensorBinding_sync(void);
+
+/** Raw sensor value in descriptor units */
+lv_subject_t *SensorBinding_value_subject(uint32_t sensor);
+
+/** Active entries, bit n for level n and bit SIM_ALARMS_FAULT for the fault */
+lv_subject_t *SensorBinding_alarm_subject(uint32_t sensor);
+
+/** 1 while any active level or fault demands the relay */
+lv_subject_t *SensorBinding_relay_subject(uint32_t relay);
+
+/** Value with the descriptor decimals and unit, e.g. "12.5 %LEL" */
+void SensorBinding_format_value(uint32_t sensor, int32_t raw, char *buf, uint32_t len);
+
+/** Show the formatted value of `sensor` in a label */
+void SensorBinding_bind_label(lv_obj_t *label, uint32_t sensor);
+
+/**
+ * Format of a NumLabel for `sensor`: the descriptor decimals and unit, integer
+ * digits for the full scale plus one, for a minus or an over-range value
+ */
+void SensorBinding_format_num_label(lv_obj_t *numLabel, uint32_t sensor);
+
+/** Show the value of `sensor` in a NumLabel, formatted as above */
+void SensorBinding_bind_num_label(lv_obj_t *numLabel, uint32_t sensor);
+
+/** Range 0..descriptor range, the value follows the sensor */
+void SensorBinding_bind_bar(lv_obj_t *bar, uint32_t sensor);
+
+/** Add `state` to the object while any level or fault of the sensor is active */
+void SensorBinding_bind_alarm_state(lv_obj_t *obj, uint32_t sensor, lv_state_t state);
+
+/** Add `state` to the object while the relay is demanded */
+void SensorBinding_bind_relay_state(lv_obj_t *obj, uint32_t relay, lv_state_t state);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SENSOR_BINDING_H*/
@@ -0,0 +1,379 @@
+/**
+ * @file SensorList.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "SensorList.h"
+#include "SensorBinding.h"
+#include "NumLabel.h"
+#include "lvgl/lvgl_private.h"
+#include "../sim/SimDescriptor.h"
+#include "ViewModel.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define MY_CLASS (&SensorList_class)
+
+/** Entry index of a row that shows nothing */
+#define ROW_UNBOUND UINT32_MAX
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  lv_obj_t *row;
+  lv_obj_t *nameLabel;
+  lv_obj_t *valueLabel;
+  uint32_t entry;     /**< list entry shown, ROW_UNBOUND if none */
+  int32_t shownValue;
+  uint8_t shownState;
+} list_row_t;
+
+typedef struct {
+  lv_obj_t obj;
+  lv_obj_t *spacer;   /**< gives the content its full height, never drawn */
+  list_row_t *rows;
+  uint32_t rowCount;
+  uint32_t first;     /**< descriptor index of entry 0 */
+  uint32_t count;
+  uint32_t selected;  /**< entry index */
+  int32_t rowHeight;
+  lv_display_t *boundDisplay;
+} SensorList_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void SensorList_constructor(const lv_obj_class_t *class_p, lv_obj_t *obj);
+static void SensorList_destructor(const lv_obj_class_t *class_p, lv_obj_t *obj);
+static void SensorList_event(const lv_obj_class_t *class_p, lv_event_t *e);
+static void pool_resize(SensorList_t *list);
+static void rows_bind(SensorList_t *list);
+static void row_bind(SensorList_t *list, list_row_t *row, uint32_t entry);
+static void row_update(SensorList_t *list, list_row_t *row);
+static void row_clicked_cb(lv_event_t *e);
+static void refr_start_cb(lv_event_t *e);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+const lv_obj_class_t SensorList_class = {
+  .constructor_cb = SensorList_constructor,
+  .destructor_cb = SensorList_destructor,
+  .event_cb = SensorList_event,
+  .width_def = LV_PCT(100),
+  .height_def = LV_PCT(100),
+  .group_def = LV_OBJ_CLASS_GROUP_DEF_TRUE,
+  .editable = LV_OBJ_CLASS_EDITABLE_TRUE,
+  .instance_size = sizeof(SensorList_t),
+  .base_class = &lv_obj_class,
+  .name = "SensorList",
+};
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_obj_t *SensorList_create(lv_obj_t *parent)
+{
+  lv_obj_t *obj = lv_obj_class_create_obj(MY_CLASS, parent);
+  lv_obj_class_init_obj(obj);
+
+  return obj;
+}
+
+void SensorList_set_sensors(lv_obj_t *obj, uint32_t first, uint32_t count)
+{
+  SensorList_t *list = (SensorList_t *) obj;
+
+  list->first = LV_MIN(first, SIM_DESCRIPTOR_MAX_SENSORS);
+  list->count = LV_MIN(count, SIM_DESCRIPTOR_MAX_SENSORS - list->first);
+  list->selected = 0;
+  lv_obj_set_height(list->spacer, (int32_t) list->count * list->rowHeight);
+  lv_obj_scroll_to_y(obj, 0, LV_ANIM_OFF);
+
+  for (uint32_t i = 0; i < list->rowCount; i++)
+  {
+    list->rows[i].entry = ROW_UNBOUND;
+  }
+  rows_bind(list);
+}
+
+void SensorList_set_row_height(lv_obj_t *obj, int32_t height)
+{
+  SensorList_t *list = (SensorList_t *) obj;
+
+  list->rowHeight = LV_MAX(height, 1);
+  lv_obj_set_height(list->spacer, (int32_t) list->count * list->rowHeight);
+  for (uint32_t i = 0; i < list->rowCount; i++)
+  {
+    lv_obj_set_height(list->rows[i].row, list->rowHeight);
+    list->rows[i].entry = ROW_UNBOUND;
+  }
+  pool_resize(list);
+}
+
+void SensorList_set_selected(lv_obj_t *obj, uint32_t index)
+{
+  SensorList_t *list = (SensorList_t *) obj;
+
+  if (list->count == 0)
+  {
+    return;
+  }
+  index = LV_MIN(index, list->count - 1U);
+  if (index == list->selected)
+  {
+    return;
+  }
+  list->selected = index;
+
+  /* Scroll just enough to show the row, then mark it */
+  int32_t top = (int32_t) index * list->rowHeight;
+  int32_t viewTop = lv_obj_get_scroll_y(obj);
+  int32_t viewH = lv_obj_get_content_height(obj);
+  if (top < viewTop)
+  {
+    lv_obj_scroll_to_y(obj, top, LV_ANIM_OFF);
+  }
+  else if (top + list->rowHeight > viewTop + viewH)
+  {
+    lv_obj_scroll_to_y(obj, top + list->rowHeight - viewH, LV_ANIM_OFF);
+  }
+  for (uint32_t i = 0; i < list->rowCount; i++)
+  {
+    lv_obj_set_state(list->rows[i].row, LV_STATE_FOCUS_KEY, list->rows[i].entry == index);
+  }
+  lv_obj_send_event(obj, LV_EVENT_VALUE_CHANGED, NULL);
+}
+
+uint32_t SensorList_get_selected(lv_obj_t *obj)
+{
+  SensorList_t *list = (SensorList_t *) obj;
+
+  return list->first + list->selected;
+}
+
+uint32_t SensorList_get_row_count(lv_obj_t *obj)
+{
+  return ((SensorList_t *) obj)->rowCount;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void SensorList_constructor(const lv_obj_class_t *class_p, lv_obj_t *obj)
+{
+  LV_UNUSED(class_p);
+  SensorList_t *list = (SensorList_t *) obj;
+
+  list->rowHeight = 32;
+  lv_obj_set_scroll_dir(obj, LV_DIR_VER);
+  lv_obj_remove_flag(obj, LV_OBJ_FLAG_SCROLL_ELASTIC);
+
+  list->spacer = lv_obj_create(obj);
+  lv_obj_remove_style_all(list->spacer);
+  lv_obj_remove_flag(list->spacer, LV_OBJ_FLAG_CLICKABLE);
+  lv_obj_set_size(list->spacer, 1, 0);
+
+  list->boundDisplay = lv_obj_get_display(obj);
+  lv_display_add_event_cb(list->boundDisplay, refr_start_cb, LV_EVENT_REFR_START, obj);
+}
+
+static void SensorList_destructor(const lv_obj_class_t *class_p, lv_obj_t *obj)
+{
+  LV_UNUSED(class_p);
+  SensorList_t *list = (SensorList_t *) obj;
+
+  lv_display_remove_event_cb_with_user_data(list->boundDisplay, refr_start_cb, obj);
+  /* The row objects are children and deleted with the list */
+  lv_free(list->rows);
+  list->rows = NULL;
+  list->rowCount = 0;
+}
+
+static void SensorList_event(const lv_obj_class_t *class_p, lv_event_t *e)
+{
+  LV_UNUSED(class_p);
+
+  if (lv_obj_event_base(MY_CLASS, e) != LV_RESULT_OK)
+  {
+    return;
+  }
+
+  lv_event_code_t code = lv_event_get_code(e);
+  lv_obj_t *obj = lv_event_get_current_target(e);
+  SensorList_t *list = (SensorList_t *) obj;
+  if (code == LV_EVENT_SCROLL)
+  {
+    rows_bind(list);
+  }
+  else if (code == LV_EVENT_SIZE_CHANGED)
+  {
+    pool_resize(list);
+  }
+  else if (code == LV_EVENT_KEY)
+  {
+    uint32_t key = lv_event_get_key(e);
+    if ((key == LV_KEY_UP || key == LV_KEY_LEFT) && list->selected > 0)
+    {
+      SensorList_set_selected(obj, list->selected - 1U);
+    }
+    else if (key == LV_KEY_DOWN || key == LV_KEY_RIGHT)
+    {
+      SensorList_set_selected(obj, list->selected + 1U);
+    }
+  }
+}
+
+/** Rows for the viewport plus overscan, created or deleted as the height changes */
+static void pool_resize(SensorList_t *list)
+{
+  lv_obj_t *obj = &list->obj;
+  int32_t viewH = lv_obj_get_content_height(obj);
+  uint32_t needed = (uint32_t) ((viewH + list->rowHeight - 1) / list->rowHeight) + 1U + 2U * SENSOR_LIST_OVERSCAN;
+
+  if (needed == list->rowCount)
+  {
+    rows_bind(list);
+    return;
+  }
+
+  for (uint32_t i = needed; i < list->rowCount; i++)
+  {
+    lv_obj_delete(list->rows[i].row);
+  }
+  list_row_t *rows = lv_realloc(list->rows, sizeof(list_row_t) * needed);
+  LV_ASSERT_MALLOC(rows);
+  if (rows == NULL)
+  {
+    return;
+  }
+  list->rows = rows;
+
+  for (uint32_t i = list->rowCount; i < needed; i++)
+  {
+    list_row_t *row = &list->rows[i];
+    row->row = lv_obj_create(obj);
+    lv_obj_remove_style_all(row->row);
+    lv_obj_set_size(row->row, LV_PCT(100), list->rowHeight);
+    lv_obj_set_style_pad_hor(row->row, 8, 0);
+    lv_obj_set_style_border_side(row->row, LV_BORDER_SIDE_BOTTOM, 0);
+    lv_obj_set_style_border_width(row->row, 1, 0);
+    lv_obj_set_style_border_color(row->row, lv_palette_main(LV_PALETTE_GREY), 0);
+    lv_obj_set_style_bg_opa(row->row, LV_OPA_COVER, LV_STATE_FOCUS_KEY);
+    lv_obj_set_style_bg_color(row->row, lv_palette_lighten(LV_PALETTE_BLUE, 3), LV_STATE_FOCUS_KEY);
+    lv_obj_set_style_text_color(row->row, lv_palette_main(LV_PALETTE_RED), LV_STATE_CHECKED);
+    lv_obj_remove_flag(row->row, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(row->row, LV_OBJ_FLAG_EVENT_BUBBLE);
+    lv_obj_add_event_cb(row->row, row_clicked_cb, LV_EVENT_CLICKED, list);
+
+    row->nameLabel = lv_label_create(row->row);
+    lv_obj_align(row->nameLabel, LV_ALIGN_LEFT_MID, 0, 0);
+    row->valueLabel = NumLabel_create(row->row);
+    lv_obj_align(row->valueLabel, LV_ALIGN_RIGHT_MID, 0, 0);
+    row->entry = ROW_UNBOUND;
+  }
+  list->rowCount = needed;
+  rows_bind(list);
+}
+
+/**
+ * Entry e is always shown by row e % rowCount, so scrolling by one row moves
+ * and rebinds exactly one row.
+ */
+static void rows_bind(SensorList_t *list)
+{
+  if (list->rowCount == 0)
+  {
+    return;
+  }
+
+  int32_t firstVisible = lv_obj_get_scroll_y(&list->obj) / list->rowHeight;
+  uint32_t start = (uint32_t) LV_MAX(firstVisible - SENSOR_LIST_OVERSCAN, 0);
+  for (uint32_t entry = start; entry < start + list->rowCount; entry++)
+  {
+    list_row_t *row = &list->rows[entry % list->rowCount];
+    row_bind(list, row, (entry < list->count) ? entry : ROW_UNBOUND);
+  }
+}
+
+static void row_bind(SensorList_t *list, list_row_t *row, uint32_t entry)
+{
+  const SimDescriptor_t *descriptor = SimDescriptor_get();
+
+  if (row->entry == entry)
+  {
+    return;
+  }
+  row->entry = entry;
+  if (entry == ROW_UNBOUND || descriptor == NULL)
+  {
+    lv_obj_add_flag(row->row, LV_OBJ_FLAG_HIDDEN);
+    return;
+  }
+
+  const SimDescriptor_sensor_t *sensor = &descriptor->sensors[list->first + entry];
+  lv_obj_remove_flag(row->row, LV_OBJ_FLAG_HIDDEN);
+  lv_obj_set_y(row->row, (int32_t) entry * list->rowHeight);
+  lv_label_set_text_fmt(row->nameLabel, "%" LV_PRIu32 "  %s  %s", list->first + entry + 1U, sensor->name, sensor->gas);
+  SensorBinding_format_num_label(row->valueLabel, list->first + entry);
+  lv_obj_set_state(row->row, LV_STATE_FOCUS_KEY, entry == list->selected);
+
+  /* Force the value text of the new sensor */
+  row->shownValue = INT32_MIN;
+  row->shownState = UINT8_MAX;
+  row_update(list, row);
+}
+
+static void row_update(SensorList_t *list, list_row_t *row)
+{
+  uint32_t sensor = list->first + row->entry;
+  int32_t value = ViewModel_get_value(sensor);
+  uint8_t state = ViewModel_get_alarm_state(sensor);
+
+  if (value != row->shownValue)
+  {
+    NumLabel_set_value(row->valueLabel, value);
+    row->shownValue = value;
+  }
+  if (state != row->shownState)
+  {
+    lv_obj_set_state(row->row, LV_STATE_CHECKED, state != 0U);
+    row->shownState = state;
+  }
+}
+
+static void row_clicked_cb(lv_event_t *e)
+{
+  SensorList_t *list = lv_event_get_user_data(e);
+  lv_obj_t *target = lv_event_get_current_target(e);
+
+  for (uint32_t i = 0; i < list->rowCount; i++)
+  {
+    if (list->rows[i].row == target && list->rows[i].entry != ROW_UNBOUND)
+    {
+      SensorList_set_selected(&list->obj, list->rows[i].entry);
+    }
+  }
+}
+
+/** Values of the bound rows only, off-screen sensors cost nothing */
+static void refr_start_cb(lv_event_t *e)
+{
+  SensorList_t *list = lv_event_get_user_data(e);
+
+  for (uint32_t i = 0; i < list->rowCount; i++)
+  {
+    if (list->rows[i].entry != ROW_UNBOUND)
+    {
+      row_update(list, &list->rows[i]);
+    }
+  }
+}
@@ -0,0 +1,57 @@
+/**
+ * @file SensorList.h
+ * Scrollable list of sensors that only creates the visible rows.
+ *
+ * The list keeps a pool of rows for the viewport plus an overscan of
+ * SENSOR_LIST_OVERSCAN rows above and below it. Scrolling rebinds the rows
+ * that left the pool range to the sensors that entered it, so memory and
+ * layout cost depend on the list height, not on the number of sensors.
+ *
+ * Scroll with touch/mouse drag, or focus the list and turn the encoder or
+ * mousewheel to move the selection. Rows in alarm get LV_STATE_CHECKED, the
+ * selected row LV_STATE_FOCUS_KEY.
+ */
+
+#ifndef SENSOR_LIST_H
+#define SENSOR_LIST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define SENSOR_LIST_OVERSCAN 2
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+lv_obj_t *SensorList_create(lv_obj_t *parent);
+
+/** List sensors first..first+count-1 of the simulator descriptor */
+void SensorList_set_sensors(lv_obj_t *obj, uint32_t first, uint32_t count);
+
+void SensorList_set_row_height(lv_obj_t *obj, int32_t height);
+
+/** Select a list entry and scroll it into view */
+void SensorList_set_selected(lv_obj_t *obj, uint32_t index);
+
+/** Selected sensor (descriptor index), LV_EVENT_VALUE_CHANGED reports changes */
+uint32_t SensorList_get_selected(lv_obj_t *obj);
+
+/** Rows currently allocated, for diagnostics */
+uint32_t SensorList_get_row_count(lv_obj_t *obj);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SENSOR_LIST_H*/
@@ -0,0 +1,267 @@
+/**
+ * @file Startup.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#ifndef _DEFAULT_SOURCE
+  #define _DEFAULT_SOURCE /* needed for clock_gettime() */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef _MSC_VER
+  #include <Windows.h>
+#else
+  #include <time.h>
+#endif
+
+#include "Startup.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  const char *name;
+  uint64_t startUs;
+  uint64_t durationUs;
+  uint8_t depth;
+  bool deferred;
+} phase_t;
+
+typedef struct {
+  const char *name;
+  Startup_init_cb_t cb;
+  void *user;
+  bool pending;
+} deferred_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static uint64_t now_us(void);
+static void run_deferred(deferred_t *work);
+static void first_frame_cb(lv_event_t *e);
+static void idle_timer_cb(lv_timer_t *timer);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static uint64_t originUs;
+static bool lazy;
+
+static phase_t phases[STARTUP_MAX_PHASES];
+static uint32_t phaseCount;
+static uint32_t openPhases[STARTUP_MAX_PHASES];
+static uint32_t openCount;
+
+static deferred_t deferredWork[STARTUP_MAX_DEFERRED];
+static uint32_t deferredCount;
+static uint32_t pendingCount;
+
+static uint64_t firstFrameUs;
+static lv_timer_t *idleTimer;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void Startup_init(bool lazyInit)
+{
+  originUs = now_us();
+  lazy = lazyInit;
+  phaseCount = 0;
+  openCount = 0;
+  deferredCount = 0;
+  pendingCount = 0;
+  firstFrameUs = 0;
+}
+
+bool Startup_is_lazy(void)
+{
+  return lazy;
+}
+
+void Startup_phase_begin(const char *name)
+{
+  /* Phases beyond the table are not traced, but must still balance */
+  uint32_t index = phaseCount;
+
+  if (phaseCount < STARTUP_MAX_PHASES)
+  {
+    phase_t *phase = &phases[phaseCount++];
+    phase->name = name;
+    phase->startUs = now_us() - originUs;
+    phase->durationUs = 0;
+    phase->depth = (uint8_t) openCount;
+    phase->deferred = firstFrameUs != 0;
+  }
+  else
+  {
+    index = UINT32_MAX;
+  }
+  if (openCount < STARTUP_MAX_PHASES)
+  {
+    openPhases[openCount++] = index;
+  }
+}
+
+void Startup_phase_end(void)
+{
+  if (openCount == 0)
+  {
+    return;
+  }
+  uint32_t index = openPhases[--openCount];
+  if (index != UINT32_MAX)
+  {
+    phases[index].durationUs = now_us() - originUs - phases[index].startUs;
+  }
+}
+
+void Startup_watch_first_frame(lv_display_t *disp)
+{
+  lv_display_add_event_cb(disp, first_frame_cb, LV_EVENT_REFR_READY, NULL);
+}
+
+bool Startup_defer(const char *name, Startup_init_cb_t cb, void *user)
+{
+  if (!lazy || deferredCount >= STARTUP_MAX_DEFERRED)
+  {
+    deferred_t work = { name, cb, user, true };
+    run_deferred(&work);
+    return !lazy;
+  }
+
+  deferred_t *work = &deferredWork[deferredCount++];
+  work->name = name;
+  work->cb = cb;
+  work->user = user;
+  work->pending = true;
+  pendingCount++;
+
+  return true;
+}
+
+void Startup_require(const char *name)
+{
+  for (uint32_t i = 0; i < deferredCount && pendingCount != 0; i++)
+  {
+    if (deferredWork[i].pending && strcmp(deferredWork[i].name, name) == 0)
+    {
+      run_deferred(&deferredWork[i]);
+    }
+  }
+}
+
+void Startup_require_all(void)
+{
+  for (uint32_t i = 0; i < deferredCount && pendingCount != 0; i++)
+  {
+    if (deferredWork[i].pending)
+    {
+      run_deferred(&deferredWork[i]);
+    }
+  }
+}
+
+uint64_t Startup_get_first_frame_us(void)
+{
+  return firstFrameUs;
+}
+
+bool Startup_write_trace(const char *path)
+{
+  FILE *out = fopen(path, "w");
+  if (out == NULL)
+  {
+    return false;
+  }
+
+  fprintf(out, "{\n  \"lazy\": %s,\n  \"firstFrameUs\": %llu,\n  \"pending\": %u,\n  \"phases\": [", lazy ? "true" : "false",
+          (unsigned long long) firstFrameUs, (unsigned) pendingCount);
+  for (uint32_t i = 0; i < phaseCount; i++)
+  {
+    const phase_t *phase = &phases[i];
+    fprintf(out, "%s\n    { \"name\": \"%s\", \"startUs\": %llu, \"us\": %llu, \"depth\": %u, \"afterFirstFrame\": %s }",
+            (i != 0) ? "," : "", phase->name, (unsigned long long) phase->startUs,
+            (unsigned long long) phase->durationUs, (unsigned) phase->depth, phase->deferred ? "true" : "false");
+  }
+  fprintf(out, "%s]\n}\n", (phaseCount != 0) ? "\n  " : "");
+
+  return fclose(out) == 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static uint64_t now_us(void)
+{
+#ifdef _MSC_VER
+  LARGE_INTEGER count;
+  LARGE_INTEGER freq;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&freq);
+  return (uint64_t) ((double) count.QuadPart * 1e6 / (double) freq.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000U + (uint64_t) ts.tv_nsec / 1000U;
+#endif
+}
+
+static void run_deferred(deferred_t *work)
+{
+  /* Cleared first, the work may require other deferred work but not itself */
+  if (work >= deferredWork && work < deferredWork + deferredCount)
+  {
+    pendingCount--;
+  }
+  work->pending = false;
+  Startup_phase_begin(work->name);
+  work->cb(work->user);
+  Startup_phase_end();
+}
+
+static void first_frame_cb(lv_event_t *e)
+{
+  lv_display_t *disp = lv_event_get_target(e);
+
+  firstFrameUs = now_us() - originUs;
+  lv_display_remove_event_cb_with_user_data(disp, first_frame_cb, NULL);
+  if (pendingCount != 0 && idleTimer == NULL)
+  {
+    idleTimer = lv_timer_create(idle_timer_cb, STARTUP_IDLE_PERIOD_MS, NULL);
+  }
+}
+
+/** Deferred work in registration order, at least one item per slice */
+static void idle_timer_cb(lv_timer_t *timer)
+{
+  uint64_t sliceStartUs = now_us();
+
+  for (uint32_t i = 0; i < deferredCount && pendingCount != 0; i++)
+  {
+    if (deferredWork[i].pending)
+    {
+      run_deferred(&deferredWork[i]);
+      if (now_us() - sliceStartUs >= STARTUP_IDLE_SLICE_US)
+      {
+        break;
+      }
+    }
+  }
+  if (pendingCount == 0)
+  {
+    lv_timer_delete(timer);
+    idleTimer = NULL;
+  }
+}
@@ -0,0 +1,86 @@
+/**
+ * @file Startup.h
+ * Startup phase tracer and deferred initialization.
+ *
+ * Every init step between process start and the first frame is timed as a
+ * phase; phases may nest. Work that the first screen does not need can be
+ * registered with Startup_defer() instead of being run in place: in lazy mode
+ * it runs after the first frame, a few milliseconds per idle slice, or right
+ * away when its first user calls Startup_require(). In eager mode
+ * Startup_defer() runs the work at once, as before.
+ *
+ * The trace is written as JSON with the offset and duration of every phase
+ * and of the first frame, relative to Startup_init().
+ */
+
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define STARTUP_MAX_PHASES 48
+#define STARTUP_MAX_DEFERRED 16
+
+/** Time one idle slice may spend on deferred work */
+#define STARTUP_IDLE_SLICE_US 4000U
+#define STARTUP_IDLE_PERIOD_MS 20U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef void (*Startup_init_cb_t)(void *user);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Start the clock, first thing in main() */
+void Startup_init(bool lazy);
+
+bool Startup_is_lazy(void);
+
+/** Time a phase until the matching Startup_phase_end(), `name` must stay valid */
+void Startup_phase_begin(const char *name);
+
+void Startup_phase_end(void);
+
+/**
+ * Record the first frame rendered on `disp`. In lazy mode the deferred work
+ * starts in idle slices afterwards. Call after lv_init().
+ */
+void Startup_watch_first_frame(lv_display_t *disp);
+
+/**
+ * Run `cb` now (eager mode) or later (lazy mode), traced as phase `name`.
+ * False if the queue is full, `cb` then ran at once.
+ */
+bool Startup_defer(const char *name, Startup_init_cb_t cb, void *user);
+
+/** Run the deferred work `name` now if it is still pending */
+void Startup_require(const char *name);
+
+/** Run all pending deferred work */
+void Startup_require_all(void);
+
+/** Time from Startup_init() to the first frame, 0 until it was drawn */
+uint64_t Startup_get_first_frame_us(void);
+
+/** Write the trace as JSON */
+bool Startup_write_trace(const char *path);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*STARTUP_H*/
@@ -0,0 +1,440 @@
+/**
+ * @file StaticLayer.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "StaticLayer.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SETTLE_CHECK_MS (STATIC_LAYER_SETTLE_MS / 5U)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+struct _StaticLayer_t {
+  lv_obj_t *root;
+  lv_obj_t *image;
+  lv_draw_buf_t *buf;
+  size_t bytes;
+  uint32_t changedMs;
+  uint32_t lastDrawMs;
+  bool used;
+  bool cached;         /**< the image is shown and the root transparent */
+  bool dirty;          /**< snapshot again once settled */
+  bool parentDeleting; /**< the image goes with the parent */
+};
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void subtree_watch(lv_obj_t *obj, StaticLayer_t *layer, bool watch);
+static void subtree_event_cb(lv_event_t *e);
+static void image_event_cb(lv_event_t *e);
+static void parent_delete_cb(lv_event_t *e);
+static void settle_timer_cb(lv_timer_t *timer);
+static void layer_changed(StaticLayer_t *layer);
+static void layer_show_live(StaticLayer_t *layer);
+static void layer_cache(StaticLayer_t *layer);
+static void layer_free_buf(StaticLayer_t *layer);
+static void layer_release(StaticLayer_t *layer, bool rootAlive);
+static bool make_room(size_t bytes, const StaticLayer_t *keep);
+static bool on_active_screen(lv_obj_t *obj);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static StaticLayer_t layers[STATIC_LAYER_MAX_LAYERS];
+static size_t budget = STATIC_LAYER_MAX_MEMORY;
+static size_t cachedBytes;
+static lv_timer_t *settleTimer;
+static StaticLayer_stats_t stats;
+/* Set while this module changes the objects, their events are its own */
+static bool updating;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+StaticLayer_t *StaticLayer_create(lv_obj_t *root)
+{
+  StaticLayer_t *layer = NULL;
+  lv_obj_t *parent = lv_obj_get_parent(root);
+
+  for (uint32_t i = 0; i < STATIC_LAYER_MAX_LAYERS && layer == NULL; i++)
+  {
+    layer = layers[i].used ? NULL : &layers[i];
+  }
+  if (layer == NULL || parent == NULL)
+  {
+    return NULL;
+  }
+
+  memset(layer, 0, sizeof(*layer));
+  layer->used = true;
+  layer->root = root;
+  layer->dirty = true;
+  /* Settled already, the first snapshot only waits for the layout */
+  layer->changedMs = lv_tick_get() - STATIC_LAYER_SETTLE_MS;
+  subtree_watch(root, layer, true);
+  lv_obj_add_event_cb(parent, parent_delete_cb, LV_EVENT_DELETE, layer);
+  if (settleTimer == NULL)
+  {
+    settleTimer = lv_timer_create(settle_timer_cb, SETTLE_CHECK_MS, NULL);
+  }
+
+  return layer;
+}
+
+void StaticLayer_delete(StaticLayer_t *layer)
+{
+  if (layer == NULL || !layer->used)
+  {
+    return;
+  }
+  subtree_watch(layer->root, layer, false);
+  lv_obj_remove_event_cb_with_user_data(lv_obj_get_parent(layer->root), parent_delete_cb, layer);
+  layer_release(layer, true);
+}
+
+void StaticLayer_invalidate(StaticLayer_t *layer)
+{
+  if (layer != NULL && layer->used)
+  {
+    layer_changed(layer);
+  }
+}
+
+bool StaticLayer_is_cached(const StaticLayer_t *layer)
+{
+  return layer != NULL && layer->used && layer->cached;
+}
+
+void StaticLayer_set_budget(size_t bytes)
+{
+  budget = bytes;
+  (void) make_room(0, NULL);
+}
+
+size_t StaticLayer_get_cached_bytes(void)
+{
+  return cachedBytes;
+}
+
+void StaticLayer_get_stats(StaticLayer_stats_t *out)
+{
+  *out = stats;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void subtree_watch(lv_obj_t *obj, StaticLayer_t *layer, bool watch)
+{
+  if (watch)
+  {
+    lv_obj_add_event_cb(obj, subtree_event_cb, LV_EVENT_ALL, layer);
+  }
+  else
+  {
+    lv_obj_remove_event_cb_with_user_data(obj, subtree_event_cb, layer);
+  }
+  for (uint32_t i = 0; i < lv_obj_get_child_count(obj); i++)
+  {
+    subtree_watch(lv_obj_get_child(obj, (int32_t) i), layer, watch);
+  }
+}
+
+static void subtree_event_cb(lv_event_t *e)
+{
+  StaticLayer_t *layer = lv_event_get_user_data(e);
+  lv_event_code_t code = lv_event_get_code(e);
+
+  if (updating)
+  {
+    return;
+  }
+  switch (code)
+  {
+  case LV_EVENT_DELETE:
+    if (lv_event_get_current_target(e) == layer->root)
+    {
+      layer_release(layer, false);
+    }
+    break;
+  case LV_EVENT_CHILD_CREATED:
+    /* Sent to the parent, the new child is the parameter */
+    if (lv_event_get_param(e) != NULL)
+    {
+      subtree_watch(lv_event_get_param(e), layer, true);
+    }
+    layer_changed(layer);
+    break;
+  case LV_EVENT_STYLE_CHANGED:
+  case LV_EVENT_SIZE_CHANGED:
+  case LV_EVENT_CHILD_CHANGED:
+  case LV_EVENT_CHILD_DELETED:
+  case LV_EVENT_VALUE_CHANGED:
+    layer_changed(layer);
+    break;
+  default:
+    break;
+  }
+}
+
+static void image_event_cb(lv_event_t *e)
+{
+  StaticLayer_t *layer = lv_event_get_user_data(e);
+
+  if (lv_event_get_code(e) == LV_EVENT_DRAW_MAIN_BEGIN)
+  {
+    layer->lastDrawMs = lv_tick_get();
+  }
+  else if (lv_event_get_code(e) == LV_EVENT_DELETE)
+  {
+    /* Deleted by someone else: draw live, the next snapshot makes a new image */
+    layer->image = NULL;
+    layer_free_buf(layer);
+    if (!layer->parentDeleting)
+    {
+      layer_changed(layer);
+    }
+  }
+}
+
+static void parent_delete_cb(lv_event_t *e)
+{
+  StaticLayer_t *layer = lv_event_get_user_data(e);
+
+  /* The parent gets its delete event before its children */
+  layer->parentDeleting = true;
+}
+
+static void settle_timer_cb(lv_timer_t *timer)
+{
+  LV_UNUSED(timer);
+  uint32_t nowMs = lv_tick_get();
+
+  for (uint32_t i = 0; i < STATIC_LAYER_MAX_LAYERS; i++)
+  {
+    StaticLayer_t *layer = &layers[i];
+    if (layer->used && layer->dirty && lv_tick_diff(nowMs, layer->changedMs) >= STATIC_LAYER_SETTLE_MS &&
+        on_active_screen(layer->root))
+    {
+      layer_cache(layer);
+    }
+  }
+}
+
+static void layer_changed(StaticLayer_t *layer)
+{
+  layer->changedMs = lv_tick_get();
+  layer->dirty = true;
+  if (layer->cached)
+  {
+    stats.invalidations++;
+    layer_show_live(layer);
+  }
+}
+
+static void layer_show_live(StaticLayer_t *layer)
+{
+  if (!layer->cached)
+  {
+    return;
+  }
+  updating = true;
+  lv_obj_remove_local_style_prop(layer->root, LV_STYLE_OPA, LV_PART_MAIN);
+  if (layer->image != NULL)
+  {
+    lv_obj_add_flag(layer->image, LV_OBJ_FLAG_HIDDEN);
+  }
+  updating = false;
+  layer->cached = false;
+}
+
+static void layer_cache(StaticLayer_t *layer)
+{
+  lv_obj_t *root = layer->root;
+  uint32_t startMs = lv_tick_get();
+
+  updating = true;
+  lv_obj_update_layout(root);
+  updating = false;
+
+  /* An opaque root needs no alpha, RGB565 halves the buffer on a 16-bit display */
+  int32_t ext = lv_obj_get_ext_draw_size(root);
+  bool opaque = lv_obj_get_style_bg_opa(root, LV_PART_MAIN) >= LV_OPA_MAX &&
+                lv_obj_get_style_radius(root, LV_PART_MAIN) == 0 && ext == 0;
+  lv_color_format_t cf = (opaque && lv_display_get_color_format(lv_obj_get_display(root)) == LV_COLOR_FORMAT_RGB565)
+                         ? LV_COLOR_FORMAT_RGB565 : LV_COLOR_FORMAT_ARGB8888;
+  int32_t w = lv_obj_get_width(root) + 2 * ext;
+  int32_t h = lv_obj_get_height(root) + 2 * ext;
+  if (w <= 0 || h <= 0)
+  {
+    return;
+  }
+  layer->dirty = false;
+
+  if (layer->buf != NULL &&
+      (layer->buf->header.cf != cf || lv_snapshot_reshape_draw_buf(root, layer->buf) != LV_RESULT_OK))
+  {
+    layer_free_buf(layer);
+  }
+  if (layer->buf == NULL)
+  {
+    size_t bytes = (size_t) lv_draw_buf_width_to_stride((uint32_t) w, cf) * (size_t) h;
+    if (!make_room(bytes, layer))
+    {
+      /* Stays live until the next change */
+      stats.overBudget++;
+      return;
+    }
+    layer->buf = lv_snapshot_create_draw_buf(root, cf);
+    if (layer->buf == NULL)
+    {
+      return;
+    }
+    layer->bytes = layer->buf->data_size;
+    cachedBytes += layer->bytes;
+  }
+
+  updating = true;
+  lv_obj_remove_local_style_prop(root, LV_STYLE_OPA, LV_PART_MAIN);
+  lv_result_t res = lv_snapshot_take_to_draw_buf(root, cf, layer->buf);
+  if (res != LV_RESULT_OK)
+  {
+    updating = false;
+    layer->cached = false;
+    layer_free_buf(layer);
+    return;
+  }
+
+  if (layer->image == NULL)
+  {
+    layer->image = lv_image_create(lv_obj_get_parent(root));
+    lv_obj_remove_style_all(layer->image);
+    lv_obj_remove_flag(layer->image, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_flag(layer->image, LV_OBJ_FLAG_IGNORE_LAYOUT);
+    lv_obj_add_event_cb(layer->image, image_event_cb, LV_EVENT_ALL, layer);
+  }
+  /* The same buffer has new pixels, nothing decoded from it may be reused */
+  lv_image_cache_drop(layer->buf);
+  lv_image_set_src(layer->image, layer->buf);
+  /* Right below the root, wherever it is among its siblings now */
+  int32_t rootIndex = lv_obj_get_index(root);
+  int32_t imageIndex = lv_obj_get_index(layer->image);
+  if (imageIndex != rootIndex - 1)
+  {
+    lv_obj_move_to_index(layer->image, (imageIndex < rootIndex) ? rootIndex - 1 : rootIndex);
+  }
+  lv_obj_set_pos(layer->image, lv_obj_get_x(root) - ext, lv_obj_get_y(root) - ext);
+  lv_obj_remove_flag(layer->image, LV_OBJ_FLAG_HIDDEN);
+  lv_obj_invalidate(layer->image);
+  lv_obj_set_style_opa(root, LV_OPA_TRANSP, LV_PART_MAIN);
+  updating = false;
+
+  layer->cached = true;
+  layer->lastDrawMs = lv_tick_get();
+  stats.renders++;
+  stats.renderMs += lv_tick_elaps(startMs);
+}
+
+static void layer_free_buf(StaticLayer_t *layer)
+{
+  if (layer->buf == NULL)
+  {
+    return;
+  }
+  if (layer->image != NULL)
+  {
+    lv_image_set_src(layer->image, NULL);
+  }
+  lv_image_cache_drop(layer->buf);
+  lv_draw_buf_destroy(layer->buf);
+  layer->buf = NULL;
+  cachedBytes -= layer->bytes;
+  layer->bytes = 0;
+}
+
+/** Free the slot, a root that stays is drawn live again */
+static void layer_release(StaticLayer_t *layer, bool rootAlive)
+{
+  if (rootAlive)
+  {
+    layer_show_live(layer);
+  }
+  if (layer->image != NULL)
+  {
+    lv_obj_remove_event_cb_with_user_data(layer->image, image_event_cb, layer);
+    if (!layer->parentDeleting)
+    {
+      lv_obj_delete(layer->image);
+    }
+    layer->image = NULL;
+  }
+  layer_free_buf(layer);
+  layer->used = false;
+
+  bool anyUsed = false;
+  for (uint32_t i = 0; i < STATIC_LAYER_MAX_LAYERS; i++)
+  {
+    anyUsed = anyUsed || layers[i].used;
+  }
+  if (!anyUsed && settleTimer != NULL)
+  {
+    lv_timer_delete(settleTimer);
+    settleTimer = NULL;
+  }
+}
+
+/**
+ * Free the buffers of the least recently drawn layers until `bytes` more fit.
+ * Layers drawn within the settle time are on screen and are kept.
+ */
+static bool make_room(size_t bytes, const StaticLayer_t *keep)
+{
+  uint32_t nowMs = lv_tick_get();
+
+  while (cachedBytes + bytes > budget)
+  {
+    StaticLayer_t *oldest = NULL;
+    for (uint32_t i = 0; i < STATIC_LAYER_MAX_LAYERS; i++)
+    {
+      StaticLayer_t *layer = &layers[i];
+      if (layer->used && layer != keep && layer->buf != NULL &&
+          (bytes == 0U || lv_tick_diff(nowMs, layer->lastDrawMs) >= STATIC_LAYER_SETTLE_MS) &&
+          (oldest == NULL || lv_tick_diff(nowMs, layer->lastDrawMs) > lv_tick_diff(nowMs, oldest->lastDrawMs)))
+      {
+        oldest = layer;
+      }
+    }
+    if (oldest == NULL)
+    {
+      return false;
+    }
+    layer_show_live(oldest);
+    layer_free_buf(oldest);
+    /* Cached again when its screen comes back */
+    oldest->dirty = true;
+    stats.evictions++;
+  }
+
+  return true;
+}
+
+static bool on_active_screen(lv_obj_t *obj)
+{
+  lv_display_t *disp = lv_obj_get_display(obj);
+
+  return disp != NULL && lv_obj_get_screen(obj) == lv_display_get_screen_active(disp) &&
+         !lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN);
+}
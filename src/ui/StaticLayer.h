@@ -0,0 +1,94 @@
+/**
+ * @file StaticLayer.h
+ * Static parts of a screen drawn once into an offscreen buffer.
+ *
+ * A layer caches a subtree whose content rarely changes, e.g. the dial,
+ * frame, scale labels and legend of a clock or overview screen. The root of
+ * the subtree is snapshotted into a draw buffer, shown by an image placed
+ * right below the root, and the root itself is made fully transparent, which
+ * skips drawing it and all its children; they stay in place for layout and
+ * input. The dynamic widgets (hands, values) must therefore be outside the
+ * root, usually its later siblings, so they are composited on top.
+ *
+ * A style, size or child change anywhere in the subtree switches the layer
+ * back to live drawing at once, so the screen is never stale; it is cached
+ * again once the subtree has been still for STATIC_LAYER_SETTLE_MS. Content
+ * changes LVGL does not report, e.g. a label text of the same size, need
+ * StaticLayer_invalidate().
+ *
+ * The buffer is RGB565 when the display renders RGB565 and the root is
+ * opaque, ARGB8888 otherwise. All layers together stay within a budget,
+ * LV_DRAW_LAYER_MAX_MEMORY if it is set; the least recently drawn layers
+ * give up their buffer first and are drawn live.
+ */
+
+#ifndef STATIC_LAYER_H
+#define STATIC_LAYER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define STATIC_LAYER_MAX_LAYERS 16U
+#define STATIC_LAYER_SETTLE_MS 250U
+
+#if LV_DRAW_LAYER_MAX_MEMORY > 0
+  #define STATIC_LAYER_MAX_MEMORY LV_DRAW_LAYER_MAX_MEMORY
+#else
+  /* One full 800x480 ARGB8888 screen */
+  #define STATIC_LAYER_MAX_MEMORY (2U * 1024U * 1024U)
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct _StaticLayer_t StaticLayer_t;
+
+typedef struct {
+  uint32_t renders;       /**< snapshots taken */
+  uint32_t invalidations; /**< switches back to live drawing */
+  uint32_t evictions;     /**< buffers given up for the budget */
+  uint32_t overBudget;    /**< layers that did not fit even after evicting */
+  uint32_t renderMs;      /**< time in the snapshots */
+} StaticLayer_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Cache the subtree of `root` once it is laid out and on the active screen.
+ * The root must not be a screen, the image goes into its parent. The layer
+ * lives as long as the root; NULL if all STATIC_LAYER_MAX_LAYERS are in use.
+ */
+StaticLayer_t *StaticLayer_create(lv_obj_t *root);
+
+/** Draw the root live again and free the buffer */
+void StaticLayer_delete(StaticLayer_t *layer);
+
+/** The subtree changed in a way LVGL does not report */
+void StaticLayer_invalidate(StaticLayer_t *layer);
+
+bool StaticLayer_is_cached(const StaticLayer_t *layer);
+
+/** Bytes all buffers may take, evicts at once if they are over it */
+void StaticLayer_set_budget(size_t bytes);
+
+size_t StaticLayer_get_cached_bytes(void);
+
+void StaticLayer_get_stats(StaticLayer_stats_t *stats);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*STATIC_LAYER_H*/
@@ -0,0 +1,508 @@
+/**
+ * @file TargetBudget.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#ifndef _DEFAULT_SOURCE
+  #define _DEFAULT_SOURCE /* needed for clock_gettime() and usleep() */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef _MSC_VER
+  #include <Windows.h>
+#else
+  #include <time.h>
+  #include <unistd.h>
+#endif
+#ifndef _WIN32
+  #include <pthread.h>
+#endif
+
+#include "TargetBudget.h"
+#include "FramePacer.h"
+#include "ScreenCache.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  TargetBudget_screen_t stats;
+  lv_obj_t *screen; /**< unnamed screens only, NULL once deleted */
+} slot_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void refr_start_cb(lv_event_t *e);
+static void render_start_cb(lv_event_t *e);
+static void flush_start_cb(lv_event_t *e);
+static void flush_finish_cb(lv_event_t *e);
+static void refr_ready_cb(lv_event_t *e);
+static void screen_delete_cb(lv_event_t *e);
+static slot_t *slot_get(lv_obj_t *screen);
+static uint64_t scaled(TargetBudget_category_t category, uint64_t hostUs);
+static void frame_host_us(uint64_t nowUs, uint64_t *hostUs);
+static uint64_t frame_excess_us(uint64_t nowUs);
+static void frame_throttle(void);
+static uint64_t take_app_us(void);
+static uint64_t now_us(void);
+static void sleep_us(uint64_t us);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_display_t *display;
+static TargetBudget_calibration_t calibration;
+static TargetBudget_mode_t budgetMode;
+
+static slot_t slots[TARGET_BUDGET_MAX_SCREENS];
+static uint32_t slotCount;
+static uint32_t unnamedCount;
+
+static bool frameOpen;
+static bool frameRendered;
+static slot_t *frameSlot;
+static uint32_t framePeriodUs;
+static uint64_t frameStartUs;
+static uint64_t renderStartUs;
+static uint64_t flushStartUs;
+static uint64_t layoutUs;
+static uint64_t flushUs;
+static uint64_t sleptUs; /* throttling within the frame, not part of any category */
+
+/* Written by whichever thread runs the application handlers */
+#ifndef _WIN32
+static pthread_mutex_t appMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static uint64_t appPendingUs;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void TargetBudget_calibration_init(TargetBudget_calibration_t *cal)
+{
+  memset(cal, 0, sizeof(*cal));
+  strcpy(cal->target, "host");
+  for (uint32_t i = 0; i < TARGET_BUDGET_CATEGORIES; i++)
+  {
+    cal->factor[i] = 1.0f;
+  }
+}
+
+bool TargetBudget_load_calibration(const char *path, TargetBudget_calibration_t *cal)
+{
+  static const char *const categoryNames[TARGET_BUDGET_CATEGORIES] = { "layout", "render", "flush", "app" };
+  char line[128];
+  char word[32];
+  uint32_t lineNr = 0;
+  bool ok = true;
+  FILE *in = fopen(path, "r");
+
+  if (in == NULL)
+  {
+    fprintf(stderr, "TargetBudget: cannot open %s\n", path);
+    return false;
+  }
+  while (fgets(line, sizeof(line), in) != NULL)
+  {
+    bool parsed = false;
+    float factor;
+    unsigned long deadlineMs;
+
+    lineNr++;
+    if (line[0] == '#' || sscanf(line, "%31s", word) != 1)
+    {
+      continue;
+    }
+    if (strcmp(word, "target") == 0)
+    {
+      parsed = sscanf(line, "%*s %31s", cal->target) == 1;
+    }
+    else if (strcmp(word, "deadline") == 0 && sscanf(line, "%*s %lu", &deadlineMs) == 1)
+    {
+      cal->deadlineMs = (uint32_t) deadlineMs;
+      parsed = true;
+    }
+    for (uint32_t i = 0; i < TARGET_BUDGET_CATEGORIES && !parsed; i++)
+    {
+      if (strcmp(word, categoryNames[i]) == 0 && sscanf(line, "%*s %f", &factor) == 1 && factor > 0.0f)
+      {
+        cal->factor[i] = factor;
+        parsed = true;
+      }
+    }
+    if (!parsed)
+    {
+      fprintf(stderr, "TargetBudget: %s:%u: cannot parse \"%s\"\n", path, (unsigned) lineNr, strtok(line, "\r\n"));
+      ok = false;
+    }
+  }
+  fclose(in);
+
+  return ok;
+}
+
+void TargetBudget_init(lv_display_t *disp, const TargetBudget_calibration_t *cal, TargetBudget_mode_t mode)
+{
+  TargetBudget_deinit();
+  if (cal != NULL)
+  {
+    calibration = *cal;
+  }
+  else
+  {
+    TargetBudget_calibration_init(&calibration);
+  }
+  budgetMode = mode;
+  memset(slots, 0, sizeof(slots));
+  slotCount = 0;
+  unnamedCount = 0;
+  frameOpen = false;
+  (void) take_app_us();
+
+  display = disp;
+  lv_display_add_event_cb(disp, refr_start_cb, LV_EVENT_REFR_START, NULL);
+  lv_display_add_event_cb(disp, render_start_cb, LV_EVENT_RENDER_START, NULL);
+  lv_display_add_event_cb(disp, flush_start_cb, LV_EVENT_FLUSH_START, NULL);
+  lv_display_add_event_cb(disp, flush_finish_cb, LV_EVENT_FLUSH_FINISH, NULL);
+  lv_display_add_event_cb(disp, refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+}
+
+void TargetBudget_deinit(void)
+{
+  if (display == NULL)
+  {
+    return;
+  }
+  lv_display_remove_event_cb_with_user_data(display, refr_start_cb, NULL);
+  lv_display_remove_event_cb_with_user_data(display, render_start_cb, NULL);
+  lv_display_remove_event_cb_with_user_data(display, flush_start_cb, NULL);
+  lv_display_remove_event_cb_with_user_data(display, flush_finish_cb, NULL);
+  lv_display_remove_event_cb_with_user_data(display, refr_ready_cb, NULL);
+  for (uint32_t i = 0; i < slotCount; i++)
+  {
+    if (slots[i].screen != NULL)
+    {
+      lv_obj_remove_event_cb_with_user_data(slots[i].screen, screen_delete_cb, &slots[i]);
+      slots[i].screen = NULL;
+    }
+  }
+  display = NULL;
+}
+
+uint64_t TargetBudget_app_begin(void)
+{
+  return (display != NULL) ? now_us() : 0U;
+}
+
+void TargetBudget_app_end(uint64_t beginUs)
+{
+  if (display == NULL || beginUs == 0U)
+  {
+    return;
+  }
+  uint64_t hostUs = now_us() - beginUs;
+
+#ifndef _WIN32
+  pthread_mutex_lock(&appMutex);
+#endif
+  appPendingUs += hostUs;
+#ifndef _WIN32
+  pthread_mutex_unlock(&appMutex);
+#endif
+
+  uint64_t targetUs = scaled(TARGET_BUDGET_APP, hostUs);
+  if (budgetMode == TARGET_BUDGET_THROTTLE && targetUs > hostUs)
+  {
+    sleep_us(targetUs - hostUs);
+  }
+}
+
+const TargetBudget_calibration_t *TargetBudget_get_calibration(void)
+{
+  return &calibration;
+}
+
+uint32_t TargetBudget_get_screen_count(void)
+{
+  return slotCount;
+}
+
+bool TargetBudget_get_screen(uint32_t index, TargetBudget_screen_t *screen)
+{
+  if (index >= slotCount)
+  {
+    return false;
+  }
+  *screen = slots[index].stats;
+
+  return true;
+}
+
+float TargetBudget_get_predicted_fps(const TargetBudget_screen_t *screen)
+{
+  if (screen->scheduledUs == 0U)
+  {
+    return 0.0f;
+  }
+  return (float) ((double) screen->frames * 1e6 / (double) screen->scheduledUs);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void refr_start_cb(lv_event_t *e)
+{
+  LV_UNUSED(e);
+
+  frameOpen = true;
+  frameRendered = false;
+  frameSlot = slot_get(lv_display_get_screen_active(display));
+  /* The pacer may change the period at this refresh start, the new one is the one to meet */
+  framePeriodUs = FramePacer_get_period() * 1000U;
+  layoutUs = 0;
+  flushUs = 0;
+  sleptUs = 0;
+  frameStartUs = now_us();
+}
+
+static void render_start_cb(lv_event_t *e)
+{
+  LV_UNUSED(e);
+
+  if (frameOpen && !frameRendered)
+  {
+    frameRendered = true;
+    renderStartUs = now_us();
+    layoutUs = renderStartUs - frameStartUs;
+  }
+}
+
+static void flush_start_cb(lv_event_t *e)
+{
+  LV_UNUSED(e);
+
+  if (!frameOpen || !frameRendered)
+  {
+    return;
+  }
+  /* Present no earlier than the target would have finished drawing */
+  if (budgetMode == TARGET_BUDGET_THROTTLE)
+  {
+    frame_throttle();
+  }
+  flushStartUs = now_us();
+}
+
+static void flush_finish_cb(lv_event_t *e)
+{
+  LV_UNUSED(e);
+
+  if (frameOpen && frameRendered)
+  {
+    flushUs += now_us() - flushStartUs;
+  }
+}
+
+static void refr_ready_cb(lv_event_t *e)
+{
+  LV_UNUSED(e);
+  uint64_t nowUs = now_us();
+  uint64_t hostUs[TARGET_BUDGET_CATEGORIES];
+  uint64_t costUs = 0;
+
+  if (!frameOpen)
+  {
+    return;
+  }
+  frameOpen = false;
+
+  if (budgetMode == TARGET_BUDGET_THROTTLE)
+  {
+    frame_throttle();
+    nowUs = now_us();
+  }
+
+  frame_host_us(nowUs, hostUs);
+  hostUs[TARGET_BUDGET_APP] = take_app_us();
+
+  TargetBudget_screen_t *stats = &frameSlot->stats;
+  for (uint32_t i = 0; i < TARGET_BUDGET_CATEGORIES; i++)
+  {
+    uint64_t targetUs = scaled((TargetBudget_category_t) i, hostUs[i]);
+    stats->hostUs[i] += hostUs[i];
+    stats->targetUs[i] += targetUs;
+    costUs += targetUs;
+  }
+
+  uint64_t deadlineUs = (calibration.deadlineMs != 0U) ? (uint64_t) calibration.deadlineMs * 1000U : framePeriodUs;
+  stats->refreshes++;
+  if (costUs > deadlineUs)
+  {
+    stats->misses++;
+  }
+  if (frameRendered)
+  {
+    stats->frames++;
+    stats->frameTargetUs += costUs;
+    if (costUs > stats->frameTargetUsMax)
+    {
+      stats->frameTargetUsMax = (uint32_t) costUs;
+    }
+    stats->scheduledUs += (costUs > framePeriodUs) ? costUs : framePeriodUs;
+  }
+}
+
+static void screen_delete_cb(lv_event_t *e)
+{
+  slot_t *slot = lv_event_get_user_data(e);
+
+  /* A new screen at the same address is another screen */
+  slot->screen = NULL;
+}
+
+/** Cached screens by name, the others by object; the last slot takes the rest */
+static slot_t *slot_get(lv_obj_t *screen)
+{
+  const char *name = ScreenCache_get_name(screen);
+
+  for (uint32_t i = 0; i < slotCount; i++)
+  {
+    if ((name != NULL) ? (slots[i].screen == NULL && strcmp(slots[i].stats.name, name) == 0)
+                       : (screen != NULL && slots[i].screen == screen))
+    {
+      return &slots[i];
+    }
+  }
+  if (slotCount == TARGET_BUDGET_MAX_SCREENS)
+  {
+    slot_t *rest = &slots[TARGET_BUDGET_MAX_SCREENS - 1U];
+    if (rest->screen != NULL)
+    {
+      lv_obj_remove_event_cb_with_user_data(rest->screen, screen_delete_cb, rest);
+      rest->screen = NULL;
+    }
+    strcpy(rest->stats.name, "(other screens)");
+    return rest;
+  }
+
+  slot_t *slot = &slots[slotCount++];
+  if (name != NULL)
+  {
+    snprintf(slot->stats.name, sizeof(slot->stats.name), "%s", name);
+  }
+  else
+  {
+    snprintf(slot->stats.name, sizeof(slot->stats.name), "screen %u", (unsigned) ++unnamedCount);
+    if (screen != NULL)
+    {
+      slot->screen = screen;
+      lv_obj_add_event_cb(screen, screen_delete_cb, LV_EVENT_DELETE, slot);
+    }
+  }
+
+  return slot;
+}
+
+static uint64_t scaled(TargetBudget_category_t category, uint64_t hostUs)
+{
+  return (uint64_t) ((double) hostUs * (double) calibration.factor[category] + 0.5);
+}
+
+/** Layout, render and flush time of the open frame so far, without the throttling */
+static void frame_host_us(uint64_t nowUs, uint64_t *hostUs)
+{
+  hostUs[TARGET_BUDGET_LAYOUT] = layoutUs;
+  if (!frameRendered)
+  {
+    /* A refresh without rendering can still be throttled, at its ready event */
+    hostUs[TARGET_BUDGET_LAYOUT] = (nowUs - frameStartUs > sleptUs) ? nowUs - frameStartUs - sleptUs : 0U;
+  }
+  hostUs[TARGET_BUDGET_RENDER] = 0;
+  hostUs[TARGET_BUDGET_FLUSH] = flushUs;
+  if (frameRendered && nowUs - renderStartUs > flushUs + sleptUs)
+  {
+    hostUs[TARGET_BUDGET_RENDER] = nowUs - renderStartUs - flushUs - sleptUs;
+  }
+}
+
+/** Time the target would still need for what the host did of the open frame */
+static uint64_t frame_excess_us(uint64_t nowUs)
+{
+  uint64_t hostUs[TARGET_BUDGET_CATEGORIES];
+  uint64_t hostSumUs = sleptUs;
+  uint64_t targetSumUs = 0;
+
+  frame_host_us(nowUs, hostUs);
+  for (uint32_t i = TARGET_BUDGET_LAYOUT; i <= TARGET_BUDGET_FLUSH; i++)
+  {
+    hostSumUs += hostUs[i];
+    targetSumUs += scaled((TargetBudget_category_t) i, hostUs[i]);
+  }
+
+  return (targetSumUs > hostSumUs) ? targetSumUs - hostSumUs : 0U;
+}
+
+/** Sleep off the excess, what the sleep took beyond it must not count as work */
+static void frame_throttle(void)
+{
+  uint64_t startUs = now_us();
+  uint64_t excessUs = frame_excess_us(startUs);
+
+  if (excessUs != 0U)
+  {
+    sleep_us(excessUs);
+    sleptUs += now_us() - startUs;
+  }
+}
+
+static uint64_t take_app_us(void)
+{
+  uint64_t us;
+
+#ifndef _WIN32
+  pthread_mutex_lock(&appMutex);
+#endif
+  us = appPendingUs;
+  appPendingUs = 0;
+#ifndef _WIN32
+  pthread_mutex_unlock(&appMutex);
+#endif
+
+  return us;
+}
+
+static uint64_t now_us(void)
+{
+#ifdef _MSC_VER
+  LARGE_INTEGER count;
+  LARGE_INTEGER freq;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&freq);
+  return (uint64_t) ((double) count.QuadPart * 1e6 / (double) freq.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000U + (uint64_t) ts.tv_nsec / 1000U;
+#endif
+}
+
+static void sleep_us(uint64_t us)
+{
+#ifdef _MSC_VER
+  Sleep((DWORD) ((us + 999U) / 1000U));
+#else
+  usleep((useconds_t) us);
+#endif
+}
@@ -0,0 +1,113 @@
+/**
+ * @file TargetBudget.h
+ * Predicted frame times of the target MCU from the simulator's.
+ *
+ * Every refresh is split into layout (refresh start to render start, with
+ * the invalidation), render and flush, taken from the display events, and the
+ * application handlers the caller brackets with TargetBudget_app_begin() and
+ * TargetBudget_app_end(). Each category is multiplied by its factor from a
+ * calibration file, how many times slower the target runs that kind of work,
+ * so one refresh costs layout + render + flush + the application time since
+ * the refresh before, all scaled. A cost above the deadline is a miss.
+ *
+ * The results are kept per screen: named after the ScreenCache descriptor if
+ * the screen is a cached one, numbered in order of appearance otherwise.
+ *
+ * In throttle mode the difference between the scaled and the measured time is
+ * slept: before each flush for layout and render, after the refresh for the
+ * flush and after every application bracket. The simulator then shows and
+ * feels like the target, stutter included. It cannot go faster than the host,
+ * so factors below 1 only count in the report.
+ *
+ * Calibration file, one entry per line, '#' starts a comment:
+ *   target <name>
+ *   layout|render|flush|app <factor>
+ *   deadline <ms>       (0 or missing: the refresh period of each frame)
+ */
+
+#ifndef TARGET_BUDGET_H
+#define TARGET_BUDGET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TARGET_BUDGET_MAX_SCREENS 16U
+#define TARGET_BUDGET_NAME_LEN 32U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+  TARGET_BUDGET_REPORT = 0,
+  TARGET_BUDGET_THROTTLE
+} TargetBudget_mode_t;
+
+typedef enum {
+  TARGET_BUDGET_LAYOUT = 0,
+  TARGET_BUDGET_RENDER,
+  TARGET_BUDGET_FLUSH,
+  TARGET_BUDGET_APP,
+  TARGET_BUDGET_CATEGORIES
+} TargetBudget_category_t;
+
+typedef struct {
+  char target[TARGET_BUDGET_NAME_LEN];
+  float factor[TARGET_BUDGET_CATEGORIES];
+  uint32_t deadlineMs;
+} TargetBudget_calibration_t;
+
+typedef struct {
+  char name[TARGET_BUDGET_NAME_LEN];
+  uint32_t refreshes;
+  uint32_t frames;        /**< refreshes that rendered something */
+  uint32_t misses;        /**< refreshes whose target cost exceeded the deadline */
+  uint64_t hostUs[TARGET_BUDGET_CATEGORIES];
+  uint64_t targetUs[TARGET_BUDGET_CATEGORIES];
+  uint64_t frameTargetUs; /**< target cost of the rendered frames */
+  uint32_t frameTargetUsMax;
+  uint64_t scheduledUs;   /**< rendered frames, each the longer of its cost and its period */
+} TargetBudget_screen_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Factors 1 and the refresh period as the deadline */
+void TargetBudget_calibration_init(TargetBudget_calibration_t *cal);
+
+/** Read a calibration file on top of the defaults, false with a message on error */
+bool TargetBudget_load_calibration(const char *path, TargetBudget_calibration_t *cal);
+
+void TargetBudget_init(lv_display_t *disp, const TargetBudget_calibration_t *cal, TargetBudget_mode_t mode);
+
+void TargetBudget_deinit(void);
+
+/** Start of application work, pass the result to TargetBudget_app_end(); any thread */
+uint64_t TargetBudget_app_begin(void);
+
+void TargetBudget_app_end(uint64_t beginUs);
+
+const TargetBudget_calibration_t *TargetBudget_get_calibration(void);
+
+uint32_t TargetBudget_get_screen_count(void);
+
+bool TargetBudget_get_screen(uint32_t index, TargetBudget_screen_t *screen);
+
+/** Frames per second the target would reach on the screen, at most the refresh rate */
+float TargetBudget_get_predicted_fps(const TargetBudget_screen_t *screen);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*TARGET_BUDGET_H*/
@@ -0,0 +1,305 @@
+/**
+ * @file VectorIcon.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "VectorIcon.h"
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  VectorIcon_key_t key;
+  lv_draw_buf_t *buf;  /**< NULL for a free entry */
+  uint32_t refs;       /**< images showing the bitmap */
+  uint32_t lastUse;
+} icon_entry_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void image_delete_cb(lv_event_t *e);
+static icon_entry_t *entry_get(const VectorIcon_key_t *key);
+static icon_entry_t *entry_find_buf(const void *buf);
+static void entry_free(icon_entry_t *entry);
+static icon_entry_t *make_room(size_t bytes, bool needEntry);
+static lv_draw_buf_t *rasterize(const VectorIcon_key_t *key);
+static bool key_equal(const VectorIcon_key_t *a, const VectorIcon_key_t *b);
+static size_t bitmap_bytes(int32_t size);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static icon_entry_t entries[VECTOR_ICON_MAX_ENTRIES];
+static size_t cachedBytes;
+static size_t budget = VECTOR_ICON_MAX_MEMORY;
+static uint32_t useClock;
+static VectorIcon_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_obj_t *VectorIcon_create(lv_obj_t *parent, const VectorIcon_src_t *src, int32_t size, lv_color_t color)
+{
+  lv_obj_t *image = lv_image_create(parent);
+
+  (void) VectorIcon_set(image, src, size, 0, color);
+
+  return image;
+}
+
+bool VectorIcon_set(lv_obj_t *image, const VectorIcon_src_t *src, int32_t size, int32_t rotation,
+                    lv_color_t color)
+{
+  VectorIcon_key_t key = { src, size, rotation, color };
+  icon_entry_t *shown = entry_find_buf(lv_image_get_src(image));
+  /* Looked up while the old bitmap is still referenced, so it is not the one evicted */
+  icon_entry_t *entry = entry_get(&key);
+
+  if (entry != NULL && entry == shown)
+  {
+    return true;
+  }
+  if (entry != NULL)
+  {
+    entry->refs++;
+  }
+  if (shown != NULL)
+  {
+    shown->refs--;
+  }
+
+  lv_obj_remove_event_cb(image, image_delete_cb);
+  lv_obj_add_event_cb(image, image_delete_cb, LV_EVENT_DELETE, NULL);
+  lv_image_set_src(image, (entry != NULL) ? entry->buf : NULL);
+
+  return entry != NULL;
+}
+
+uint32_t VectorIcon_prewarm(const VectorIcon_key_t *keys, uint32_t count)
+{
+  uint32_t cached = 0;
+
+  for (uint32_t i = 0; i < count; i++)
+  {
+    (void) entry_get(&keys[i]);
+  }
+  /* Later keys may have evicted earlier ones */
+  for (uint32_t i = 0; i < count; i++)
+  {
+    VectorIcon_key_t key = keys[i];
+    key.rotation = ((key.rotation % 3600) + 3600) % 3600;
+    for (uint32_t e = 0; e < VECTOR_ICON_MAX_ENTRIES; e++)
+    {
+      if (entries[e].buf != NULL && key_equal(&entries[e].key, &key))
+      {
+        cached++;
+        break;
+      }
+    }
+  }
+
+  return cached;
+}
+
+void VectorIcon_set_budget(size_t bytes)
+{
+  budget = bytes;
+  (void) make_room(0, false);
+}
+
+size_t VectorIcon_get_cached_bytes(void)
+{
+  return cachedBytes;
+}
+
+void VectorIcon_clear_cache(void)
+{
+  for (uint32_t e = 0; e < VECTOR_ICON_MAX_ENTRIES; e++)
+  {
+    if (entries[e].buf != NULL && entries[e].refs == 0U)
+    {
+      entry_free(&entries[e]);
+    }
+  }
+}
+
+void VectorIcon_get_stats(VectorIcon_stats_t *out)
+{
+  *out = stats;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void image_delete_cb(lv_event_t *e)
+{
+  icon_entry_t *entry = entry_find_buf(lv_image_get_src(lv_event_get_target(e)));
+
+  /* Kept cached, it is evicted when the room is needed */
+  if (entry != NULL && entry->refs > 0U)
+  {
+    entry->refs--;
+  }
+}
+
+/** The cached entry of `key`, rasterized on a miss; NULL if it could not be */
+static icon_entry_t *entry_get(const VectorIcon_key_t *key)
+{
+  VectorIcon_key_t normalized = *key;
+
+  if (key->src == NULL || key->src->draw == NULL || key->size <= 0)
+  {
+    return NULL;
+  }
+  normalized.rotation = ((key->rotation % 3600) + 3600) % 3600;
+  for (uint32_t e = 0; e < VECTOR_ICON_MAX_ENTRIES; e++)
+  {
+    if (entries[e].buf != NULL && key_equal(&entries[e].key, &normalized))
+    {
+      entries[e].lastUse = ++useClock;
+      stats.hits++;
+      return &entries[e];
+    }
+  }
+
+  size_t bytes = bitmap_bytes(normalized.size);
+  icon_entry_t *entry = make_room(bytes, true);
+  if (entry == NULL)
+  {
+    LV_LOG_WARN("VectorIcon: all %u entries in use", (unsigned) VECTOR_ICON_MAX_ENTRIES);
+    return NULL;
+  }
+  if (cachedBytes + bytes > budget)
+  {
+    stats.overBudget++;
+  }
+
+  uint32_t startMs = lv_tick_get();
+  entry->buf = rasterize(&normalized);
+  if (entry->buf == NULL)
+  {
+    LV_LOG_WARN("VectorIcon: no memory for %s at %" LV_PRId32 " px", normalized.src->name, normalized.size);
+    return NULL;
+  }
+  entry->key = normalized;
+  entry->refs = 0;
+  entry->lastUse = ++useClock;
+  cachedBytes += entry->buf->data_size;
+  stats.misses++;
+  stats.rasterMs += lv_tick_elaps(startMs);
+
+  return entry;
+}
+
+static icon_entry_t *entry_find_buf(const void *buf)
+{
+  if (buf == NULL)
+  {
+    return NULL;
+  }
+  for (uint32_t e = 0; e < VECTOR_ICON_MAX_ENTRIES; e++)
+  {
+    if (entries[e].buf == buf)
+    {
+      return &entries[e];
+    }
+  }
+
+  return NULL;
+}
+
+static void entry_free(icon_entry_t *entry)
+{
+  /* The image cache may still hold the decoded variable source */
+  lv_image_cache_drop(entry->buf);
+  cachedBytes -= entry->buf->data_size;
+  lv_draw_buf_destroy(entry->buf);
+  lv_memzero(entry, sizeof(*entry));
+}
+
+/**
+ * Evict unused bitmaps, least recently used first, until `bytes` more fit
+ * into the budget and, if `needEntry`, an entry is free. Returns a free
+ * entry, NULL if there is none; the budget may still be exceeded when all
+ * remaining bitmaps are in use.
+ */
+static icon_entry_t *make_room(size_t bytes, bool needEntry)
+{
+  for (;;)
+  {
+    icon_entry_t *unused = NULL;
+    icon_entry_t *oldest = NULL;
+    for (uint32_t e = 0; e < VECTOR_ICON_MAX_ENTRIES; e++)
+    {
+      if (entries[e].buf == NULL)
+      {
+        unused = (unused == NULL) ? &entries[e] : unused;
+      }
+      else if (entries[e].refs == 0U && (oldest == NULL || entries[e].lastUse < oldest->lastUse))
+      {
+        oldest = &entries[e];
+      }
+    }
+
+    if ((cachedBytes + bytes <= budget && (unused != NULL || !needEntry)) || oldest == NULL)
+    {
+      return unused;
+    }
+    entry_free(oldest);
+    stats.evictions++;
+  }
+}
+
+/**
+ * The icon drawn through a temporary canvas into a transparent ARGB8888
+ * buffer, rotated around its center
+ */
+static lv_draw_buf_t *rasterize(const VectorIcon_key_t *key)
+{
+  lv_draw_buf_t *buf = lv_draw_buf_create((uint32_t) key->size, (uint32_t) key->size, LV_COLOR_FORMAT_ARGB8888,
+                                          LV_STRIDE_AUTO);
+  if (buf == NULL)
+  {
+    return NULL;
+  }
+  lv_draw_buf_clear(buf, NULL);
+
+  lv_obj_t *canvas = lv_canvas_create(lv_layer_sys());
+  lv_obj_add_flag(canvas, LV_OBJ_FLAG_HIDDEN);
+  lv_canvas_set_draw_buf(canvas, buf);
+
+  lv_layer_t layer;
+  lv_canvas_init_layer(canvas, &layer);
+  lv_vector_dsc_t *dsc = lv_vector_dsc_create(&layer);
+  float half = (float) key->size / 2.0f;
+  if (key->rotation != 0)
+  {
+    lv_vector_dsc_translate(dsc, half, half);
+    lv_vector_dsc_rotate(dsc, (float) key->rotation / 10.0f);
+    lv_vector_dsc_translate(dsc, -half, -half);
+  }
+  key->src->draw(dsc, (float) key->size, key->color);
+  lv_draw_vector(dsc);
+  lv_vector_dsc_delete(dsc);
+  lv_canvas_finish_layer(canvas, &layer);
+  lv_obj_delete(canvas);
+
+  return buf;
+}
+
+static bool key_equal(const VectorIcon_key_t *a, const VectorIcon_key_t *b)
+{
+  return a->src == b->src && a->size == b->size && a->rotation == b->rotation && lv_color_eq(a->color, b->color);
+}
+
+static size_t bitmap_bytes(int32_t size)
+{
+  return (size_t) lv_draw_buf_width_to_stride((uint32_t) size, LV_COLOR_FORMAT_ARGB8888) * (size_t) size;
+}
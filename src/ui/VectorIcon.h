@@ -0,0 +1,109 @@
+/**
+ * @file VectorIcon.h
+ * Rasterization cache for vector icons.
+ *
+ * A vector icon is drawn by a callback that adds ThorVG paths to a vector
+ * descriptor. Drawing it live tessellates and rasterizes the paths on every
+ * refresh of its area; here each (icon, size, rotation, color) is rasterized
+ * once into an ARGB8888 buffer, which an lv_image then shows like any bitmap.
+ *
+ * The cache keeps at most VECTOR_ICON_MAX_ENTRIES bitmaps within a byte
+ * budget. Bitmaps no image shows are evicted least recently used first;
+ * bitmaps in use are never freed, so the icons on the existing screens may
+ * take more than the budget.
+ *
+ * Rasterizing dispatches a draw of its own, so icons must be set or prewarmed
+ * outside of a refresh, never from a draw event.
+ */
+
+#ifndef VECTOR_ICON_H
+#define VECTOR_ICON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define VECTOR_ICON_MAX_ENTRIES 64U
+
+/** 16 icons of 64x64 ARGB8888 */
+#define VECTOR_ICON_MAX_MEMORY (256U * 1024U)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**
+ * Add the paths of the icon to `dsc`, in a box of `size` x `size` pixels with
+ * the origin top left. Rotation is applied around the center of the box, so a
+ * rotated icon should stay within its inscribed circle. The descriptor copies
+ * the paths, they may be deleted right after lv_vector_dsc_add_path().
+ */
+typedef void (*VectorIcon_draw_cb_t)(lv_vector_dsc_t *dsc, float size, lv_color_t color);
+
+/** The vector source, usually one const instance per icon */
+typedef struct {
+  const char *name;
+  VectorIcon_draw_cb_t draw;
+} VectorIcon_src_t;
+
+/** One bitmap to rasterize ahead of use */
+typedef struct {
+  const VectorIcon_src_t *src;
+  int32_t size;
+  int32_t rotation; /**< 0.1 degrees */
+  lv_color_t color;
+} VectorIcon_key_t;
+
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;        /**< rasterizations */
+  uint32_t evictions;
+  uint32_t overBudget;    /**< bitmaps kept although over the budget */
+  uint32_t rasterMs;      /**< time spent rasterizing */
+} VectorIcon_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** An image showing the icon, see VectorIcon_set() */
+lv_obj_t *VectorIcon_create(lv_obj_t *parent, const VectorIcon_src_t *src, int32_t size, lv_color_t color);
+
+/**
+ * Show the icon in `image`, an lv_image, rasterized on a miss. The bitmap
+ * stays cached at least as long as the image shows it. False if it could not
+ * be allocated; the image is then left empty.
+ */
+bool VectorIcon_set(lv_obj_t *image, const VectorIcon_src_t *src, int32_t size, int32_t rotation,
+                    lv_color_t color);
+
+/**
+ * Rasterize the bitmaps of `keys` that are not cached yet, e.g. the icons of
+ * the first screens at startup or from Startup_defer(). Returns how many are
+ * cached afterwards; prewarming more than the budget evicts the first ones.
+ */
+uint32_t VectorIcon_prewarm(const VectorIcon_key_t *keys, uint32_t count);
+
+/** Bytes all bitmaps may take, evicts unused ones at once if they are over it */
+void VectorIcon_set_budget(size_t bytes);
+
+size_t VectorIcon_get_cached_bytes(void);
+
+/** Free all bitmaps no image shows */
+void VectorIcon_clear_cache(void);
+
+void VectorIcon_get_stats(VectorIcon_stats_t *stats);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*VECTOR_ICON_H*/
@@ -0,0 +1,287 @@
+/**
+ * @file ViewModel.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+#ifdef _WIN32
+  #include <Windows.h>
+#else
+  #include <pthread.h>
+#endif
+
+#include "ViewModel.h"
+#include "../sim/SimAlarms.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SNAPSHOT_COUNT 3U
+
+/* The exchange word: index of the published buffer, and whether the UI has not taken it yet */
+#define EXCHANGE_INDEX 0x3U
+#define EXCHANGE_FRESH 0x4U
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void lock(void);
+static void unlock(void);
+static uint32_t exchange_swap(uint32_t value);
+static uint32_t exchange_load(void);
+static void counter_add(uint32_t *counter);
+static uint32_t counter_get(const uint32_t *counter);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static bool threaded;
+#ifdef _WIN32
+static SRWLOCK mutex = SRWLOCK_INIT;
+#else
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static ViewModel_snapshot_t snapshots[SNAPSHOT_COUNT];
+/* Each side owns its index, the published one is only in the exchange word */
+static uint32_t readIndex;
+static uint32_t writeIndex;
+static uint32_t exchange;
+static const ViewModel_snapshot_t *current;
+static uint32_t lastPublishMs;
+static uint32_t epoch;
+static bool publishedOnce;
+
+static ViewModel_cmd_t commands[VIEW_MODEL_MAX_COMMANDS];
+static uint32_t commandHead;
+static uint32_t commandCount;
+
+static ViewModel_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void ViewModel_init(bool threadedMode)
+{
+  threaded = threadedMode;
+  memset(snapshots, 0, sizeof(snapshots));
+  readIndex = 0;
+  exchange = 1;
+  writeIndex = 2;
+  current = &snapshots[readIndex];
+  epoch = 0;
+  publishedOnce = false;
+  commandHead = 0;
+  commandCount = 0;
+  memset(&stats, 0, sizeof(stats));
+}
+
+bool ViewModel_is_threaded(void)
+{
+  return threaded;
+}
+
+void ViewModel_publish(uint32_t nowMs)
+{
+  if (!threaded || (publishedOnce && nowMs - lastPublishMs < VIEW_MODEL_PUBLISH_MS))
+  {
+    return;
+  }
+  lastPublishMs = nowMs;
+  publishedOnce = true;
+
+  /* The write buffer belongs to this thread alone, the UI cannot see it until it is swapped in */
+  ViewModel_snapshot_t *snapshot = &snapshots[writeIndex];
+  snapshot->epoch = ++epoch;
+  snapshot->timeMs = nowMs;
+  /* Already converted by SensorIngest, one copy of all its arrays */
+  memcpy(&snapshot->sensors, SensorIngest_get(), sizeof(snapshot->sensors));
+  SimAlarms_get_relay_demand(snapshot->relays);
+
+  /* Publish, the previously published buffer becomes the next write buffer */
+  uint32_t previous = exchange_swap(writeIndex | EXCHANGE_FRESH);
+  writeIndex = previous & EXCHANGE_INDEX;
+  if ((previous & EXCHANGE_FRESH) != 0U)
+  {
+    counter_add(&stats.replaced);
+  }
+  counter_add(&stats.published);
+}
+
+bool ViewModel_poll_command(ViewModel_cmd_t *cmd)
+{
+  bool found = false;
+
+  lock();
+  if (commandCount != 0U)
+  {
+    *cmd = commands[commandHead];
+    commandHead = (commandHead + 1U) % VIEW_MODEL_MAX_COMMANDS;
+    commandCount--;
+    found = true;
+  }
+  unlock();
+
+  return found;
+}
+
+bool ViewModel_acquire(void)
+{
+  /* Only this thread clears the fresh flag, so it is still set at the swap */
+  if (!threaded || (exchange_load() & EXCHANGE_FRESH) == 0U)
+  {
+    return false;
+  }
+
+  /* The old read buffer goes back as a published but stale one, the writer takes it next */
+  readIndex = exchange_swap(readIndex) & EXCHANGE_INDEX;
+  current = &snapshots[readIndex];
+  counter_add(&stats.acquired);
+
+  return true;
+}
+
+bool ViewModel_post_command(const ViewModel_cmd_t *cmd)
+{
+  bool queued = false;
+
+  lock();
+  if (commandCount < VIEW_MODEL_MAX_COMMANDS)
+  {
+    commands[(commandHead + commandCount) % VIEW_MODEL_MAX_COMMANDS] = *cmd;
+    commandCount++;
+    queued = true;
+  }
+  else
+  {
+    stats.commandsDropped++;
+  }
+  unlock();
+
+  return queued;
+}
+
+const int32_t *ViewModel_get_values(void)
+{
+  return ViewModel_get_sensors()->values;
+}
+
+const SensorIngest_snapshot_t *ViewModel_get_sensors(void)
+{
+  return threaded ? &current->sensors : SensorIngest_get();
+}
+
+int32_t ViewModel_get_value(uint32_t sensor)
+{
+  return (sensor < SIM_DESCRIPTOR_MAX_SENSORS) ? ViewModel_get_sensors()->values[sensor] : 0;
+}
+
+bool ViewModel_get_fault(uint32_t sensor)
+{
+  return (sensor < SIM_DESCRIPTOR_MAX_SENSORS) && ViewModel_get_sensors()->faults[sensor];
+}
+
+uint32_t ViewModel_get_epoch(void)
+{
+  return threaded ? current->epoch : SensorIngest_get()->seq;
+}
+
+uint8_t ViewModel_get_alarm_state(uint32_t sensor)
+{
+  return (sensor < SIM_DESCRIPTOR_MAX_SENSORS) ? ViewModel_get_sensors()->alarmStates[sensor] : 0U;
+}
+
+void ViewModel_get_relay_demand(SimDescriptor_relayMask_t demand)
+{
+  if (!threaded)
+  {
+    SimAlarms_get_relay_demand(demand);
+    return;
+  }
+  memcpy(demand, current->relays, sizeof(SimDescriptor_relayMask_t));
+}
+
+void ViewModel_get_stats(ViewModel_stats_t *out)
+{
+  out->published = counter_get(&stats.published);
+  out->replaced = counter_get(&stats.replaced);
+  out->acquired = counter_get(&stats.acquired);
+  lock();
+  out->commandsDropped = stats.commandsDropped;
+  unlock();
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void lock(void)
+{
+  if (threaded)
+  {
+#ifdef _WIN32
+    AcquireSRWLockExclusive(&mutex);
+#else
+    pthread_mutex_lock(&mutex);
+#endif
+  }
+}
+
+static void unlock(void)
+{
+  if (threaded)
+  {
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(&mutex);
+#else
+    pthread_mutex_unlock(&mutex);
+#endif
+  }
+}
+
+/**
+ * Swap the exchange word. Acquire-release: the snapshot written before a
+ * swap is complete for whoever swaps it out next.
+ */
+static uint32_t exchange_swap(uint32_t value)
+{
+#ifndef _WIN32
+  return __atomic_exchange_n(&exchange, value, __ATOMIC_ACQ_REL);
+#else
+  /* Interlocked functions are full barriers */
+  return (uint32_t) InterlockedExchange((volatile LONG *) &exchange, (LONG) value);
+#endif
+}
+
+static uint32_t exchange_load(void)
+{
+#ifndef _WIN32
+  return __atomic_load_n(&exchange, __ATOMIC_ACQUIRE);
+#else
+  return (uint32_t) InterlockedCompareExchange((volatile LONG *) &exchange, 0, 0);
+#endif
+}
+
+/* Each counter has one writing thread, the atomics only keep the readers tear-free */
+static void counter_add(uint32_t *counter)
+{
+#ifndef _WIN32
+  __atomic_fetch_add(counter, 1U, __ATOMIC_RELAXED);
+#else
+  InterlockedIncrement((volatile LONG *) counter);
+#endif
+}
+
+static uint32_t counter_get(const uint32_t *counter)
+{
+#ifndef _WIN32
+  return __atomic_load_n(counter, __ATOMIC_RELAXED);
+#else
+  /* Aligned 32-bit reads do not tear */
+  return *(const volatile uint32_t *) counter;
+#endif
+}
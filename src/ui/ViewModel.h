@@ -0,0 +1,130 @@
+/**
+ * @file ViewModel.h
+ * Plant state as the UI sees it, decoupled from the application thread.
+ *
+ * Widgets read sensor values, faults, alarm states and relays only through
+ * this module. Single-threaded, the accessors read the SensorIngest snapshot
+ * and SimAlarms directly. With a UI thread of its own, the application
+ * thread copies the state into a snapshot buffer and publishes it, at most
+ * every VIEW_MODEL_PUBLISH_MS; the UI thread takes the newest published
+ * snapshot with ViewModel_acquire() before it runs the LVGL timers, so one
+ * frame always shows one consistent state. A snapshot is never written
+ * while the UI holds it.
+ *
+ * There are three buffers: the one the UI reads, the newest published one
+ * and the one the application writes. Publishing and acquiring each swap
+ * their buffer with the published one in a single atomic exchange, so
+ * neither side ever locks or waits; publishing replaces an unread snapshot.
+ * Every snapshot carries the epoch it was published in, which tells readers
+ * such as charts or logging whether anything changed since they last looked.
+ *
+ * The other direction, UI to application, is a queue of commands such as
+ * alarm acknowledgements and key presses, guarded by a mutex. The UI never
+ * changes application state itself.
+ */
+
+#ifndef VIEW_MODEL_H
+#define VIEW_MODEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "../sim/SimDescriptor.h"
+#include "../sim/SensorIngest.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define VIEW_MODEL_PUBLISH_MS 10U
+#define VIEW_MODEL_MAX_COMMANDS 32U
+#define VIEW_MODEL_KEY_NAME_LEN 32U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum {
+  VIEW_MODEL_CMD_ACK_SENSOR = 0, /**< acknowledge the alarms of sensor `arg` */
+  VIEW_MODEL_CMD_ACK_ALL,
+  VIEW_MODEL_CMD_KEY,            /**< a key press for the configuration handler, `keyName` */
+} ViewModel_cmd_type_t;
+
+typedef struct {
+  ViewModel_cmd_type_t type;
+  uint32_t arg;
+  char keyName[VIEW_MODEL_KEY_NAME_LEN];
+} ViewModel_cmd_t;
+
+typedef struct {
+  uint32_t epoch;       /**< 1 for the first published snapshot, then counting up */
+  uint32_t timeMs;      /**< application time of the copy */
+  SensorIngest_snapshot_t sensors;
+  SimDescriptor_relayMask_t relays;
+} ViewModel_snapshot_t;
+
+typedef struct {
+  uint32_t published;
+  uint32_t replaced;    /**< published snapshots the UI never read */
+  uint32_t acquired;
+  uint32_t commandsDropped;
+} ViewModel_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/** Switch between direct reads (false) and snapshots (true), before any thread uses the module */
+void ViewModel_init(bool threaded);
+
+bool ViewModel_is_threaded(void);
+
+/* Application thread */
+
+/** Copy and publish the state if VIEW_MODEL_PUBLISH_MS passed since the last copy */
+void ViewModel_publish(uint32_t nowMs);
+
+/** Next command of the UI, false if there is none */
+bool ViewModel_poll_command(ViewModel_cmd_t *cmd);
+
+/* UI thread */
+
+/** Take the newest published snapshot, once per UI loop. Returns true if it changed */
+bool ViewModel_acquire(void);
+
+/** Queue a command for the application thread, false if the queue is full */
+bool ViewModel_post_command(const ViewModel_cmd_t *cmd);
+
+/** All SIM_DESCRIPTOR_MAX_SENSORS values, valid until the next ViewModel_acquire() */
+const int32_t *ViewModel_get_values(void);
+
+/** The converted readings of all sensors, valid until the next ViewModel_acquire() */
+const SensorIngest_snapshot_t *ViewModel_get_sensors(void);
+
+/**
+ * Epoch of the state the accessors return, changes whenever it does. 0
+ * before the first snapshot; single-threaded the SensorIngest update count.
+ */
+uint32_t ViewModel_get_epoch(void);
+
+int32_t ViewModel_get_value(uint32_t sensor);
+
+bool ViewModel_get_fault(uint32_t sensor);
+
+/** Active alarm entries of a sensor, as SimAlarms_get_state() */
+uint8_t ViewModel_get_alarm_state(uint32_t sensor);
+
+void ViewModel_get_relay_demand(SimDescriptor_relayMask_t demand);
+
+void ViewModel_get_stats(ViewModel_stats_t *stats);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*VIEW_MODEL_H*/
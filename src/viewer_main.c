@@ -0,0 +1,439 @@
+/**
+ * @file viewer_main.c
+ * Viewer of the frame stream of `main --stream` (see hal/frame_stream.h).
+ *
+ * Reassembles the frames from their tiles and shows them in a window; keys
+ * pressed in the window go back to the panel. With -o it opens no window,
+ * waits for a number of frames, saves the last one as BMP and exits, for
+ * visual checks in scripts.
+ *
+ * Usage: viewer <address> [-s scale] [-o frame.bmp [-n frames]]
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#ifndef _DEFAULT_SOURCE
+  #define _DEFAULT_SOURCE /* needed for poll() */
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <SDL.h>
+
+#include "hal/frame_stream.h"
+#include "hal/blit565.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define STATS_PERIOD_MS 5000U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct {
+  uint32_t * pixels;      /**< XRGB8888 */
+  uint32_t width;
+  uint32_t height;
+  uint8_t * payload;
+  uint32_t payload_cap;
+  uint8_t * tile;
+  uint32_t tile_cap;
+  uint64_t frames;
+  uint64_t bytes;
+} viewer_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bool receive_frame(int fd, viewer_t * viewer);
+static bool apply_tiles(viewer_t * viewer, const frame_stream_header_t * header);
+static bool read_all(int fd, uint8_t * dst, size_t len);
+static void viewer_free(viewer_t * viewer);
+static bool save_bmp(const viewer_t * viewer, const char * path);
+static void write_le(FILE * f, uint32_t value, uint32_t bytes);
+static void print_usage(const char * program);
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+int main(int argc, char ** argv)
+{
+  const char * address = (argc > 1) ? argv[1] : NULL;
+  const char * output = NULL;
+  uint32_t frameTarget = 1;
+  int scale = 1;
+  viewer_t viewer = { 0 };
+
+  if (address == NULL || address[0] == '-')
+  {
+    print_usage(argv[0]);
+    return 1;
+  }
+  for (int i = 2; i < argc; i += 2)
+  {
+    const char * value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    if (value == NULL)
+    {
+      print_usage(argv[0]);
+      return 1;
+    }
+    if (strcmp(argv[i], "-s") == 0)
+    {
+      scale = atoi(value);
+      scale = (scale < 1) ? 1 : (scale > 4) ? 4 : scale;
+    }
+    else if (strcmp(argv[i], "-o") == 0)
+    {
+      output = value;
+    }
+    else if (strcmp(argv[i], "-n") == 0)
+    {
+      frameTarget = (uint32_t) strtoul(value, NULL, 10);
+      frameTarget = (frameTarget == 0U) ? 1U : frameTarget;
+    }
+    else
+    {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  int fd = frame_stream_connect(address);
+  if (fd < 0)
+  {
+    fprintf(stderr, "viewer: cannot connect to %s\n", address);
+    return 1;
+  }
+
+  if (output != NULL)
+  {
+    int result = 0;
+    while (result == 0 && viewer.frames < frameTarget)
+    {
+      if (!receive_frame(fd, &viewer))
+      {
+        fprintf(stderr, "viewer: stream ended after %llu frames\n", (unsigned long long) viewer.frames);
+        result = 1;
+      }
+    }
+    close(fd);
+    if (result == 0 && !save_bmp(&viewer, output))
+    {
+      fprintf(stderr, "viewer: cannot write %s\n", output);
+      result = 1;
+    }
+    viewer_free(&viewer);
+    return result;
+  }
+
+  if (SDL_Init(SDL_INIT_VIDEO) != 0)
+  {
+    fprintf(stderr, "viewer: %s\n", SDL_GetError());
+    return 1;
+  }
+  SDL_Window * window = NULL;
+  SDL_Renderer * renderer = NULL;
+  SDL_Texture * texture = NULL;
+  uint32_t textureWidth = 0;
+  uint32_t textureHeight = 0;
+  uint32_t statsRefMs = SDL_GetTicks();
+  uint64_t statsFrames = 0;
+  uint64_t statsBytes = 0;
+  bool running = true;
+
+  while (running)
+  {
+    SDL_Event event;
+    while (SDL_PollEvent(&event))
+    {
+      if (event.type == SDL_QUIT)
+      {
+        running = false;
+      }
+      else if (event.type == SDL_KEYDOWN)
+      {
+        frame_stream_send_key(fd, SDL_GetKeyName(event.key.keysym.sym));
+      }
+    }
+
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    bool updated = false;
+    while (running && poll(&pfd, 1, updated ? 0 : 10) > 0)
+    {
+      if (!receive_frame(fd, &viewer))
+      {
+        fprintf(stderr, "viewer: stream ended\n");
+        running = false;
+        break;
+      }
+      updated = true;
+    }
+    if (!updated || viewer.pixels == NULL)
+    {
+      continue;
+    }
+
+    if (texture != NULL && (viewer.width != textureWidth || viewer.height != textureHeight))
+    {
+      /* The stream changed its resolution, e.g. the simulator was restarted with another one */
+      SDL_DestroyTexture(texture);
+      texture = NULL;
+      SDL_SetWindowSize(window, (int) viewer.width * scale, (int) viewer.height * scale);
+    }
+    if (texture == NULL)
+    {
+      if (window == NULL)
+      {
+        window = SDL_CreateWindow(address, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                                  (int) viewer.width * scale, (int) viewer.height * scale, 0);
+        renderer = (window != NULL) ? SDL_CreateRenderer(window, -1, 0) : NULL;
+      }
+      texture = (renderer != NULL) ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                                       (int) viewer.width, (int) viewer.height) : NULL;
+      if (texture == NULL)
+      {
+        fprintf(stderr, "viewer: %s\n", SDL_GetError());
+        break;
+      }
+      textureWidth = viewer.width;
+      textureHeight = viewer.height;
+    }
+    SDL_UpdateTexture(texture, NULL, viewer.pixels, (int) (viewer.width * 4U));
+    SDL_RenderCopy(renderer, texture, NULL, NULL);
+    SDL_RenderPresent(renderer);
+
+    if (SDL_GetTicks() - statsRefMs >= STATS_PERIOD_MS)
+    {
+      double seconds = (double) (SDL_GetTicks() - statsRefMs) / 1000.0;
+      printf("viewer: %.1f frames/s, %.1f KB/s\n", (double) (viewer.frames - statsFrames) / seconds,
+             (double) (viewer.bytes - statsBytes) / 1024.0 / seconds);
+      statsRefMs = SDL_GetTicks();
+      statsFrames = viewer.frames;
+      statsBytes = viewer.bytes;
+    }
+  }
+
+  close(fd);
+  if (texture != NULL)
+  {
+    SDL_DestroyTexture(texture);
+  }
+  if (renderer != NULL)
+  {
+    SDL_DestroyRenderer(renderer);
+  }
+  if (window != NULL)
+  {
+    SDL_DestroyWindow(window);
+  }
+  SDL_Quit();
+  viewer_free(&viewer);
+
+  return 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/** Read one frame message and apply its tiles */
+static bool receive_frame(int fd, viewer_t * viewer)
+{
+  uint8_t data[FRAME_STREAM_HEADER_SIZE];
+  frame_stream_header_t header;
+
+  if (!read_all(fd, data, sizeof(data)) || !frame_stream_parse_header(data, &header))
+  {
+    return false;
+  }
+  if (header.width != viewer->width || header.height != viewer->height)
+  {
+    uint32_t * pixels = realloc(viewer->pixels, (size_t) header.width * header.height * 4U);
+    if (pixels == NULL)
+    {
+      return false;
+    }
+    memset(pixels, 0, (size_t) header.width * header.height * 4U);
+    viewer->pixels = pixels;
+    viewer->width = header.width;
+    viewer->height = header.height;
+  }
+  if (header.payload_bytes > viewer->payload_cap)
+  {
+    uint8_t * payload = realloc(viewer->payload, header.payload_bytes);
+    if (payload == NULL)
+    {
+      return false;
+    }
+    viewer->payload = payload;
+    viewer->payload_cap = header.payload_bytes;
+  }
+  if (!read_all(fd, viewer->payload, header.payload_bytes))
+  {
+    return false;
+  }
+  viewer->frames++;
+  viewer->bytes += FRAME_STREAM_HEADER_SIZE + header.payload_bytes;
+
+  return apply_tiles(viewer, &header);
+}
+
+static bool apply_tiles(viewer_t * viewer, const frame_stream_header_t * header)
+{
+  uint32_t pixel_size = frame_stream_pixel_size(header->format);
+  uint32_t tile_bytes = header->tile_size * header->tile_size * pixel_size;
+  uint32_t off = 0;
+
+  if (header->tile_size > 256U)
+  {
+    return false;
+  }
+  if (tile_bytes > viewer->tile_cap)
+  {
+    uint8_t * tile = realloc(viewer->tile, tile_bytes);
+    if (tile == NULL)
+    {
+      return false;
+    }
+    viewer->tile = tile;
+    viewer->tile_cap = tile_bytes;
+  }
+
+  for (uint32_t t = 0; t < header->tile_count; t++)
+  {
+    if (off + FRAME_STREAM_TILE_HEADER_SIZE > header->payload_bytes)
+    {
+      return false;
+    }
+    const uint8_t * p = viewer->payload + off;
+    uint32_t x0 = (uint32_t) (p[0] | (p[1] << 8)) * header->tile_size;
+    uint32_t y0 = (uint32_t) (p[2] | (p[3] << 8)) * header->tile_size;
+    uint32_t bytes = (uint32_t) p[4] | ((uint32_t) p[5] << 8) | ((uint32_t) p[6] << 16) | ((uint32_t) p[7] << 24);
+    off += FRAME_STREAM_TILE_HEADER_SIZE;
+    if (x0 >= viewer->width || y0 >= viewer->height || bytes > header->payload_bytes - off)
+    {
+      return false;
+    }
+
+    uint32_t w = (viewer->width - x0 < header->tile_size) ? viewer->width - x0 : header->tile_size;
+    uint32_t h = (viewer->height - y0 < header->tile_size) ? viewer->height - y0 : header->tile_size;
+    if (!frame_stream_rle_decode(viewer->tile, w * h, pixel_size, viewer->payload + off, bytes))
+    {
+      return false;
+    }
+    off += bytes;
+
+    for (uint32_t y = 0; y < h; y++)
+    {
+      uint32_t * dst = viewer->pixels + (size_t) (y0 + y) * viewer->width + x0;
+      const uint8_t * src = viewer->tile + (size_t) y * w * pixel_size;
+      if (header->format == FRAME_STREAM_RGB565)
+      {
+        uint16_t line[256];
+        memcpy(line, src, (size_t) w * 2U);
+        blit565_to_xrgb8888(dst, line, w);
+        continue;
+      }
+      for (uint32_t x = 0; x < w; x++)
+      {
+        dst[x] = 0xFF000000U | ((uint32_t) src[2] << 16) | ((uint32_t) src[1] << 8) | src[0];
+        src += 3;
+      }
+    }
+  }
+
+  return off == header->payload_bytes;
+}
+
+static bool read_all(int fd, uint8_t * dst, size_t len)
+{
+  size_t off = 0;
+
+  while (off < len)
+  {
+    ssize_t received = recv(fd, dst + off, len - off, 0);
+    if (received < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (received <= 0)
+    {
+      return false;
+    }
+    off += (size_t) received;
+  }
+
+  return true;
+}
+
+static void viewer_free(viewer_t * viewer)
+{
+  free(viewer->pixels);
+  free(viewer->payload);
+  free(viewer->tile);
+  memset(viewer, 0, sizeof(*viewer));
+}
+
+/** 32-bit BMP, the same layout as hal_screenshot_save() */
+static bool save_bmp(const viewer_t * viewer, const char * path)
+{
+  FILE * f = fopen(path, "wb");
+  if (f == NULL)
+  {
+    return false;
+  }
+
+  uint32_t image_size = viewer->width * viewer->height * 4U;
+  fputc('B', f);
+  fputc('M', f);
+  write_le(f, 14U + 40U + image_size, 4);
+  write_le(f, 0, 4);
+  write_le(f, 14U + 40U, 4);
+  write_le(f, 40U, 4);
+  write_le(f, viewer->width, 4);
+  write_le(f, viewer->height, 4);
+  write_le(f, 1, 2);
+  write_le(f, 32, 2);
+  write_le(f, 0, 4);
+  write_le(f, image_size, 4);
+  write_le(f, 2835, 4);
+  write_le(f, 2835, 4);
+  write_le(f, 0, 4);
+  write_le(f, 0, 4);
+  for (uint32_t y = viewer->height; y > 0; y--)
+  {
+    fwrite(viewer->pixels + (size_t) (y - 1U) * viewer->width, 4, viewer->width, f);
+  }
+
+  return fclose(f) == 0;
+}
+
+static void write_le(FILE * f, uint32_t value, uint32_t bytes)
+{
+  for (uint32_t i = 0; i < bytes; i++)
+  {
+    fputc((int) ((value >> (8U * i)) & 0xFFU), f);
+  }
+}
+
+static void print_usage(const char * program)
+{
+  fprintf(stderr,
+          "usage: %s <address> [-s scale] [-o frame.bmp [-n frames]]\n"
+          "  address  as passed to main --stream: unix:<path>, <host>:<port> or <port>\n"
+          "  -s  window scale 1..4 (default: 1)\n"
+          "  -o  no window: save frame n as BMP and exit\n"
+          "  -n  frames to wait for with -o (default: 1, the key frame)\n",
+          program);
+}